@@ -9,11 +9,10 @@
 #include <gtc/matrix_transform.hpp>
 
 AngleStudy::AngleStudy()
-	: m_pSocket(NULL)
+	: m_pMotorClient(NULL)
+	, m_uiMoveCommandID(0u)
+	, m_bMotorFailureReported(false)
 	, m_pHinge(NULL)
-	, m_fHingeSize(10.f)
-	, m_pEditParam(NULL)
-	, m_pDiagram(NULL)
 	, m_bStudyMode(false)
 	, m_bPaused(false)
 	, m_bShowStimulus(true)
@@ -22,19 +21,23 @@ AngleStudy::AngleStudy()
 	, m_bShowDiagram(false)
 	, m_bWaitingForResponse(false)
 	, m_bDisplayCondition(false)
+	, m_fHingeSize(10.f)
 	, m_Generator(std::random_device()())
 	, m_AngleDistribution(std::uniform_int_distribution<int>(10, 20))
 	, m_BoolDistribution(std::uniform_int_distribution<int>(0, 1))
+	, m_pEditParam(NULL)
+	, m_pDiagram(NULL)
 {
 }
 
 
 AngleStudy::~AngleStudy()
 {
-	if (m_pSocket)
+	if (m_pMotorClient)
 	{
-		m_pSocket->send("0,1");
-		delete m_pSocket;
+		if (m_pMotorClient->getState() == MotorControlClient::CONNECTED)
+			m_pMotorClient->send("0,1");
+		delete m_pMotorClient;
 	}
 
 	if (m_pHinge)
@@ -52,8 +55,11 @@ void AngleStudy::init(glm::ivec2 screenRes, glm::mat4 worldToScreenTransform)
 	m_mat4Screen = worldToScreenTransform;
 	m_mat4Screen[2] *= 10.f;
 
-	if (m_pSocket == NULL)
-		m_pSocket = new WinsockClient();
+	if (m_pMotorClient == NULL)
+	{
+		m_pMotorClient = new MotorControlClient();
+		m_pMotorClient->setStateCallback(std::bind(&AngleStudy::onMotorStateChange, this, std::placeholders::_1));
+	}
 
 	if (m_pHinge == NULL)
 		m_pHinge = new Hinge(m_fHingeSize, 90.f);
@@ -148,7 +154,6 @@ void AngleStudy::reset()
 void AngleStudy::update()
 {
 	using clock = std::chrono::high_resolution_clock;
-	auto tick = clock::now();
 
 	float elapsedMove = std::chrono::duration<float>(clock::now() - m_tMoveStart).count();
 	float elapsedStim = std::chrono::duration<float>(clock::now() - m_tStimulusStart).count();
@@ -185,16 +190,7 @@ void AngleStudy::update()
 		m_bShowStimulus = true;
 
 
-	if (m_SocketFuture.valid() && m_SocketFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
-	{
-		if (m_SocketFuture.get())
-		{
-			moveScreen(0, true);
-			Renderer::getInstance().showMessage("Successfully connected to " + m_strServerAddress + " port " + std::to_string(m_uiServerPort) + " successfully!");
-		}
-		else
-			Renderer::getInstance().showMessage("ERROR! Could not connect to server at " + m_strServerAddress + " port " + std::to_string(m_uiServerPort) + "!");
-	}
+	m_pMotorClient->pollEvents();
 }
 
 
@@ -209,7 +205,7 @@ void AngleStudy::draw()
 		//m_pHinge->draw();
 	}
 	
-	for (int i = 0; i < m_vec3DistortedGridPoints.size(); ++i)
+	for (size_t i = 0; i < m_vec3DistortedGridPoints.size(); ++i)
 	{
 		glm::vec3 dir(m_vec3DistortedGridPoints[i] - m_vec3GridPoints[i]);
 
@@ -233,9 +229,7 @@ void AngleStudy::draw()
 		Renderer::RendererSubmission rs;
 		rs.glPrimitiveType = GL_TRIANGLES;
 		rs.shaderName = rod.shaderName;
-		rs.VAO = Renderer::getInstance().getPrimitiveVAO("cylinder");
-		rs.vertCount = Renderer::getInstance().getPrimitiveIndexCount("cylinder");
-		rs.indexType = GL_UNSIGNED_SHORT;
+		Renderer::getInstance().setSubmissionPrimitive(rs, "cylinder");
 		rs.diffuseTexName = rod.textureName;
 		rs.diffuseColor = glm::vec4(rod.color, 1.f);
 		rs.hasTransparency = rs.diffuseColor.a != 1.f;
@@ -349,7 +343,6 @@ void AngleStudy::draw()
 		std::stringstream ss;
 		ss.precision(3);
 
-		StudyCondition c = m_vExperimentConditions.back();
 		ss << "Viewing Angle: " << (m_bLockViewCOP ? m_fViewAngle : m_fCOPAngle) << std::endl;
 		ss << "Viewing Distance: " << (m_bLockViewCOP ? m_fViewDist : m_fCOPDist) << std::endl;
 		ss << "Hinge Angle: " << m_pHinge->getAngle() << std::endl;
@@ -379,6 +372,8 @@ void AngleStudy::begin()
 
 	DataLogger::getInstance().setID(m_strName);
 	DataLogger::getInstance().openLog(m_strName);
+	// start.angle is 90 +/- 10..20 degrees. Logs written before the fix to generateTrials() only
+	// ever recorded 89 or 91, so pool those sessions separately.
 	DataLogger::getInstance().setHeader("trial,view.angle,view.dist.factor,fishtank,start.angle,hinge.length,hinge.z.pos,hinge.angle,response");
 	DataLogger::getInstance().start();
 
@@ -394,7 +389,7 @@ void AngleStudy::generateTrials(bool randomOrder)
 				StudyCondition cond;
 				cond.hingeLen = m_fHingeSize;
 				cond.hingePos = glm::vec3(0.f, 0.f, -m_fHingeSize / 2.f);
-				cond.startAngle = 90.f + (m_AngleDistribution(m_Generator) * m_BoolDistribution(m_Generator) ? 1.f : -1.f);
+				cond.startAngle = 90.f + m_AngleDistribution(m_Generator) * (m_BoolDistribution(m_Generator) ? 1.f : -1.f);
 				cond.viewAngle = m_BoolDistribution(m_Generator) ? a : -a;
 				cond.viewDistFactor = d;
 				cond.matchedView = f;
@@ -474,27 +469,18 @@ float AngleStudy::getEyeSep()
 
 void AngleStudy::writeToLog(StudyResponse response)
 {
-	std::string logEntry;
-	logEntry += std::to_string(m_nTrials - m_vExperimentConditions.size());
-	logEntry += ",";
-	logEntry += std::to_string(m_vExperimentConditions.back().viewAngle);
-	logEntry += ",";
-	logEntry += std::to_string(m_vExperimentConditions.back().viewDistFactor);
-	logEntry += ",";
-	logEntry += std::to_string(m_vExperimentConditions.back().matchedView);
-	logEntry += ",";
-	logEntry += std::to_string(m_vExperimentConditions.back().startAngle);
-	logEntry += ",";
-	logEntry += std::to_string(m_vExperimentConditions.back().hingeLen);
-	logEntry += ",";
-	logEntry += std::to_string(m_vExperimentConditions.back().hingePos.z);
-	logEntry += ",";
-	logEntry += std::to_string(m_pHinge->getAngle());
-	logEntry += ",";
-	logEntry += response == ACUTE ? "acute" : "obtuse";
-	logEntry += ",";
-
-	DataLogger::getInstance().logMessage(logEntry);
+	DataLogger::Row row;
+	row.add(static_cast<unsigned int>(m_nTrials - m_vExperimentConditions.size()))
+		.add(m_vExperimentConditions.back().viewAngle)
+		.add(m_vExperimentConditions.back().viewDistFactor)
+		.add(m_vExperimentConditions.back().matchedView)
+		.add(m_vExperimentConditions.back().startAngle)
+		.add(m_vExperimentConditions.back().hingeLen)
+		.add(m_vExperimentConditions.back().hingePos.z)
+		.add(m_pHinge->getAngle())
+		.add(response == ACUTE ? "acute" : "obtuse");
+
+	DataLogger::getInstance().logRow(row);
 }
 
 void AngleStudy::loadCondition(StudyCondition &c)
@@ -530,40 +516,63 @@ bool AngleStudy::moveScreen(float viewAngle, bool forceMove)
 	ss.precision(2);
 	ss << -viewAngle << "," << m_fMoveTime;
 	
-	m_pSocket->send(ss.str());
+	// Until the server acknowledges, assume the move starts after a typical network delay
 	m_tMoveStart = std::chrono::high_resolution_clock::now() + std::chrono::milliseconds(250);
 
+	if (m_pMotorClient->getState() == MotorControlClient::CONNECTED)
+	{
+		unsigned int moveID = ++m_uiMoveCommandID;
+
+		// the server echoes a command just before it starts moving, so the move began half a round trip before the echo arrived
+		m_pMotorClient->send(ss.str(), [this, moveID](bool ok, const std::string &reply, double roundTripSeconds) {
+			if (ok && moveID == m_uiMoveCommandID)
+				m_tMoveStart = std::chrono::high_resolution_clock::now() - std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::duration<double>(roundTripSeconds * 0.5));
+		});
+	}
+
 	return true;
 }
 
-void AngleStudy::receive(void * data)
+void AngleStudy::onMotorStateChange(MotorControlClient::ConnectionState state)
+{
+	if (state == MotorControlClient::CONNECTED)
+	{
+		m_bMotorFailureReported = false;
+		moveScreen(0, true);
+		Renderer::getInstance().showMessage("Successfully connected to " + m_pMotorClient->getServer() + " port " + std::to_string(m_pMotorClient->getPort()) + "!");
+	}
+	else if (state == MotorControlClient::DISCONNECTED && !m_bMotorFailureReported)
+	{
+		// the client keeps retrying in the background, so only say so once per outage
+		m_bMotorFailureReported = true;
+		Renderer::getInstance().showMessage("ERROR! No connection to server at " + m_pMotorClient->getServer() + " port " + std::to_string(m_pMotorClient->getPort()) + "; retrying...");
+	}
+}
+
+void AngleStudy::receive(const InputEvent &ev)
 {
 	//if (m_bBlockInput)
 	//	return;
 
-	int eventData[2];
-
-	memcpy(&eventData, data, sizeof(int) * 2);
-
-	if (eventData[0] == GLFWInputBroadcaster::EVENT::KEY_DOWN)
+	if (ev.type == GLFWInputBroadcaster::EVENT::KEY_DOWN)
 	{
 		if (m_bStudyMode)
 		{
-			if (eventData[1] == GLFW_KEY_LEFT_SHIFT)
+			if (ev.code == GLFW_KEY_LEFT_SHIFT)
 			{
-				if (m_nReversals <= 10u) // ignore the first reversal
+				if (m_nReversals <= 10) // ignore the first reversal
 					writeToLog(ACUTE);
 				next(ACUTE);
 			}
 
-			if (eventData[1] == GLFW_KEY_RIGHT_SHIFT)
+			if (ev.code == GLFW_KEY_RIGHT_SHIFT)
 			{
-				if (m_nReversals <= 10u) // ignore the first reversal
+				if (m_nReversals <= 10) // ignore the first reversal
 					writeToLog(OBTUSE);
 				next(OBTUSE);
 			}
 
-			if (eventData[1] == GLFW_KEY_SPACE && m_bPaused)
+			if (ev.code == GLFW_KEY_SPACE && m_bPaused)
 			{
 				m_bPaused = false;
 				loadCondition(m_vExperimentConditions.back());
@@ -574,24 +583,24 @@ void AngleStudy::receive(void * data)
 
 			if (m_pEditParam)
 			{
-				if (eventData[1] == GLFW_KEY_BACKSPACE && m_pEditParam->buf.length() > 0)
+				if (ev.code == GLFW_KEY_BACKSPACE && m_pEditParam->buf.length() > 0)
 					m_pEditParam->buf.pop_back();
 
 				if (m_pEditParam->format & STUDYPARAM_NUMERIC)
 				{
-					if (eventData[1] >= GLFW_KEY_0 && eventData[1] <= GLFW_KEY_9)
-						m_pEditParam->buf += std::to_string(eventData[1] - GLFW_KEY_0);
+					if (ev.code >= GLFW_KEY_0 && ev.code <= GLFW_KEY_9)
+						m_pEditParam->buf += std::to_string(ev.code - GLFW_KEY_0);
 				}
 
 				if (m_pEditParam->format & STUDYPARAM_ALPHA)
 				{
-					if (eventData[1] >= GLFW_KEY_A && eventData[1] <= GLFW_KEY_Z)
-						m_pEditParam->buf += glfwGetKeyName(eventData[1], 0);
+					if (ev.code >= GLFW_KEY_A && ev.code <= GLFW_KEY_Z)
+						m_pEditParam->buf += glfwGetKeyName(ev.code, 0);
 				}
 
 				if (m_pEditParam->format & STUDYPARAM_POSNEG)
 				{
-					if (eventData[1] == GLFW_KEY_MINUS)
+					if (ev.code == GLFW_KEY_MINUS)
 					{
 						if (m_pEditParam->buf[0] == '-')
 							m_pEditParam->buf.erase(0, 1);
@@ -602,7 +611,7 @@ void AngleStudy::receive(void * data)
 
 				if (m_pEditParam->format & STUDYPARAM_DECIMAL)
 				{
-					if (eventData[1] == GLFW_KEY_PERIOD)
+					if (ev.code == GLFW_KEY_PERIOD)
 					{
 						auto decimalCount = std::count(m_pEditParam->buf.begin(), m_pEditParam->buf.end(), '.');
 
@@ -612,7 +621,7 @@ void AngleStudy::receive(void * data)
 				}
 
 
-				if (eventData[1] == GLFW_KEY_ENTER && m_pEditParam->buf.length() > 0)
+				if (ev.code == GLFW_KEY_ENTER && m_pEditParam->buf.length() > 0)
 				{
 					Renderer::getInstance().showMessage(m_pEditParam->desc + " set to " + m_pEditParam->buf);
 
@@ -656,66 +665,66 @@ void AngleStudy::receive(void * data)
 			}
 			else
 			{
-				if (eventData[1] == GLFW_KEY_F1)
+				if (ev.code == GLFW_KEY_F1)
 				{
 					m_pEditParam = &(*std::find_if(m_vParams.begin(), m_vParams.end(), [](StudyParam p) {
 						return p.desc.compare("Server IP") == 0;
 					}));
 				}
 
-				if (eventData[1] == GLFW_KEY_F2)
+				if (ev.code == GLFW_KEY_F2)
 				{
 					m_pEditParam = &(*std::find_if(m_vParams.begin(), m_vParams.end(), [](StudyParam p) {
 						return p.desc.compare("Server Port") == 0;
 					}));
 				}
 
-				if (eventData[1] == GLFW_KEY_F3)
+				if (ev.code == GLFW_KEY_F3)
 				{
 					m_pEditParam = &(*std::find_if(m_vParams.begin(), m_vParams.end(), [](StudyParam p) {
 						return p.desc.compare("Eye Separation (cm)") == 0;
 					}));
 				}
 
-				if (eventData[1] == GLFW_KEY_F4)
+				if (ev.code == GLFW_KEY_F4)
 				{
 					m_pEditParam = &(*std::find_if(m_vParams.begin(), m_vParams.end(), [](StudyParam p) {
 						return p.desc.compare("View Distance (cm)") == 0;
 					}));
 				}
 
-				if (eventData[1] == GLFW_KEY_F5)
+				if (ev.code == GLFW_KEY_F5)
 				{
 					m_pEditParam = &(*std::find_if(m_vParams.begin(), m_vParams.end(), [](StudyParam p) {
 						return p.desc.compare("View Angle (deg)") == 0;
 					}));
 				}
 
-				if (eventData[1] == GLFW_KEY_F6)
+				if (ev.code == GLFW_KEY_F6)
 				{
 					m_pEditParam = &(*std::find_if(m_vParams.begin(), m_vParams.end(), [](StudyParam p) {
 						return p.desc.compare("Display Move Time (sec)") == 0;
 					}));
 				}
 
-				if (eventData[1] == GLFW_KEY_F7)
+				if (ev.code == GLFW_KEY_F7)
 				{
 					m_pEditParam = &(*std::find_if(m_vParams.begin(), m_vParams.end(), [](StudyParam p) {
 						return p.desc.compare("Name") == 0;
 					}));
 				}
 
-				if (eventData[1] == GLFW_KEY_R)
+				if (ev.code == GLFW_KEY_R)
 					reset();
 
-				if (eventData[1] == GLFW_KEY_HOME)
+				if (ev.code == GLFW_KEY_HOME)
 				{
 					m_bStudyMode = true;
 					begin();
 				}
 			}
 
-			if (eventData[1] == GLFW_KEY_F8)
+			if (ev.code == GLFW_KEY_F8)
 			{
 				m_bLockViewCOP = !m_bLockViewCOP;
 				std::string msg("COP and View Point ");
@@ -723,30 +732,30 @@ void AngleStudy::receive(void * data)
 				Renderer::getInstance().showMessage(msg);
 			}
 
-			if (eventData[1] == GLFW_KEY_F9)
+			if (ev.code == GLFW_KEY_F9)
 			{
-				if (!m_SocketFuture.valid())
+				if (m_pMotorClient->getState() != MotorControlClient::DISCONNECTED && m_pMotorClient->getServer() == m_strServerAddress && m_pMotorClient->getPort() == static_cast<int>(m_uiServerPort))
 				{
-					Renderer::getInstance().showMessage("Connecting to " + m_strServerAddress + " port " + std::to_string(m_uiServerPort));
-					m_SocketFuture = std::async(std::launch::async, &WinsockClient::connect, m_pSocket, m_strServerAddress, m_uiServerPort);
+					Renderer::getInstance().showMessage("Already connected or connecting to " + m_strServerAddress + " port " + std::to_string(m_uiServerPort));
 				}
 				else
 				{
-					Renderer::getInstance().showMessage("Already attempting connection with " + m_strServerAddress + " port " + std::to_string(m_uiServerPort));
+					Renderer::getInstance().showMessage("Connecting to " + m_strServerAddress + " port " + std::to_string(m_uiServerPort));
+					m_pMotorClient->connect(m_strServerAddress, m_uiServerPort);
 				}
 			}
 
-			if (eventData[1] == GLFW_KEY_F10)
+			if (ev.code == GLFW_KEY_F10)
 			{
 				m_bShowDiagram = !m_bShowDiagram;
 			}
 
-			if (eventData[1] == GLFW_KEY_I)
+			if (ev.code == GLFW_KEY_I)
 			{
 				m_bDisplayCondition = !m_bDisplayCondition;
 			}
 
-			if (eventData[1] == GLFW_KEY_X)
+			if (ev.code == GLFW_KEY_X)
 			{
 				glm::mat4 m_mat4ScreenBasisOrtho = glm::mat4(
 					glm::normalize(m_mat4Screen[0]),
@@ -766,10 +775,11 @@ void AngleStudy::receive(void * data)
 				glm::vec3 rightEyePos = (glm::rotate(glm::mat4(), glm::radians(m_fViewAngle + viewAngleOffset), glm::vec3(m_mat4ScreenBasisOrtho[1])) * glm::translate(m_mat4ScreenBasisOrtho, glm::vec3(0.f, 0.f, m_fViewDist)))[3];
 
 				//m_vec3DistortedGridPoints.clear();
-				m_vec3DistortedGridPoints = distutil::transformStereoscopicPoints(copLeft, copRight, leftEyePos, rightEyePos, glm::vec3(m_mat4ScreenBasisOrtho[3]), glm::normalize(glm::vec3(m_mat4ScreenBasisOrtho[2])), m_vec3GridPoints);
+				m_vec3DistortedGridPoints.resize(m_vec3GridPoints.size());
+				distutil::transformStereoscopicPoints(copLeft, copRight, leftEyePos, rightEyePos, glm::vec3(m_mat4ScreenBasisOrtho[3]), glm::normalize(glm::vec3(m_mat4ScreenBasisOrtho[2])), m_vec3GridPoints.data(), m_vec3GridPoints.size(), m_vec3DistortedGridPoints.data());
 
 				m_fMaxDistortionMag = 0.f;
-				for (int i = 0; i < m_vec3DistortedGridPoints.size(); ++i)
+				for (size_t i = 0; i < m_vec3DistortedGridPoints.size(); ++i)
 				{
 					float len = glm::length(m_vec3DistortedGridPoints[i] - m_vec3GridPoints[i]);
 					if (len > m_fMaxDistortionMag)
@@ -780,67 +790,67 @@ void AngleStudy::receive(void * data)
 		}
 	}
 
-	if (eventData[0] == GLFWInputBroadcaster::EVENT::KEY_DOWN || eventData[0] == GLFWInputBroadcaster::EVENT::KEY_HOLD)
+	if (ev.type == GLFWInputBroadcaster::EVENT::KEY_DOWN || ev.type == GLFWInputBroadcaster::EVENT::KEY_HOLD)
 	{
 		float angleDelta = 1.f;
 		float distDelta = 1.f;
 
 		if (!m_bStudyMode)
 		{
-			if (eventData[1] == GLFW_KEY_LEFT)
+			if (ev.code == GLFW_KEY_LEFT)
 			{
 				m_pHinge->setAngle(m_pHinge->getAngle() + 1.f);
 			}
-			if (eventData[1] == GLFW_KEY_RIGHT)
+			if (ev.code == GLFW_KEY_RIGHT)
 			{
 				m_pHinge->setAngle(m_pHinge->getAngle() - 1.f);
 			}
 
-			if (eventData[1] == GLFW_KEY_KP_4)
+			if (ev.code == GLFW_KEY_KP_4)
 			{
 				m_Vector.angle += 1.f;
 			}
-			if (eventData[1] == GLFW_KEY_KP_6)
+			if (ev.code == GLFW_KEY_KP_6)
 			{
 				m_Vector.angle -= 1.f;
 			}
-			if (eventData[1] == GLFW_KEY_KP_8)
+			if (ev.code == GLFW_KEY_KP_8)
 			{
 				m_Vector.length += 0.1f;
 			}
-			if (eventData[1] == GLFW_KEY_KP_2)
+			if (ev.code == GLFW_KEY_KP_2)
 			{
 				m_Vector.length = std::max(m_Vector.length - 0.1f, 0.1f);
 			}
 
-			if (eventData[1] == GLFW_KEY_UP)
+			if (ev.code == GLFW_KEY_UP)
 				m_MeasuringRod.length += 0.1f;
-			if (eventData[1] == GLFW_KEY_DOWN)
+			if (ev.code == GLFW_KEY_DOWN)
 				m_MeasuringRod.length = std::max(m_MeasuringRod.length - 0.1f, 0.1f);
 
-			if (eventData[1] == GLFW_KEY_LEFT_BRACKET)
+			if (ev.code == GLFW_KEY_LEFT_BRACKET)
 				m_fCOPAngle -= angleDelta;
-			if (eventData[1] == GLFW_KEY_RIGHT_BRACKET)
+			if (ev.code == GLFW_KEY_RIGHT_BRACKET)
 				m_fCOPAngle += angleDelta;
 
-			if (eventData[1] == GLFW_KEY_KP_SUBTRACT)
+			if (ev.code == GLFW_KEY_KP_SUBTRACT)
 				m_fCOPDist = std::max(m_fCOPDist - distDelta, 0.f);
-			if (eventData[1] == GLFW_KEY_KP_ADD)
+			if (ev.code == GLFW_KEY_KP_ADD)
 				m_fCOPDist += distDelta;
 
-			if (eventData[1] == GLFW_KEY_MINUS)
+			if (ev.code == GLFW_KEY_MINUS)
 				m_pDiagram->setEyeSeparation(m_pDiagram->getEyeSeparation() - 0.1f);
-			if (eventData[1] == GLFW_KEY_EQUAL)
+			if (ev.code == GLFW_KEY_EQUAL)
 				m_pDiagram->setEyeSeparation(m_pDiagram->getEyeSeparation() + 0.1f);
 
-			if (eventData[1] == GLFW_KEY_9)
+			if (ev.code == GLFW_KEY_9)
 				m_pDiagram->setViewDistance(m_pDiagram->getViewDistance() - 0.1f);
-			if (eventData[1] == GLFW_KEY_0)
+			if (ev.code == GLFW_KEY_0)
 				m_pDiagram->setViewDistance(m_pDiagram->getViewDistance() + 0.1f);
 
-			if (eventData[1] == GLFW_KEY_COMMA)
+			if (ev.code == GLFW_KEY_COMMA)
 				m_pDiagram->setProjectionAngle(m_pDiagram->getProjectionAngle() - 1.f);
-			if (eventData[1] == GLFW_KEY_PERIOD)
+			if (ev.code == GLFW_KEY_PERIOD)
 				m_pDiagram->setProjectionAngle(m_pDiagram->getProjectionAngle() + 1.f);
 		}
 	}
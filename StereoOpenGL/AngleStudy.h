@@ -1,6 +1,6 @@
 #pragma once
 
-#include "WinsockClient.h"
+#include "MotorControlClient.h"
 #include "GLFWInputBroadcaster.h"
 #include "Hinge.h"
 #include "ViewingConditionsDiagram.h"
@@ -8,7 +8,6 @@
 #include <glm.hpp>
 #include <chrono>
 #include <random>
-#include <future>
 
 #define STUDYPARAM_DECIMAL	1 << 0
 #define STUDYPARAM_POSNEG	1 << 1
@@ -76,8 +75,9 @@ private:
 	std::vector<glm::vec3> m_vec3DistortedGridPoints;
 	float m_fMaxDistortionMag;
 
-	std::future<bool> m_SocketFuture;
-	WinsockClient* m_pSocket;
+	MotorControlClient* m_pMotorClient;
+	unsigned int m_uiMoveCommandID;
+	bool m_bMotorFailureReported;
 	Hinge* m_pHinge;
 	Rod m_Vector;
 	Rod m_MeasuringRod;
@@ -140,6 +140,7 @@ private:
 	void writeToLog(StudyResponse response);
 	void loadCondition(StudyCondition &c);
 	bool moveScreen(float viewAngle, bool forceMove = false);
-	void receive(void* data);
+	void onMotorStateChange(MotorControlClient::ConnectionState state);
+	void receive(const InputEvent &ev);
 };
 
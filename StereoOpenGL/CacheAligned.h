@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <stdlib.h>
+#endif
+
+#define CACHEALIGNED_BYTES	64	// alignment of the lock-free queues' cache-line separated members
+
+// Base for classes that hold alignas(CACHEALIGNED_BYTES) members (SPSCQueue, MPMCQueue) and are
+// created with new. Before C++17 operator new only guarantees alignof(std::max_align_t), so
+// such objects would be under-aligned on the heap; this allocates them aligned instead.
+struct CacheAligned
+{
+	static void* operator new(size_t size)
+	{
+		void *p = allocate(size);
+		if (!p)
+			throw std::bad_alloc();
+		return p;
+	}
+
+	static void* operator new[](size_t size) { return operator new(size); }
+
+	static void operator delete(void *p) { release(p); }
+	static void operator delete[](void *p) { release(p); }
+
+private:
+	static void* allocate(size_t size)
+	{
+#ifdef _WIN32
+		return _aligned_malloc(size, CACHEALIGNED_BYTES);
+#else
+		void *p = NULL;
+		return posix_memalign(&p, CACHEALIGNED_BYTES, size) == 0 ? p : NULL;
+#endif
+	}
+
+	static void release(void *p)
+	{
+#ifdef _WIN32
+		_aligned_free(p);
+#else
+		free(p);
+#endif
+	}
+};
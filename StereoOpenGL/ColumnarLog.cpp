@@ -0,0 +1,394 @@
+#include "ColumnarLog.h"
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+
+unsigned int ColumnarLog::typeSize(ColumnType type)
+{
+	switch (type)
+	{
+	case INT32:
+	case UINT32:
+	case FLOAT32:
+	case CATEGORY:
+		return 4u;
+	case INT64:
+	case UINT64:
+	case FLOAT64:
+		return 8u;
+	case BOOL8:
+		return 1u;
+	default:
+		return 0u;
+	}
+}
+
+const char* ColumnarLog::typeName(ColumnType type)
+{
+	switch (type)
+	{
+	case INT32:		return "int32";
+	case UINT32:	return "uint32";
+	case INT64:		return "int64";
+	case UINT64:	return "uint64";
+	case FLOAT32:	return "float32";
+	case FLOAT64:	return "float64";
+	case BOOL8:		return "bool8";
+	case CATEGORY:	return "category";
+	default:		return "unknown";
+	}
+}
+
+namespace
+{
+	struct CRC32Table {
+		uint32_t entries[256];
+
+		CRC32Table()
+		{
+			for (uint32_t i = 0u; i < 256u; ++i)
+			{
+				uint32_t c = i;
+				for (int k = 0; k < 8; ++k)
+					c = (c & 1u) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				entries[i] = c;
+			}
+		}
+	};
+}
+
+// standard CRC-32 (IEEE 802.3 polynomial, reflected)
+uint32_t ColumnarLog::checksum(const void* data, size_t length, uint32_t crc)
+{
+	// the writer and readers can run on different threads; a local static is initialized exactly once
+	static const CRC32Table s_Table;
+
+	const unsigned char* p = static_cast<const unsigned char*>(data);
+
+	crc = ~crc;
+	for (size_t i = 0u; i < length; ++i)
+		crc = s_Table.entries[(crc ^ p[i]) & 0xFFu] ^ (crc >> 8);
+
+	return ~crc;
+}
+
+ColumnarLog::ColumnarLog()
+	: m_uiBlockRows(0u)
+	, m_nBlockBytes(0u)
+	, m_nBlockOffset(0u)
+	, m_uiRowInBlock(0u)
+	, m_nRows(0ull)
+	, m_nDictionaryBytes(0u)
+{
+}
+
+ColumnarLog::~ColumnarLog()
+{
+	close();
+}
+
+unsigned int ColumnarLog::addColumn(std::string name, ColumnType type)
+{
+	if (isOpen())
+	{
+		std::cerr << "ColumnarLog: cannot add column \"" << name << "\" to an open log" << std::endl;
+		return static_cast<unsigned int>(-1);
+	}
+
+	Column col;
+	col.name = name;
+	col.type = type;
+	col.offset = 0u;
+	m_vColumns.push_back(col);
+
+	return static_cast<unsigned int>(m_vColumns.size() - 1u);
+}
+
+void ColumnarLog::clearColumns()
+{
+	if (!isOpen())
+		m_vColumns.clear();
+}
+
+bool ColumnarLog::open(std::string path, unsigned int blockRows)
+{
+	close();
+
+	if (m_vColumns.size() == 0u)
+	{
+		std::cerr << "ColumnarLog: no columns defined for " << path << std::endl;
+		return false;
+	}
+
+	// a multiple of 8 rows keeps every column array 8-byte aligned
+	m_uiBlockRows = (blockRows + 7u) & ~7u;
+	if (m_uiBlockRows == 0u)
+		m_uiBlockRows = 8u;
+
+	size_t headerBytes = sizeof(ColumnarFileHeader);
+	size_t payloadBytes = 0u;
+	for (auto &col : m_vColumns)
+	{
+		headerBytes += 4u + col.name.length();
+		col.offset = payloadBytes;
+		col.categoryCodes.clear();
+		col.categoryLabels.clear();
+		payloadBytes += m_uiBlockRows * typeSize(col.type);
+	}
+	headerBytes = (headerBytes + 7u) & ~static_cast<size_t>(7u);
+
+	m_nBlockBytes = sizeof(ColumnarBlockHeader) + payloadBytes;
+
+	size_t initialSize = headerBytes + m_nBlockBytes;
+	if (initialSize < COLUMNARLOG_GROW_BYTES)
+		initialSize = COLUMNARLOG_GROW_BYTES;
+
+	if (!m_File.create(path, initialSize))
+		return false;
+
+	unsigned char* p = m_File.data();
+
+	ColumnarFileHeader header;
+	memcpy(header.magic, COLUMNARLOG_MAGIC, sizeof(header.magic));
+	header.version = COLUMNARLOG_VERSION;
+	header.columnCount = static_cast<uint32_t>(m_vColumns.size());
+	header.blockRows = m_uiBlockRows;
+	header.headerBytes = static_cast<uint32_t>(headerBytes);
+	memcpy(p, &header, sizeof(header));
+	p += sizeof(header);
+
+	for (auto const &col : m_vColumns)
+	{
+		uint16_t nameLength = static_cast<uint16_t>(col.name.length());
+		p[0] = col.type;
+		p[1] = 0u;
+		memcpy(p + 2, &nameLength, sizeof(nameLength));
+		memcpy(p + 4, col.name.data(), nameLength);
+		p += 4u + nameLength;
+	}
+
+	m_nBlockOffset = headerBytes;
+	m_uiRowInBlock = 0u;
+	m_nRows = 0ull;
+	m_nDictionaryBytes = 0u;
+
+	return beginBlock();
+}
+
+void ColumnarLog::close()
+{
+	if (!isOpen())
+		return;
+
+	// a block with no rows in it is dropped
+	if (m_uiRowInBlock > 0u)
+		sealBlock();
+
+	writeDictionary();
+
+	m_File.close(m_nBlockOffset);
+}
+
+void ColumnarLog::set(unsigned int col, int val)				{ store(col, val); }
+void ColumnarLog::set(unsigned int col, unsigned int val)		{ store(col, val); }
+void ColumnarLog::set(unsigned int col, long long val)			{ store(col, val); }
+void ColumnarLog::set(unsigned int col, unsigned long long val)	{ store(col, val); }
+void ColumnarLog::set(unsigned int col, float val)				{ store(col, val); }
+void ColumnarLog::set(unsigned int col, double val)				{ store(col, val); }
+void ColumnarLog::set(unsigned int col, bool val)				{ store(col, val); }
+void ColumnarLog::set(unsigned int col, const std::string &val)	{ set(col, val.data(), val.length()); }
+void ColumnarLog::set(unsigned int col, const char* val)		{ set(col, val, strlen(val)); }
+
+void ColumnarLog::set(unsigned int col, const char* val, size_t length)
+{
+	if (!isOpen() || col >= m_vColumns.size())
+		return;
+
+	Column &c = m_vColumns[col];
+
+	// the text is looked up through a reused string, so only new labels allocate
+	m_strLookup.assign(val, length);
+
+	if (c.type != CATEGORY)
+	{
+		store(col, strtod(m_strLookup.c_str(), NULL));
+		return;
+	}
+
+	auto it = c.categoryCodes.find(m_strLookup);
+	uint32_t code;
+	if (it == c.categoryCodes.end())
+	{
+		size_t dictionaryBytes = (m_nDictionaryBytes == 0u ? sizeof(ColumnarBlockHeader) : m_nDictionaryBytes) + 4u + length;
+		if (!reserve(dictionaryBytes))
+		{
+			// the labels of every committed row still fit in the space reserved so far
+			std::cerr << "ColumnarLog: could not grow log file for category labels; closing it" << std::endl;
+			close();
+			return;
+		}
+		m_nDictionaryBytes = dictionaryBytes;
+
+		code = static_cast<uint32_t>(c.categoryLabels.size());
+		c.categoryCodes[m_strLookup] = code;
+		c.categoryLabels.push_back(m_strLookup);
+	}
+	else
+		code = it->second;
+
+	store(col, code);
+}
+
+template <typename T>
+void ColumnarLog::store(unsigned int col, T val)
+{
+	if (!isOpen() || col >= m_vColumns.size())
+		return;
+
+	Column const &c = m_vColumns[col];
+	unsigned char* dst = m_File.data() + m_nBlockOffset + sizeof(ColumnarBlockHeader) + c.offset + m_uiRowInBlock * typeSize(c.type);
+
+	switch (c.type)
+	{
+	case INT32:		{ int32_t v = static_cast<int32_t>(val); memcpy(dst, &v, sizeof(v)); break; }
+	case UINT32:
+	case CATEGORY:	{ uint32_t v = static_cast<uint32_t>(val); memcpy(dst, &v, sizeof(v)); break; }
+	case INT64:		{ int64_t v = static_cast<int64_t>(val); memcpy(dst, &v, sizeof(v)); break; }
+	case UINT64:	{ uint64_t v = static_cast<uint64_t>(val); memcpy(dst, &v, sizeof(v)); break; }
+	case FLOAT32:	{ float v = static_cast<float>(val); memcpy(dst, &v, sizeof(v)); break; }
+	case FLOAT64:	{ double v = static_cast<double>(val); memcpy(dst, &v, sizeof(v)); break; }
+	case BOOL8:		{ *dst = val ? 1u : 0u; break; }
+	}
+}
+
+void ColumnarLog::commitRow()
+{
+	if (!isOpen())
+		return;
+
+	++m_uiRowInBlock;
+	++m_nRows;
+
+	// keep the row count on disk current so a crashed session is still readable
+	ColumnarBlockHeader* header = reinterpret_cast<ColumnarBlockHeader*>(m_File.data() + m_nBlockOffset);
+	header->rowCount = m_uiRowInBlock;
+
+	if (m_uiRowInBlock == m_uiBlockRows)
+	{
+		sealBlock();
+		beginBlock();
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Makes room for the current block plus a dictionary of the given
+//			size after it, so a log that cannot grow any further can still be
+//			closed with its category labels
+//-----------------------------------------------------------------------------
+bool ColumnarLog::reserve(size_t dictionaryBytes)
+{
+	size_t needed = m_nBlockOffset + m_nBlockBytes + ((dictionaryBytes + 7u) & ~static_cast<size_t>(7u));
+	if (needed <= m_File.size())
+		return true;
+
+	size_t grow = needed - m_File.size() > COLUMNARLOG_GROW_BYTES ? needed - m_File.size() : COLUMNARLOG_GROW_BYTES;
+
+	return m_File.resize(m_File.size() + grow);
+}
+
+bool ColumnarLog::beginBlock()
+{
+	if (!reserve(m_nDictionaryBytes))
+	{
+		// nothing is in the new block yet, so this just writes the dictionary into the reserved tail
+		std::cerr << "ColumnarLog: could not grow log file; closing it" << std::endl;
+		close();
+		return false;
+	}
+
+	ColumnarBlockHeader header;
+	header.magic = COLUMNARLOG_BLOCK_MAGIC;
+	header.rowCount = 0u;
+	header.checksum = 0u;
+	header.flags = 0u;
+	memcpy(m_File.data() + m_nBlockOffset, &header, sizeof(header));
+
+	m_uiRowInBlock = 0u;
+
+	return true;
+}
+
+void ColumnarLog::sealBlock()
+{
+	unsigned char* block = m_File.data() + m_nBlockOffset;
+	ColumnarBlockHeader* header = reinterpret_cast<ColumnarBlockHeader*>(block);
+
+	uint32_t crc = 0u;
+	for (auto const &col : m_vColumns)
+		crc = checksum(block + sizeof(ColumnarBlockHeader) + col.offset, m_uiRowInBlock * typeSize(col.type), crc);
+
+	header->checksum = crc;
+	header->flags |= COLUMNARLOG_BLOCK_SEALED;
+
+	// only the sealed block is handed to the OS, so the cost stays per block rather than per file
+	m_File.flush(m_nBlockOffset, m_nBlockBytes);
+
+	m_nBlockOffset += m_nBlockBytes;
+	m_uiRowInBlock = 0u;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Appends the category label tables after the last block. Codes are
+//			assigned in first-seen order, so entries are written in code order.
+//-----------------------------------------------------------------------------
+void ColumnarLog::writeDictionary()
+{
+	uint32_t entries = 0u;
+	size_t bytes = sizeof(ColumnarBlockHeader);
+
+	for (auto const &col : m_vColumns)
+	{
+		entries += static_cast<uint32_t>(col.categoryLabels.size());
+		for (auto const &label : col.categoryLabels)
+			bytes += 4u + label.length();
+	}
+
+	if (entries == 0u)
+		return;
+
+	bytes = (bytes + 7u) & ~static_cast<size_t>(7u);
+
+	if (m_nBlockOffset + bytes > m_File.size() && !m_File.resize(m_nBlockOffset + bytes))
+	{
+		std::cerr << "ColumnarLog: could not write category labels" << std::endl;
+		return;
+	}
+
+	unsigned char* dict = m_File.data() + m_nBlockOffset;
+	unsigned char* p = dict + sizeof(ColumnarBlockHeader);
+
+	for (size_t i = 0u; i < m_vColumns.size(); ++i)
+	{
+		for (auto const &label : m_vColumns[i].categoryLabels)
+		{
+			uint16_t column = static_cast<uint16_t>(i);
+			uint16_t length = static_cast<uint16_t>(label.length());
+			memcpy(p, &column, sizeof(column));
+			memcpy(p + 2, &length, sizeof(length));
+			memcpy(p + 4, label.data(), length);
+			p += 4u + length;
+		}
+	}
+
+	memset(p, 0, dict + bytes - p);
+
+	ColumnarBlockHeader header;
+	header.magic = COLUMNARLOG_DICT_MAGIC;
+	header.rowCount = entries;
+	header.checksum = checksum(dict + sizeof(ColumnarBlockHeader), bytes - sizeof(ColumnarBlockHeader));
+	header.flags = COLUMNARLOG_BLOCK_SEALED;
+	memcpy(dict, &header, sizeof(header));
+
+	m_nBlockOffset += bytes;
+}
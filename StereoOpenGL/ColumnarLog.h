@@ -0,0 +1,134 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#define COLUMNARLOG_MAGIC				"SOGLCOL1"
+#define COLUMNARLOG_VERSION				1u
+#define COLUMNARLOG_BLOCK_MAGIC			0x4B434C42u	// "BLCK"
+#define COLUMNARLOG_DICT_MAGIC			0x54434944u	// "DICT"
+#define COLUMNARLOG_BLOCK_SEALED		1u
+#define COLUMNARLOG_DEFAULT_BLOCK_ROWS	1024u
+#define COLUMNARLOG_GROW_BYTES			(16u << 20)
+
+// On-disk layout (little-endian):
+//   ColumnarFileHeader
+//   column descriptors: { uint8 type, uint8 reserved, uint16 nameLength, char name[nameLength] }, padded to 8 bytes
+//   blocks: ColumnarBlockHeader followed by one array of blockRows values per column, in column order.
+//           Every block reserves room for blockRows rows; rowCount says how many are valid.
+//           Sealed blocks carry a CRC-32 of the valid values of each column, taken in column order.
+//   optional dictionary: ColumnarBlockHeader with the DICT magic and rowCount = number of entries, then
+//           { uint16 column, uint16 length, char label[length] } per entry, padded to 8 bytes. Entries
+//           for a CATEGORY column are listed in code order. The checksum covers the entries.
+struct ColumnarFileHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t columnCount;
+	uint32_t blockRows;
+	uint32_t headerBytes;
+};
+
+struct ColumnarBlockHeader {
+	uint32_t magic;
+	uint32_t rowCount;
+	uint32_t checksum;
+	uint32_t flags;
+};
+
+// Append-only typed columnar log, written straight into a memory-mapped file.
+// Declare the columns, open the file, then set() each column and commitRow() once per sample.
+class ColumnarLog
+{
+public:
+	enum ColumnType : uint8_t {
+		INT32,
+		UINT32,
+		INT64,
+		UINT64,
+		FLOAT32,
+		FLOAT64,
+		BOOL8,
+		CATEGORY	// uint32 code into a per-column table of text labels
+	};
+
+	static unsigned int typeSize(ColumnType type);
+	static const char* typeName(ColumnType type);
+
+	static uint32_t checksum(const void* data, size_t length, uint32_t crc = 0u);
+
+	ColumnarLog();
+	~ColumnarLog();
+
+	// columns can only be changed while the log is closed; returns the column index
+	unsigned int addColumn(std::string name, ColumnType type);
+	void clearColumns();
+
+	bool open(std::string path, unsigned int blockRows = COLUMNARLOG_DEFAULT_BLOCK_ROWS);
+	void close();
+	bool isOpen() const { return m_File.isOpen(); }
+
+	// values are converted to the column's declared type
+	void set(unsigned int col, int val);
+	void set(unsigned int col, unsigned int val);
+	void set(unsigned int col, long long val);
+	void set(unsigned int col, unsigned long long val);
+	void set(unsigned int col, float val);
+	void set(unsigned int col, double val);
+	void set(unsigned int col, bool val);
+	void set(unsigned int col, const char* val);
+	void set(unsigned int col, const std::string &val);
+	// text that need not be null-terminated
+	void set(unsigned int col, const char* val, size_t length);
+
+	void commitRow();
+
+	unsigned long long rowCount() const { return m_nRows; }
+
+private:
+	struct Column {
+		std::string name;
+		ColumnType type;
+		size_t offset; // from the start of the block payload
+		std::unordered_map<std::string, uint32_t> categoryCodes;
+		std::vector<std::string> categoryLabels;
+	};
+
+	std::vector<Column> m_vColumns;
+
+	MappedFile m_File;
+
+	unsigned int m_uiBlockRows;
+	size_t m_nBlockBytes;
+	size_t m_nBlockOffset;
+	unsigned int m_uiRowInBlock;
+	unsigned long long m_nRows;
+	size_t m_nDictionaryBytes;	// what writeDictionary() would append now; always kept free past the current block
+
+	std::string m_strLookup;	// scratch for set() with text
+
+	template <typename T>
+	void store(unsigned int col, T val);
+
+	bool reserve(size_t dictionaryBytes);
+	bool beginBlock();
+	void sealBlock();
+	void writeDictionary();
+
+public:
+	ColumnarLog(ColumnarLog const&) = delete;
+	void operator=(ColumnarLog const&) = delete;
+};
+
+// maps C++ value types to the column type they are stored as
+template <typename T> struct ColumnTypeOf;
+template <> struct ColumnTypeOf<int32_t> { static const ColumnarLog::ColumnType value = ColumnarLog::INT32; };
+template <> struct ColumnTypeOf<uint32_t> { static const ColumnarLog::ColumnType value = ColumnarLog::UINT32; };
+template <> struct ColumnTypeOf<int64_t> { static const ColumnarLog::ColumnType value = ColumnarLog::INT64; };
+template <> struct ColumnTypeOf<uint64_t> { static const ColumnarLog::ColumnType value = ColumnarLog::UINT64; };
+template <> struct ColumnTypeOf<float> { static const ColumnarLog::ColumnType value = ColumnarLog::FLOAT32; };
+template <> struct ColumnTypeOf<double> { static const ColumnarLog::ColumnType value = ColumnarLog::FLOAT64; };
+template <> struct ColumnTypeOf<uint8_t> { static const ColumnarLog::ColumnType value = ColumnarLog::BOOL8; };
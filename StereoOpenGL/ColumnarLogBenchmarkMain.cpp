@@ -0,0 +1,252 @@
+#include "ColumnarLogReader.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <experimental/filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std::experimental::filesystem::v1;
+
+// Compares loading trial logs as CSV against loading the same data from a ColumnarLog file.
+// Each CSV is converted once (numeric columns become float64, anything else a category),
+// then both forms are loaded repeatedly and every value is touched.
+//
+// usage: ColumnarLogBenchmark [logs directory or .csv files...] [-n iterations]
+
+struct CSVTable {
+	std::vector<std::string> names;
+	std::vector<std::vector<std::string>> cells; // [column][row]
+};
+
+static std::vector<std::string> splitCSVLine(const std::string &line)
+{
+	std::vector<std::string> fields;
+	std::stringstream ss(line);
+	std::string field;
+	while (std::getline(ss, field, ','))
+		fields.push_back(field);
+
+	return fields;
+}
+
+static bool isNumber(const std::string &s)
+{
+	if (s.empty())
+		return false;
+
+	char* end;
+	strtod(s.c_str(), &end);
+
+	return *end == '\0';
+}
+
+static bool readCSVTable(std::string path, CSVTable &table)
+{
+	std::ifstream in(path);
+	std::string line;
+
+	if (!std::getline(in, line))
+		return false;
+
+	table.names = splitCSVLine(line);
+	table.cells.assign(table.names.size(), std::vector<std::string>());
+
+	// older logs end every row with a stray comma, so extra fields are ignored
+	while (std::getline(in, line))
+	{
+		std::vector<std::string> fields = splitCSVLine(line);
+		for (size_t c = 0u; c < table.names.size(); ++c)
+			table.cells[c].push_back(c < fields.size() ? fields[c] : std::string());
+	}
+
+	return true;
+}
+
+static bool convertToColumnar(CSVTable const &table, std::string path)
+{
+	ColumnarLog log;
+	std::vector<bool> numeric;
+
+	for (size_t c = 0u; c < table.names.size(); ++c)
+	{
+		bool allNumbers = true;
+		for (auto const &cell : table.cells[c])
+			allNumbers &= isNumber(cell);
+
+		numeric.push_back(allNumbers);
+		log.addColumn(table.names[c], allNumbers ? ColumnarLog::FLOAT64 : ColumnarLog::CATEGORY);
+	}
+
+	// trial logs are a few hundred rows, so keep blocks small like DataLogger does
+	if (!log.open(path, 128u))
+		return false;
+
+	size_t rows = table.cells.empty() ? 0u : table.cells[0].size();
+	for (size_t r = 0u; r < rows; ++r)
+	{
+		for (unsigned int c = 0u; c < table.names.size(); ++c)
+		{
+			if (numeric[c])
+				log.set(c, strtod(table.cells[c][r].c_str(), NULL));
+			else
+				log.set(c, table.cells[c][r]);
+		}
+		log.commitRow();
+	}
+
+	log.close();
+
+	return true;
+}
+
+// the usual analysis-script load: split every line and convert every numeric field
+static double loadCSV(std::string path, size_t &rows)
+{
+	std::ifstream in(path);
+	std::string line;
+	std::getline(in, line);
+
+	size_t columns = splitCSVLine(line).size();
+	std::vector<std::vector<double>> values(columns);
+	std::vector<std::vector<std::string>> labels(columns);
+
+	rows = 0u;
+	while (std::getline(in, line))
+	{
+		std::vector<std::string> fields = splitCSVLine(line);
+		for (size_t c = 0u; c < columns && c < fields.size(); ++c)
+		{
+			char* end;
+			double v = strtod(fields[c].c_str(), &end);
+			if (*end == '\0' && !fields[c].empty())
+				values[c].push_back(v);
+			else
+				labels[c].push_back(fields[c]);
+		}
+		++rows;
+	}
+
+	double sum = 0.0;
+	for (auto const &col : values)
+		for (double v : col)
+			sum += v;
+
+	return sum;
+}
+
+static double loadColumnar(std::string path, size_t &rows)
+{
+	ColumnarLogReader reader;
+	if (!reader.open(path))
+		return 0.0;
+
+	double sum = 0.0;
+	for (size_t b = 0u; b < reader.blockCount(); ++b)
+	{
+		for (unsigned int c = 0u; c < reader.columnCount(); ++c)
+		{
+			ColumnSpan<double> span = reader.span<double>(b, c);
+			for (double v : span)
+				sum += v;
+		}
+	}
+
+	rows = static_cast<size_t>(reader.rowCount());
+
+	return sum;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose:
+//-----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+	std::vector<std::string> csvFiles;
+	int iterations = 200;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg(argv[i]);
+
+		if (arg == "-n" && i + 1 < argc)
+			iterations = atoi(argv[++i]);
+		else if (is_directory(arg))
+		{
+			for (auto &entry : directory_iterator(arg))
+				if (entry.path().extension() == ".csv")
+					csvFiles.push_back(entry.path().string());
+		}
+		else
+			csvFiles.push_back(arg);
+	}
+
+	if (csvFiles.empty())
+		for (auto &entry : directory_iterator("logs"))
+			if (entry.path().extension() == ".csv")
+				csvFiles.push_back(entry.path().string());
+
+	if (iterations < 1)
+		iterations = 1;
+
+	using clock = std::chrono::high_resolution_clock;
+
+	double totalCSV = 0.0, totalCol = 0.0;
+	unsigned long long totalCSVBytes = 0ull, totalColBytes = 0ull;
+
+	printf("%-48s %8s %10s %10s %10s %8s\n", "log", "rows", "csv ms", "col ms", "col KB", "speedup");
+
+	for (auto const &csvPath : csvFiles)
+	{
+		CSVTable table;
+		if (!readCSVTable(csvPath, table))
+		{
+			printf("Could not read %s\n", csvPath.c_str());
+			continue;
+		}
+
+		std::string colPath = csvPath + ".bench.col";
+		if (!convertToColumnar(table, colPath))
+			continue;
+
+		size_t csvRows = 0u, colRows = 0u;
+		double csvSum = 0.0, colSum = 0.0;
+
+		auto t0 = clock::now();
+		for (int i = 0; i < iterations; ++i)
+			csvSum = loadCSV(csvPath, csvRows);
+		auto t1 = clock::now();
+		for (int i = 0; i < iterations; ++i)
+			colSum = loadColumnar(colPath, colRows);
+		auto t2 = clock::now();
+
+		double csvMS = std::chrono::duration<double, std::milli>(t1 - t0).count() / iterations;
+		double colMS = std::chrono::duration<double, std::milli>(t2 - t1).count() / iterations;
+
+		unsigned long long csvBytes = file_size(csvPath);
+		unsigned long long colBytes = file_size(colPath);
+
+		printf("%-48s %8zu %10.3f %10.3f %10.1f %7.1fx%s\n",
+			path(csvPath).filename().string().c_str(), colRows, csvMS, colMS, colBytes / 1024.0, csvMS / colMS,
+			(csvRows != colRows || fabs(csvSum - colSum) > 1e-9 * fabs(csvSum)) ? "  (MISMATCH)" : "");
+
+		totalCSV += csvMS;
+		totalCol += colMS;
+		totalCSVBytes += csvBytes;
+		totalColBytes += colBytes;
+
+		remove(colPath);
+	}
+
+	if (totalCol > 0.0)
+		printf("\nTotal: csv %.3f ms (%.1f MB/s, %llu KB), columnar %.3f ms (%.1f MB/s of equivalent CSV, %llu KB), %.1fx faster\n",
+			totalCSV, totalCSVBytes / (totalCSV * 1000.0), totalCSVBytes / 1024ull,
+			totalCol, totalCSVBytes / (totalCol * 1000.0), totalColBytes / 1024ull,
+			totalCSV / totalCol);
+
+	return 0;
+}
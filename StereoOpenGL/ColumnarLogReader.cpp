@@ -0,0 +1,199 @@
+#include "ColumnarLogReader.h"
+
+#include <iostream>
+#include <cstring>
+
+ColumnarLogReader::ColumnarLogReader()
+	: m_uiBlockRows(0u)
+	, m_nRows(0ull)
+	, m_nCorruptBlocks(0u)
+{
+}
+
+ColumnarLogReader::~ColumnarLogReader()
+{
+	close();
+}
+
+bool ColumnarLogReader::open(std::string path, bool verifyChecksums)
+{
+	close();
+
+	if (!m_File.openRead(path))
+		return false;
+
+	const unsigned char* base = m_File.data();
+	size_t size = m_File.size();
+
+	ColumnarFileHeader header;
+	if (size < sizeof(header))
+	{
+		std::cerr << "ColumnarLogReader: " << path << " is too small to be a columnar log" << std::endl;
+		close();
+		return false;
+	}
+
+	memcpy(&header, base, sizeof(header));
+
+	if (memcmp(header.magic, COLUMNARLOG_MAGIC, sizeof(header.magic)) != 0 || header.version != COLUMNARLOG_VERSION)
+	{
+		std::cerr << "ColumnarLogReader: " << path << " is not a version " << COLUMNARLOG_VERSION << " columnar log" << std::endl;
+		close();
+		return false;
+	}
+
+	if (header.headerBytes > size || header.headerBytes < sizeof(header) || header.blockRows == 0u)
+	{
+		std::cerr << "ColumnarLogReader: " << path << " has a corrupt header" << std::endl;
+		close();
+		return false;
+	}
+
+	m_uiBlockRows = header.blockRows;
+
+	const unsigned char* p = base + sizeof(header);
+	const unsigned char* headerEnd = base + header.headerBytes;
+	size_t payloadBytes = 0u;
+
+	for (uint32_t i = 0u; i < header.columnCount; ++i)
+	{
+		// every entry and its name must lie inside the header, and name a known type
+		uint16_t nameLength = 0u;
+		if (headerEnd - p >= 4)
+			memcpy(&nameLength, p + 2, sizeof(nameLength));
+
+		if (headerEnd - p < 4 || headerEnd - (p + 4) < nameLength || ColumnarLog::typeSize(static_cast<ColumnarLog::ColumnType>(p[0])) == 0u)
+		{
+			std::cerr << "ColumnarLogReader: " << path << " has a truncated or corrupt column table" << std::endl;
+			close();
+			return false;
+		}
+
+		ColumnInfo col;
+		col.type = static_cast<ColumnarLog::ColumnType>(p[0]);
+		col.name.assign(reinterpret_cast<const char*>(p + 4), nameLength);
+		col.offset = payloadBytes;
+		payloadBytes += m_uiBlockRows * ColumnarLog::typeSize(col.type);
+
+		m_vColumns.push_back(col);
+
+		p += 4u + nameLength;
+	}
+
+	size_t blockBytes = sizeof(ColumnarBlockHeader) + payloadBytes;
+	size_t offset = header.headerBytes;
+
+	while (offset + sizeof(ColumnarBlockHeader) <= size)
+	{
+		ColumnarBlockHeader blockHeader;
+		memcpy(&blockHeader, base + offset, sizeof(blockHeader));
+
+		// preallocated space left behind by a session that was not closed cleanly
+		if (blockHeader.magic == 0u)
+			break;
+
+		if (blockHeader.magic == COLUMNARLOG_DICT_MAGIC)
+		{
+			if (!readDictionary(base + offset, size - offset))
+				std::cerr << "ColumnarLogReader: category labels in " << path << " are corrupt; codes will have no text" << std::endl;
+			break;
+		}
+
+		if (blockHeader.magic != COLUMNARLOG_BLOCK_MAGIC || blockHeader.rowCount > m_uiBlockRows || offset + blockBytes > size)
+		{
+			std::cerr << "ColumnarLogReader: stopping at corrupt block " << m_vBlocks.size() + m_nCorruptBlocks << " in " << path << std::endl;
+			break;
+		}
+
+		const unsigned char* payload = base + offset + sizeof(ColumnarBlockHeader);
+		offset += blockBytes;
+
+		if (blockHeader.rowCount == 0u)
+			continue;
+
+		// unsealed blocks are the tail of a session that was cut short and have no checksum yet
+		if (verifyChecksums && (blockHeader.flags & COLUMNARLOG_BLOCK_SEALED))
+		{
+			uint32_t crc = 0u;
+			for (auto const &col : m_vColumns)
+				crc = ColumnarLog::checksum(payload + col.offset, blockHeader.rowCount * ColumnarLog::typeSize(col.type), crc);
+
+			if (crc != blockHeader.checksum)
+			{
+				std::cerr << "ColumnarLogReader: checksum mismatch in block " << m_vBlocks.size() + m_nCorruptBlocks << " of " << path << "; skipping it" << std::endl;
+				++m_nCorruptBlocks;
+				continue;
+			}
+		}
+
+		m_vBlocks.push_back({ payload, blockHeader.rowCount });
+		m_nRows += blockHeader.rowCount;
+	}
+
+	return true;
+}
+
+void ColumnarLogReader::close()
+{
+	m_File.close();
+	m_vColumns.clear();
+	m_vBlocks.clear();
+	m_uiBlockRows = 0u;
+	m_nRows = 0ull;
+	m_nCorruptBlocks = 0u;
+}
+
+int ColumnarLogReader::findColumn(std::string name) const
+{
+	for (size_t i = 0u; i < m_vColumns.size(); ++i)
+		if (m_vColumns[i].name == name)
+			return static_cast<int>(i);
+
+	return -1;
+}
+
+const void* ColumnarLogReader::columnData(size_t block, unsigned int col) const
+{
+	return m_vBlocks[block].payload + m_vColumns[col].offset;
+}
+
+const std::string& ColumnarLogReader::categoryLabel(unsigned int col, uint32_t code) const
+{
+	static const std::string s_strEmpty;
+
+	auto const &labels = m_vColumns[col].categoryLabels;
+
+	return code < labels.size() ? labels[code] : s_strEmpty;
+}
+
+bool ColumnarLogReader::readDictionary(const unsigned char* dict, size_t available)
+{
+	ColumnarBlockHeader header;
+	memcpy(&header, dict, sizeof(header));
+
+	const unsigned char* p = dict + sizeof(header);
+	const unsigned char* end = dict + available;
+
+	for (uint32_t i = 0u; i < header.rowCount; ++i)
+	{
+		if (p + 4 > end)
+			return false;
+
+		uint16_t column, length;
+		memcpy(&column, p, sizeof(column));
+		memcpy(&length, p + 2, sizeof(length));
+
+		if (column >= m_vColumns.size() || p + 4 + length > end)
+			return false;
+
+		m_vColumns[column].categoryLabels.push_back(std::string(reinterpret_cast<const char*>(p + 4), length));
+
+		p += 4u + length;
+	}
+
+	size_t entryBytes = ((p - dict + 7u) & ~static_cast<size_t>(7u)) - sizeof(header);
+	if (entryBytes + sizeof(header) > available)
+		entryBytes = p - dict - sizeof(header);
+
+	return ColumnarLog::checksum(dict + sizeof(header), entryBytes) == header.checksum;
+}
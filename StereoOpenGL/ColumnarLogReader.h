@@ -0,0 +1,88 @@
+#pragma once
+
+#include "ColumnarLog.h"
+
+// Contiguous run of one column's values inside the mapped file
+template <typename T>
+struct ColumnSpan {
+	const T* data;
+	size_t size;
+
+	ColumnSpan() : data(NULL), size(0u) {}
+	ColumnSpan(const T* d, size_t n) : data(d), size(n) {}
+
+	const T* begin() const { return data; }
+	const T* end() const { return data + size; }
+	const T& operator[](size_t i) const { return data[i]; }
+	bool empty() const { return size == 0u; }
+};
+
+// Read-only view of a file written by ColumnarLog. The file is memory-mapped and
+// column data is handed out as pointers into the mapping, so nothing is copied.
+class ColumnarLogReader
+{
+public:
+	struct ColumnInfo {
+		std::string name;
+		ColumnarLog::ColumnType type;
+		size_t offset; // from the start of the block payload
+		std::vector<std::string> categoryLabels;
+	};
+
+	ColumnarLogReader();
+	~ColumnarLogReader();
+
+	// sealed blocks whose checksum does not match are reported and skipped
+	bool open(std::string path, bool verifyChecksums = true);
+	void close();
+	bool isOpen() const { return m_File.isOpen(); }
+
+	unsigned int columnCount() const { return static_cast<unsigned int>(m_vColumns.size()); }
+	const ColumnInfo& column(unsigned int col) const { return m_vColumns[col]; }
+	// returns -1 if there is no such column
+	int findColumn(std::string name) const;
+
+	size_t blockCount() const { return m_vBlocks.size(); }
+	unsigned int blockRowCount(size_t block) const { return m_vBlocks[block].rowCount; }
+	unsigned long long rowCount() const { return m_nRows; }
+	size_t corruptBlockCount() const { return m_nCorruptBlocks; }
+
+	// start of the values for one column within one block
+	const void* columnData(size_t block, unsigned int col) const;
+
+	// typed view of one column within one block; empty if T does not match the column type
+	// (CATEGORY columns are read as uint32_t, BOOL8 columns as uint8_t)
+	template <typename T>
+	ColumnSpan<T> span(size_t block, unsigned int col) const
+	{
+		ColumnarLog::ColumnType type = m_vColumns[col].type;
+		if (type != ColumnTypeOf<T>::value && !(type == ColumnarLog::CATEGORY && ColumnTypeOf<T>::value == ColumnarLog::UINT32))
+			return ColumnSpan<T>();
+
+		return ColumnSpan<T>(static_cast<const T*>(columnData(block, col)), m_vBlocks[block].rowCount);
+	}
+
+	// text for a CATEGORY code, or an empty string if the label table is missing it
+	const std::string& categoryLabel(unsigned int col, uint32_t code) const;
+
+private:
+	struct Block {
+		const unsigned char* payload;
+		unsigned int rowCount;
+	};
+
+	MappedFile m_File;
+
+	std::vector<ColumnInfo> m_vColumns;
+	std::vector<Block> m_vBlocks;
+
+	unsigned int m_uiBlockRows;
+	unsigned long long m_nRows;
+	size_t m_nCorruptBlocks;
+
+	bool readDictionary(const unsigned char* dict, size_t available);
+
+public:
+	ColumnarLogReader(ColumnarLogReader const&) = delete;
+	void operator=(ColumnarLogReader const&) = delete;
+};
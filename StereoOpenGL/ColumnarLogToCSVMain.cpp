@@ -0,0 +1,86 @@
+#include "ColumnarLogReader.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+// Converts a ColumnarLog file to CSV. Floating point columns are printed with
+// enough digits to round-trip exactly.
+//
+// usage: ColumnarLogToCSV <input.col> [output.csv]
+
+static void printValue(FILE* out, ColumnarLogReader const &reader, unsigned int col, const unsigned char* p)
+{
+	switch (reader.column(col).type)
+	{
+	case ColumnarLog::INT32:	{ int32_t v; memcpy(&v, p, sizeof(v)); fprintf(out, "%d", v); break; }
+	case ColumnarLog::UINT32:	{ uint32_t v; memcpy(&v, p, sizeof(v)); fprintf(out, "%u", v); break; }
+	case ColumnarLog::INT64:	{ int64_t v; memcpy(&v, p, sizeof(v)); fprintf(out, "%lld", static_cast<long long>(v)); break; }
+	case ColumnarLog::UINT64:	{ uint64_t v; memcpy(&v, p, sizeof(v)); fprintf(out, "%llu", static_cast<unsigned long long>(v)); break; }
+	case ColumnarLog::FLOAT32:	{ float v; memcpy(&v, p, sizeof(v)); fprintf(out, "%.9g", v); break; }
+	case ColumnarLog::FLOAT64:	{ double v; memcpy(&v, p, sizeof(v)); fprintf(out, "%.17g", v); break; }
+	case ColumnarLog::BOOL8:	{ fputc(*p ? '1' : '0', out); break; }
+	case ColumnarLog::CATEGORY:	{ uint32_t v; memcpy(&v, p, sizeof(v)); fputs(reader.categoryLabel(col, v).c_str(), out); break; }
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose:
+//-----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		printf("usage: %s <input.col> [output.csv]\n", argv[0]);
+		return 1;
+	}
+
+	std::string inPath(argv[1]);
+	std::string outPath;
+
+	if (argc > 2)
+		outPath = argv[2];
+	else
+	{
+		size_t ext = inPath.find_last_of('.');
+		outPath = (ext == std::string::npos ? inPath : inPath.substr(0, ext)) + ".csv";
+	}
+
+	ColumnarLogReader reader;
+	if (!reader.open(inPath))
+		return 1;
+
+	FILE* out = fopen(outPath.c_str(), "w");
+	if (!out)
+	{
+		printf("Could not open %s for writing\n", outPath.c_str());
+		return 1;
+	}
+
+	for (unsigned int c = 0u; c < reader.columnCount(); ++c)
+		fprintf(out, c == 0u ? "%s" : ",%s", reader.column(c).name.c_str());
+	fputc('\n', out);
+
+	for (size_t b = 0u; b < reader.blockCount(); ++b)
+	{
+		unsigned int rows = reader.blockRowCount(b);
+
+		for (unsigned int r = 0u; r < rows; ++r)
+		{
+			for (unsigned int c = 0u; c < reader.columnCount(); ++c)
+			{
+				if (c > 0u)
+					fputc(',', out);
+
+				printValue(out, reader, c, static_cast<const unsigned char*>(reader.columnData(b, c)) + r * ColumnarLog::typeSize(reader.column(c).type));
+			}
+			fputc('\n', out);
+		}
+	}
+
+	fclose(out);
+
+	printf("Wrote %llu rows x %u columns to %s\n", reader.rowCount(), reader.columnCount(), outPath.c_str());
+
+	return 0;
+}
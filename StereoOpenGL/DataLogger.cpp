@@ -4,41 +4,183 @@
 #include <sstream>
 #include <string>
 #include <iomanip>
+#include <cstdarg>
+#include <cstring>
+#include <cmath>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 using namespace std::experimental::filesystem::v1;
 
+//-----------------------------------------------------------------------------
+// Purpose: Row builder. Every field is printed straight into the fixed buffer;
+//			text that would overflow the row is cut off.
+//-----------------------------------------------------------------------------
+DataLogger::Row::Field* DataLogger::Row::append(ColumnarLog::ColumnType type, const char* fmt, ...)
+{
+	if (m_uiFields > 0u && m_uiLength < DATALOGGER_MAX_ROW_LENGTH - 1u)
+	{
+		m_szBuffer[m_uiLength++] = ',';
+		m_szBuffer[m_uiLength] = '\0';
+	}
+
+	unsigned int start = m_uiLength;
+	unsigned int remaining = DATALOGGER_MAX_ROW_LENGTH - m_uiLength;
+
+	va_list args;
+	va_start(args, fmt);
+	int written = vsnprintf(m_szBuffer + m_uiLength, remaining, fmt, args);
+	va_end(args);
+
+	if (written < 0)
+		m_szBuffer[m_uiLength] = '\0';
+	else if (static_cast<unsigned int>(written) >= remaining)
+		m_uiLength = DATALOGGER_MAX_ROW_LENGTH - 1u;
+	else
+		m_uiLength += written;
+
+	if (m_uiFields >= DATALOGGER_MAX_FIELDS)
+	{
+		++m_uiFields;
+		return NULL;
+	}
+
+	Field* f = &m_arrFields[m_uiFields++];
+	f->type = type;
+	f->textOffset = static_cast<unsigned short>(start);
+	f->textLength = static_cast<unsigned short>(m_uiLength - start);
+	f->u = 0ull;
+
+	return f;
+}
+
+DataLogger::Row& DataLogger::Row::add(int val)
+{
+	Field* f = append(ColumnarLog::INT32, "%d", val);
+	if (f) f->i = val;
+	return *this;
+}
+
+DataLogger::Row& DataLogger::Row::add(unsigned int val)
+{
+	Field* f = append(ColumnarLog::UINT32, "%u", val);
+	if (f) f->u = val;
+	return *this;
+}
+
+DataLogger::Row& DataLogger::Row::add(long long val)
+{
+	Field* f = append(ColumnarLog::INT64, "%lld", val);
+	if (f) f->i = val;
+	return *this;
+}
+
+DataLogger::Row& DataLogger::Row::add(unsigned long long val)
+{
+	Field* f = append(ColumnarLog::UINT64, "%llu", val);
+	if (f) f->u = val;
+	return *this;
+}
+
+DataLogger::Row& DataLogger::Row::add(float val)
+{
+	Field* f = append(ColumnarLog::FLOAT32, "%f", static_cast<double>(val));
+	if (f) f->d = val;
+	return *this;
+}
+
+DataLogger::Row& DataLogger::Row::add(double val)
+{
+	Field* f = append(ColumnarLog::FLOAT64, "%f", val);
+	if (f) f->d = val;
+	return *this;
+}
+
+DataLogger::Row& DataLogger::Row::add(bool val)
+{
+	Field* f = append(ColumnarLog::BOOL8, "%d", val ? 1 : 0);
+	if (f) f->u = val ? 1ull : 0ull;
+	return *this;
+}
+
+DataLogger::Row& DataLogger::Row::add(const char* val)
+{
+	append(ColumnarLog::CATEGORY, "%s", val);
+	return *this;
+}
+
+DataLogger::Row& DataLogger::Row::add(const std::string &val)
+{
+	return add(val.c_str());
+}
+
 void DataLogger::setLogDirectory(std::string dir)
 {
-	if (dir.back() != '//')
-		dir += '//';
+	if (dir.back() != '/')
+		dir += '/';
 
 	m_LogDirectory = current_path().append(dir);
 }
 
 bool DataLogger::openLog(std::string logName, bool appendTimestampToLogname)
 {
-	std::string filename = appendTimestampToLogname ? logName + "_" + getTimeString() + ".csv": logName + ".csv";
-	m_fsLog.open(std::string(m_LogDirectory.string() + filename));
-	return m_fsLog.is_open();
+	if (m_pLogFile)
+		closeLog();
+
+	m_strLogBasePath = m_LogDirectory.string() + (appendTimestampToLogname ? logName + "_" + getTimeString() : logName);
+	m_pLogFile = fopen(std::string(m_strLogBasePath + ".csv").c_str(), "w");
+
+	if (!m_pLogFile)
+		return false;
+
+	m_bWriterRunning = true;
+	m_WriterThread = std::thread(&DataLogger::writerLoop, this);
+
+	return true;
 }
 
 void DataLogger::closeLog()
 {
-	if (m_fsLog.is_open())
-		m_fsLog.close();
-
 	stop();
+
+	m_ColumnarLog.close();
+	m_bColumnarFailed = false;
+
+	if (!m_pLogFile)
+		return;
+
+	m_bWriterPauseRequested = false;
+
+	flush();
+
+	m_bWriterRunning = false;
+	if (m_WriterThread.joinable())
+		m_WriterThread.join();
+
+	fclose(m_pLogFile);
+	m_pLogFile = NULL;
+
+	if (m_nLinesOverflowed > 0u)
+		std::cerr << "DataLogger: writer fell behind; " << m_nLinesOverflowed << " lines went through the overflow buffer" << std::endl;
+	m_nLinesOverflowed = 0u;
 }
 
 void DataLogger::start()
 {
-	m_bLogging = m_fsLog.is_open();
+	m_bLogging = m_pLogFile != NULL;
 
 	if (m_bLogging)
 	{
 		m_tpLogStart = std::chrono::high_resolution_clock::now();
 		if (m_strHeader != std::string())
-			m_fsLog << "id," << m_strHeader << "\n";
+		{
+			std::string line = "id," + m_strHeader + "\n";
+			enqueue(line.c_str(), static_cast<unsigned int>(line.length()));
+		}
 	}
 }
 
@@ -62,10 +204,285 @@ void DataLogger::setHeader(std::string header)
 	m_strHeader = header;
 }
 
+void DataLogger::logRow(const Row &row)
+{
+	if (!m_bLogging)
+		return;
+
+	LogLine *line = claimLine();
+	line->length = static_cast<unsigned int>(snprintf(line->text, DATALOGGER_MAX_ROW_LENGTH, "%s,%s\n", m_strID.c_str(), row.c_str()));
+	commitLine(line);
+
+	if (m_bColumnarOutput)
+		writeColumnarRow(row);
+}
+
 void DataLogger::logMessage(std::string message)
 {
-	if (m_bLogging)
-		m_fsLog << m_strID << ',' << message << "\n";
+	if (!m_bLogging)
+		return;
+
+	LogLine *line = claimLine();
+	line->length = static_cast<unsigned int>(snprintf(line->text, DATALOGGER_MAX_ROW_LENGTH, "%s,%s\n", m_strID.c_str(), message.c_str()));
+	commitLine(line);
+}
+
+void DataLogger::setColumnarOutput(bool enable)
+{
+	m_bColumnarOutput = enable;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: The columnar file is opened on the first row, once the field types
+//			are known. It is written on the calling thread; the stores go
+//			straight into a memory mapping and never touch the disk directly.
+//-----------------------------------------------------------------------------
+void DataLogger::writeColumnarRow(const Row &row)
+{
+	if (m_bColumnarFailed)
+		return;
+
+	if (!m_ColumnarLog.isOpen())
+	{
+		std::vector<std::string> names;
+		std::stringstream ss("id," + m_strHeader);
+		std::string name;
+		while (std::getline(ss, name, ','))
+			names.push_back(name);
+
+		if (names.size() != row.fieldCount() + 1u)
+		{
+			std::cerr << "DataLogger: header has " << names.size() << " columns but rows have " << row.fieldCount() + 1u << "; not writing columnar log" << std::endl;
+			m_bColumnarFailed = true;
+			return;
+		}
+
+		m_ColumnarLog.clearColumns();
+		m_ColumnarLog.addColumn(names[0], ColumnarLog::CATEGORY);
+		for (unsigned int i = 0u; i < row.fieldCount(); ++i)
+			m_ColumnarLog.addColumn(names[i + 1u], row.field(i).type);
+
+		if (!m_ColumnarLog.open(m_strLogBasePath + ".col", DATALOGGER_COLUMNAR_BLOCK_ROWS))
+		{
+			m_bColumnarFailed = true;
+			return;
+		}
+	}
+
+	m_ColumnarLog.set(0u, m_strID);
+
+	for (unsigned int i = 0u; i < row.fieldCount(); ++i)
+	{
+		const Row::Field &f = row.field(i);
+
+		switch (f.type)
+		{
+		case ColumnarLog::INT32:
+		case ColumnarLog::INT64:
+			m_ColumnarLog.set(i + 1u, f.i);
+			break;
+		case ColumnarLog::UINT32:
+		case ColumnarLog::UINT64:
+		case ColumnarLog::BOOL8:
+			m_ColumnarLog.set(i + 1u, f.u);
+			break;
+		case ColumnarLog::FLOAT32:
+		case ColumnarLog::FLOAT64:
+			m_ColumnarLog.set(i + 1u, f.d);
+			break;
+		case ColumnarLog::CATEGORY:
+			m_ColumnarLog.set(i + 1u, row.fieldText(i), f.textLength);
+			break;
+		}
+	}
+
+	m_ColumnarLog.commitRow();
+}
+
+void DataLogger::flush()
+{
+	if (!m_pLogFile || !m_bWriterRunning)
+		return;
+
+	unsigned long long request = ++m_nFlushRequest;
+
+	std::unique_lock<std::mutex> lock(m_mtxFlush);
+	m_cvFlush.wait(lock, [&] { return m_nFlushCompleted >= request; });
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Producer side of the line queue. If the writer has fallen a full
+//			queue behind, lines go to the overflow buffer instead, so the
+//			caller neither waits nor loses data.
+//-----------------------------------------------------------------------------
+DataLogger::LogLine* DataLogger::claimLine()
+{
+	if (!m_bOverflowing.load(std::memory_order_acquire))
+	{
+		LogLine *line = m_qLines.claim();
+		if (line)
+			return line;
+	}
+
+	return &m_OverflowLine;
+}
+
+void DataLogger::commitLine(LogLine *line)
+{
+	// snprintf reports the untruncated length; keep the newline on truncated lines
+	if (line->length >= DATALOGGER_MAX_ROW_LENGTH)
+	{
+		line->length = DATALOGGER_MAX_ROW_LENGTH - 1u;
+		line->text[line->length - 1u] = '\n';
+	}
+
+	if (line != &m_OverflowLine)
+	{
+		m_qLines.commit();
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mtxOverflow);
+	m_vOverflow.push_back(*line);
+	m_bOverflowing.store(true, std::memory_order_release);
+	++m_nLinesOverflowed;
+}
+
+void DataLogger::pauseWriter(bool paused)
+{
+	m_bWriterPauseRequested = paused;
+
+	while (paused && m_pLogFile && !m_bWriterParked.load(std::memory_order_acquire))
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+void DataLogger::enqueue(const char* text, unsigned int length)
+{
+	LogLine *line = claimLine();
+	line->length = length < DATALOGGER_MAX_ROW_LENGTH ? length : DATALOGGER_MAX_ROW_LENGTH;
+	memcpy(line->text, text, line->length);
+	commitLine(line);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Writer thread. Drains the line queue into the file, syncs it to
+//			disk at most every DATALOGGER_SYNC_INTERVAL_MS, and services
+//			flush() requests.
+//-----------------------------------------------------------------------------
+void DataLogger::writerLoop()
+{
+	bool dirty = false;
+	std::chrono::steady_clock::time_point lastSync = std::chrono::steady_clock::now();
+
+	std::vector<LogLine> overflow;
+
+	while (m_bWriterRunning || !m_qLines.empty() || m_bOverflowing)
+	{
+		// read the request before draining so every line queued ahead of it gets written
+		unsigned long long request = m_nFlushRequest.load(std::memory_order_acquire);
+
+		bool wrote = false;
+		LogLine *line;
+		while ((line = m_qLines.front()) != NULL)
+		{
+			fwrite(line->text, 1, line->length, m_pLogFile);
+			m_qLines.release();
+			wrote = true;
+		}
+
+		while (m_bWriterPauseRequested.load(std::memory_order_acquire))
+		{
+			m_bWriterParked.store(true, std::memory_order_release);
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		m_bWriterParked.store(false, std::memory_order_release);
+
+		// The producer only starts overflowing once the queue is full and then stops using it,
+		// but it may have refilled the queue since the drain above. Those lines predate every
+		// overflowed one, so drain again before taking the overflow.
+		if (m_bOverflowing.load(std::memory_order_acquire))
+		{
+			while ((line = m_qLines.front()) != NULL)
+			{
+				fwrite(line->text, 1, line->length, m_pLogFile);
+				m_qLines.release();
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_mtxOverflow);
+				overflow.swap(m_vOverflow);
+				m_bOverflowing.store(false, std::memory_order_release);
+			}
+
+			for (auto const &spilled : overflow)
+				fwrite(spilled.text, 1, spilled.length, m_pLogFile);
+
+			overflow.clear();
+			wrote = true;
+		}
+
+		dirty |= wrote;
+
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+		if (dirty && std::chrono::duration_cast<std::chrono::milliseconds>(now - lastSync).count() >= DATALOGGER_SYNC_INTERVAL_MS)
+		{
+			syncToDisk();
+			dirty = false;
+			lastSync = now;
+		}
+
+		bool flushPending;
+		{
+			std::lock_guard<std::mutex> lock(m_mtxFlush);
+			flushPending = request > m_nFlushCompleted;
+		}
+
+		if (flushPending)
+		{
+			syncToDisk();
+			dirty = false;
+			lastSync = now;
+
+			{
+				std::lock_guard<std::mutex> lock(m_mtxFlush);
+				m_nFlushCompleted = request;
+			}
+			m_cvFlush.notify_all();
+		}
+
+		if (!wrote && !flushPending)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	syncToDisk();
+}
+
+void DataLogger::syncToDisk()
+{
+	fflush(m_pLogFile);
+
+#ifdef _WIN32
+	_commit(_fileno(m_pLogFile));
+#else
+	fsync(fileno(m_pLogFile));
+#endif
+}
+
+double DataLogger::getTimeSinceLogStart()
+{
+	if (!m_bLogging)
+		return 0.0;
+
+	return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - m_tpLogStart).count();
+}
+
+double DataLogger::getTimeSinceLogStart(std::chrono::high_resolution_clock::time_point t)
+{
+	if (!m_bLogging)
+		return 0.0;
+
+	return std::chrono::duration<double>(t - m_tpLogStart).count();
 }
 
 std::string DataLogger::getTimeSinceLogStartString()
@@ -73,36 +490,44 @@ std::string DataLogger::getTimeSinceLogStartString()
 	if (!m_bLogging)
 		return "00:00:00.000";
 
-	std::chrono::duration<double> elapsedTime(std::chrono::high_resolution_clock::now() - m_tpLogStart);
+	long long elapsedMS = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - m_tpLogStart).count();
 
-	int hours, minutes, seconds, milliseconds;
+	int hours = static_cast<int>((elapsedMS / 3600000ll) % 24ll);
+	int minutes = static_cast<int>((elapsedMS / 60000ll) % 60ll);
+	int seconds = static_cast<int>((elapsedMS / 1000ll) % 60ll);
+	int milliseconds = static_cast<int>(elapsedMS % 1000ll);
 
-	hours = fmod(std::chrono::duration_cast<std::chrono::hours>(elapsedTime).count(), 24);
-	minutes = fmod(std::chrono::duration_cast<std::chrono::minutes>(elapsedTime).count(), 60);
-	seconds = fmod(std::chrono::duration_cast<std::chrono::seconds>(elapsedTime).count(), 60);
-	milliseconds = fmod(std::chrono::duration_cast<std::chrono::milliseconds>(elapsedTime).count(), 1000);
+	// sized for four full-width ints, so even a negative interval never truncates
+	char buf[48];
+	snprintf(buf, sizeof(buf), "%02d:%02d:%02d.%03d", hours, minutes, seconds, milliseconds);
 
-	std::stringstream ss;
-	ss << std::setw(2) << std::setfill('0') << hours;
-	ss << ":";
-	ss << std::setw(2) << std::setfill('0') << minutes;
-	ss << ":";
-	ss << std::setw(2) << std::setfill('0') << seconds;
-	ss << ".";
-	ss << std::setw(3) << std::setfill('0') << milliseconds;
+	return std::string(buf);
+}
 
-	return ss.str();
+std::string DataLogger::getLogBasePath()
+{
+	return m_strLogBasePath;
 }
 
-DataLogger::DataLogger() : m_bLogging(false)
+DataLogger::DataLogger()
+	: m_bLogging(false)
+	, m_pLogFile(NULL)
+	, m_bColumnarOutput(false)
+	, m_bColumnarFailed(false)
+	, m_bOverflowing(false)
+	, m_nLinesOverflowed(0ull)
+	, m_bWriterRunning(false)
+	, m_bWriterPauseRequested(false)
+	, m_bWriterParked(false)
+	, m_nFlushRequest(0ull)
+	, m_nFlushCompleted(0ull)
 {
 }
 
 
 DataLogger::~DataLogger()
 {
-	if (m_fsLog.is_open())
-		m_fsLog.close();
+	closeLog();
 }
 
 
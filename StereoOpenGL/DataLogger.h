@@ -3,11 +3,73 @@
 #include <map>
 #include <sstream>
 #include <fstream>
-#include <filesystem>
+#include <experimental/filesystem>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <vector>
+
+#include "SPSCQueue.h"
+#include "ColumnarLog.h"
+
+#define DATALOGGER_MAX_ROW_LENGTH	512
+#define DATALOGGER_MAX_FIELDS		32
+#define DATALOGGER_COLUMNAR_BLOCK_ROWS	64
+#define DATALOGGER_QUEUE_SIZE		4096
+#define DATALOGGER_SYNC_INTERVAL_MS	1000
 
 class DataLogger
 {
 public:
+	// Fixed-size CSV row builder; fields are formatted in place so building a row never allocates.
+	// The typed value of each field is kept alongside its text for the columnar log.
+	class Row
+	{
+	public:
+		struct Field {
+			ColumnarLog::ColumnType type;
+			unsigned short textOffset;
+			unsigned short textLength;
+			union {
+				long long i;
+				unsigned long long u;
+				double d;
+			};
+		};
+
+		Row() : m_uiLength(0u), m_uiFields(0u) { m_szBuffer[0] = '\0'; }
+
+		Row& add(int val);
+		Row& add(unsigned int val);
+		Row& add(long long val);
+		Row& add(unsigned long long val);
+		Row& add(float val);
+		Row& add(double val);
+		Row& add(bool val);
+		Row& add(const char* val);
+		Row& add(const std::string &val);
+
+		void clear() { m_uiLength = m_uiFields = 0u; m_szBuffer[0] = '\0'; }
+
+		const char* c_str() const { return m_szBuffer; }
+		unsigned int length() const { return m_uiLength; }
+
+		unsigned int fieldCount() const { return m_uiFields < DATALOGGER_MAX_FIELDS ? m_uiFields : DATALOGGER_MAX_FIELDS; }
+		const Field& field(unsigned int i) const { return m_arrFields[i]; }
+		// points into the row's buffer; the text is field(i).textLength long and not null-terminated
+		const char* fieldText(unsigned int i) const { return m_szBuffer + m_arrFields[i].textOffset; }
+
+	private:
+		char m_szBuffer[DATALOGGER_MAX_ROW_LENGTH];
+		unsigned int m_uiLength;
+		unsigned int m_uiFields;
+		Field m_arrFields[DATALOGGER_MAX_FIELDS];
+
+		// formats the next field and returns its typed slot, or NULL once DATALOGGER_MAX_FIELDS is reached
+		Field* append(ColumnarLog::ColumnType type, const char* fmt, ...);
+	};
 
 	static DataLogger& getInstance()
 	{
@@ -29,27 +91,83 @@ public:
 	// do not include 'id' field, it is added automatically
 	void setHeader(std::string header);
 
+	// Rows are handed to a background writer thread; both calls must come from the same (producer) thread
+	void logRow(const Row &row);
 	void logMessage(std::string message);
 
+	// Blocks until everything logged so far has been written and synced to disk
+	void flush();
+
+	// Parks the writer thread between draining the queue and collecting overflowed lines, and
+	// returns once it is parked. Lines are still accepted meanwhile, so tests can push the
+	// queue past capacity. closeLog() releases the writer too.
+	void pauseWriter(bool paused);
+
+	// Also write rows to <log>.col as typed columns. Column names come from setHeader() and
+	// types from the fields of the first logged Row; logMessage() lines only go to the CSV.
+	void setColumnarOutput(bool enable);
+
+	// seconds since start(), for timestamping samples without string formatting
+	double getTimeSinceLogStart();
+	// seconds from the log start to t, which may lie in the future
+	double getTimeSinceLogStart(std::chrono::high_resolution_clock::time_point t);
 	std::string getTimeSinceLogStartString();
 
+	// path of the open log without its extension, so companion files can sit next to it
+	std::string getLogBasePath();
+
 private:
 	DataLogger();
 	~DataLogger();
 
+	struct LogLine {
+		char text[DATALOGGER_MAX_ROW_LENGTH];
+		unsigned int length;
+	};
+
 	bool m_bLogging;
 
-	std::ofstream m_fsLog;
+	FILE* m_pLogFile;
 
 	std::string m_strID;
 	std::string m_strHeader;
+	std::string m_strLogBasePath;
+
+	bool m_bColumnarOutput;
+	bool m_bColumnarFailed;
+	ColumnarLog m_ColumnarLog;
 
 	std::experimental::filesystem::v1::path m_LogDirectory;
 	std::chrono::time_point<std::chrono::high_resolution_clock> m_tpLogStart;
 
+	SPSCQueue<LogLine, DATALOGGER_QUEUE_SIZE> m_qLines;
+
+	// Lines that found the queue full. Once set, m_bOverflowing sends every later line here
+	// too until the writer has drained both, so the file keeps its order.
+	LogLine m_OverflowLine;	// producer-side scratch for the line being built
+	std::vector<LogLine> m_vOverflow;
+	std::mutex m_mtxOverflow;
+	std::atomic<bool> m_bOverflowing;
+	unsigned long long m_nLinesOverflowed;
+
+	std::thread m_WriterThread;
+	std::atomic<bool> m_bWriterRunning;
+	std::atomic<bool> m_bWriterPauseRequested;
+	std::atomic<bool> m_bWriterParked;
+	std::atomic<unsigned long long> m_nFlushRequest;
+	unsigned long long m_nFlushCompleted;
+	std::mutex m_mtxFlush;
+	std::condition_variable m_cvFlush;
+
+	LogLine* claimLine();
+	void commitLine(LogLine *line);
+	void enqueue(const char* text, unsigned int length);
+	void writerLoop();
+	void syncToDisk();
+	void writeColumnarRow(const Row &row);
+
 public:
 	// DELETE THE FOLLOWING FUNCTIONS TO AVOID NON-SINGLETON USE
 	DataLogger(DataLogger const&) = delete;
 	void operator=(DataLogger const&) = delete;
 };
-
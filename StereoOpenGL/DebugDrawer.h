@@ -30,7 +30,7 @@ public:
 	// Set the debug drawer's transform using a GLM 4x4 matrix
 	// NOTE: Set this before drawing if you want to specify non-world-space coordinates
 	// (e.g., set it to an object's model transformation matrix before drawing the model in local space)
-	void setTransform(glm::mat4 &m)
+	void setTransform(const glm::mat4 &m)
 	{
 		m_mat4Transform = m;
 	}
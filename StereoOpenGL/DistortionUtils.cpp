@@ -2,16 +2,17 @@
 
 #include <gtx/intersect.hpp>
 #include <gtx/vector_angle.hpp>
+#include <limits>
 
 namespace distutil
 {
-	std::vector<glm::vec3> transformMonoscopicPoints(glm::vec3 centerOfProj, glm::vec3 viewPos, glm::vec3 screenCtr, glm::vec3 screenNorm, std::vector<glm::vec3> pts)
+	std::vector<glm::vec3> transformMonoscopicPoints(glm::vec3 centerOfProj, glm::vec3 viewPos, glm::vec3 screenCtr, glm::vec3 screenNorm, std::vector<glm::vec3> const &pts)
 	{
 		auto intPts = getScreenIntersections(centerOfProj, screenCtr, screenNorm, pts);
 
 		std::vector<glm::vec3> ret;
 
-		for (int i = 0; i < pts.size(); ++i)
+		for (size_t i = 0; i < pts.size(); ++i)
 		{
 			float ratio = glm::length(pts[i] - intPts[i]) / glm::length(intPts[i] - centerOfProj);
 			glm::vec3 newPosToInt = intPts[i] - viewPos;
@@ -23,36 +24,71 @@ namespace distutil
 		return ret;
 	}
 
-	std::vector<glm::vec3> transformStereoscopicPoints(glm::vec3 centerOfProjL, glm::vec3 centerOfProjR, glm::vec3 viewPosL, glm::vec3 viewPosR, glm::vec3 screenCtr, glm::vec3 screenNorm, const std::vector<glm::vec3> pts)
+	std::vector<glm::vec3> transformStereoscopicPoints(glm::vec3 centerOfProjL, glm::vec3 centerOfProjR, glm::vec3 viewPosL, glm::vec3 viewPosR, glm::vec3 screenCtr, glm::vec3 screenNorm, std::vector<glm::vec3> const &pts, std::vector<uint8_t> *validMask)
 	{
-		std::vector<glm::vec3> iL(getScreenIntersections(centerOfProjL, screenCtr, screenNorm, pts));
-		std::vector<glm::vec3> iR(getScreenIntersections(centerOfProjR, screenCtr, screenNorm, pts));
+		std::vector<glm::vec3> ret(pts.size());
 
-		std::vector<glm::vec3> ret;
-		for (int i = 0; i < pts.size(); ++i)
+		if (validMask)
+			validMask->resize(pts.size());
+
+		transformStereoscopicPoints(centerOfProjL, centerOfProjR, viewPosL, viewPosR, screenCtr, screenNorm, pts.data(), pts.size(), ret.data(), validMask ? validMask->data() : NULL);
+
+		return ret;
+	}
+
+	size_t transformStereoscopicPoints(glm::vec3 centerOfProjL, glm::vec3 centerOfProjR, glm::vec3 viewPosL, glm::vec3 viewPosR, glm::vec3 screenCtr, glm::vec3 screenNorm, const glm::vec3 *pts, size_t count, glm::vec3 *out, uint8_t *validMask)
+	{
+		typedef glm::tvec3<real, glm::highp> rvec3;
+
+		// Per-thread scratch, so reprojecting every frame stops allocating once the buffers have grown
+		thread_local std::vector<rvec3> rayL, rayR, pa, pb;
+		thread_local std::vector<uint8_t> validScratch;
+
+		rayL.resize(count);
+		rayR.resize(count);
+		pa.resize(count);
+		pb.resize(count);
+
+		for (size_t i = 0; i < count; ++i)
 		{
-			glm::vec3 pa, pb;
-			double mua, mub;
-			LineLineIntersect(viewPosL, iL[i], viewPosR, iR[i], &pa, &pb, &mua, &mub);
-			ret.push_back((pa + pb) / 2.f);
+			rayL[i] = rvec3(getScreenIntersection(centerOfProjL, screenCtr, screenNorm, pts[i]));
+			rayR[i] = rvec3(getScreenIntersection(centerOfProjR, screenCtr, screenNorm, pts[i]));
 		}
 
-		return ret;
+		if (!validMask)
+		{
+			validScratch.resize(count);
+			validMask = validScratch.data();
+		}
+
+		// Rays that cannot be fused (parallel or zero-length) resolve to the midpoint of their
+		// screen intersections, i.e. zero disparity, and are flagged in the validity mask
+		size_t nValid = IntersectRaysFromTwoOrigins<real>(rvec3(viewPosL), rayL.data(), rvec3(viewPosR), rayR.data(), count, pa.data(), pb.data(), NULL, NULL, validMask);
+
+		for (size_t i = 0; i < count; ++i)
+			out[i] = glm::vec3((pa[i] + pb[i]) * real(0.5));
+
+		return nValid;
 	}
 
-	std::vector<glm::vec3> getScreenIntersections(glm::vec3 centerOfProjection, glm::vec3 screenCenter, glm::vec3 screenNormal, const std::vector<glm::vec3> pts)
+	std::vector<glm::vec3> getScreenIntersections(glm::vec3 centerOfProjection, glm::vec3 screenCenter, glm::vec3 screenNormal, std::vector<glm::vec3> const &pts)
 	{
 		std::vector<glm::vec3> ret;
+		ret.reserve(pts.size());
 
 		for (auto pt : pts)
-		{
-			float ptDist;
-			glm::intersectRayPlane(centerOfProjection, pt - centerOfProjection, screenCenter, screenNormal, ptDist);
-			ret.push_back(centerOfProjection + (pt - centerOfProjection) * ptDist);
-		}
+			ret.push_back(getScreenIntersection(centerOfProjection, screenCenter, screenNormal, pt));
+
 		return ret;
 	}
 
+	glm::vec3 getScreenIntersection(glm::vec3 centerOfProjection, glm::vec3 screenCenter, glm::vec3 screenNormal, glm::vec3 pt)
+	{
+		float ptDist = 0.f;
+		glm::intersectRayPlane(centerOfProjection, pt - centerOfProjection, screenCenter, screenNormal, ptDist);
+		return centerOfProjection + (pt - centerOfProjection) * ptDist;
+	}
+
 	/////////////////////////////////////////////////////////////////////////////
 	// from http://paulbourke.net/geometry/pointlineplane/lineline.c		   //
 	// 																		   //
@@ -64,45 +100,69 @@ namespace distutil
 	/////////////////////////////////////////////////////////////////////////////
 	bool LineLineIntersect(glm::vec3 p1, glm::vec3 p2, glm::vec3 p3, glm::vec3 p4, glm::vec3 *pa, glm::vec3 *pb, double *mua, double *mub)
 	{
-		glm::vec3 p13, p43, p21;
-		double d1343, d4321, d1321, d4343, d2121;
-		double numer, denom;
-
-		p13.x = p1.x - p3.x;
-		p13.y = p1.y - p3.y;
-		p13.z = p1.z - p3.z;
-		p43.x = p4.x - p3.x;
-		p43.y = p4.y - p3.y;
-		p43.z = p4.z - p3.z;
-		if (glm::abs(p43.x) < glm::epsilon<float>() && glm::abs(p43.y) < glm::epsilon<float>() && glm::abs(p43.z) < glm::epsilon<float>())
-			return false;
-		p21.x = p2.x - p1.x;
-		p21.y = p2.y - p1.y;
-		p21.z = p2.z - p1.z;
-		if (glm::abs(p21.x) < glm::epsilon<float>() && glm::abs(p21.y) < glm::epsilon<float>() && glm::abs(p21.z) < glm::epsilon<float>())
-			return false;
+		glm::dvec3 dp2(p2), dp4(p4);
+		glm::dvec3 dpa, dpb;
+		uint8_t valid;
 
-		d1343 = p13.x * p43.x + p13.y * p43.y + p13.z * p43.z;
-		d4321 = p43.x * p21.x + p43.y * p21.y + p43.z * p21.z;
-		d1321 = p13.x * p21.x + p13.y * p21.y + p13.z * p21.z;
-		d4343 = p43.x * p43.x + p43.y * p43.y + p43.z * p43.z;
-		d2121 = p21.x * p21.x + p21.y * p21.y + p21.z * p21.z;
+		IntersectRaysFromTwoOrigins<double>(glm::dvec3(p1), &dp2, glm::dvec3(p3), &dp4, 1, &dpa, &dpb, mua, mub, &valid);
 
-		denom = d2121 * d4343 - d4321 * d4321;
-		if (glm::abs(denom) < glm::epsilon<float>())
+		if (!valid)
 			return false;
-		numer = d1343 * d4321 - d1321 * d4343;
 
-		*mua = numer / denom;
-		*mub = (d1343 + d4321 * (*mua)) / d4343;
-
-		pa->x = p1.x + *mua * p21.x;
-		pa->y = p1.y + *mua * p21.y;
-		pa->z = p1.z + *mua * p21.z;
-		pb->x = p3.x + *mub * p43.x;
-		pb->y = p3.y + *mub * p43.y;
-		pb->z = p3.z + *mub * p43.z;
+		*pa = glm::vec3(dpa);
+		*pb = glm::vec3(dpb);
 
 		return true;
 	}
+
+	template <typename T>
+	size_t IntersectRaysFromTwoOrigins(glm::tvec3<T, glm::highp> const &p1, const glm::tvec3<T, glm::highp> *p2, glm::tvec3<T, glm::highp> const &p3, const glm::tvec3<T, glm::highp> *p4, size_t count, glm::tvec3<T, glm::highp> *pa, glm::tvec3<T, glm::highp> *pb, T *mua, T *mub, uint8_t *valid)
+	{
+		// Tolerances are relative to the precision of T: segments shorter than sqrt(eps) are
+		// degenerate, and lines whose squared sine of separation angle is below eps are parallel
+		const T eps = std::numeric_limits<T>::epsilon();
+		const T one(1);
+
+		const glm::tvec3<T, glm::highp> p13 = p1 - p3;
+
+		size_t nValid = 0u;
+
+		for (size_t i = 0u; i < count; ++i)
+		{
+			glm::tvec3<T, glm::highp> p43 = p4[i] - p3;
+			glm::tvec3<T, glm::highp> p21 = p2[i] - p1;
+
+			T d1343 = glm::dot(p13, p43);
+			T d4321 = glm::dot(p43, p21);
+			T d1321 = glm::dot(p13, p21);
+			T d4343 = glm::dot(p43, p43);
+			T d2121 = glm::dot(p21, p21);
+
+			T denom = d2121 * d4343 - d4321 * d4321;
+			T numer = d1343 * d4321 - d1321 * d4343;
+
+			// bitwise & so every test is evaluated; no early-out branches
+			bool ok = (d4343 > eps) & (d2121 > eps) & (denom > eps * d2121 * d4343);
+			T okMask = static_cast<T>(ok);
+			T badMask = one - okMask;
+
+			// replace divisors of degenerate pairs with 1 so the division is always well-defined
+			T a = okMask * (numer / (denom * okMask + badMask)) + badMask;
+			T b = okMask * ((d1343 + d4321 * a) / (d4343 * okMask + badMask)) + badMask;
+
+			pa[i] = p1 + a * p21;
+			pb[i] = p3 + b * p43;
+
+			if (mua) mua[i] = a;
+			if (mub) mub[i] = b;
+
+			valid[i] = static_cast<uint8_t>(ok);
+			nValid += ok;
+		}
+
+		return nValid;
+	}
+
+	template size_t IntersectRaysFromTwoOrigins<float>(glm::vec3 const&, const glm::vec3*, glm::vec3 const&, const glm::vec3*, size_t, glm::vec3*, glm::vec3*, float*, float*, uint8_t*);
+	template size_t IntersectRaysFromTwoOrigins<double>(glm::dvec3 const&, const glm::dvec3*, glm::dvec3 const&, const glm::dvec3*, size_t, glm::dvec3*, glm::dvec3*, double*, double*, uint8_t*);
 }
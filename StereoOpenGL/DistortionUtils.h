@@ -1,16 +1,24 @@
 #pragma once
 
 #include <vector>
+#include <cstdint>
 #include <glm.hpp>
 
 namespace distutil 
 {
+	// Precision used by the reprojection functions below; define DISTUTIL_SINGLE_PRECISION to use float
+#ifdef DISTUTIL_SINGLE_PRECISION
+	typedef float real;
+#else
+	typedef double real;
+#endif
+
 	std::vector<glm::vec3> transformMonoscopicPoints(
 		glm::vec3 centerOfProj,
 		glm::vec3 viewPos,
 		glm::vec3 screenCtr,
 		glm::vec3 screenNorm,
-		std::vector<glm::vec3> pts
+		std::vector<glm::vec3> const &pts
 	);
 
 	std::vector<glm::vec3> transformStereoscopicPoints(
@@ -20,14 +28,38 @@ namespace distutil
 		glm::vec3 viewPosB,
 		glm::vec3 screenCtr,
 		glm::vec3 screenNorm,
-		const std::vector<glm::vec3> pts
+		std::vector<glm::vec3> const &pts,
+		std::vector<uint8_t> *validMask = NULL
+	);
+
+	// Writes the count reprojected points to out (which may not alias pts) instead of allocating a
+	// vector, for callers that reproject into the same buffer every frame. validMask may be NULL.
+	// Returns the number of points whose eye rays could be fused.
+	size_t transformStereoscopicPoints(
+		glm::vec3 centerOfProjA,
+		glm::vec3 centerOfProjB,
+		glm::vec3 viewPosA,
+		glm::vec3 viewPosB,
+		glm::vec3 screenCtr,
+		glm::vec3 screenNorm,
+		const glm::vec3 *pts,
+		size_t count,
+		glm::vec3 *out,
+		uint8_t *validMask = NULL
 	);
 	
 	std::vector<glm::vec3> getScreenIntersections(
 		glm::vec3 centerOfProjection,
 		glm::vec3 screenCtr,
 		glm::vec3 screenNorm,
-		const std::vector<glm::vec3> pts
+		std::vector<glm::vec3> const &pts
+	);
+
+	glm::vec3 getScreenIntersection(
+		glm::vec3 centerOfProjection,
+		glm::vec3 screenCtr,
+		glm::vec3 screenNorm,
+		glm::vec3 pt
 	);
 	
 	bool LineLineIntersect(
@@ -39,4 +71,24 @@ namespace distutil
 		glm::vec3* pb,
 		double* mua,
 		double* mub);
+
+	// Solves LineLineIntersect for count pairs of rays without branching on degenerate input. Unlike
+	// LineLineIntersect, every ray of a side starts at the same origin: ray i of side A runs from originA
+	// through targetA[i] and ray i of side B from originB through targetB[i], e.g. two eyes casting rays
+	// through the screen. Pairs with their own origins must go through LineLineIntersect one at a time.
+	// valid[i] is 1 when pair i has a unique solution and 0 when either ray has zero length or the rays
+	// are parallel; invalid pairs report mua = mub = 1 (Pa = targetA, Pb = targetB). mua/mub may be NULL.
+	// Explicitly instantiated for float and double. Returns the number of valid pairs.
+	template <typename T>
+	size_t IntersectRaysFromTwoOrigins(
+		glm::tvec3<T, glm::highp> const& originA,
+		const glm::tvec3<T, glm::highp>* targetA,
+		glm::tvec3<T, glm::highp> const& originB,
+		const glm::tvec3<T, glm::highp>* targetB,
+		size_t count,
+		glm::tvec3<T, glm::highp>* pa,
+		glm::tvec3<T, glm::highp>* pb,
+		T* mua,
+		T* mub,
+		uint8_t* valid);
 }
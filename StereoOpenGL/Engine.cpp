@@ -5,8 +5,9 @@
 #include <sstream>
 #include <string>
 #include <algorithm>
-#include <filesystem>
+#include <experimental/filesystem>
 #include <limits>
+#include <random>
 
 #define INTOCM 2.54f
 
@@ -89,15 +90,49 @@ void error_callback_glfw(int error, const char* desc) { dprintf("GLFW Error 0x%x
 // Purpose: Constructor
 //-----------------------------------------------------------------------------
 Engine::Engine(int argc, char *argv[], int mode)
-	: m_bGLInitialized(false)
+	: m_bLatencyBenchmark(false)
+	, m_uiLatencyBenchmarkSamples(1000u)
+	, m_bLatencyBenchmarkReported(false)
+	, m_bProbeThreadRunning(false)
+	, m_eFrameMode(FrameScheduler::VSYNC)
+	, m_dFixedFrameRate(0.0)
+	, m_dDisplayRefreshRate(60.0)
+	, m_LastRenderStats()
+	, m_bGLInitialized(false)
+	, m_bShowDiagnostics(false)
+	, m_bConditionScreenshotsInProgress(false)
 	, m_pMainWindow(NULL)
 	, m_pLeftEyeFramebuffer(NULL)
 	, m_pRightEyeFramebuffer(NULL)
 	, m_pAngleStudy(NULL)
 	, m_pMagStudy(NULL)
-	, m_bShowDiagnostics(false)
-	, m_bConditionScreenshotsInProgress(false)
 {
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::string(argv[i]) == "--latency-benchmark")
+		{
+			m_bLatencyBenchmark = true;
+			if (i + 1 < argc && atoi(argv[i + 1]) > 0)
+				m_uiLatencyBenchmarkSamples = atoi(argv[++i]);
+		}
+		else if (std::string(argv[i]) == "--frame-mode" && i + 1 < argc)
+		{
+			if (!FrameScheduler::parseMode(argv[++i], m_eFrameMode))
+				printf("Unknown frame mode %s; expected vsync, adaptive, fixed or uncapped\n", argv[i]);
+		}
+		else if (std::string(argv[i]) == "--frame-rate" && i + 1 < argc)
+		{
+			m_dFixedFrameRate = atof(argv[++i]);
+		}
+		else if (std::string(argv[i]) == "--mesh" && i + 1 < argc)
+		{
+			m_vstrMeshFiles.push_back(argv[++i]);
+		}
+		else if (std::string(argv[i]) == "--cloud" && i + 1 < argc)
+		{
+			m_vstrCloudFiles.push_back(argv[++i]);
+		}
+	}
 };
 
 
@@ -139,9 +174,23 @@ bool Engine::init()
 		//return false;
 	}
 
+	FrameTiming::getInstance().init();
+	Profiler::getInstance().init();
+
+	m_FrameScheduler.init(m_pMainWindow, m_dDisplayRefreshRate);
+	m_FrameScheduler.setMode(m_eFrameMode, m_dFixedFrameRate);
+
 	GLFWInputBroadcaster::getInstance().init(m_pMainWindow);
 
-	GLFWInputBroadcaster::getInstance().addObserver(this);
+	GLFWInputBroadcaster::getInstance().addObserver(this, INPUT_MASK_KEYS | INPUT_MASK(InputEvent::PROBE));
+
+	if (m_bLatencyBenchmark)
+	{
+		printf("Latency benchmark: timing %u probe events from input to swap completion\n", m_uiLatencyBenchmarkSamples);
+		FrameTiming::getInstance().setFrameCallback(std::bind(&Engine::onFrameTimed, this, std::placeholders::_1));
+		m_bProbeThreadRunning = true;
+		m_ProbeThread = std::thread(&Engine::probeLoop, this);
+	}
 
 
 	glfwSetInputMode(m_pMainWindow, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -169,11 +218,35 @@ bool Engine::init()
 
 	//m_pAngleStudy = new AngleStudy();
 	//m_pAngleStudy->init(m_ivec2MainWindowSize, screenTrans);
-	//GLFWInputBroadcaster::getInstance().addObserver(m_pAngleStudy);
+	//GLFWInputBroadcaster::getInstance().addObserver(m_pAngleStudy, INPUT_MASK_KEYS);
 
 	m_pMagStudy = new MagnitudeStudy();
 	m_pMagStudy->init(m_ivec2MainWindowSize, screenTrans);
-	GLFWInputBroadcaster::getInstance().addObserver(m_pMagStudy);
+	GLFWInputBroadcaster::getInstance().addObserver(m_pMagStudy, INPUT_MASK_KEYS);
+
+	// the bounds are in the file header, so meshes can be placed before any of their data is uploaded
+	for (auto const &path : m_vstrMeshFiles)
+	{
+		if (!Renderer::getInstance().streamPrimitive(path, path))
+			continue;
+
+		glm::vec4 bounds = Renderer::getInstance().getPrimitiveBoundingSphere(path);
+		float scale = bounds.w > 0.f ? screenSize_cm.y * 0.5f / bounds.w : 1.f;
+
+		m_vStreamedMeshes.push_back(std::make_pair(path, glm::translate(glm::mat4(), g_vec3ScreenPos) * glm::scale(glm::mat4(), glm::vec3(scale)) * glm::translate(glm::mat4(), -glm::vec3(bounds))));
+	}
+
+	// survey clouds are z-up, so they are tipped onto the y-up screen space
+	for (auto const &path : m_vstrCloudFiles)
+	{
+		if (!Renderer::getInstance().addPointCloud(path, path))
+			continue;
+
+		glm::vec4 bounds = Renderer::getInstance().getPointCloud(path)->getBoundingSphere();
+		float scale = bounds.w > 0.f ? screenSize_cm.y * 0.5f / bounds.w : 1.f;
+
+		m_vPointClouds.push_back(std::make_pair(path, glm::translate(glm::mat4(), g_vec3ScreenPos) * glm::scale(glm::mat4(), glm::vec3(scale)) * glm::rotate(glm::mat4(), glm::radians(-90.f), glm::vec3(1.f, 0.f, 0.f)) * glm::translate(glm::mat4(), -glm::vec3(bounds))));
+	}
 
 	return true;
 }
@@ -228,6 +301,16 @@ bool Engine::initGL(bool stereoContext)
 //-----------------------------------------------------------------------------
 void Engine::Shutdown()
 {
+	m_bProbeThreadRunning = false;
+	if (m_ProbeThread.joinable())
+		m_ProbeThread.join();
+
+	Profiler::getInstance().shutdown();
+	FrameTiming::getInstance().setFrameCallback(FrameTiming::FrameCallback());
+	FrameTiming::getInstance().shutdown();
+
+	printf("%s", m_FrameScheduler.histogramString().c_str());
+
 	if (m_pAngleStudy)
 	{
 		GLFWInputBroadcaster::getInstance().removeObserver(m_pAngleStudy);
@@ -264,30 +347,74 @@ void Engine::HandleInput()
 	GLFWInputBroadcaster::getInstance().poll();
 }
 
-void Engine::receive(void * data)
+void Engine::receive(const InputEvent &ev)
 {
-	int eventData[2];
-
-	memcpy(&eventData, data, sizeof(int) * 2);
+	if (ev.type == InputEvent::PROBE)
+	{
+		m_qPendingProbes.push_back({ ev.time, std::chrono::high_resolution_clock::now(), FrameTiming::getInstance().currentFrame() });
+		return;
+	}
 
-	if (eventData[0] == GLFWInputBroadcaster::EVENT::KEY_DOWN)
+	if (ev.type == GLFWInputBroadcaster::EVENT::KEY_DOWN)
 	{
-		//if (eventData[1] == GLFW_KEY_ESCAPE && ((m_pAngleStudy->isStudyActive() && (glfwGetKey(m_pMainWindow, GLFW_KEY_LEFT_SHIFT) || glfwGetKey(m_pMainWindow, GLFW_KEY_RIGHT_SHIFT))) || !m_pAngleStudy->isStudyActive()))
+		//if (ev.code == GLFW_KEY_ESCAPE && ((m_pAngleStudy->isStudyActive() && (glfwGetKey(m_pMainWindow, GLFW_KEY_LEFT_SHIFT) || glfwGetKey(m_pMainWindow, GLFW_KEY_RIGHT_SHIFT))) || !m_pAngleStudy->isStudyActive()))
 		//{
 		//	glfwSetWindowShouldClose(m_pMainWindow, GLFW_TRUE);
 		//}
 
-		if (eventData[1] == GLFW_KEY_ESCAPE && ((m_pMagStudy->isStudyActive() && (glfwGetKey(m_pMainWindow, GLFW_KEY_LEFT_SHIFT) || glfwGetKey(m_pMainWindow, GLFW_KEY_RIGHT_SHIFT))) || !m_pMagStudy->isStudyActive()))
+		if (ev.code == GLFW_KEY_ESCAPE && ((m_pMagStudy->isStudyActive() && (glfwGetKey(m_pMainWindow, GLFW_KEY_LEFT_SHIFT) || glfwGetKey(m_pMainWindow, GLFW_KEY_RIGHT_SHIFT))) || !m_pMagStudy->isStudyActive()))
 		{
 			glfwSetWindowShouldClose(m_pMainWindow, GLFW_TRUE);
 		}
 
-		if (eventData[1] == GLFW_KEY_F11)
+		if (ev.code == GLFW_KEY_F11)
+		{
+			if (ev.mods & GLFW_MOD_SHIFT)
+			{
+				std::stringstream ss;
+				ss << "profile_" << std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count() << ".json";
+				Profiler::getInstance().captureTrace(ss.str());
+				Renderer::getInstance().showMessage("Capturing " + std::to_string(PROFILER_TRACE_FRAMES) + " frames to " + ss.str());
+			}
+			else
+				m_bShowDiagnostics = !m_bShowDiagnostics;
+		}
+
+		// renderer toggles are Ctrl-modified, since MagnitudeStudy uses the plain function keys;
+		// keep the list in drawDiagnostics() in step
+		if (ev.code == GLFW_KEY_F10 && (ev.mods & GLFW_MOD_CONTROL) && !m_pMagStudy->isStudyActive())
+		{
+			Renderer::getInstance().setCulling(!Renderer::getInstance().getCulling());
+			Renderer::getInstance().showMessage(std::string("Culling: ") + (Renderer::getInstance().getCulling() ? "on" : "off"));
+		}
+
+		if (ev.code == GLFW_KEY_F9 && (ev.mods & GLFW_MOD_CONTROL) && !m_pMagStudy->isStudyActive())
+		{
+			Renderer::TransparencyMode mode = static_cast<Renderer::TransparencyMode>((Renderer::getInstance().getTransparencyMode() + 1) % (Renderer::TRANSPARENCY_AUTO + 1));
+			Renderer::getInstance().setTransparencyMode(mode);
+			Renderer::getInstance().showMessage(std::string("Transparency: ") + Renderer::transparencyModeName(mode));
+		}
+
+		if (ev.code == GLFW_KEY_F8 && (ev.mods & GLFW_MOD_CONTROL) && !m_pMagStudy->isStudyActive())
+		{
+			Renderer::getInstance().setMultiDrawIndirect(!Renderer::getInstance().getMultiDrawIndirect());
+			Renderer::getInstance().showMessage(std::string("Multi-draw indirect: ") + (Renderer::getInstance().getMultiDrawIndirect() ? "on" : "off"));
+		}
+
+		if (ev.code == GLFW_KEY_F7 && (ev.mods & GLFW_MOD_CONTROL) && !m_pMagStudy->isStudyActive())
 		{
-			m_bShowDiagnostics = !m_bShowDiagnostics;
+			Renderer::getInstance().setLevelOfDetail(!Renderer::getInstance().getLevelOfDetail());
+			Renderer::getInstance().showMessage(std::string("Level of detail: ") + (Renderer::getInstance().getLevelOfDetail() ? "on" : "off"));
 		}
 
-		if (eventData[1] == GLFW_KEY_PRINT_SCREEN && !m_pMagStudy->isStudyActive())
+		if (ev.code == GLFW_KEY_F12 && !m_pMagStudy->isStudyActive())
+		{
+			m_eFrameMode = static_cast<FrameScheduler::Mode>((m_eFrameMode + 1) % (FrameScheduler::UNCAPPED + 1));
+			m_FrameScheduler.setMode(m_eFrameMode, m_dFixedFrameRate);
+			Renderer::getInstance().showMessage(std::string("Frame pacing: ") + FrameScheduler::modeName(m_eFrameMode));
+		}
+
+		if (ev.code == GLFW_KEY_PRINT_SCREEN && !m_pMagStudy->isStudyActive())
 		{
 			m_bConditionScreenshotsInProgress = true;
 			m_pMagStudy->generateTrials(false);
@@ -295,7 +422,7 @@ void Engine::receive(void * data)
 
 	}
 
-	if (eventData[0] == GLFWInputBroadcaster::EVENT::KEY_DOWN || eventData[0] == GLFWInputBroadcaster::EVENT::KEY_HOLD)
+	if (ev.type == GLFWInputBroadcaster::EVENT::KEY_DOWN || ev.type == GLFWInputBroadcaster::EVENT::KEY_HOLD)
 	{	
 
 	}
@@ -314,26 +441,54 @@ void Engine::RunMainLoop()
 
 	while (!glfwWindowShouldClose(m_pMainWindow))
 	{
+		FrameTiming::getInstance().beginFrame();
+		Profiler::getInstance().beginFrame();
+
 		auto currentTime = clock::now();
 		m_msFrameTime = currentTime - lastTime;
 		lastTime = currentTime;
 
 		auto a = clock::now();
-		HandleInput();
+		{
+			PROFILE_SCOPE("input");
+			HandleInput();
+		}
 		m_msInputHandleTime = clock::now() - a;
 
 		a = clock::now();
-		update();
+		{
+			PROFILE_SCOPE("update");
+			update();
+		}
 		m_msUpdateTime = clock::now() - a;
 
 		a = clock::now();
-		makeScene();
+		{
+			PROFILE_SCOPE("scene");
+			makeScene();
+		}
 		m_msDrawTime = clock::now() - a;
 
 		a = clock::now();
-		render();
+		{
+			PROFILE_SCOPE("pacing wait");
+			m_FrameScheduler.waitForLatch();
+			latchViews();
+		}
+		m_msWaitTime = clock::now() - a;
+
+		a = clock::now();
+		{
+			PROFILE_SCOPE("render");
+			render();
+		}
 		m_msRenderTime = clock::now() - a;
 
+		m_LastRenderStats = Renderer::getInstance().getRenderStats();
+		Renderer::getInstance().resetRenderStats();
+
+		Profiler::getInstance().endFrame();
+
 		if (m_bConditionScreenshotsInProgress)
 		{
 			std::string cond = m_pMagStudy->conditionString();
@@ -352,13 +507,76 @@ void Engine::RunMainLoop()
 }
 
 
-void Engine::update()
+//-----------------------------------------------------------------------------
+// Purpose: Latency benchmark input source. Probes are posted from this thread
+//			at random intervals so they land at every phase of the frame loop,
+//			the way real key presses do.
+//-----------------------------------------------------------------------------
+void Engine::probeLoop()
 {
-	float sizer = g_fDisplayDiag / sqrt(m_ivec2MainWindowSize.x * m_ivec2MainWindowSize.x + m_ivec2MainWindowSize.y * m_ivec2MainWindowSize.y);
+	std::default_random_engine generator(std::random_device{}());
+	std::uniform_int_distribution<int> intervalUS(2000, 25000);
 
-	float width_cm = m_ivec2MainWindowSize.x * sizer;
-	float height_cm = m_ivec2MainWindowSize.y * sizer;
+	int seq = 0;
+
+	while (m_bProbeThreadRunning)
+	{
+		std::this_thread::sleep_for(std::chrono::microseconds(intervalUS(generator)));
+
+		InputEvent ev;
+		ev.type = InputEvent::PROBE;
+		ev.time = std::chrono::high_resolution_clock::now();
+		ev.code = seq++;
+		ev.mods = 0;
+		ev.x = ev.y = 0.f;
+		GLFWInputBroadcaster::getInstance().post(ev);
+	}
+}
 
+void Engine::onFrameTimed(const FrameTiming::FrameRecord &rec)
+{
+	while (!m_qPendingProbes.empty() && m_qPendingProbes.front().frame <= rec.frame)
+	{
+		LatencyProbe const &p = m_qPendingProbes.front();
+
+		if (p.frame == rec.frame && m_vdProbeTotalMS.size() < m_uiLatencyBenchmarkSamples)
+		{
+			m_vdProbeQueueMS.push_back(std::chrono::duration<double, std::milli>(p.handled - p.posted).count());
+			m_vdProbeTotalMS.push_back(std::chrono::duration<double, std::milli>(rec.completed - p.posted).count());
+		}
+
+		m_qPendingProbes.pop_front();
+	}
+
+	if (m_vdProbeTotalMS.size() == m_uiLatencyBenchmarkSamples && !m_bLatencyBenchmarkReported)
+	{
+		reportLatencyBenchmark();
+		m_bLatencyBenchmarkReported = true;
+		glfwSetWindowShouldClose(m_pMainWindow, GLFW_TRUE);
+	}
+}
+
+void Engine::reportLatencyBenchmark()
+{
+	auto summarize = [](const char* label, std::vector<double> v) {
+		std::sort(v.begin(), v.end());
+		double sum = 0.0;
+		for (double x : v)
+			sum += x;
+		auto pct = [&v](double p) { return v[std::min(v.size() - 1u, static_cast<size_t>(p * v.size()))]; };
+		printf("  %-22s mean %7.3f  min %7.3f  p50 %7.3f  p95 %7.3f  p99 %7.3f  max %7.3f ms\n",
+			label, sum / v.size(), v.front(), pct(0.5), pct(0.95), pct(0.99), v.back());
+	};
+
+	printf("Latency benchmark: %u probes\n", m_uiLatencyBenchmarkSamples);
+	summarize("input -> dispatch", m_vdProbeQueueMS);
+	summarize("input -> swap complete", m_vdProbeTotalMS);
+	printf("  refresh period %.3f ms, mean swap interval %.3f ms\n", m_FrameScheduler.getRefreshPeriod() * 1000.0, m_FrameScheduler.getSwapInterval() * 1000.0);
+	printf("%s", m_FrameScheduler.histogramString().c_str());
+}
+
+void Engine::update()
+{
 	if (m_bConditionScreenshotsInProgress && m_pMagStudy->trialsRemaining() > 0)
 	{		
 		m_pMagStudy->loadNextCondition();
@@ -367,8 +585,21 @@ void Engine::update()
 		m_bConditionScreenshotsInProgress = false;
 		
 	//m_pAngleStudy->update();
+	m_pMagStudy->setFramePeriod(m_FrameScheduler.getFramePeriod());
+	m_pMagStudy->setPhotonTime(m_FrameScheduler.predictPhotonTime());
 	m_pMagStudy->update();
 
+	Renderer::getInstance().updateStreaming();
+}
+
+void Engine::latchViews()
+{
+	float sizer = g_fDisplayDiag / sqrt(m_ivec2MainWindowSize.x * m_ivec2MainWindowSize.x + m_ivec2MainWindowSize.y * m_ivec2MainWindowSize.y);
+
+	float width_cm = m_ivec2MainWindowSize.x * sizer;
+	float height_cm = m_ivec2MainWindowSize.y * sizer;
+
+	m_pMagStudy->latchViewAngle(m_FrameScheduler.predictPhotonTime());
 
 	//if (g_bStereo)
 	//{
@@ -395,14 +626,9 @@ void Engine::update()
 
 	if (g_bStereo)
 	{
-		glm::vec3 COP = m_pMagStudy->getCOP();
-		glm::quat COPRot = glm::inverse(glm::lookAt(COP, glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f)));
-		glm::vec3 COPRight = glm::normalize(glm::mat3_cast(COPRot)[0]);
-		glm::vec3 COPOffset = COPRight * m_pMagStudy->getEyeSep() * 0.5f;
-
 		// Update eye positions using current head position
-		glm::vec3 leftEyePos = COP - COPOffset;
-		glm::vec3 rightEyePos = COP + COPOffset;
+		glm::vec3 leftEyePos, rightEyePos;
+		m_pMagStudy->getEyePositions(leftEyePos, rightEyePos);
 
 		m_sviLeftEyeInfo.view = glm::translate(glm::mat4(), -leftEyePos);
 		m_sviLeftEyeInfo.projection = getViewingFrustum(leftEyePos, g_vec3ScreenPos, g_vec3ScreenNormal, g_vec3ScreenUp, glm::vec2(width_cm, height_cm));
@@ -468,6 +694,12 @@ void Engine::makeScene()
 	//m_pAngleStudy->draw();
 	m_pMagStudy->draw();
 
+	for (auto const &mesh : m_vStreamedMeshes)
+		Renderer::getInstance().drawFlatPrimitive(mesh.first, mesh.second, glm::vec4(1.f));
+
+	for (auto const &cloud : m_vPointClouds)
+		Renderer::getInstance().drawPointCloud(cloud.first, cloud.second);
+
 	if (m_bShowDiagnostics)
 		drawDiagnostics();
 
@@ -482,17 +714,38 @@ void Engine::render()
 
 	if (g_bStereo)
 	{
-		Renderer::getInstance().RenderFrame(&m_sviLeftEyeInfo, &m_sviUIInfo, m_pLeftEyeFramebuffer);
-		Renderer::getInstance().RenderFrame(&m_sviRightEyeInfo, &m_sviUIInfo, m_pRightEyeFramebuffer);
-		Renderer::getInstance().RenderStereoTexture(m_ivec2MainWindowSize.x, m_ivec2MainWindowSize.y, m_pLeftEyeFramebuffer->m_nResolveTextureId, m_pRightEyeFramebuffer->m_nResolveTextureId);
+		{
+			PROFILE_GPU_SCOPE("left eye");
+			Renderer::getInstance().RenderFrame(&m_sviLeftEyeInfo, &m_sviUIInfo, m_pLeftEyeFramebuffer);
+		}
+		{
+			PROFILE_GPU_SCOPE("right eye");
+			Renderer::getInstance().RenderFrame(&m_sviRightEyeInfo, &m_sviUIInfo, m_pRightEyeFramebuffer);
+		}
+		{
+			PROFILE_GPU_SCOPE("composite");
+			Renderer::getInstance().RenderStereoTexture(m_ivec2MainWindowSize.x, m_ivec2MainWindowSize.y, m_pLeftEyeFramebuffer->m_nResolveTextureId, m_pRightEyeFramebuffer->m_nResolveTextureId);
+		}
 	}
 	else
 	{
-		Renderer::getInstance().RenderFrame(&m_sviMonoInfo, &m_sviUIInfo, m_pMonoFramebuffer);
-		Renderer::getInstance().RenderFullscreenTexture(m_ivec2MainWindowSize.x, m_ivec2MainWindowSize.y, m_pMonoFramebuffer->m_nResolveTextureId);
+		{
+			PROFILE_GPU_SCOPE("mono");
+			Renderer::getInstance().RenderFrame(&m_sviMonoInfo, &m_sviUIInfo, m_pMonoFramebuffer);
+		}
+		{
+			PROFILE_GPU_SCOPE("composite");
+			Renderer::getInstance().RenderFullscreenTexture(m_ivec2MainWindowSize.x, m_ivec2MainWindowSize.y, m_pMonoFramebuffer->m_nResolveTextureId);
+		}
 	}
 	
-	glfwSwapBuffers(m_pMainWindow);
+	{
+		PROFILE_SCOPE("swap");
+		glfwSwapBuffers(m_pMainWindow);
+	}
+
+	m_FrameScheduler.onSwap();
+	FrameTiming::getInstance().markSwap();
 	
 	Renderer::getInstance().clearDynamicRenderQueue();
 	Renderer::getInstance().clearUIRenderQueue();
@@ -535,8 +788,21 @@ void Engine::drawDiagnostics()
 	ss << "Input Handling: " << m_msInputHandleTime.count() << "ms" << std::endl;
 	ss << "State Update: " << m_msUpdateTime.count() << "ms" << std::endl;
 	ss << "Scene Drawing: " << m_msDrawTime.count() << "ms" << std::endl;
+	ss << "Pacing Wait: " << m_msWaitTime.count() << "ms" << std::endl;
 	ss << "Rendering: " << m_msRenderTime.count() << "ms" << std::endl;
 	ss << 1.f / std::chrono::duration_cast<std::chrono::duration<float>>(m_msFrameTime).count() << "fps" << std::endl;
+	ss << FrameScheduler::modeName(m_FrameScheduler.getMode()) << " p50/p99: " << m_FrameScheduler.percentileFrameMS(0.5) << "/" << m_FrameScheduler.percentileFrameMS(0.99) << "ms, " << m_FrameScheduler.missedFrameCount() << " missed" << std::endl;
+	ss << "Drawn: " << m_LastRenderStats.submissions << " in " << m_LastRenderStats.drawCalls << " draw calls" << (Renderer::getInstance().getBindlessTextures() ? " (MDI, bindless)" : Renderer::getInstance().getMultiDrawIndirect() ? " (MDI)" : "") << ", culled: " << m_LastRenderStats.culledOutside << " outside + " << m_LastRenderStats.culledTooSmall << " too small" << (Renderer::getInstance().getCulling() ? "" : " (culling off)") << ", coarser LODs: " << m_LastRenderStats.coarserLODs << (Renderer::getInstance().getLevelOfDetail() ? "" : " (LOD off)") << std::endl;
+	ss << "Transparency: " << Renderer::transparencyModeName(Renderer::getInstance().getTransparencyMode()) << (Renderer::getInstance().usingOIT() ? " (OIT)" : " (sorted)") << std::endl;
+	if (Renderer::getInstance().getStreamingBytesPending() > 0u)
+		ss << "Streaming: " << Renderer::getInstance().getStreamingBytesPending() / (1024.f * 1024.f) << "MB left, " << m_LastRenderStats.streamedBytes / (1024.f * 1024.f) << "MB this frame" << std::endl;
+	for (auto const &cloud : m_vPointClouds)
+	{
+		PointCloud::Stats pcStats = Renderer::getInstance().getPointCloud(cloud.first)->getStats();
+		ss << "Points: " << m_LastRenderStats.pointCloudPoints / 1000000.f << "M in " << m_LastRenderStats.pointCloudNodes << " nodes, " << pcStats.residentNodes << "/" << pcStats.slots << " slots resident, " << pcStats.loadsPending << " loading" << std::endl;
+	}
+	ss << "Keys: Ctrl+F7 LOD, Ctrl+F8 multi-draw, Ctrl+F9 transparency, Ctrl+F10 culling" << std::endl;
+	ss << std::endl << Profiler::getInstance().statsString();
 
 	Renderer::getInstance().drawUIText(
 		ss.str(),
@@ -600,7 +866,10 @@ GLFWwindow * Engine::createWindow(GLFWmonitor* monitor, int width, int height, b
 	
 	glfwMakeContextCurrent(ret);
 
-	glfwSwapInterval(0);
+	// the swap interval is set by the frame scheduler
+	const GLFWvidmode *currentMode = glfwGetVideoMode(monitor);
+	if (currentMode && currentMode->refreshRate > 0)
+		m_dDisplayRefreshRate = currentMode->refreshRate;
 
 	return ret;
 }
@@ -640,11 +909,6 @@ glm::mat4 Engine::getViewingFrustum(glm::vec3 eyePos, glm::vec3 screenCenter, gl
 
 void Engine::createMonoView()
 {
-	float sizer = g_fDisplayDiag / sqrt(m_ivec2MainWindowSize.x * m_ivec2MainWindowSize.x + m_ivec2MainWindowSize.y * m_ivec2MainWindowSize.y);
-
-	float width_cm = m_ivec2MainWindowSize.x * sizer; 
-	float height_cm = m_ivec2MainWindowSize.y * sizer;
-
 	m_sviMonoInfo.m_nRenderWidth = m_ivec2MainWindowSize.x;
 	m_sviMonoInfo.m_nRenderHeight = m_ivec2MainWindowSize.y;
 
@@ -1,20 +1,24 @@
 #pragma once
 
-#define _WINSOCKAPI_
+#include "Platform.h"
 
 #include <chrono>
 #include <vector>
+#include <thread>
+#include <atomic>
+#include <deque>
 
 #include <GL/glew.h>
-#include <Windows.h>
 #include <GLFW/glfw3.h>
-#include <gl/glu.h>
 #include <glm.hpp>
 
 #include "GLFWInputBroadcaster.h"
 #include "Renderer.h"
 #include "AngleStudy.h"
 #include "MagnitudeStudy.h"
+#include "FrameTiming.h"
+#include "FrameScheduler.h"
+#include "Profiler.h"
 
 
 //-----------------------------------------------------------------------------
@@ -35,7 +39,38 @@ public:
 	void HandleInput();
 	
 private:
-	std::chrono::duration<double, std::milli> m_msFrameTime, m_msInputHandleTime, m_msUpdateTime, m_msVRUpdateTime, m_msDrawTime, m_msRenderTime;
+	std::chrono::duration<double, std::milli> m_msFrameTime, m_msInputHandleTime, m_msUpdateTime, m_msVRUpdateTime, m_msDrawTime, m_msWaitTime, m_msRenderTime;
+
+	// --latency-benchmark: a thread posts probe input events at random times, and each probe is
+	// timed from its timestamp to the GPU completion of the first frame swapped after it was handled
+	struct LatencyProbe {
+		std::chrono::high_resolution_clock::time_point posted;
+		std::chrono::high_resolution_clock::time_point handled;
+		unsigned long long frame;
+	};
+
+	bool m_bLatencyBenchmark;
+	unsigned int m_uiLatencyBenchmarkSamples;
+	bool m_bLatencyBenchmarkReported;
+	std::atomic<bool> m_bProbeThreadRunning;
+	std::thread m_ProbeThread;
+	std::deque<LatencyProbe> m_qPendingProbes;
+	std::vector<double> m_vdProbeQueueMS, m_vdProbeTotalMS;
+
+	FrameScheduler m_FrameScheduler;
+	FrameScheduler::Mode m_eFrameMode;
+	double m_dFixedFrameRate;
+	double m_dDisplayRefreshRate;
+
+	Renderer::RenderStats m_LastRenderStats; // previous frame's render queue totals for the diagnostics overlay
+
+	// --mesh: mesh files streamed in as primitives and drawn fitted to the screen
+	std::vector<std::string> m_vstrMeshFiles;
+	std::vector<std::pair<std::string, glm::mat4>> m_vStreamedMeshes;
+
+	// --cloud: point octrees (see PointOctreeBuilder) drawn fitted to the screen
+	std::vector<std::string> m_vstrCloudFiles;
+	std::vector<std::pair<std::string, glm::mat4>> m_vPointClouds;
 
 	bool m_bGLInitialized;
 	bool m_bShowDiagnostics;
@@ -65,9 +100,15 @@ private:
 
 	void update();
 	void makeScene();
+	// eye poses are set as late as possible, right before the frame is submitted
+	void latchViews();
 	void render();
 
-	void receive(void* data);
+	void receive(const InputEvent &ev);
+
+	void probeLoop();
+	void onFrameTimed(const FrameTiming::FrameRecord &rec);
+	void reportLatencyBenchmark();
 
 	void createMonoView();
 	void createStereoViews();
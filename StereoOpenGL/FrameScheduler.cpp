@@ -0,0 +1,255 @@
+#include "FrameScheduler.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <thread>
+
+typedef FrameScheduler::Clock Clock;
+
+static Clock::duration toDuration(double seconds)
+{
+	return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+FrameScheduler::FrameScheduler()
+	: m_pWindow(NULL)
+	, m_eMode(VSYNC)
+	, m_dRefreshPeriod(1.0 / 60.0)
+	, m_dFixedPeriod(1.0 / 60.0)
+	, m_bTearControl(false)
+	, m_dSwapInterval(0.0)
+	, m_dSubmitTime(0.0)
+{
+	resetStats();
+}
+
+void FrameScheduler::init(GLFWwindow * window, double refreshRateHz)
+{
+	m_pWindow = window;
+
+	if (refreshRateHz > 0.0)
+		m_dRefreshPeriod = 1.0 / refreshRateHz;
+
+	m_bTearControl = glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear");
+}
+
+void FrameScheduler::setMode(Mode mode, double fixedRateHz)
+{
+	m_eMode = mode;
+	m_dFixedPeriod = fixedRateHz > 0.0 ? 1.0 / fixedRateHz : m_dRefreshPeriod;
+
+	switch (mode)
+	{
+	case VSYNC:
+		glfwSwapInterval(1);
+		break;
+	case ADAPTIVE:
+		glfwSwapInterval(m_bTearControl ? -1 : 1);
+		if (!m_bTearControl)
+			printf("FrameScheduler: adaptive vsync is not supported by the driver; using vsync\n");
+		break;
+	case FIXED_RATE:
+	case UNCAPPED:
+		glfwSwapInterval(0);
+		break;
+	}
+
+	m_tDeadline = Clock::now() + toDuration(m_dFixedPeriod);
+	m_dSwapInterval = 0.0;
+
+	resetStats();
+
+	printf("FrameScheduler: %s, %.2f Hz frames on a %.2f Hz display\n", modeName(mode), 1.0 / getFramePeriod(), 1.0 / m_dRefreshPeriod);
+}
+
+const char * FrameScheduler::modeName(Mode mode)
+{
+	switch (mode)
+	{
+	case VSYNC:			return "vsync";
+	case ADAPTIVE:		return "adaptive";
+	case FIXED_RATE:	return "fixed";
+	case UNCAPPED:		return "uncapped";
+	}
+
+	return "unknown";
+}
+
+bool FrameScheduler::parseMode(std::string name, Mode & mode)
+{
+	for (Mode m : { VSYNC, ADAPTIVE, FIXED_RATE, UNCAPPED })
+	{
+		if (name == modeName(m))
+		{
+			mode = m;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+double FrameScheduler::getFramePeriod() const
+{
+	switch (m_eMode)
+	{
+	case FIXED_RATE:
+		return m_dFixedPeriod;
+	case UNCAPPED:
+		return m_dSwapInterval > 0.0 ? m_dSwapInterval : m_dRefreshPeriod;
+	default:
+		return m_dRefreshPeriod;
+	}
+}
+
+unsigned int FrameScheduler::framesFor(double seconds) const
+{
+	return std::max(1u, static_cast<unsigned int>(std::round(seconds / getFramePeriod())));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Sleep until close to the latch point, then spin the rest of the
+//			way; OS sleeps overshoot by a millisecond or more. The latch point
+//			is the deadline less the time submits have been taking.
+//-----------------------------------------------------------------------------
+void FrameScheduler::waitForLatch()
+{
+	if (m_eMode == FIXED_RATE)
+	{
+		Clock::time_point latchAt = m_tDeadline - toDuration(m_dSubmitTime * 1.5 + FRAMESCHEDULER_LATCH_MARGIN_MS / 1000.0);
+		Clock::time_point sleepUntil = latchAt - toDuration(FRAMESCHEDULER_SPIN_MS / 1000.0);
+
+		if (Clock::now() < sleepUntil)
+			std::this_thread::sleep_until(sleepUntil);
+
+		while (Clock::now() < latchAt)
+			std::this_thread::yield();
+	}
+
+	m_tLatch = Clock::now();
+}
+
+Clock::time_point FrameScheduler::predictPhotonTime() const
+{
+	// scanout reaches the middle of the screen half a refresh after the frame starts showing
+	Clock::duration halfRefresh = toDuration(m_dRefreshPeriod * 0.5);
+
+	switch (m_eMode)
+	{
+	case VSYNC:
+	case ADAPTIVE:
+		// the swap returns at a vblank; the frame being built now shows from the next one
+		if (m_tLastSwap != Clock::time_point())
+			return m_tLastSwap + toDuration(m_dRefreshPeriod) + halfRefresh;
+		break;
+	case FIXED_RATE:
+		// no vsync: the image replaces the old one wherever scanout is when it is swapped
+		return m_tDeadline + halfRefresh;
+	case UNCAPPED:
+		if (m_tLastSwap != Clock::time_point())
+			return m_tLastSwap + toDuration(m_dSwapInterval) + halfRefresh;
+		break;
+	}
+
+	return Clock::now() + halfRefresh;
+}
+
+void FrameScheduler::onSwap()
+{
+	Clock::time_point now = Clock::now();
+
+	if (m_tLatch != Clock::time_point())
+	{
+		double submit = std::chrono::duration<double>(now - m_tLatch).count();
+		m_dSubmitTime = m_dSubmitTime > 0.0 ? m_dSubmitTime + (submit - m_dSubmitTime) * 0.1 : submit;
+	}
+
+	if (m_tLastSwap != Clock::time_point())
+	{
+		double interval = std::chrono::duration<double>(now - m_tLastSwap).count();
+		m_dSwapInterval = m_dSwapInterval > 0.0 ? m_dSwapInterval + (interval - m_dSwapInterval) * 0.1 : interval;
+		addFrameTime(interval);
+	}
+
+	m_tLastSwap = now;
+
+	if (m_eMode == FIXED_RATE)
+	{
+		m_tDeadline += toDuration(m_dFixedPeriod);
+
+		// after a stall, start a fresh schedule rather than rushing to catch up
+		if (m_tDeadline < now)
+			m_tDeadline = now + toDuration(m_dFixedPeriod);
+	}
+}
+
+void FrameScheduler::resetStats()
+{
+	std::fill(m_arrHistogram, m_arrHistogram + FRAMESCHEDULER_HISTOGRAM_BINS, 0ull);
+	m_nFrames = 0ull;
+	m_nMissedFrames = 0ull;
+	m_dFrameTimeSum = 0.0;
+}
+
+void FrameScheduler::addFrameTime(double seconds)
+{
+	double ms = seconds * 1000.0;
+	unsigned int bin = std::min(FRAMESCHEDULER_HISTOGRAM_BINS - 1u, static_cast<unsigned int>(ms / FRAMESCHEDULER_HISTOGRAM_BIN_MS));
+
+	m_arrHistogram[bin]++;
+	m_nFrames++;
+	m_dFrameTimeSum += seconds;
+
+	// a frame that took half again as long as it should have was shown for at least one extra refresh
+	if (m_eMode != UNCAPPED && seconds > getFramePeriod() * 1.5)
+		m_nMissedFrames++;
+}
+
+double FrameScheduler::meanFrameMS() const
+{
+	return m_nFrames > 0ull ? m_dFrameTimeSum * 1000.0 / m_nFrames : 0.0;
+}
+
+double FrameScheduler::percentileFrameMS(double p) const
+{
+	if (m_nFrames == 0ull)
+		return 0.0;
+
+	unsigned long long target = static_cast<unsigned long long>(std::ceil(p * m_nFrames));
+	unsigned long long seen = 0ull;
+
+	for (unsigned int i = 0u; i < FRAMESCHEDULER_HISTOGRAM_BINS; ++i)
+	{
+		seen += m_arrHistogram[i];
+		if (seen >= target)
+			return (i + 1u) * FRAMESCHEDULER_HISTOGRAM_BIN_MS;
+	}
+
+	return FRAMESCHEDULER_HISTOGRAM_BINS * FRAMESCHEDULER_HISTOGRAM_BIN_MS;
+}
+
+std::string FrameScheduler::histogramString() const
+{
+	std::stringstream ss;
+	ss.precision(2);
+
+	ss << std::fixed << modeName(m_eMode) << ": " << m_nFrames << " frames, mean " << meanFrameMS() << " ms, p50 " << percentileFrameMS(0.5)
+		<< " ms, p99 " << percentileFrameMS(0.99) << " ms, " << m_nMissedFrames << " missed" << std::endl;
+
+	unsigned long long peak = *std::max_element(m_arrHistogram, m_arrHistogram + FRAMESCHEDULER_HISTOGRAM_BINS);
+
+	for (unsigned int i = 0u; i < FRAMESCHEDULER_HISTOGRAM_BINS; ++i)
+	{
+		if (m_arrHistogram[i] == 0ull)
+			continue;
+
+		ss << (i == FRAMESCHEDULER_HISTOGRAM_BINS - 1u ? ">" : " ") << i * FRAMESCHEDULER_HISTOGRAM_BIN_MS << " ms "
+			<< std::string(static_cast<size_t>(1ull + 40ull * m_arrHistogram[i] / peak), '#') << " " << m_arrHistogram[i] << std::endl;
+	}
+
+	return ss.str();
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+#define FRAMESCHEDULER_HISTOGRAM_BINS		200		// frame-time histogram bins
+#define FRAMESCHEDULER_HISTOGRAM_BIN_MS		0.25	// width of each bin; the last bin collects everything longer
+#define FRAMESCHEDULER_SPIN_MS				2.0		// a fixed-rate wait sleeps until this close to the latch point, then spins
+#define FRAMESCHEDULER_LATCH_MARGIN_MS		0.5		// slack kept between latching poses and the submit deadline
+
+struct GLFWwindow;
+
+// Paces the main loop and predicts when each frame will be displayed.
+//	VSYNC		swap interval 1; one frame per refresh
+//	ADAPTIVE	swap interval -1 where the driver supports late swaps tearing, otherwise as VSYNC
+//	FIXED_RATE	swap interval 0; the loop waits until just before each frame's deadline, so views
+//				latched right after waitForLatch() are as fresh as possible when submitted
+//	UNCAPPED	swap interval 0 and no waiting, for benchmarking
+// Every swap is added to a frame-time histogram.
+class FrameScheduler
+{
+public:
+	typedef std::chrono::high_resolution_clock Clock;
+
+	enum Mode {
+		VSYNC,
+		ADAPTIVE,
+		FIXED_RATE,
+		UNCAPPED
+	};
+
+	FrameScheduler();
+
+	void init(GLFWwindow* window, double refreshRateHz);
+
+	// fixedRateHz is only used by FIXED_RATE; 0 means the display refresh rate
+	void setMode(Mode mode, double fixedRateHz = 0.0);
+	Mode getMode() const { return m_eMode; }
+
+	static const char* modeName(Mode mode);
+	static bool parseMode(std::string name, Mode &mode);
+
+	// seconds between presented frames in the current mode
+	double getFramePeriod() const;
+	double getRefreshPeriod() const { return m_dRefreshPeriod; }
+	double getSwapInterval() const { return m_dSwapInterval; }
+
+	// whole number of frames closest to a duration, at least one
+	unsigned int framesFor(double seconds) const;
+
+	// FIXED_RATE waits here until it is time to latch poses and submit; the other modes return at once
+	void waitForLatch();
+
+	// when the frame being built now should be on screen (middle of the display)
+	Clock::time_point predictPhotonTime() const;
+
+	// call right after glfwSwapBuffers
+	void onSwap();
+
+	void resetStats();
+	double meanFrameMS() const;
+	double percentileFrameMS(double p) const;
+	unsigned long long frameCount() const { return m_nFrames; }
+	unsigned long long missedFrameCount() const { return m_nMissedFrames; }
+	std::string histogramString() const;
+
+private:
+	GLFWwindow* m_pWindow;
+	Mode m_eMode;
+
+	double m_dRefreshPeriod;
+	double m_dFixedPeriod;
+	bool m_bTearControl;
+
+	Clock::time_point m_tLastSwap;
+	Clock::time_point m_tDeadline;	// FIXED_RATE: when the current frame should be swapped
+	Clock::time_point m_tLatch;
+	double m_dSwapInterval;			// smoothed seconds between swaps
+	double m_dSubmitTime;			// smoothed seconds from latch to swap return
+
+	unsigned long long m_arrHistogram[FRAMESCHEDULER_HISTOGRAM_BINS];
+	unsigned long long m_nFrames;
+	unsigned long long m_nMissedFrames;
+	double m_dFrameTimeSum;
+
+	void addFrameTime(double seconds);
+};
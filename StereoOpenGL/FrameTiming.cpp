@@ -0,0 +1,192 @@
+#include "FrameTiming.h"
+
+#include <GL/glew.h>
+#include <cstdio>
+
+static long long nanosecondsSinceEpoch(FrameTiming::Clock::time_point t)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+FrameTiming::FrameTiming()
+	: m_bInitialized(false)
+	, m_bTimerQueries(false)
+	, m_nFrame(0ull)
+	, m_uiNextSlot(0u)
+	, m_llGPUToCPUNanoseconds(0ll)
+{
+	for (auto &p : m_arrPending)
+		p.inUse = false;
+
+	for (auto &rec : m_arrHistory)
+		rec.frame = ~0ull;
+}
+
+FrameTiming::~FrameTiming()
+{
+}
+
+bool FrameTiming::init()
+{
+	if (m_bInitialized)
+		return true;
+
+	// GL_TIMESTAMP is core since 3.3, but some drivers report 0 bits for it
+	GLint bits = 0;
+	glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+	m_bTimerQueries = bits > 0;
+
+	if (m_bTimerQueries)
+	{
+		glGenQueries(FRAMETIMING_FRAMES_IN_FLIGHT, m_arrQueries);
+		calibrate();
+	}
+	else
+		printf("FrameTiming: no GL timestamp queries; swap completion will be timed with fences only\n");
+
+	m_bInitialized = true;
+
+	return true;
+}
+
+void FrameTiming::shutdown()
+{
+	if (!m_bInitialized)
+		return;
+
+	for (auto &p : m_arrPending)
+	{
+		if (p.inUse)
+			glDeleteSync(static_cast<GLsync>(p.fence));
+		p.inUse = false;
+	}
+
+	if (m_bTimerQueries)
+		glDeleteQueries(FRAMETIMING_FRAMES_IN_FLIGHT, m_arrQueries);
+
+	m_bInitialized = false;
+}
+
+unsigned long long FrameTiming::beginFrame()
+{
+	return ++m_nFrame;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Reading GL_TIMESTAMP directly returns the GPU clock at the moment
+//			the call reaches the driver, which is bracketed by two CPU reads.
+//-----------------------------------------------------------------------------
+void FrameTiming::calibrate()
+{
+	GLint64 gpu = 0;
+
+	Clock::time_point before = Clock::now();
+	glGetInteger64v(GL_TIMESTAMP, &gpu);
+	Clock::time_point after = Clock::now();
+
+	long long cpu = nanosecondsSinceEpoch(before) + std::chrono::duration_cast<std::chrono::nanoseconds>(after - before).count() / 2ll;
+
+	m_llGPUToCPUNanoseconds = cpu - static_cast<long long>(gpu);
+	m_tLastCalibration = after;
+}
+
+void FrameTiming::markSwap()
+{
+	if (!m_bInitialized)
+		return;
+
+	Clock::time_point now = Clock::now();
+
+	collect();
+
+	Pending &p = m_arrPending[m_uiNextSlot];
+	if (p.inUse)
+	{
+		// the GPU is more than FRAMETIMING_FRAMES_IN_FLIGHT swaps behind; leave this frame untimed
+		return;
+	}
+
+	if (m_bTimerQueries)
+	{
+		glQueryCounter(m_arrQueries[m_uiNextSlot], GL_TIMESTAMP);
+
+		if (now - m_tLastCalibration > std::chrono::milliseconds(FRAMETIMING_CALIBRATION_MS))
+			calibrate();
+	}
+
+	p.frame = m_nFrame;
+	p.submitted = now;
+	p.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	p.inUse = true;
+
+	// make sure the fence reaches the GPU so it can signal without a later frame's flush
+	glFlush();
+
+	m_uiNextSlot = (m_uiNextSlot + 1u) % FRAMETIMING_FRAMES_IN_FLIGHT;
+}
+
+void FrameTiming::collect()
+{
+	if (!m_bInitialized)
+		return;
+
+	// slots complete in submission order, starting from the oldest outstanding one
+	for (unsigned int i = 0u; i < FRAMETIMING_FRAMES_IN_FLIGHT; ++i)
+	{
+		unsigned int slot = (m_uiNextSlot + i) % FRAMETIMING_FRAMES_IN_FLIGHT;
+		Pending &p = m_arrPending[slot];
+
+		if (!p.inUse)
+			continue;
+
+		GLenum status = glClientWaitSync(static_cast<GLsync>(p.fence), 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			break;
+
+		resolve(slot, Clock::now());
+	}
+}
+
+void FrameTiming::resolve(unsigned int slot, Clock::time_point seen)
+{
+	Pending &p = m_arrPending[slot];
+
+	FrameRecord &rec = m_arrHistory[p.frame & (FRAMETIMING_HISTORY - 1)];
+	rec.frame = p.frame;
+	rec.submitted = p.submitted;
+	rec.completed = seen;
+	rec.gpuTimed = false;
+
+	if (m_bTimerQueries)
+	{
+		// the fence follows the query, so the result is ready and this does not stall
+		GLuint64 gpu = 0;
+		glGetQueryObjectui64v(m_arrQueries[slot], GL_QUERY_RESULT, &gpu);
+
+		rec.completed = fromGPUTime(gpu);
+		rec.gpuTimed = true;
+	}
+
+	glDeleteSync(static_cast<GLsync>(p.fence));
+	p.inUse = false;
+
+	if (m_fnFrameCallback)
+		m_fnFrameCallback(rec);
+}
+
+FrameTiming::Clock::time_point FrameTiming::fromGPUTime(unsigned long long gpuNanoseconds) const
+{
+	return Clock::time_point(std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(static_cast<long long>(gpuNanoseconds) + m_llGPUToCPUNanoseconds)));
+}
+
+bool FrameTiming::getSwapTime(unsigned long long frame, Clock::time_point &t) const
+{
+	FrameRecord const &rec = m_arrHistory[frame & (FRAMETIMING_HISTORY - 1)];
+
+	if (rec.frame != frame)
+		return false;
+
+	t = rec.completed;
+
+	return true;
+}
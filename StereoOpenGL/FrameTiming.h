@@ -0,0 +1,89 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+
+#define FRAMETIMING_FRAMES_IN_FLIGHT	8		// swaps whose completion can be outstanding at once
+#define FRAMETIMING_HISTORY				1024	// resolved frames kept for lookup; power of two
+#define FRAMETIMING_CALIBRATION_MS		1000	// how often the GPU clock is re-aligned with the CPU clock
+
+// Records when each frame's buffer swap actually completed on the GPU.
+// A GL_TIMESTAMP query and a fence are issued right after glfwSwapBuffers; once the fence has
+// signaled (checked without blocking on later frames) the query result is read and mapped onto
+// the CPU clock, so completion times compare directly with input event timestamps.
+class FrameTiming
+{
+public:
+	typedef std::chrono::high_resolution_clock Clock;
+
+	struct FrameRecord {
+		unsigned long long frame;
+		Clock::time_point submitted;	// CPU time glfwSwapBuffers returned
+		Clock::time_point completed;	// GPU time the swap was processed, on the CPU clock
+		bool gpuTimed;					// false if completed is only when the fence was seen
+	};
+
+	typedef std::function<void(const FrameRecord &rec)> FrameCallback;
+
+	static FrameTiming& getInstance()
+	{
+		static FrameTiming s_instance;
+		return s_instance;
+	}
+
+	// needs a current GL context
+	bool init();
+	void shutdown();
+
+	// call at the start of each frame; returns the index of the frame being built
+	unsigned long long beginFrame();
+	unsigned long long currentFrame() const { return m_nFrame; }
+
+	// call right after glfwSwapBuffers
+	void markSwap();
+
+	// finished frames are resolved from markSwap(); this forces a non-blocking check
+	void collect();
+
+	// false if the frame has not completed yet or is too old
+	bool getSwapTime(unsigned long long frame, Clock::time_point &t) const;
+
+	void setFrameCallback(FrameCallback cb) { m_fnFrameCallback = cb; }
+
+	// maps a GL_TIMESTAMP query result (nanoseconds) onto the CPU clock
+	Clock::time_point fromGPUTime(unsigned long long gpuNanoseconds) const;
+
+private:
+	FrameTiming();
+	~FrameTiming();
+
+	struct Pending {
+		unsigned long long frame;
+		Clock::time_point submitted;
+		void* fence;
+		bool inUse;
+	};
+
+	bool m_bInitialized;
+	bool m_bTimerQueries;
+	unsigned long long m_nFrame;
+
+	unsigned int m_arrQueries[FRAMETIMING_FRAMES_IN_FLIGHT];
+	Pending m_arrPending[FRAMETIMING_FRAMES_IN_FLIGHT];
+	unsigned int m_uiNextSlot;
+
+	FrameRecord m_arrHistory[FRAMETIMING_HISTORY];
+
+	long long m_llGPUToCPUNanoseconds;
+	Clock::time_point m_tLastCalibration;
+
+	FrameCallback m_fnFrameCallback;
+
+	void calibrate();
+	void resolve(unsigned int slot, Clock::time_point seen);
+
+public:
+	// DELETE THE FOLLOWING FUNCTIONS TO AVOID NON-SINGLETON USE
+	FrameTiming(FrameTiming const&) = delete;
+	void operator=(FrameTiming const&) = delete;
+};
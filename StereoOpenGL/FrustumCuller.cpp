@@ -0,0 +1,201 @@
+#include "FrustumCuller.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef FRUSTUMCULLER_SSE
+#include <emmintrin.h>
+#endif
+
+FrustumCuller::FrustumCuller()
+	: m_vec4ClipW(0.f, 0.f, 0.f, 1.f)
+	, m_fPixelScale(0.f)
+	, m_fMinPixels(0.f)
+	, m_uiCulledOutside(0u)
+	, m_uiCulledTooSmall(0u)
+{
+	for (auto &p : m_arrPlanes)
+		p = glm::vec4(0.f, 0.f, 0.f, 1.f);
+}
+
+void FrustumCuller::setView(const glm::mat4 & viewProjection, float pixelScale, float minPixels)
+{
+	// glm is column-major, so row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i])
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; ++i)
+		rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+	m_arrPlanes[0] = rows[3] + rows[0];	// left
+	m_arrPlanes[1] = rows[3] - rows[0];	// right
+	m_arrPlanes[2] = rows[3] + rows[1];	// bottom
+	m_arrPlanes[3] = rows[3] - rows[1];	// top
+	m_arrPlanes[4] = rows[3] + rows[2];	// near
+	m_arrPlanes[5] = rows[3] - rows[2];	// far
+
+	for (auto &p : m_arrPlanes)
+	{
+		float len = glm::length(glm::vec3(p));
+		if (len > 0.f)
+			p /= len;
+	}
+
+	m_vec4ClipW = rows[3];
+	m_fPixelScale = pixelScale;
+	m_fMinPixels = minPixels;
+}
+
+void FrustumCuller::clear()
+{
+	m_vX.clear();
+	m_vY.clear();
+	m_vZ.clear();
+	m_vR.clear();
+}
+
+void FrustumCuller::reserve(size_t count)
+{
+	m_vX.reserve(count);
+	m_vY.reserve(count);
+	m_vZ.reserve(count);
+	m_vR.reserve(count);
+	m_vVisible.reserve(count);
+}
+
+void FrustumCuller::add(const glm::vec3 & center, float radius)
+{
+	m_vX.push_back(center.x);
+	m_vY.push_back(center.y);
+	m_vZ.push_back(center.z);
+	m_vR.push_back(radius);
+}
+
+void FrustumCuller::add(const glm::vec4 & objectSphere, const glm::mat4 & modelToWorld)
+{
+	if (objectSphere.w < 0.f)
+	{
+		add(glm::vec3(0.f), FRUSTUMCULLER_UNBOUNDED);
+		return;
+	}
+
+	add(glm::vec3(modelToWorld * glm::vec4(glm::vec3(objectSphere), 1.f)), objectSphere.w * maxAxisScale(modelToWorld));
+}
+
+float FrustumCuller::projectedRadius(const glm::vec4 & objectSphere, const glm::mat4 & modelToWorld) const
+{
+	glm::vec4 center = modelToWorld * glm::vec4(glm::vec3(objectSphere), 1.f);
+	float radius = objectSphere.w * maxAxisScale(modelToWorld);
+	float w = glm::dot(m_vec4ClipW, center);
+
+	if (w <= radius)
+		return FRUSTUMCULLER_UNBOUNDED;
+
+	return radius * m_fPixelScale / w;
+}
+
+float FrustumCuller::maxAxisScale(const glm::mat4 & modelToWorld)
+{
+	// the largest axis scale bounds the sphere under any rotation/non-uniform scale
+	return std::sqrt(std::max(glm::dot(modelToWorld[0], modelToWorld[0]), std::max(glm::dot(modelToWorld[1], modelToWorld[1]), glm::dot(modelToWorld[2], modelToWorld[2]))));
+}
+
+unsigned char FrustumCuller::testSphere(size_t i, bool & outside) const
+{
+	outside = false;
+
+	for (auto const &p : m_arrPlanes)
+	{
+		if (p.x * m_vX[i] + p.y * m_vY[i] + p.z * m_vZ[i] + p.w < -m_vR[i])
+		{
+			outside = true;
+			return 0;
+		}
+	}
+
+	if (m_fMinPixels > 0.f)
+	{
+		float w = m_vec4ClipW.x * m_vX[i] + m_vec4ClipW.y * m_vY[i] + m_vec4ClipW.z * m_vZ[i] + m_vec4ClipW.w;
+		if (w > m_vR[i] && m_vR[i] * m_fPixelScale < m_fMinPixels * w)
+			return 0;
+	}
+
+	return 1;
+}
+
+unsigned int FrustumCuller::cull()
+{
+	size_t n = m_vR.size();
+
+	m_vVisible.resize(n);
+	m_uiCulledOutside = 0u;
+	m_uiCulledTooSmall = 0u;
+
+	size_t i = 0u;
+
+#ifdef FRUSTUMCULLER_SSE
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+	for (int p = 0; p < 6; ++p)
+	{
+		planeX[p] = _mm_set1_ps(m_arrPlanes[p].x);
+		planeY[p] = _mm_set1_ps(m_arrPlanes[p].y);
+		planeZ[p] = _mm_set1_ps(m_arrPlanes[p].z);
+		planeW[p] = _mm_set1_ps(m_arrPlanes[p].w);
+	}
+
+	const __m128 wX = _mm_set1_ps(m_vec4ClipW.x);
+	const __m128 wY = _mm_set1_ps(m_vec4ClipW.y);
+	const __m128 wZ = _mm_set1_ps(m_vec4ClipW.z);
+	const __m128 wW = _mm_set1_ps(m_vec4ClipW.w);
+	const __m128 pixelScale = _mm_set1_ps(m_fPixelScale);
+	const __m128 minPixels = _mm_set1_ps(m_fMinPixels);
+	const bool sizeTest = m_fMinPixels > 0.f;
+
+	for (; i + 4u <= n; i += 4u)
+	{
+		__m128 x = _mm_loadu_ps(&m_vX[i]);
+		__m128 y = _mm_loadu_ps(&m_vY[i]);
+		__m128 z = _mm_loadu_ps(&m_vZ[i]);
+		__m128 r = _mm_loadu_ps(&m_vR[i]);
+		__m128 negR = _mm_sub_ps(_mm_setzero_ps(), r);
+
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (int p = 0; p < 6; ++p)
+		{
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)), _mm_add_ps(_mm_mul_ps(planeZ[p], z), planeW[p]));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negR));
+		}
+
+		int insideMask = _mm_movemask_ps(inside);
+		int smallMask = 0;
+
+		if (sizeTest)
+		{
+			__m128 w = _mm_add_ps(_mm_add_ps(_mm_mul_ps(wX, x), _mm_mul_ps(wY, y)), _mm_add_ps(_mm_mul_ps(wZ, z), wW));
+			__m128 small = _mm_and_ps(_mm_cmpgt_ps(w, r), _mm_cmplt_ps(_mm_mul_ps(r, pixelScale), _mm_mul_ps(minPixels, w)));
+			smallMask = _mm_movemask_ps(small) & insideMask;
+		}
+
+		for (int k = 0; k < 4; ++k)
+		{
+			bool in = (insideMask >> k) & 1;
+			bool small = (smallMask >> k) & 1;
+
+			m_vVisible[i + k] = in && !small;
+			m_uiCulledOutside += !in;
+			m_uiCulledTooSmall += small;
+		}
+	}
+#endif
+
+	for (; i < n; ++i)
+	{
+		bool outside;
+		m_vVisible[i] = testSphere(i, outside);
+
+		if (outside)
+			m_uiCulledOutside++;
+		else if (!m_vVisible[i])
+			m_uiCulledTooSmall++;
+	}
+
+	return static_cast<unsigned int>(n) - m_uiCulledOutside - m_uiCulledTooSmall;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include <glm.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUMCULLER_SSE
+#endif
+
+#define FRUSTUMCULLER_UNBOUNDED		1e30f	// radius given to spheres that must never be culled
+
+// Tests bounding spheres against the six planes of a view-projection matrix, and optionally
+// against a minimum projected size. Spheres are stored as separate x/y/z/radius arrays so the
+// test runs on four at a time with SSE (scalar code handles the remainder and other targets).
+// The planes come straight from the matrix, so off-axis (e.g. glm::frustum) projections work.
+class FrustumCuller
+{
+public:
+	FrustumCuller();
+
+	// pixelScale converts radius/depth to a radius in pixels (projection[1][1] * viewport height / 2);
+	// spheres whose projected radius is below minPixels are culled. minPixels <= 0 disables the size test.
+	void setView(const glm::mat4 &viewProjection, float pixelScale, float minPixels);
+
+	void clear();
+	void reserve(size_t count);
+
+	// world-space sphere
+	void add(const glm::vec3 &center, float radius);
+	// object-space sphere (xyz center, w radius) moved into world space; w < 0 means never cull
+	void add(const glm::vec4 &objectSphere, const glm::mat4 &modelToWorld);
+
+	size_t size() const { return m_vR.size(); }
+
+	// radius in pixels of an object-space sphere under the current view, FRUSTUMCULLER_UNBOUNDED
+	// when it reaches the eye; independent of the spheres added for culling
+	float projectedRadius(const glm::vec4 &objectSphere, const glm::mat4 &modelToWorld) const;
+
+	// tests every sphere added since clear(); returns how many are visible
+	unsigned int cull();
+
+	// one byte per sphere, nonzero if visible; valid after cull()
+	const unsigned char* visibility() const { return m_vVisible.empty() ? NULL : &m_vVisible[0]; }
+	unsigned int culledOutside() const { return m_uiCulledOutside; }
+	unsigned int culledTooSmall() const { return m_uiCulledTooSmall; }
+
+private:
+	glm::vec4 m_arrPlanes[6];	// xyz normal, w distance; inside when dot >= -radius
+	glm::vec4 m_vec4ClipW;		// row of the view-projection matrix giving clip-space w
+	float m_fPixelScale;
+	float m_fMinPixels;
+
+	std::vector<float> m_vX;
+	std::vector<float> m_vY;
+	std::vector<float> m_vZ;
+	std::vector<float> m_vR;
+	std::vector<unsigned char> m_vVisible;
+
+	unsigned int m_uiCulledOutside;
+	unsigned int m_uiCulledTooSmall;
+
+	unsigned char testSphere(size_t i, bool &outside) const;
+
+	static float maxAxisScale(const glm::mat4 &modelToWorld);
+};
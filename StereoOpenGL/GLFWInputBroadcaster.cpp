@@ -1,13 +1,14 @@
-#pragma once
 #include <vector>
 #include <algorithm>
 #include <iostream>
+#include <cstring>
 
 #include <GLFW/glfw3.h>
 #include "GLFWInputBroadcaster.h"
 
 
 GLFWInputBroadcaster::GLFWInputBroadcaster()
+	: m_nDroppedEvents(0ull)
 {
 }
 
@@ -31,21 +32,72 @@ void GLFWInputBroadcaster::init(GLFWwindow * window)
 	m_fLastMouseY = 0;
 }
 
-void GLFWInputBroadcaster::addObserver(GLFWInputObserver * o)
+void GLFWInputBroadcaster::addObserver(GLFWInputObserver * o, unsigned int eventMask)
 {
-	if (std::find(m_vpObservers.begin(), m_vpObservers.end(), o) == m_vpObservers.end())
-		m_vpObservers.push_back(o);
+	for (auto &obs : m_vObservers)
+	{
+		if (obs.observer == o)
+		{
+			obs.mask = eventMask;
+			return;
+		}
+	}
+
+	m_vObservers.push_back({ o, eventMask });
 }
 
 void GLFWInputBroadcaster::removeObserver(GLFWInputObserver * o)
 {
-	m_vpObservers.erase(std::remove(m_vpObservers.begin(), m_vpObservers.end(), o), m_vpObservers.end());
+	m_vObservers.erase(std::remove_if(m_vObservers.begin(), m_vObservers.end(), [o](Observer const &obs) { return obs.observer == o; }), m_vObservers.end());
 }
 
-void GLFWInputBroadcaster::notifyObservers(void* data)
+bool GLFWInputBroadcaster::post(const InputEvent &ev)
 {
-	for (auto o : m_vpObservers)
-		o->receive(data);
+	if (m_qEvents.push(ev))
+		return true;
+
+	if (m_nDroppedEvents++ == 0ull)
+		std::cerr << "Input event queue full; dropping events" << std::endl;
+
+	return false;
+}
+
+unsigned int GLFWInputBroadcaster::dispatch(unsigned int maxEvents)
+{
+	InputEvent ev;
+	unsigned int n = 0u;
+
+	while (n < maxEvents && m_qEvents.pop(ev))
+	{
+		// key and button state follows the events as they are delivered, whatever posted them
+		switch (ev.type)
+		{
+		case InputEvent::KEY_DOWN:
+			if (ev.code >= 0 && ev.code < 1024)
+				m_arrbActiveKeys[ev.code] = true;
+			break;
+		case InputEvent::KEY_UP:
+			if (ev.code >= 0 && ev.code < 1024)
+				m_arrbActiveKeys[ev.code] = false;
+			break;
+		case InputEvent::MOUSE_PRESS:
+			m_bMousePressed = true;
+			break;
+		case InputEvent::MOUSE_UNPRESS:
+			m_bMousePressed = false;
+			break;
+		default:
+			break;
+		}
+
+		for (auto const &obs : m_vObservers)
+			if (obs.mask & INPUT_MASK(ev.type))
+				obs.observer->receive(ev);
+
+		++n;
+	}
+
+	return n;
 }
 
 bool GLFWInputBroadcaster::keyPressed(const int glfwKeyCode)
@@ -61,6 +113,20 @@ bool GLFWInputBroadcaster::mousePressed()
 void GLFWInputBroadcaster::poll()
 {
 	glfwPollEvents();
+	dispatch();
+}
+
+InputEvent GLFWInputBroadcaster::makeEvent(InputEvent::Type type, int code, int mods, float x, float y)
+{
+	InputEvent ev;
+	ev.type = type;
+	// GLFW calls back from inside glfwPollEvents(), so this is when the event was polled
+	ev.time = std::chrono::high_resolution_clock::now();
+	ev.code = code;
+	ev.mods = mods;
+	ev.x = x;
+	ev.y = y;
+	return ev;
 }
 
 // Is called whenever a key is pressed/released via GLFW
@@ -68,46 +134,21 @@ void GLFWInputBroadcaster::key_callback(GLFWwindow* window, int key, int scancod
 {	
 	if (key >= 0 && key < 1024)
 	{
-		int data[2];
-		data[1] = key;
-
 		if (action == GLFW_PRESS)
-		{
-			getInstance().m_arrbActiveKeys[key] = true;
-			data[0] = EVENT::KEY_DOWN;
-			getInstance().notifyObservers(data);
-		}
+			getInstance().post(makeEvent(InputEvent::KEY_DOWN, key, mode));
 		else if (action == GLFW_REPEAT)
-		{
-			data[0] = EVENT::KEY_HOLD;
-			getInstance().notifyObservers(data);
-		}
+			getInstance().post(makeEvent(InputEvent::KEY_HOLD, key, mode));
 		else if (action == GLFW_RELEASE)
-		{
-			getInstance().m_arrbActiveKeys[key] = false;
-			data[0] = EVENT::KEY_UP;
-			getInstance().notifyObservers(data);
-		}
+			getInstance().post(makeEvent(InputEvent::KEY_UP, key, mode));
 	}
 }
 
 void GLFWInputBroadcaster::mouse_button_callback(GLFWwindow * window, int button, int action, int mods)
 {
-	int data[2];
-	data[1] = button;
-
 	if (action == GLFW_PRESS)
-	{
-		getInstance().m_bMousePressed = true;
-		data[0] = EVENT::MOUSE_PRESS;
-		getInstance().notifyObservers(data);
-	}
+		getInstance().post(makeEvent(InputEvent::MOUSE_PRESS, button, mods));
 	else if (action == GLFW_RELEASE)
-	{
-		getInstance().m_bMousePressed = false;
-		data[0] = EVENT::MOUSE_UNPRESS;
-		getInstance().notifyObservers(data);
-	}
+		getInstance().post(makeEvent(InputEvent::MOUSE_UNPRESS, button, mods));
 }
 
 void GLFWInputBroadcaster::mouse_position_callback(GLFWwindow * window, double xpos, double ypos)
@@ -125,25 +166,10 @@ void GLFWInputBroadcaster::mouse_position_callback(GLFWwindow * window, double x
 	getInstance().m_fLastMouseX = static_cast<GLfloat>(xpos);
 	getInstance().m_fLastMouseY = static_cast<GLfloat>(ypos);
 
-	float offset[2] = { static_cast<float>(xoffset), static_cast<float>(yoffset) };
-
-	struct mousedata {
-		int eventType;
-		float offsets[2];
-	} data;
-	data.eventType = EVENT::MOUSE_MOVE;
-	data.offsets[0] = static_cast<float>(xoffset);
-	data.offsets[1] = static_cast<float>(yoffset);
-	getInstance().notifyObservers(&data);
+	getInstance().post(makeEvent(InputEvent::MOUSE_MOVE, 0, 0, static_cast<float>(xoffset), static_cast<float>(yoffset)));
 }
 
 void GLFWInputBroadcaster::scroll_callback(GLFWwindow * window, double xoffset, double yoffset)
 {
-	struct mousedata {
-		int eventType;
-		float offset;
-	} data;
-	data.eventType = EVENT::MOUSE_SCROLL;
-	data.offset = static_cast<float>(yoffset);
-	getInstance().notifyObservers(&data);
+	getInstance().post(makeEvent(InputEvent::MOUSE_SCROLL, 0, 0, static_cast<float>(xoffset), static_cast<float>(yoffset)));
 }
@@ -1,35 +1,72 @@
 #pragma once
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 
-struct GLFWwindow;
+#include "MPMCQueue.h"
 
-class GLFWInputObserver
-{
-	friend class GLFWInputBroadcaster;
-	virtual void receive(void* data) = 0;
-};
+#define INPUTQUEUE_SIZE		1024
 
-class GLFWInputBroadcaster
+#define INPUT_MASK(type)	(1u << (type))
+#define INPUT_MASK_KEYS		(INPUT_MASK(InputEvent::KEY_DOWN) | INPUT_MASK(InputEvent::KEY_UP) | INPUT_MASK(InputEvent::KEY_HOLD))
+#define INPUT_MASK_MOUSE	(INPUT_MASK(InputEvent::MOUSE_PRESS) | INPUT_MASK(InputEvent::MOUSE_UNPRESS) | INPUT_MASK(InputEvent::MOUSE_MOVE) | INPUT_MASK(InputEvent::MOUSE_SCROLL))
+#define INPUT_MASK_ALL		0xFFFFFFFFu
+
+struct GLFWwindow;
+
+struct InputEvent
 {
-public:
-	enum EVENT {
+	enum Type {
 		MOUSE_PRESS,
 		MOUSE_UNPRESS,
 		MOUSE_MOVE,
 		MOUSE_SCROLL,
 		KEY_DOWN,
 		KEY_UP,
-		KEY_HOLD
+		KEY_HOLD,
+		PROBE		// synthetic event for latency measurement; code is a caller-defined sequence number
 	};
 
+	Type type;
+	std::chrono::high_resolution_clock::time_point time;	// when polled (GLFW events), or posted
+	int code;	// GLFW key or mouse button
+	int mods;	// GLFW modifier bits
+	float x;	// mouse move offset, or scroll offset
+	float y;
+};
+
+class GLFWInputObserver
+{
+	friend class GLFWInputBroadcaster;
+	virtual void receive(const InputEvent &ev) = 0;
+
+public:
+	virtual ~GLFWInputObserver() {}
+};
+
+// Input callbacks (or any other thread, through post()) add timestamped events to a lock-free queue.
+// GLFW only delivers events from inside glfwPollEvents() on the main thread, so key and mouse
+// events carry the time they were polled, which is quantized to the frame rate.
+// dispatch() hands them to the observers whose mask includes the event type, and poll() does
+// this once per frame after GLFW has delivered its events.
+class GLFWInputBroadcaster
+{
+public:
+	typedef InputEvent::Type EVENT;
+
 	static GLFWInputBroadcaster& getInstance();
 
 	void init(GLFWwindow* window);
 
-	void addObserver(GLFWInputObserver *o);
+	void addObserver(GLFWInputObserver *o, unsigned int eventMask = INPUT_MASK_ALL);
 	void removeObserver(GLFWInputObserver *o);
-	void notifyObservers(void* data);
+
+	// safe from any thread; returns false (and counts the loss) if the queue is full
+	bool post(const InputEvent &ev);
+
+	// delivers at most maxEvents queued events and returns how many were delivered
+	unsigned int dispatch(unsigned int maxEvents = INPUTQUEUE_SIZE);
 
 	bool keyPressed(const int glfwKeyCode);
 
@@ -37,16 +74,28 @@ public:
 
 	void poll();
 
+	unsigned long long getDroppedEventCount() const { return m_nDroppedEvents.load(); }
+
 private:
 	GLFWInputBroadcaster();
 
-	std::vector<GLFWInputObserver*> m_vpObservers;
+	struct Observer {
+		GLFWInputObserver* observer;
+		unsigned int mask;
+	};
+
+	std::vector<Observer> m_vObservers;
+
+	MPMCQueue<InputEvent, INPUTQUEUE_SIZE> m_qEvents;
+	std::atomic<unsigned long long> m_nDroppedEvents;
 
 	static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
 	static void mouse_button_callback(GLFWwindow* window,int x, int y, int z);
 	static void mouse_position_callback(GLFWwindow* window, double xpos, double ypos);
 	static void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 
+	static InputEvent makeEvent(InputEvent::Type type, int code = 0, int mods = 0, float x = 0.f, float y = 0.f);
+
 	bool m_arrbActiveKeys[1024];
 	bool m_bFirstMouse, m_bMousePressed;
 	float m_fLastMouseX, m_fLastMouseY;
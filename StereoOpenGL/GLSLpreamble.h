@@ -1,6 +1,14 @@
 #ifndef PREAMBLE_GLSL
 #define PREAMBLE_GLSL
 
+// gl_DrawIDARB and sampler handles for programs built with MULTI_DRAW_INDIRECT (must precede any GLSL tokens)
+#if defined(MULTI_DRAW_INDIRECT) && defined(VERTEX_SHADER)
+#extension GL_ARB_shader_draw_parameters : require
+#endif
+#if defined(MULTI_DRAW_INDIRECT) && defined(BINDLESS_TEXTURES)
+#extension GL_ARB_bindless_texture : require
+#endif
+
 
 // VERTEX ATTRIBUTES: layout(location = _____)
 
@@ -19,6 +27,9 @@
 #define LIGHT_COUNT_UNIFORM_LOCATION			2
 #define DIFFUSE_COLOR_UNIFORM_LOCATION			3
 #define SPECULAR_COLOR_UNIFORM_LOCATION			4
+#define DRAW_OFFSET_UNIFORM_LOCATION			5
+#define TEXCOORD_TRANSFORM_UNIFORM_LOCATION		6
+#define POINT_SIZE_UNIFORM_LOCATION				7
 
 
 // UNIFORM BLOCKS: layout(std40, binding = _____)
@@ -27,6 +38,12 @@
 #define LIGHTS_UNIFORM_BUFFER_LOCATION			1
 
 
+// SHADER STORAGE BLOCKS: layout(std430, binding = _____)
+
+#define DRAW_DATA_STORAGE_BUFFER_BINDING		0
+#define POINT_NODE_STORAGE_BUFFER_BINDING		1
+
+
 // TEXTURE UNITS: layout(binding = _____)
 
 #define DIFFUSE_TEXTURE_BINDING					0
@@ -34,7 +51,120 @@
 #define EMISSIVE_TEXTURE_BINDING				2
 
 
+// FRAGMENT OUTPUTS: layout(location = _____)
+
+#define COLOR_OUTPUT_LOCATION					0
+#define OIT_REVEALAGE_OUTPUT_LOCATION			1
+
+
 // LIGHTING DEFINITIONS
 #define MAX_LIGHTS 10
 
+
+// PER-DRAW INPUTS
+// Shaders read the model matrix and material through the DRAW_* macros rather than declaring
+// them. Programs built with MULTI_DRAW_INDIRECT fetch them from the draw data buffer instead of
+// uniforms, at drawOffset + gl_DrawIDARB; vertex shaders call forwardDrawID() so the fragment
+// stage reads the same entry. Textures are sampled through DRAW_DIFFUSE_SAMPLER(type) and
+// DRAW_SPECULAR_SAMPLER(type): the bound diffuseTex/specularTex, or with BINDLESS_TEXTURES the
+// draw's own handles, so draws with different textures can share one multi-draw.
+#if defined(VERTEX_SHADER) || defined(FRAGMENT_SHADER)
+#ifdef MULTI_DRAW_INDIRECT
+struct DrawData
+{
+	mat4 m4Model;
+	vec4 v4DiffuseColor;
+	vec4 v4SpecularColor;
+	vec4 v4TexCoordTransform;
+	uvec2 diffuseTexHandle;
+	uvec2 specularTexHandle;
+	float fShininess;
+};
+
+layout(std430, binding = DRAW_DATA_STORAGE_BUFFER_BINDING) readonly buffer DrawDataBuffer
+{
+	DrawData drawData[];
+};
+
+#ifdef VERTEX_SHADER
+layout(location = DRAW_OFFSET_UNIFORM_LOCATION)
+	uniform int drawOffset;
+
+flat out int iDrawIndex;
+
+#define DRAW_INDEX (drawOffset + gl_DrawIDARB)
+
+void forwardDrawID()
+{
+	iDrawIndex = DRAW_INDEX;
+}
+#else
+flat in int iDrawIndex;
+
+#define DRAW_INDEX iDrawIndex
+#endif
+
+#define DRAW_MODEL				drawData[DRAW_INDEX].m4Model
+#define DRAW_DIFFUSE_COLOR		drawData[DRAW_INDEX].v4DiffuseColor
+#define DRAW_SPECULAR_COLOR		drawData[DRAW_INDEX].v4SpecularColor
+#define DRAW_TEXCOORD_TRANSFORM	drawData[DRAW_INDEX].v4TexCoordTransform
+#define DRAW_SHININESS			drawData[DRAW_INDEX].fShininess
+
+#ifdef BINDLESS_TEXTURES
+#define DRAW_DIFFUSE_SAMPLER(type)	type(drawData[DRAW_INDEX].diffuseTexHandle)
+#define DRAW_SPECULAR_SAMPLER(type)	type(drawData[DRAW_INDEX].specularTexHandle)
+#else
+#define DRAW_DIFFUSE_SAMPLER(type)	diffuseTex
+#define DRAW_SPECULAR_SAMPLER(type)	specularTex
+#endif
+#else
+layout(location = MODEL_MAT_UNIFORM_LOCATION)
+	uniform mat4 m4Model;
+layout(location = MATERIAL_SHININESS_UNIFORM_LOCATION)
+	uniform float shininess;
+layout(location = DIFFUSE_COLOR_UNIFORM_LOCATION)
+	uniform vec4 diffColor;
+layout(location = SPECULAR_COLOR_UNIFORM_LOCATION)
+	uniform vec4 specColor;
+layout(location = TEXCOORD_TRANSFORM_UNIFORM_LOCATION)
+	uniform vec4 texCoordTransform;
+
+void forwardDrawID()
+{
+}
+
+#define DRAW_MODEL				m4Model
+#define DRAW_DIFFUSE_COLOR		diffColor
+#define DRAW_SPECULAR_COLOR		specColor
+#define DRAW_TEXCOORD_TRANSFORM	texCoordTransform
+#define DRAW_SHININESS			shininess
+
+#define DRAW_DIFFUSE_SAMPLER(type)	diffuseTex
+#define DRAW_SPECULAR_SAMPLER(type)	specularTex
+#endif
+#endif
+
+
+// TRANSPARENCY OUTPUT
+// Fragment shaders that can draw transparent submissions pass their final color through
+// shadeOutput(). Programs built with WEIGHTED_BLENDED_OIT write weighted, premultiplied color
+// to the accumulation target and alpha to the revealage target instead (McGuire & Bavoil 2013).
+#ifdef FRAGMENT_SHADER
+#ifdef WEIGHTED_BLENDED_OIT
+layout(location = OIT_REVEALAGE_OUTPUT_LOCATION) out float oitRevealage;
+
+vec4 shadeOutput(vec4 color)
+{
+	float weight = color.a * clamp(3e3f * pow(1.f - gl_FragCoord.z, 3.f), 1e-2f, 3e3f);
+	oitRevealage = color.a;
+	return vec4(color.rgb * color.a, color.a) * weight;
+}
+#else
+vec4 shadeOutput(vec4 color)
+{
+	return color;
+}
+#endif
+#endif
+
 #endif // PREAMBLE_GLSL
\ No newline at end of file
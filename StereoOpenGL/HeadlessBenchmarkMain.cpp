@@ -0,0 +1,608 @@
+#include "Renderer.h"
+#include "DebugDrawer.h"
+#include "PointOctreeBuilder.h"
+
+#include <GL/glew.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <experimental/filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+// Renders synthetic scenes through the public Renderer API into offscreen framebuffers, without
+// a window, and reports CPU submission time and the GL calls the render queues issued.
+// The context comes from EGL with no surface, so it runs on Mesa's software rasterizer on a Linux
+// machine without a GPU (set LIBGL_ALWAYS_SOFTWARE=1 to force it). It is built by CMake only, not
+// the Visual Studio project. Run from the directory holding shaders/ and fonts/.
+//
+// usage: HeadlessBenchmark [-p primitives] [-t text strings] [-l debug lines] [-f frames]
+//                          [-s widthxheight] [-m mono|stereo|both] [--seed n] [--no-cull]
+//                          [-o sorted|oit|auto] [--no-mdi] [--float-verts] [--no-lod]
+//                          [--no-mesh-cache] [--stream-points n] [--cloud-points n]
+
+#define HEADLESSBENCH_WARMUP_FRAMES	10
+#define HEADLESSBENCH_IPD_CM		6.4f
+#define HEADLESSBENCH_EYE_DIST_CM	60.f
+
+struct BenchmarkOptions {
+	unsigned int primitives;
+	unsigned int textStrings;
+	unsigned int debugLines;
+	unsigned int frames;
+	int width;
+	int height;
+	bool mono;
+	bool stereo;
+	unsigned int seed;
+	bool culling;
+	Renderer::TransparencyMode transparency;
+	bool multiDraw;
+	bool packedVertices;
+	bool levelOfDetail;
+	bool meshCache;
+	unsigned int streamPoints;
+	unsigned int cloudPoints;
+};
+
+struct SceneObject {
+	std::string primitive;
+	glm::mat4 transform;
+	glm::vec4 color;
+};
+
+struct SceneText {
+	std::string text;
+	glm::vec3 pos;
+	glm::vec4 color;
+};
+
+struct SceneLine {
+	glm::vec3 from;
+	glm::vec3 to;
+	glm::vec4 color;
+};
+
+struct SyntheticScene {
+	std::vector<SceneObject> objects;
+	std::vector<SceneText> text;
+	std::vector<SceneLine> lines;
+	std::string streamedMesh; // point cloud streamed in while the benchmark runs, if any
+	std::string pointCloud; // point octree drawn through the out-of-core renderer, if any
+	glm::mat4 pointCloudTransform;
+};
+
+struct FrameSample {
+	double sceneMS;		// queueing the scene through the Renderer API
+	double submitMS;	// RenderFrame calls, i.e. GL command submission
+	double frameMS;		// including glFinish
+	Renderer::RenderStats stats;
+};
+
+static EGLDisplay g_eglDisplay = EGL_NO_DISPLAY;
+static EGLContext g_eglContext = EGL_NO_CONTEXT;
+static EGLSurface g_eglSurface = EGL_NO_SURFACE;
+
+static bool createContext()
+{
+	// prefer Mesa's surfaceless platform so no X server or DRM device is needed
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+	if (getPlatformDisplay && clientExtensions && strstr(clientExtensions, "EGL_MESA_platform_surfaceless"))
+		g_eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+
+	if (g_eglDisplay == EGL_NO_DISPLAY)
+		g_eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	EGLint major, minor;
+	if (g_eglDisplay == EGL_NO_DISPLAY || !eglInitialize(g_eglDisplay, &major, &minor))
+	{
+		printf("Could not initialize an EGL display\n");
+		return false;
+	}
+
+	const char* displayExtensions = eglQueryString(g_eglDisplay, EGL_EXTENSIONS);
+	bool surfaceless = displayExtensions && strstr(displayExtensions, "EGL_KHR_surfaceless_context");
+
+	EGLint configAttribs[] = {
+		EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_DEPTH_SIZE, 24,
+		EGL_NONE
+	};
+
+	EGLConfig config;
+	EGLint numConfigs = 0;
+	if (!eglChooseConfig(g_eglDisplay, configAttribs, &config, 1, &numConfigs) || numConfigs < 1)
+	{
+		printf("No suitable EGL config\n");
+		return false;
+	}
+
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		printf("EGL does not support desktop OpenGL\n");
+		return false;
+	}
+
+	EGLint contextAttribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION_KHR, 4,
+		EGL_CONTEXT_MINOR_VERSION_KHR, 5,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+		EGL_NONE
+	};
+
+	g_eglContext = eglCreateContext(g_eglDisplay, config, EGL_NO_CONTEXT, contextAttribs);
+	if (g_eglContext == EGL_NO_CONTEXT)
+	{
+		printf("Could not create an OpenGL 4.5 core context (EGL error 0x%x)\n", eglGetError());
+		return false;
+	}
+
+	// the Renderer only draws into its own framebuffers, so the surface is never used
+	if (!surfaceless)
+	{
+		EGLint pbufferAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+		g_eglSurface = eglCreatePbufferSurface(g_eglDisplay, config, pbufferAttribs);
+	}
+
+	if (!eglMakeCurrent(g_eglDisplay, g_eglSurface, g_eglSurface, g_eglContext))
+	{
+		printf("Could not make the EGL context current\n");
+		return false;
+	}
+
+	return true;
+}
+
+static void destroyContext()
+{
+	eglMakeCurrent(g_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (g_eglSurface != EGL_NO_SURFACE)
+		eglDestroySurface(g_eglDisplay, g_eglSurface);
+	eglDestroyContext(g_eglDisplay, g_eglContext);
+	eglTerminate(g_eglDisplay);
+}
+
+static SyntheticScene buildScene(BenchmarkOptions const &opts)
+{
+	const char* primitives[] = { "icosphere", "cube", "cylinder", "torus" };
+
+	std::mt19937 rng(opts.seed);
+	std::uniform_real_distribution<float> pos(-30.f, 30.f);
+	std::uniform_real_distribution<float> depth(-60.f, 0.f);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+	SyntheticScene scene;
+
+	for (unsigned int i = 0u; i < opts.primitives; ++i)
+	{
+		SceneObject obj;
+		obj.primitive = primitives[i % 4u];
+		obj.transform = glm::rotate(glm::translate(glm::mat4(), glm::vec3(pos(rng), pos(rng), depth(rng))), unit(rng) * 6.28f, glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + 0.01f)) * glm::scale(glm::mat4(), glm::vec3(0.5f + unit(rng) * 2.f));
+		// one in ten is transparent so the transparency path (sorted or OIT) gets exercised too
+		obj.color = glm::vec4(unit(rng), unit(rng), unit(rng), i % 10u == 0u ? 0.5f : 1.f);
+		scene.objects.push_back(obj);
+	}
+
+	for (unsigned int i = 0u; i < opts.textStrings; ++i)
+		scene.text.push_back({ "Benchmark string " + std::to_string(i), glm::vec3(pos(rng), pos(rng), depth(rng)), glm::vec4(1.f) });
+
+	for (unsigned int i = 0u; i < opts.debugLines; ++i)
+		scene.lines.push_back({ glm::vec3(pos(rng), pos(rng), depth(rng)), glm::vec3(pos(rng), pos(rng), depth(rng)), glm::vec4(unit(rng), unit(rng), unit(rng), 1.f) });
+
+	return scene;
+}
+
+// Writes a sonar-like point cloud (a rippled sea floor colored by depth) as a mesh file to stream
+static std::string writePointCloud(unsigned int points, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> pos(-25.f, 25.f);
+
+	std::vector<Renderer::PrimVert> verts(points);
+	for (auto &v : verts)
+	{
+		float x = pos(rng);
+		float z = pos(rng);
+		float y = 2.f * sin(x * 0.3f) * cos(z * 0.2f) - 10.f;
+		float shade = (y + 12.f) / 4.f;
+
+		v.p = glm::vec3(x, y, z - 30.f);
+		v.n = glm::vec3(0.f, 1.f, 0.f);
+		v.c = glm::vec4(shade, 0.5f, 1.f - shade, 1.f);
+		v.t = glm::vec2(0.f);
+	}
+
+	MeshCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	snprintf(header.key, sizeof(header.key), "benchmark points %u", points);
+	header.topology = MESHCACHE_POINTS;
+	header.vertexSize = sizeof(Renderer::PrimVert);
+	header.vertexCount = points;
+	header.boundingSphere[1] = -10.f;
+	header.boundingSphere[2] = -30.f;
+	header.boundingSphere[3] = 25.f * 1.415f + 2.f;
+
+	std::error_code ec;
+	std::experimental::filesystem::create_directories(MESHCACHE_DEFAULT_DIRECTORY, ec);
+
+	std::string path = std::string(MESHCACHE_DEFAULT_DIRECTORY) + "/benchmark_points_" + std::to_string(points) + ".mesh";
+	if (!MeshCache::writeFile(path, header, verts.data(), NULL))
+		return "";
+
+	return path;
+}
+
+// Writes the same sea floor as a text survey in z-up UTM-like coordinates and builds it into a
+// point octree, as PointOctreeBuilder would from a sonar export
+static std::string buildPointOctree(unsigned int points, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<double> pos(-25.0, 25.0);
+
+	std::error_code ec;
+	std::experimental::filesystem::create_directories(MESHCACHE_DEFAULT_DIRECTORY, ec);
+
+	std::string base = std::string(MESHCACHE_DEFAULT_DIRECTORY) + "/benchmark_cloud_" + std::to_string(points);
+
+	FILE* f = fopen((base + ".txt").c_str(), "w");
+	if (!f)
+	{
+		printf("Error: Could not write %s.txt\n", base.c_str());
+		return "";
+	}
+
+	for (unsigned int i = 0u; i < points; ++i)
+	{
+		double x = pos(rng);
+		double y = pos(rng);
+		double z = 2.0 * sin(x * 0.3) * cos(y * 0.2) - 10.0;
+
+		fprintf(f, "%.3f %.3f %.3f\n", 500000.0 + x, 4100000.0 + y, z);
+	}
+
+	fclose(f);
+
+	PointOctreeBuilder builder;
+	if (!builder.build({ base + ".txt" }, base + ".octree"))
+		return "";
+
+	PointOctreeBuilder::Stats const &stats = builder.getStats();
+	printf("point octree: %llu points parsed in %.2f s (%.1f MB/s), %u nodes built in %.2f s on %u threads\n", static_cast<unsigned long long>(stats.points), stats.readSeconds, stats.inputBytes / (1024.0 * 1024.0) / std::max(stats.readSeconds, 1e-6), stats.nodes, stats.buildSeconds, stats.threads);
+
+	return base + ".octree";
+}
+
+static void queueScene(SyntheticScene const &scene)
+{
+	for (auto const &obj : scene.objects)
+		Renderer::getInstance().drawPrimitive(obj.primitive, obj.transform, obj.color, glm::vec4(1.f), 30.f);
+
+	for (auto const &txt : scene.text)
+		Renderer::getInstance().drawText(txt.text, txt.color, txt.pos, glm::quat(), 2.f, Renderer::HEIGHT);
+
+	for (auto const &line : scene.lines)
+		DebugDrawer::getInstance().drawLine(line.from, line.to, line.color);
+
+	if (!scene.streamedMesh.empty())
+		Renderer::getInstance().drawFlatPrimitive(scene.streamedMesh, glm::mat4(), glm::vec4(1.f));
+
+	if (!scene.pointCloud.empty())
+		Renderer::getInstance().drawPointCloud(scene.pointCloud, scene.pointCloudTransform);
+
+	Renderer::getInstance().drawUIText("Headless benchmark", glm::vec4(1.f), glm::vec3(0.f), glm::quat(), 24.f, Renderer::HEIGHT, Renderer::LEFT, Renderer::BOTTOM_LEFT);
+
+	DebugDrawer::getInstance().draw();
+}
+
+static Renderer::SceneViewInfo makeEyeView(BenchmarkOptions const &opts, float eyeOffset)
+{
+	Renderer::SceneViewInfo svi;
+	svi.m_nRenderWidth = opts.width;
+	svi.m_nRenderHeight = opts.height;
+	svi.view = glm::lookAt(glm::vec3(eyeOffset, 0.f, HEADLESSBENCH_EYE_DIST_CM), glm::vec3(eyeOffset, 0.f, 0.f), glm::vec3(0.f, 1.f, 0.f));
+	svi.projection = glm::perspective(glm::radians(60.f), static_cast<float>(opts.width) / opts.height, 1.f, 200.f);
+	svi.viewTransform = glm::mat4();
+
+	return svi;
+}
+
+static double percentile(std::vector<double> v, double p)
+{
+	if (v.empty())
+		return 0.0;
+
+	std::sort(v.begin(), v.end());
+
+	return v[std::min(v.size() - 1u, static_cast<size_t>(p * v.size()))];
+}
+
+static void runBenchmark(BenchmarkOptions const &opts, SyntheticScene const &scene, bool stereo)
+{
+	using clock = std::chrono::high_resolution_clock;
+
+	std::vector<Renderer::FramebufferDesc*> framebuffers;
+	std::vector<Renderer::SceneViewInfo> views;
+
+	if (stereo)
+	{
+		views.push_back(makeEyeView(opts, -HEADLESSBENCH_IPD_CM * 0.5f));
+		views.push_back(makeEyeView(opts, HEADLESSBENCH_IPD_CM * 0.5f));
+	}
+	else
+		views.push_back(makeEyeView(opts, 0.f));
+
+	for (size_t i = 0u; i < views.size(); ++i)
+	{
+		framebuffers.push_back(new Renderer::FramebufferDesc());
+		if (!Renderer::getInstance().CreateFrameBuffer(opts.width, opts.height, *framebuffers.back()))
+			printf("Could not create framebuffer %u\n", static_cast<unsigned int>(i));
+	}
+
+	Renderer::SceneViewInfo uiView;
+	uiView.m_nRenderWidth = opts.width;
+	uiView.m_nRenderHeight = opts.height;
+	uiView.view = glm::mat4();
+	uiView.projection = glm::ortho(0.f, static_cast<float>(opts.width), 0.f, static_cast<float>(opts.height), -1.f, 1.f);
+
+	std::vector<FrameSample> samples;
+	samples.reserve(opts.frames);
+
+	for (unsigned int f = 0u; f < opts.frames + HEADLESSBENCH_WARMUP_FRAMES; ++f)
+	{
+		FrameSample s;
+
+		Renderer::getInstance().resetRenderStats();
+
+		auto t0 = clock::now();
+
+		// once per frame, not per eye, so both eyes draw the same part of a streaming mesh
+		Renderer::getInstance().updateStreaming();
+
+		queueScene(scene);
+		Renderer::getInstance().sortTransparentObjects(glm::vec3(0.f, 0.f, HEADLESSBENCH_EYE_DIST_CM));
+
+		auto t1 = clock::now();
+
+		for (size_t i = 0u; i < views.size(); ++i)
+			Renderer::getInstance().RenderFrame(&views[i], &uiView, framebuffers[i]);
+
+		auto t2 = clock::now();
+
+		glFinish();
+
+		auto t3 = clock::now();
+
+		Renderer::getInstance().clearDynamicRenderQueue();
+		Renderer::getInstance().clearUIRenderQueue();
+		DebugDrawer::getInstance().flushLines();
+
+		s.sceneMS = std::chrono::duration<double, std::milli>(t1 - t0).count();
+		s.submitMS = std::chrono::duration<double, std::milli>(t2 - t1).count();
+		s.frameMS = std::chrono::duration<double, std::milli>(t3 - t0).count();
+		s.stats = Renderer::getInstance().getRenderStats();
+
+		if (f >= HEADLESSBENCH_WARMUP_FRAMES)
+			samples.push_back(s);
+	}
+
+	for (auto fb : framebuffers)
+		delete fb;
+
+	std::vector<double> sceneTimes, submitTimes, frameTimes;
+	double culled = 0.0, drawCalls = 0.0, stateChanges = 0.0, programBinds = 0.0, vaoBinds = 0.0, textureBinds = 0.0, uniforms = 0.0, vertexBytes = 0.0, coarserLODs = 0.0, cloudPoints = 0.0, cloudNodes = 0.0;
+
+	for (auto const &s : samples)
+	{
+		sceneTimes.push_back(s.sceneMS);
+		submitTimes.push_back(s.submitMS);
+		frameTimes.push_back(s.frameMS);
+		culled += s.stats.culledOutside + s.stats.culledTooSmall;
+		drawCalls += s.stats.drawCalls;
+		stateChanges += s.stats.stateChanges();
+		programBinds += s.stats.programBinds;
+		vaoBinds += s.stats.vertexArrayBinds;
+		textureBinds += s.stats.textureBinds;
+		uniforms += s.stats.uniformUpdates;
+		vertexBytes += static_cast<double>(s.stats.primitiveVertexBytes);
+		coarserLODs += s.stats.coarserLODs;
+		cloudPoints += static_cast<double>(s.stats.pointCloudPoints);
+		cloudNodes += s.stats.pointCloudNodes;
+	}
+
+	double n = static_cast<double>(samples.size());
+	auto mean = [](std::vector<double> const &v) { double sum = 0.0; for (double x : v) sum += x; return v.empty() ? 0.0 : sum / v.size(); };
+
+	printf("%-7s %8.3f %8.3f %8.3f %8.3f %8.3f %8.0f %8.0f %8.0f %8.0f %8.0f %8.0f %8.0f %8.3f %8.0f\n",
+		stereo ? "stereo" : "mono",
+		mean(sceneTimes),
+		mean(submitTimes), percentile(submitTimes, 0.95),
+		mean(frameTimes), percentile(frameTimes, 0.95),
+		culled / n, drawCalls / n, stateChanges / n, programBinds / n, vaoBinds / n, textureBinds / n, uniforms / n, vertexBytes / n / (1024.0 * 1024.0), coarserLODs / n);
+
+	if (!scene.pointCloud.empty())
+	{
+		PointCloud::Stats pcStats = Renderer::getInstance().getPointCloud(scene.pointCloud)->getStats();
+		printf("        point cloud: %.2f M points in %.0f nodes per frame, %u/%u slots resident, %u loads pending, %.1f MB uploaded\n", cloudPoints / n / 1e6, cloudNodes / n, pcStats.residentNodes, pcStats.slots, pcStats.loadsPending, pcStats.uploadedBytes / (1024.0 * 1024.0));
+	}
+}
+
+static bool parseOptions(int argc, char *argv[], BenchmarkOptions &opts)
+{
+	opts.primitives = 1000u;
+	opts.textStrings = 100u;
+	opts.debugLines = 1000u;
+	opts.frames = 300u;
+	opts.width = 1280;
+	opts.height = 720;
+	opts.mono = true;
+	opts.stereo = true;
+	opts.seed = 1u;
+	opts.culling = true;
+	opts.transparency = Renderer::TRANSPARENCY_AUTO;
+	opts.multiDraw = true;
+	opts.packedVertices = true;
+	opts.levelOfDetail = true;
+	opts.meshCache = true;
+	opts.streamPoints = 0u;
+	opts.cloudPoints = 0u;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg(argv[i]);
+		bool hasValue = i + 1 < argc;
+
+		if (arg == "-p" && hasValue)
+			opts.primitives = atoi(argv[++i]);
+		else if (arg == "-t" && hasValue)
+			opts.textStrings = atoi(argv[++i]);
+		else if (arg == "-l" && hasValue)
+			opts.debugLines = atoi(argv[++i]);
+		else if (arg == "-f" && hasValue)
+			opts.frames = std::max(1, atoi(argv[++i]));
+		else if (arg == "-s" && hasValue)
+		{
+			if (sscanf(argv[++i], "%dx%d", &opts.width, &opts.height) != 2 || opts.width < 1 || opts.height < 1)
+				return false;
+		}
+		else if (arg == "-m" && hasValue)
+		{
+			std::string mode(argv[++i]);
+			opts.mono = mode == "mono" || mode == "both";
+			opts.stereo = mode == "stereo" || mode == "both";
+			if (!opts.mono && !opts.stereo)
+				return false;
+		}
+		else if (arg == "--seed" && hasValue)
+			opts.seed = atoi(argv[++i]);
+		else if (arg == "--no-cull")
+			opts.culling = false;
+		else if (arg == "-o" && hasValue)
+		{
+			std::string mode(argv[++i]);
+			if (mode == "sorted")
+				opts.transparency = Renderer::TRANSPARENCY_SORTED;
+			else if (mode == "oit")
+				opts.transparency = Renderer::TRANSPARENCY_WEIGHTED_BLENDED;
+			else if (mode == "auto")
+				opts.transparency = Renderer::TRANSPARENCY_AUTO;
+			else
+				return false;
+		}
+		else if (arg == "--no-mdi")
+			opts.multiDraw = false;
+		else if (arg == "--float-verts")
+			opts.packedVertices = false;
+		else if (arg == "--no-lod")
+			opts.levelOfDetail = false;
+		else if (arg == "--no-mesh-cache")
+			opts.meshCache = false;
+		else if (arg == "--stream-points" && hasValue)
+			opts.streamPoints = atoi(argv[++i]);
+		else if (arg == "--cloud-points" && hasValue)
+			opts.cloudPoints = atoi(argv[++i]);
+		else
+			return false;
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose:
+//-----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+	BenchmarkOptions opts;
+
+	if (!parseOptions(argc, argv, opts))
+	{
+		printf("usage: %s [-p primitives] [-t text strings] [-l debug lines] [-f frames] [-s widthxheight] [-m mono|stereo|both] [--seed n] [--no-cull] [-o sorted|oit|auto] [--no-mdi] [--float-verts] [--no-lod] [--no-mesh-cache] [--stream-points n] [--cloud-points n]\n", argv[0]);
+		return 1;
+	}
+
+	if (!createContext())
+		return 1;
+
+	// GLEW's window-system part can fail on an EGL context; only the core entry points matter here
+	glewExperimental = GL_TRUE;
+	GLenum glewError = glewInit();
+	glGetError();
+	if (!glCreateFramebuffers)
+	{
+		printf("Could not load OpenGL 4.5 entry points: %s\n", glewGetErrorString(glewError));
+		destroyContext();
+		return 1;
+	}
+
+	printf("%s / %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+
+	// read by init(), which builds the primitive arena
+	Renderer::getInstance().setMeshCache(opts.meshCache);
+
+	if (!Renderer::getInstance().init())
+	{
+		destroyContext();
+		return 1;
+	}
+
+	Renderer::getInstance().setCulling(opts.culling);
+	Renderer::getInstance().setTransparencyMode(opts.transparency);
+	Renderer::getInstance().setMultiDrawIndirect(opts.multiDraw);
+	Renderer::getInstance().setPackedVertices(opts.packedVertices);
+	Renderer::getInstance().setLevelOfDetail(opts.levelOfDetail);
+
+	SyntheticScene scene = buildScene(opts);
+
+	if (opts.streamPoints > 0u)
+	{
+		std::string path = writePointCloud(opts.streamPoints, opts.seed);
+		if (!path.empty() && Renderer::getInstance().streamPrimitive("streamed points", path))
+			scene.streamedMesh = "streamed points";
+	}
+
+	if (opts.cloudPoints > 0u)
+	{
+		std::string path = buildPointOctree(opts.cloudPoints, opts.seed);
+		if (!path.empty() && Renderer::getInstance().addPointCloud("point cloud", path))
+		{
+			// z-up survey, centered where the streamed points sit
+			glm::vec4 bounds = Renderer::getInstance().getPointCloud("point cloud")->getBoundingSphere();
+
+			scene.pointCloud = "point cloud";
+			scene.pointCloudTransform = glm::translate(glm::mat4(), glm::vec3(0.f, -10.f, -30.f)) * glm::rotate(glm::mat4(), glm::radians(-90.f), glm::vec3(1.f, 0.f, 0.f)) * glm::translate(glm::mat4(), -glm::vec3(bounds));
+		}
+	}
+
+	printf("%u primitives, %u text strings, %u debug lines, %u frames at %dx%d, %s transparency, %s\n", opts.primitives, opts.textStrings, opts.debugLines, opts.frames, opts.width, opts.height, Renderer::transparencyModeName(opts.transparency), Renderer::getInstance().getBindlessTextures() ? "multi-draw indirect, bindless textures" : Renderer::getInstance().getMultiDrawIndirect() ? "multi-draw indirect" : "one draw per submission");
+	printf("primitive setup: %.1f ms, %u meshes from the mesh cache, %u generated\n", Renderer::getInstance().getPrimitiveSetupMS(), Renderer::getInstance().getCachedPrimitiveCount(), Renderer::getInstance().getGeneratedPrimitiveCount());
+	printf("%s primitive vertices: %u bytes each, %.1f KB arena\n\n", Renderer::getInstance().getPackedVertices() ? "packed" : "float", static_cast<unsigned int>(Renderer::getInstance().getPrimitiveVertexSize()), Renderer::getInstance().getPrimitiveArenaBytes() / 1024.0);
+	printf("%-7s %8s %8s %8s %8s %8s %8s %8s %8s %8s %8s %8s %8s %8s %8s\n", "mode", "scene", "submit", "sub p95", "frame", "frm p95", "culled", "draws", "states", "progs", "VAOs", "texs", "unifs", "vtx MB", "low LOD");
+	printf("%-7s %8s %8s %8s %8s %8s %8s %8s %8s %8s %8s %8s %8s %8s %8s\n", "", "ms", "ms", "ms", "ms", "ms", "/frame", "/frame", "/frame", "/frame", "/frame", "/frame", "/frame", "/frame", "/frame");
+
+	if (opts.mono)
+		runBenchmark(opts, scene, false);
+	if (opts.stereo)
+		runBenchmark(opts, scene, true);
+
+	DebugDrawer::getInstance().shutdown();
+	Renderer::getInstance().shutdown();
+
+	destroyContext();
+
+	return 0;
+}
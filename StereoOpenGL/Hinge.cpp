@@ -51,9 +51,7 @@ void Hinge::draw()
 	Renderer::RendererSubmission rs;
 	rs.glPrimitiveType = GL_TRIANGLES;
 	rs.shaderName = "gridflat";
-	rs.VAO = Renderer::getInstance().getPrimitiveVAO("quaddouble");
-	rs.vertCount = Renderer::getInstance().getPrimitiveIndexCount("quaddouble");
-	rs.indexType = GL_UNSIGNED_SHORT;
+	Renderer::getInstance().setSubmissionPrimitive(rs, "quaddouble");
 	rs.diffuseTexName = "wood.png";
 	rs.diffuseColor = glm::vec4(glm::vec3(0.75f), 1.f);
 	rs.hasTransparency = rs.diffuseColor.a != 1.f;
@@ -76,9 +74,9 @@ void Hinge::drawShadow()
 	Renderer::RendererSubmission rs;
 	rs.glPrimitiveType = GL_TRIANGLES;
 	rs.shaderName = "shadow";
-	rs.VAO = Renderer::getInstance().getPrimitiveVAO("quaddouble");
-	rs.vertCount = Renderer::getInstance().getPrimitiveIndexCount("quaddouble");
-	rs.indexType = GL_UNSIGNED_SHORT;
+	Renderer::getInstance().setSubmissionPrimitive(rs, "quaddouble");
+	// no bounding sphere: the shadow shader projects the quad away from its model transform
+	rs.boundingSphere = glm::vec4(0.f, 0.f, 0.f, -1.f);
 	rs.diffuseTexName = "white";
 	rs.diffuseColor = glm::vec4(0.1f, 0.1f, 0.1f, 1.f);
 	rs.hasTransparency = rs.diffuseColor.a != 1.f;
@@ -1,7 +1,7 @@
 #include "Icosphere.h"
-#include <list>
 
 #include "GLSLpreamble.h"
+#include "PackedVertex.h"
 
 Icosphere::Icosphere(int recursionLevel)
 	: index(0)
@@ -46,7 +46,7 @@ void Icosphere::recalculate(int recursionLevel)
 
 
 	// create 20 triangles of the icosahedron
-	std::list<TriangleIndices> faces;
+	std::vector<TriangleIndices> faces;
 
 	// 5 faces around point 0
 	faces.push_back(TriangleIndices(0, 11, 5));
@@ -80,7 +80,8 @@ void Icosphere::recalculate(int recursionLevel)
 	// refine triangles
 	for (int i = 0; i < recursionLevel; i++)
 	{
-		std::list<TriangleIndices> faces2;
+		std::vector<TriangleIndices> faces2;
+		faces2.reserve(faces.size() * 4u);
 		for (auto &tri : faces)
 		{
 			// replace triangle by 4 triangles
@@ -93,7 +94,7 @@ void Icosphere::recalculate(int recursionLevel)
 			faces2.push_back(TriangleIndices(tri.v3, c, b));
 			faces2.push_back(TriangleIndices(a, b, c));
 		}
-		faces = faces2;
+		faces.swap(faces2);
 	}
 
 	// done, now add triangles to mesh
@@ -111,23 +112,15 @@ std::vector<GLushort> Icosphere::getIndices(void) { return indices; }
 
 GLuint Icosphere::getVAO()
 {
-	std::vector<IcoVert> buff(vertices.size());
+	std::vector<PackedVertex> buff(vertices.size());
 	for (int i = 0; i < int(vertices.size()); ++i)
-	{
-		IcoVert iv;
-		iv.v = vertices[i];
-		iv.n = vertices[i];
-		iv.c = glm::vec4(1.f);
-		iv.t = glm::vec2(0.5f);
-	
-		buff[i] = iv;
-	}
+		buff[i] = packVertex(vertices[i], vertices[i], glm::vec4(1.f), glm::vec2(0.5f));
 
 	GLuint m_glVBO, m_glIBO;
 
 	// Populate a vertex buffer
 	glCreateBuffers(1, &m_glVBO);
-	glNamedBufferStorage(m_glVBO, sizeof(IcoVert) * buff.size(), &buff[0], GL_NONE);
+	glNamedBufferStorage(m_glVBO, sizeof(PackedVertex) * buff.size(), &buff[0], GL_NONE);
 
 	// Create and populate the index buffer
 	glCreateBuffers(1, &m_glIBO);
@@ -135,26 +128,11 @@ GLuint Icosphere::getVAO()
 
 	GLuint m_glVAO;
 
-	// create and bind a VAO to hold state for this model
-	glGenVertexArrays(1, &m_glVAO);
-	glBindVertexArray(m_glVAO);
-		
-		// Bind our VBO and IBO to this VAO
-		glBindBuffer(GL_ARRAY_BUFFER, m_glVBO);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_glIBO);
-
-		// Identify the components in the vertex buffer
-		glEnableVertexAttribArray(POSITION_ATTRIB_LOCATION);
-		glVertexAttribPointer(POSITION_ATTRIB_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(IcoVert), (GLvoid*) offsetof(IcoVert, v));
-		glEnableVertexAttribArray(NORMAL_ATTRIB_LOCATION);
-		glVertexAttribPointer(NORMAL_ATTRIB_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(IcoVert), (GLvoid*) offsetof(IcoVert, n));
-		glEnableVertexAttribArray(COLOR_ATTRIB_LOCATION);
-		glVertexAttribPointer(COLOR_ATTRIB_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(IcoVert), (GLvoid*)offsetof(IcoVert, c));
-		glEnableVertexAttribArray(TEXCOORD_ATTRIB_LOCATION);
-		glVertexAttribPointer(TEXCOORD_ATTRIB_LOCATION, 2, GL_FLOAT, GL_FALSE, sizeof(IcoVert), (GLvoid*) offsetof(IcoVert, t));
-
-
-	glBindVertexArray(0);
+	// create a VAO to hold state for this model
+	glCreateVertexArrays(1, &m_glVAO);
+	glVertexArrayVertexBuffer(m_glVAO, 0, m_glVBO, 0, sizeof(PackedVertex));
+	glVertexArrayElementBuffer(m_glVAO, m_glIBO);
+	setPackedVertexFormat(m_glVAO, 0);
 
 	return m_glVAO;
 }
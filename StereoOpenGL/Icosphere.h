@@ -1,6 +1,7 @@
 #pragma once
 
 #include <unordered_map>
+#include <vector>
 
 #include <glm.hpp>
 
@@ -12,7 +13,7 @@ public:
 	Icosphere(int recursionLevel);
 	~Icosphere(void);
 
-	void Icosphere::recalculate(int recursionLevel);
+	void recalculate(int recursionLevel);
 
 	std::vector<glm::vec3> getVertices(void);
 	std::vector<GLushort> getIndices(void);
@@ -35,14 +36,6 @@ private:
         }
     };
 
-	struct IcoVert
-	{
-		glm::vec3 v;
-		glm::vec3 n;
-		glm::vec4 c;
-		glm::vec2 t;
-	};
-
 	GLushort addVertex(glm::vec3 p);
 	GLushort getMiddlePoint(GLushort p1, GLushort p2, std::unordered_map<int64_t, GLushort> &midPointMap);
 
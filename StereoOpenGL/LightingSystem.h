@@ -7,7 +7,7 @@
 #include "GLSLpreamble.h"
 
 #include <glm.hpp>
-#include <GL\glew.h>
+#include <GL/glew.h>
 
 class LightingSystem
 {
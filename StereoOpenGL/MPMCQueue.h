@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#include "CacheAligned.h"
+
+// Bounded lock-free queue for any number of producer and consumer threads.
+// Each slot carries a sequence number telling producers and consumers whose turn it is,
+// so a push or pop is a single compare-and-swap on the shared index plus one store.
+// Capacity must be a power of two.
+template <typename T, size_t Capacity>
+class MPMCQueue
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "MPMCQueue capacity must be a power of two");
+
+public:
+	MPMCQueue()
+		: m_nEnqueuePos(0)
+		, m_nDequeuePos(0)
+	{
+		for (size_t i = 0; i < Capacity; ++i)
+			m_arrCells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	// Returns false without blocking if the queue is full.
+	bool push(const T &item)
+	{
+		size_t pos = m_nEnqueuePos.load(std::memory_order_relaxed);
+		Cell* cell;
+
+		while (true)
+		{
+			cell = &m_arrCells[pos & (Capacity - 1)];
+			size_t seq = cell->sequence.load(std::memory_order_acquire);
+			ptrdiff_t diff = static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos);
+
+			if (diff == 0)
+			{
+				if (m_nEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+				return false;
+			else
+				pos = m_nEnqueuePos.load(std::memory_order_relaxed);
+		}
+
+		cell->data = item;
+		cell->sequence.store(pos + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	// Returns false if the queue is empty.
+	bool pop(T &item)
+	{
+		size_t pos = m_nDequeuePos.load(std::memory_order_relaxed);
+		Cell* cell;
+
+		while (true)
+		{
+			cell = &m_arrCells[pos & (Capacity - 1)];
+			size_t seq = cell->sequence.load(std::memory_order_acquire);
+			ptrdiff_t diff = static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos + 1);
+
+			if (diff == 0)
+			{
+				if (m_nDequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+				return false;
+			else
+				pos = m_nDequeuePos.load(std::memory_order_relaxed);
+		}
+
+		item = cell->data;
+		cell->sequence.store(pos + Capacity, std::memory_order_release);
+
+		return true;
+	}
+
+	// approximate when other threads are pushing or popping
+	size_t size() const
+	{
+		size_t enq = m_nEnqueuePos.load(std::memory_order_acquire);
+		size_t deq = m_nDequeuePos.load(std::memory_order_acquire);
+		return enq > deq ? enq - deq : 0;
+	}
+
+private:
+	struct Cell {
+		std::atomic<size_t> sequence;
+		T data;
+	};
+
+	// keep the indices on separate cache lines so producers and consumers do not false-share
+	alignas(CACHEALIGNED_BYTES) std::atomic<size_t> m_nEnqueuePos;
+	alignas(CACHEALIGNED_BYTES) std::atomic<size_t> m_nDequeuePos;
+	alignas(CACHEALIGNED_BYTES) Cell m_arrCells[Capacity];
+
+public:
+	MPMCQueue(MPMCQueue const&) = delete;
+	void operator=(MPMCQueue const&) = delete;
+};
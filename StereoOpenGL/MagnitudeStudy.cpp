@@ -3,17 +3,44 @@
 #include "Renderer.h"
 #include "DataLogger.h"
 #include "DistortionUtils.h"
+#include "FrameTiming.h"
 
 #include <GLFW/glfw3.h>
 #include <algorithm>
+#include <cmath>
 #include <iomanip> // for std::setprecision()
 #include <gtc/matrix_transform.hpp>
+#include <gtc/quaternion.hpp>
+
+// per-frame telemetry columns, in the order they are added in openFrameLog()
+enum FrameLogColumn {
+	FRAMELOG_TIME,
+	FRAMELOG_PHOTON_TIME,
+	FRAMELOG_FRAME,
+	FRAMELOG_TRIAL,
+	FRAMELOG_COP_X,
+	FRAMELOG_COP_Y,
+	FRAMELOG_COP_Z,
+	FRAMELOG_VIEW_ANGLE,
+	FRAMELOG_COP_ANGLE,
+	FRAMELOG_LEFT_EYE_X,
+	FRAMELOG_LEFT_EYE_Y,
+	FRAMELOG_LEFT_EYE_Z,
+	FRAMELOG_RIGHT_EYE_X,
+	FRAMELOG_RIGHT_EYE_Y,
+	FRAMELOG_RIGHT_EYE_Z,
+	FRAMELOG_FISHTANK,
+	FRAMELOG_STIMULUS,
+	FRAMELOG_PAUSED,
+	FRAMELOG_SCREEN_MOVING,
+	FRAMELOG_SCREEN_TARGET,
+	FRAMELOG_SCREEN_COMMANDED
+};
 
 MagnitudeStudy::MagnitudeStudy()
-	: m_pSocket(NULL)
-	, m_fHingeSize(10.f)
-	, m_pEditParam(NULL)
-	, m_pDiagram(NULL)
+	: m_pMotorClient(NULL)
+	, m_uiMoveCommandID(0u)
+	, m_bMotorFailureReported(false)
 	, m_bDemoMode(false)
 	, m_bStudyMode(false)
 	, m_bPaused(false)
@@ -23,19 +50,27 @@ MagnitudeStudy::MagnitudeStudy()
 	, m_bShowDiagram(false)
 	, m_bWaitingForResponse(false)
 	, m_bDisplayCondition(false)
+	, m_fHingeSize(10.f)
 	, m_Generator(std::random_device()())
 	, m_AngleDistribution(std::uniform_int_distribution<int>(10, 20))
 	, m_BoolDistribution(std::uniform_int_distribution<int>(0, 1))
+	, m_nStimulusOnsetFrame(0ull)
+	, m_uiStimulusFrames(1u)
+	, m_dFramePeriod(1.0 / 60.0)
+	, m_pEditParam(NULL)
+	, m_pDiagram(NULL)
+	, m_nFrameCount(0ull)
 {
 }
 
 
 MagnitudeStudy::~MagnitudeStudy()
 {
-	if (m_pSocket)
+	if (m_pMotorClient)
 	{
-		m_pSocket->send("0,1");
-		delete m_pSocket;
+		if (m_pMotorClient->getState() == MotorControlClient::CONNECTED)
+			m_pMotorClient->send("0,1");
+		delete m_pMotorClient;
 	}
 
 	if (m_pDiagram)
@@ -50,8 +85,12 @@ void MagnitudeStudy::init(glm::ivec2 screenRes, glm::mat4 worldToScreenTransform
 	m_mat4Screen = worldToScreenTransform;
 	m_mat4Screen[2] *= 10.f;
 
-	if (m_pSocket == NULL)
-		m_pSocket = new WinsockClient();
+	if (m_pMotorClient == NULL)
+	{
+		m_pMotorClient = new MotorControlClient();
+		m_pMotorClient->setStateCallback(std::bind(&MagnitudeStudy::onMotorStateChange, this, std::placeholders::_1));
+		m_pMotorClient->setPositionCallback(std::bind(&MagnitudeStudy::onMotorPosition, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+	}
 
 	if (m_pDiagram == NULL)
 		m_pDiagram = new ViewingConditionsDiagram(m_mat4Screen, m_ivec2Screen);
@@ -112,11 +151,15 @@ void MagnitudeStudy::reset()
 	m_fStimulusTime = 10.f;
 	m_fStimulusDelay = 1.f;
 	m_tStimulusStart = std::chrono::high_resolution_clock::time_point();
+	m_tFirstAdjustment = m_tLastAdjustment = std::chrono::high_resolution_clock::time_point();
+	m_nStimulusOnsetFrame = 0ull;
 
 	m_fMoveTime = 2.5f;
 	m_tMoveStart = std::chrono::high_resolution_clock::time_point();
 
-	m_fLastAngle = m_fTargetAngle = 0.f;
+	m_fTargetAngle = 0.f;
+	m_MotionModel.reset(0.f);
+	m_tPhotonTime = std::chrono::high_resolution_clock::now();
 
 	m_pEditParam = NULL;
 
@@ -143,33 +186,34 @@ void MagnitudeStudy::reset()
 void MagnitudeStudy::update()
 {
 	using clock = std::chrono::high_resolution_clock;
-	auto tick = clock::now();
 
-	float elapsedMove = std::chrono::duration<float>(clock::now() - m_tMoveStart).count();
-	float elapsedStim = std::chrono::duration<float>(clock::now() - m_tStimulusStart).count();
+	// take in the latest acknowledgements and position samples before predicting
+	m_pMotorClient->pollEvents();
 
-	if (elapsedMove > 0.f)
-	{	
-		if (elapsedMove < m_fMoveTime)
-		{
-			float ratio = elapsedMove / m_fMoveTime;
-			m_fViewAngle = m_fLastAngle + (m_fTargetAngle - m_fLastAngle) * ratio;
-		}
-		else
-		{
-			m_fViewAngle = m_fTargetAngle;
-		}
-	}
+	auto now = clock::now();
+	float elapsedMove = std::chrono::duration<float>(now - m_tMoveStart).count();
+	float elapsedStim = std::chrono::duration<float>(now - m_tStimulusStart).count();
+
+	m_fViewAngle = m_MotionModel.predict(m_tPhotonTime);
 
 	if (m_bStudyMode)
 	{
-		if (elapsedStim >= 0.f && elapsedStim <= m_fStimulusTime)
-			m_bShowStimulus = true;
-		else
-			m_bShowStimulus = false;
+		unsigned long long frame = FrameTiming::getInstance().currentFrame();
+
+		// the stimulus stays up for a whole number of frames counted from the first one that showed it,
+		// so its duration is an exact number of refreshes rather than whatever the loop timing allows
+		bool expired = m_nStimulusOnsetFrame != 0ull && frame - m_nStimulusOnsetFrame >= m_uiStimulusFrames;
+
+		m_bShowStimulus = m_tStimulusStart != clock::time_point() && elapsedStim >= 0.f && !expired;
 
+		// the frame built now is the first to show the stimulus; its swap time is the true onset
+		if (m_bShowStimulus && !m_bPaused && m_nStimulusOnsetFrame == 0ull)
+		{
+			m_nStimulusOnsetFrame = frame;
+			m_uiStimulusFrames = std::max(1u, static_cast<unsigned int>(std::round(m_fStimulusTime / m_dFramePeriod)));
+		}
 
-		if (elapsedStim > m_fStimulusTime && !m_bPaused)
+		if (expired && !m_bPaused)
 		{
 			m_bBlockInput = true;
 
@@ -197,20 +241,18 @@ void MagnitudeStudy::update()
 	}
 	else
 		m_bShowStimulus = true;
+}
 
 
-	if (m_SocketFuture.valid() && m_SocketFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
-	{
-		if (m_SocketFuture.get())
-		{
-			moveScreen(0, true);
-			Renderer::getInstance().showMessage("Successfully connected to " + m_strServerAddress + " port " + std::to_string(m_uiServerPort) + " successfully!");
-		}
-		else
-			Renderer::getInstance().showMessage("ERROR! Could not connect to server at " + m_strServerAddress + " port " + std::to_string(m_uiServerPort) + "!");
-	}
-}
+void MagnitudeStudy::latchViewAngle(std::chrono::high_resolution_clock::time_point photonTime)
+{
+	m_tPhotonTime = photonTime;
+	m_fViewAngle = m_MotionModel.predict(m_tPhotonTime);
 
+	// sampled here rather than in update() so the row holds the angle the views are built from
+	if (m_FrameLog.isOpen())
+		writeFrameSample();
+}
 
 void MagnitudeStudy::draw()
 {
@@ -225,9 +267,7 @@ void MagnitudeStudy::draw()
 			Renderer::RendererSubmission rs;
 			rs.glPrimitiveType = GL_TRIANGLES;
 			rs.shaderName = rod.shaderName;
-			rs.VAO = Renderer::getInstance().getPrimitiveVAO("cylinder");
-			rs.vertCount = Renderer::getInstance().getPrimitiveIndexCount("cylinder");
-			rs.indexType = GL_UNSIGNED_SHORT;
+			Renderer::getInstance().setSubmissionPrimitive(rs, "cylinder");
 			rs.diffuseTexName = rod.textureName;
 			rs.diffuseColor = glm::vec4(rod.color, 1.f);
 			rs.hasTransparency = rs.diffuseColor.a != 1.f;
@@ -241,7 +281,7 @@ void MagnitudeStudy::draw()
 		}
 	}
 	
-	for (int i = 0; i < m_vec3DistortedGridPoints.size(); ++i)
+	for (size_t i = 0; i < m_vec3DistortedGridPoints.size(); ++i)
 	{
 		glm::vec3 dir(m_vec3DistortedGridPoints[i] - m_vec3GridPoints[i]);
 
@@ -384,9 +424,12 @@ void MagnitudeStudy::beginStudy()
 
 	DataLogger::getInstance().setID(m_strName);
 	DataLogger::getInstance().openLog(m_strName);
-	DataLogger::getInstance().setHeader("trial,ipd,view.dist,view.dist.factor,view.angle,fishtank,rod.angle,rod.length,response,expected");
+	DataLogger::getInstance().setHeader("trial,ipd,view.dist,view.dist.factor,view.angle,fishtank,rod.angle,rod.length,response,expected,response.poll.time,first.response.poll.time,onset.delay,stimulus.frames");
+	DataLogger::getInstance().setColumnarOutput(true);
 	DataLogger::getInstance().start();
 
+	openFrameLog();
+
 	m_bPaused = true;
 }
 
@@ -461,6 +504,7 @@ void MagnitudeStudy::endStudy()
 {
 	moveScreen(0);
 	m_bStudyMode = false;
+	m_FrameLog.close();
 	DataLogger::getInstance().closeLog();
 }
 
@@ -477,6 +521,17 @@ float MagnitudeStudy::getEyeSep()
 	return m_fEyeSep;
 }
 
+void MagnitudeStudy::getEyePositions(glm::vec3 &leftEye, glm::vec3 &rightEye)
+{
+	glm::vec3 COP = getCOP();
+	glm::quat COPRot = glm::inverse(glm::lookAt(COP, glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f)));
+	glm::vec3 COPRight = glm::normalize(glm::mat3_cast(COPRot)[0]);
+	glm::vec3 COPOffset = COPRight * m_fEyeSep * 0.5f;
+
+	leftEye = COP - COPOffset;
+	rightEye = COP + COPOffset;
+}
+
 std::string MagnitudeStudy::conditionString()
 {
 	return m_strCondition;
@@ -515,28 +570,102 @@ void MagnitudeStudy::outputTable()
 
 void MagnitudeStudy::writeToLog()
 {
-	std::string logEntry;
-	logEntry += std::to_string(m_nTrials - m_vExperimentConditions.size());
-	logEntry += ",";
-	logEntry += std::to_string(m_fEyeSep);
-	logEntry += ",";
-	logEntry += std::to_string(m_fViewDist);
-	logEntry += ",";
-	logEntry += std::to_string(m_vExperimentConditions.back().viewDistFactor);
-	logEntry += ",";
-	logEntry += std::to_string(m_vExperimentConditions.back().viewAngle);
-	logEntry += ",";
-	logEntry += std::to_string(m_vExperimentConditions.back().fishtank);
-	logEntry += ",";
-	logEntry += std::to_string(m_vExperimentConditions.back().angle);
-	logEntry += ",";
-	logEntry += std::to_string(m_vExperimentConditions.back().len);
-	logEntry += ",";
-	logEntry += std::to_string(m_MeasuringRod.length);
-	logEntry += ",";
-	logEntry += std::to_string(calculateExpectedResponse(m_vExperimentConditions.back()));
-
-	DataLogger::getInstance().logMessage(logEntry);
+	using clock = std::chrono::high_resolution_clock;
+
+	// onset is when the first frame showing the stimulus finished swapping; fall back to the scheduled start if it was never timed
+	clock::time_point onset = m_tStimulusStart;
+	FrameTiming::getInstance().getSwapTime(m_nStimulusOnsetFrame, onset);
+
+	// seconds from onset to when the participant's first and last rod adjustments were polled, or -1
+	// if they made none; input is polled once per frame, so these resolve to a frame, not a keypress
+	double firstResponseTime = m_tFirstAdjustment == clock::time_point() ? -1.0 : std::chrono::duration<double>(m_tFirstAdjustment - onset).count();
+	double responseTime = m_tLastAdjustment == clock::time_point() ? -1.0 : std::chrono::duration<double>(m_tLastAdjustment - onset).count();
+	double onsetDelay = std::chrono::duration<double>(onset - m_tStimulusStart).count();
+
+	DataLogger::Row row;
+	row.add(static_cast<unsigned int>(m_nTrials - m_vExperimentConditions.size()))
+		.add(m_fEyeSep)
+		.add(m_fViewDist)
+		.add(m_vExperimentConditions.back().viewDistFactor)
+		.add(m_vExperimentConditions.back().viewAngle)
+		.add(m_vExperimentConditions.back().fishtank)
+		.add(m_vExperimentConditions.back().angle)
+		.add(m_vExperimentConditions.back().len)
+		.add(m_MeasuringRod.length)
+		.add(calculateExpectedResponse(m_vExperimentConditions.back()))
+		.add(responseTime)
+		.add(firstResponseTime)
+		.add(onsetDelay)
+		.add(m_uiStimulusFrames);
+
+	DataLogger::getInstance().logRow(row);
+}
+
+void MagnitudeStudy::openFrameLog()
+{
+	std::string basePath = DataLogger::getInstance().getLogBasePath();
+	if (basePath.empty())
+		return;
+
+	m_FrameLog.clearColumns();
+	m_FrameLog.addColumn("time", ColumnarLog::FLOAT64);
+	m_FrameLog.addColumn("photon.time", ColumnarLog::FLOAT64);
+	m_FrameLog.addColumn("frame", ColumnarLog::UINT64);
+	m_FrameLog.addColumn("trial", ColumnarLog::UINT32);
+	m_FrameLog.addColumn("cop.x", ColumnarLog::FLOAT32);
+	m_FrameLog.addColumn("cop.y", ColumnarLog::FLOAT32);
+	m_FrameLog.addColumn("cop.z", ColumnarLog::FLOAT32);
+	m_FrameLog.addColumn("view.angle", ColumnarLog::FLOAT32);
+	m_FrameLog.addColumn("cop.angle", ColumnarLog::FLOAT32);
+	m_FrameLog.addColumn("eye.left.x", ColumnarLog::FLOAT32);
+	m_FrameLog.addColumn("eye.left.y", ColumnarLog::FLOAT32);
+	m_FrameLog.addColumn("eye.left.z", ColumnarLog::FLOAT32);
+	m_FrameLog.addColumn("eye.right.x", ColumnarLog::FLOAT32);
+	m_FrameLog.addColumn("eye.right.y", ColumnarLog::FLOAT32);
+	m_FrameLog.addColumn("eye.right.z", ColumnarLog::FLOAT32);
+	m_FrameLog.addColumn("fishtank", ColumnarLog::BOOL8);
+	m_FrameLog.addColumn("stimulus", ColumnarLog::BOOL8);
+	m_FrameLog.addColumn("paused", ColumnarLog::BOOL8);
+	m_FrameLog.addColumn("screen.moving", ColumnarLog::BOOL8);
+	m_FrameLog.addColumn("screen.target", ColumnarLog::FLOAT32);
+	m_FrameLog.addColumn("screen.commanded", ColumnarLog::FLOAT32);
+
+	if (!m_FrameLog.open(basePath + "_frames.col"))
+		std::cerr << "Could not open per-frame log; continuing without it" << std::endl;
+
+	m_nFrameCount = 0ull;
+}
+
+void MagnitudeStudy::writeFrameSample()
+{
+	glm::vec3 COP = getCOP();
+	glm::vec3 leftEye, rightEye;
+	getEyePositions(leftEye, rightEye);
+
+	bool screenMoving = m_MotionModel.isMoving(m_tPhotonTime);
+
+	m_FrameLog.set(FRAMELOG_TIME, DataLogger::getInstance().getTimeSinceLogStart());
+	m_FrameLog.set(FRAMELOG_PHOTON_TIME, DataLogger::getInstance().getTimeSinceLogStart(m_tPhotonTime));
+	m_FrameLog.set(FRAMELOG_FRAME, m_nFrameCount++);
+	m_FrameLog.set(FRAMELOG_TRIAL, static_cast<unsigned int>(m_nTrials - m_vExperimentConditions.size()));
+	m_FrameLog.set(FRAMELOG_COP_X, COP.x);
+	m_FrameLog.set(FRAMELOG_COP_Y, COP.y);
+	m_FrameLog.set(FRAMELOG_COP_Z, COP.z);
+	m_FrameLog.set(FRAMELOG_VIEW_ANGLE, m_fViewAngle);
+	m_FrameLog.set(FRAMELOG_COP_ANGLE, m_fCOPAngle);
+	m_FrameLog.set(FRAMELOG_LEFT_EYE_X, leftEye.x);
+	m_FrameLog.set(FRAMELOG_LEFT_EYE_Y, leftEye.y);
+	m_FrameLog.set(FRAMELOG_LEFT_EYE_Z, leftEye.z);
+	m_FrameLog.set(FRAMELOG_RIGHT_EYE_X, rightEye.x);
+	m_FrameLog.set(FRAMELOG_RIGHT_EYE_Y, rightEye.y);
+	m_FrameLog.set(FRAMELOG_RIGHT_EYE_Z, rightEye.z);
+	m_FrameLog.set(FRAMELOG_FISHTANK, m_bFishtank);
+	m_FrameLog.set(FRAMELOG_STIMULUS, m_bShowStimulus && !m_bPaused);
+	m_FrameLog.set(FRAMELOG_PAUSED, m_bPaused);
+	m_FrameLog.set(FRAMELOG_SCREEN_MOVING, screenMoving);
+	m_FrameLog.set(FRAMELOG_SCREEN_TARGET, m_fTargetAngle);
+	m_FrameLog.set(FRAMELOG_SCREEN_COMMANDED, m_MotionModel.hasSamples() ? m_MotionModel.getLastSample() : std::nanf(""));
+	m_FrameLog.commitRow();
 }
 
 void MagnitudeStudy::loadCondition(StudyCondition &c)
@@ -556,6 +685,8 @@ void MagnitudeStudy::loadCondition(StudyCondition &c)
 		m_tStimulusStart =  std::chrono::high_resolution_clock::now();
 
 	m_tStimulusStart += std::chrono::milliseconds(static_cast<int>(m_fStimulusDelay * 1000.f));
+	m_tFirstAdjustment = m_tLastAdjustment = std::chrono::high_resolution_clock::time_point();
+	m_nStimulusOnsetFrame = 0ull;
 
 	m_bBlockInput = false;
 }
@@ -588,8 +719,6 @@ float MagnitudeStudy::calculateExpectedResponse(StudyCondition &c)
 	glm::vec3 leftEyePos = (glm::rotate(glm::mat4(), glm::radians(c.viewAngle - viewAngleOffset), glm::vec3(screenBasisOrtho[1])) * glm::translate(screenBasisOrtho, glm::vec3(0.f, 0.f, m_fViewDist)))[3];
 	glm::vec3 rightEyePos = (glm::rotate(glm::mat4(), glm::radians(c.viewAngle + viewAngleOffset), glm::vec3(screenBasisOrtho[1])) * glm::translate(screenBasisOrtho, glm::vec3(0.f, 0.f, m_fViewDist)))[3];
 
-	glm::vec3 screenOrigin = glm::vec3(m_mat4Screen[3]);
-
 	std::vector<glm::vec3> pts, ptsxformed;
 
 	for (auto pt : { glm::vec3(0.f, 0.f, -0.5f), glm::vec3(0.f, 0.f, 0.5f) })
@@ -602,10 +731,9 @@ float MagnitudeStudy::calculateExpectedResponse(StudyCondition &c)
 
 bool MagnitudeStudy::moveScreen(float viewAngle, bool forceMove)
 {
-	if (m_fViewAngle == viewAngle && !forceMove)
+	if (m_fTargetAngle == viewAngle && !forceMove)
 		return false;
 
-	m_fLastAngle = m_fViewAngle;
 	m_fTargetAngle = viewAngle;
 
 	// The display angle should be the negative of the viewing angle since our viewpoint is fixed
@@ -613,26 +741,77 @@ bool MagnitudeStudy::moveScreen(float viewAngle, bool forceMove)
 	ss.precision(2);
 	ss << -viewAngle << "," << m_fMoveTime;
 	
-	m_pSocket->send(ss.str());
+	// Until the server acknowledges, assume the move starts after a typical network delay
 	m_tMoveStart = std::chrono::high_resolution_clock::now() + std::chrono::milliseconds(250);
+	m_MotionModel.commandMove(viewAngle, m_fMoveTime, m_tMoveStart);
+
+	if (m_pMotorClient->getState() == MotorControlClient::CONNECTED)
+	{
+		unsigned int moveID = ++m_uiMoveCommandID;
+
+		// the server echoes a command just before it starts moving, so the move began half a round trip before the echo arrived
+		m_pMotorClient->send(ss.str(), [this, moveID](bool ok, const std::string &reply, double roundTripSeconds) {
+			if (moveID != m_uiMoveCommandID)
+				return;
+
+			if (ok)
+			{
+				m_tMoveStart = std::chrono::high_resolution_clock::now() - std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::duration<double>(roundTripSeconds * 0.5));
+				m_MotionModel.confirmStart(m_tMoveStart);
+			}
+			else
+			{
+				// the connection went down with the move; onMotorStateChange() sends it again on reconnect
+				std::cerr << "Display move to " << m_fTargetAngle << " degrees was lost with the motor connection" << std::endl;
+			}
+		});
+	}
 
 	return true;
 }
 
-void MagnitudeStudy::receive(void * data)
+void MagnitudeStudy::onMotorStateChange(MotorControlClient::ConnectionState state)
 {
-	//if (m_bBlockInput)
-	//	return;
+	if (state == MotorControlClient::CONNECTED)
+	{
+		m_bMotorFailureReported = false;
+		// the display may have missed the current target (a lost move, or one made while disconnected), so send it again
+		moveScreen(m_fTargetAngle, true);
+		Renderer::getInstance().showMessage("Successfully connected to " + m_pMotorClient->getServer() + " port " + std::to_string(m_pMotorClient->getPort()) + "!");
+	}
+	else if (state == MotorControlClient::DISCONNECTED && !m_bMotorFailureReported)
+	{
+		// the client keeps retrying in the background, so only say so once per outage
+		m_bMotorFailureReported = true;
+		Renderer::getInstance().showMessage("ERROR! No connection to server at " + m_pMotorClient->getServer() + " port " + std::to_string(m_pMotorClient->getPort()) + "; retrying...");
+	}
+}
+
+void MagnitudeStudy::recordAdjustment(std::chrono::high_resolution_clock::time_point t)
+{
+	if (m_tFirstAdjustment == std::chrono::high_resolution_clock::time_point())
+		m_tFirstAdjustment = t;
 
-	int eventData[2];
+	m_tLastAdjustment = t;
+}
 
-	memcpy(&eventData, data, sizeof(int) * 2);
+void MagnitudeStudy::onMotorPosition(double serverTime, float displayAngle, std::chrono::high_resolution_clock::time_point received)
+{
+	// the server reports the commanded display angle, which is the negative of the viewing angle
+	m_MotionModel.addSample(serverTime, -displayAngle, received);
+}
 
-	if (eventData[0] == GLFWInputBroadcaster::EVENT::KEY_DOWN)
+void MagnitudeStudy::receive(const InputEvent &ev)
+{
+	//if (m_bBlockInput)
+	//	return;
+
+	// Ctrl-modified keys belong to the Engine's renderer toggles
+	if (ev.type == GLFWInputBroadcaster::EVENT::KEY_DOWN && !(ev.mods & GLFW_MOD_CONTROL))
 	{
 		if (m_bStudyMode)
 		{
-			if (eventData[1] == GLFW_KEY_SPACE && m_bPaused)
+			if (ev.code == GLFW_KEY_SPACE && m_bPaused)
 			{
 				m_bPaused = false;
 				loadCondition(m_vExperimentConditions.back());
@@ -641,30 +820,30 @@ void MagnitudeStudy::receive(void * data)
 		}
 		else
 		{
-			if (eventData[1] == GLFW_KEY_D)
+			if (ev.code == GLFW_KEY_D)
 				m_bShowDiagram = !m_bShowDiagram;
 
 
 			if (m_pEditParam)
 			{
-				if (eventData[1] == GLFW_KEY_BACKSPACE && m_pEditParam->buf.length() > 0)
+				if (ev.code == GLFW_KEY_BACKSPACE && m_pEditParam->buf.length() > 0)
 					m_pEditParam->buf.pop_back();
 
 				if (m_pEditParam->format & STUDYPARAM_NUMERIC)
 				{
-					if (eventData[1] >= GLFW_KEY_0 && eventData[1] <= GLFW_KEY_9)
-						m_pEditParam->buf += std::to_string(eventData[1] - GLFW_KEY_0);
+					if (ev.code >= GLFW_KEY_0 && ev.code <= GLFW_KEY_9)
+						m_pEditParam->buf += std::to_string(ev.code - GLFW_KEY_0);
 				}
 
 				if (m_pEditParam->format & STUDYPARAM_ALPHA)
 				{
-					if (eventData[1] >= GLFW_KEY_A && eventData[1] <= GLFW_KEY_Z)
-						m_pEditParam->buf += glfwGetKeyName(eventData[1], 0);
+					if (ev.code >= GLFW_KEY_A && ev.code <= GLFW_KEY_Z)
+						m_pEditParam->buf += glfwGetKeyName(ev.code, 0);
 				}
 
 				if (m_pEditParam->format & STUDYPARAM_POSNEG)
 				{
-					if (eventData[1] == GLFW_KEY_MINUS)
+					if (ev.code == GLFW_KEY_MINUS)
 					{
 						if (m_pEditParam->buf[0] == '-')
 							m_pEditParam->buf.erase(0, 1);
@@ -675,7 +854,7 @@ void MagnitudeStudy::receive(void * data)
 
 				if (m_pEditParam->format & STUDYPARAM_DECIMAL)
 				{
-					if (eventData[1] == GLFW_KEY_PERIOD)
+					if (ev.code == GLFW_KEY_PERIOD)
 					{
 						auto decimalCount = std::count(m_pEditParam->buf.begin(), m_pEditParam->buf.end(), '.');
 
@@ -685,7 +864,7 @@ void MagnitudeStudy::receive(void * data)
 				}
 
 
-				if (eventData[1] == GLFW_KEY_ENTER && m_pEditParam->buf.length() > 0)
+				if (ev.code == GLFW_KEY_ENTER && m_pEditParam->buf.length() > 0)
 				{
 					Renderer::getInstance().showMessage(m_pEditParam->desc + " set to " + m_pEditParam->buf);
 
@@ -729,66 +908,66 @@ void MagnitudeStudy::receive(void * data)
 			}
 			else
 			{
-				if (eventData[1] == GLFW_KEY_F1)
+				if (ev.code == GLFW_KEY_F1)
 				{
 					m_pEditParam = &(*std::find_if(m_vParams.begin(), m_vParams.end(), [](StudyParam p) {
 						return p.desc.compare("Server IP") == 0;
 					}));
 				}
 
-				if (eventData[1] == GLFW_KEY_F2)
+				if (ev.code == GLFW_KEY_F2)
 				{
 					m_pEditParam = &(*std::find_if(m_vParams.begin(), m_vParams.end(), [](StudyParam p) {
 						return p.desc.compare("Server Port") == 0;
 					}));
 				}
 
-				if (eventData[1] == GLFW_KEY_F3)
+				if (ev.code == GLFW_KEY_F3)
 				{
 					m_pEditParam = &(*std::find_if(m_vParams.begin(), m_vParams.end(), [](StudyParam p) {
 						return p.desc.compare("Eye Separation (cm)") == 0;
 					}));
 				}
 
-				if (eventData[1] == GLFW_KEY_F4)
+				if (ev.code == GLFW_KEY_F4)
 				{
 					m_pEditParam = &(*std::find_if(m_vParams.begin(), m_vParams.end(), [](StudyParam p) {
 						return p.desc.compare("View Distance (cm)") == 0;
 					}));
 				}
 
-				if (eventData[1] == GLFW_KEY_F5)
+				if (ev.code == GLFW_KEY_F5)
 				{
 					m_pEditParam = &(*std::find_if(m_vParams.begin(), m_vParams.end(), [](StudyParam p) {
 						return p.desc.compare("View Angle (deg)") == 0;
 					}));
 				}
 
-				if (eventData[1] == GLFW_KEY_F6)
+				if (ev.code == GLFW_KEY_F6)
 				{
 					m_pEditParam = &(*std::find_if(m_vParams.begin(), m_vParams.end(), [](StudyParam p) {
 						return p.desc.compare("Display Move Time (sec)") == 0;
 					}));
 				}
 
-				if (eventData[1] == GLFW_KEY_F7)
+				if (ev.code == GLFW_KEY_F7)
 				{
 					m_pEditParam = &(*std::find_if(m_vParams.begin(), m_vParams.end(), [](StudyParam p) {
 						return p.desc.compare("Name") == 0;
 					}));
 				}
 
-				if (eventData[1] == GLFW_KEY_R)
+				if (ev.code == GLFW_KEY_R)
 					reset();
 
-				if (eventData[1] == GLFW_KEY_HOME)
+				if (ev.code == GLFW_KEY_HOME)
 				{
 					m_bStudyMode = true;
 					m_bDemoMode = false;
 					beginStudy();
 				}
 
-				if (eventData[1] == GLFW_KEY_KP_ENTER)
+				if (ev.code == GLFW_KEY_KP_ENTER)
 				{
 					m_bDemoMode = true;
 					m_fMoveTime = 10.f;
@@ -796,7 +975,7 @@ void MagnitudeStudy::receive(void * data)
 				}
 			}
 
-			if (eventData[1] == GLFW_KEY_F8)
+			if (ev.code == GLFW_KEY_F8)
 			{
 				m_bFishtank = !m_bFishtank;
 				std::string msg("Fishtank Mode ");
@@ -804,35 +983,35 @@ void MagnitudeStudy::receive(void * data)
 				Renderer::getInstance().showMessage(msg);
 			}
 
-			if (eventData[1] == GLFW_KEY_F9)
+			if (ev.code == GLFW_KEY_F9)
 			{
-				if (!m_SocketFuture.valid())
+				if (m_pMotorClient->getState() != MotorControlClient::DISCONNECTED && m_pMotorClient->getServer() == m_strServerAddress && m_pMotorClient->getPort() == static_cast<int>(m_uiServerPort))
 				{
-					Renderer::getInstance().showMessage("Connecting to " + m_strServerAddress + " port " + std::to_string(m_uiServerPort));
-					m_SocketFuture = std::async(std::launch::async, &WinsockClient::connect, m_pSocket, m_strServerAddress, m_uiServerPort);
+					Renderer::getInstance().showMessage("Already connected or connecting to " + m_strServerAddress + " port " + std::to_string(m_uiServerPort));
 				}
 				else
 				{
-					Renderer::getInstance().showMessage("Already attempting connection with " + m_strServerAddress + " port " + std::to_string(m_uiServerPort));
+					Renderer::getInstance().showMessage("Connecting to " + m_strServerAddress + " port " + std::to_string(m_uiServerPort));
+					m_pMotorClient->connect(m_strServerAddress, m_uiServerPort);
 				}
 			}
 
-			if (eventData[1] == GLFW_KEY_F10)
+			if (ev.code == GLFW_KEY_F10)
 			{
 				m_bShowDiagram = !m_bShowDiagram;
 			}
 
-			if (eventData[1] == GLFW_KEY_T)
+			if (ev.code == GLFW_KEY_T)
 			{
 				outputTable();
 			}
 
-			if (eventData[1] == GLFW_KEY_I)
+			if (ev.code == GLFW_KEY_I)
 			{
 				m_bDisplayCondition = !m_bDisplayCondition;
 			}
 
-			//if (eventData[1] == GLFW_KEY_X)
+			//if (ev.code == GLFW_KEY_X)
 			//{
 			//	glm::mat4 m_mat4ScreenBasisOrtho = glm::mat4(
 			//		glm::normalize(m_mat4Screen[0]),
@@ -855,7 +1034,7 @@ void MagnitudeStudy::receive(void * data)
 			//	m_vec3DistortedGridPoints = distutil::transformStereoscopicPoints(copLeft, copRight, leftEyePos, rightEyePos, glm::vec3(m_mat4ScreenBasisOrtho[3]), glm::normalize(glm::vec3(m_mat4ScreenBasisOrtho[2])), m_vec3GridPoints);
 			//
 			//	m_fMaxDistortionMag = 0.f;
-			//	for (int i = 0; i < m_vec3DistortedGridPoints.size(); ++i)
+			//	for (size_t i = 0; i < m_vec3DistortedGridPoints.size(); ++i)
 			//	{
 			//		float len = glm::length(m_vec3DistortedGridPoints[i] - m_vec3GridPoints[i]);
 			//		if (len > m_fMaxDistortionMag)
@@ -866,67 +1045,73 @@ void MagnitudeStudy::receive(void * data)
 		}
 	}
 
-	if (eventData[0] == GLFWInputBroadcaster::EVENT::KEY_DOWN || eventData[0] == GLFWInputBroadcaster::EVENT::KEY_HOLD)
+	if (ev.type == GLFWInputBroadcaster::EVENT::KEY_DOWN || ev.type == GLFWInputBroadcaster::EVENT::KEY_HOLD)
 	{
 		float angleDelta = 1.f;
 		float distDelta = 1.f;
 
 		if (!m_bStudyMode)
 		{
-			if (eventData[1] == GLFW_KEY_LEFT)
+			if (ev.code == GLFW_KEY_LEFT)
 			{
 			}
-			if (eventData[1] == GLFW_KEY_RIGHT)
+			if (ev.code == GLFW_KEY_RIGHT)
 			{
 			}
 
-			if (eventData[1] == GLFW_KEY_KP_4)
+			if (ev.code == GLFW_KEY_KP_4)
 			{
 				m_Vector.angle += 1.f;
 			}
-			if (eventData[1] == GLFW_KEY_KP_6)
+			if (ev.code == GLFW_KEY_KP_6)
 			{
 				m_Vector.angle -= 1.f;
 			}
-			if (eventData[1] == GLFW_KEY_KP_8)
+			if (ev.code == GLFW_KEY_KP_8)
 			{
 				m_Vector.length += 0.1f;
 			}
-			if (eventData[1] == GLFW_KEY_KP_2)
+			if (ev.code == GLFW_KEY_KP_2)
 			{
 				m_Vector.length = std::max(m_Vector.length - 0.1f, 0.1f);
 			}
 
-			if (eventData[1] == GLFW_KEY_LEFT_BRACKET)
+			if (ev.code == GLFW_KEY_LEFT_BRACKET)
 				m_fCOPAngle -= angleDelta;
-			if (eventData[1] == GLFW_KEY_RIGHT_BRACKET)
+			if (ev.code == GLFW_KEY_RIGHT_BRACKET)
 				m_fCOPAngle += angleDelta;
 
-			if (eventData[1] == GLFW_KEY_KP_SUBTRACT)
+			if (ev.code == GLFW_KEY_KP_SUBTRACT)
 				m_fCOPDist = std::max(m_fCOPDist - distDelta, 0.f);
-			if (eventData[1] == GLFW_KEY_KP_ADD)
+			if (ev.code == GLFW_KEY_KP_ADD)
 				m_fCOPDist += distDelta;
 
-			if (eventData[1] == GLFW_KEY_MINUS)
+			if (ev.code == GLFW_KEY_MINUS)
 				m_pDiagram->setEyeSeparation(m_pDiagram->getEyeSeparation() - 0.1f);
-			if (eventData[1] == GLFW_KEY_EQUAL)
+			if (ev.code == GLFW_KEY_EQUAL)
 				m_pDiagram->setEyeSeparation(m_pDiagram->getEyeSeparation() + 0.1f);
 
-			if (eventData[1] == GLFW_KEY_9)
+			if (ev.code == GLFW_KEY_9)
 				m_pDiagram->setViewDistance(m_pDiagram->getViewDistance() - 0.1f);
-			if (eventData[1] == GLFW_KEY_0)
+			if (ev.code == GLFW_KEY_0)
 				m_pDiagram->setViewDistance(m_pDiagram->getViewDistance() + 0.1f);
 
-			if (eventData[1] == GLFW_KEY_COMMA)
+			if (ev.code == GLFW_KEY_COMMA)
 				m_pDiagram->setProjectionAngle(m_pDiagram->getProjectionAngle() - 1.f);
-			if (eventData[1] == GLFW_KEY_PERIOD)
+			if (ev.code == GLFW_KEY_PERIOD)
 				m_pDiagram->setProjectionAngle(m_pDiagram->getProjectionAngle() + 1.f);
 		}
 
-		if (eventData[1] == GLFW_KEY_UP)
+		if (ev.code == GLFW_KEY_UP)
+		{
 			m_MeasuringRod.length += 0.1f;
-		if (eventData[1] == GLFW_KEY_DOWN)
+			recordAdjustment(ev.time);
+		}
+		if (ev.code == GLFW_KEY_DOWN)
+		{
 			m_MeasuringRod.length = std::max(m_MeasuringRod.length - 0.1f, 0.1f);
+			recordAdjustment(ev.time);
+		}
 
 	}
 }
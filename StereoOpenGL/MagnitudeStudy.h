@@ -1,14 +1,15 @@
 #pragma once
 
-#include "WinsockClient.h"
+#include "MotorControlClient.h"
 #include "GLFWInputBroadcaster.h"
 #include "Hinge.h"
 #include "ViewingConditionsDiagram.h"
+#include "ColumnarLog.h"
+#include "ScreenMotionModel.h"
 
 #include <glm.hpp>
 #include <chrono>
 #include <random>
-#include <future>
 
 #define STUDYPARAM_DECIMAL	1 << 0
 #define STUDYPARAM_POSNEG	1 << 1
@@ -26,6 +27,16 @@ public:
 
 	void reset();
 
+	// when the frame about to be built is expected to reach the display; the screen angle is predicted for that moment
+	void setPhotonTime(std::chrono::high_resolution_clock::time_point t) { m_tPhotonTime = t; }
+
+	// seconds per displayed frame; stimulus durations are rounded to whole frames
+	void setFramePeriod(double seconds) { m_dFramePeriod = seconds; }
+
+	// re-predicts the screen angle for a later photon time just before the views are built,
+	// then writes the frame's telemetry row
+	void latchViewAngle(std::chrono::high_resolution_clock::time_point photonTime);
+
 	void update();
 
 	void draw();
@@ -38,6 +49,7 @@ public:
 
 	glm::vec3 getCOP();
 	float getEyeSep();
+	void getEyePositions(glm::vec3 &leftEye, glm::vec3 &rightEye);
 
 	std::string conditionString();
 
@@ -83,8 +95,9 @@ private:
 	std::vector<glm::vec3> m_vec3DistortedGridPoints;
 	float m_fMaxDistortionMag;
 
-	std::future<bool> m_SocketFuture;
-	WinsockClient* m_pSocket;
+	MotorControlClient* m_pMotorClient;
+	unsigned int m_uiMoveCommandID;
+	bool m_bMotorFailureReported;
 	Rod m_Vector;
 	Rod m_MeasuringRod;
 
@@ -130,11 +143,17 @@ private:
 	float m_fStimulusTime;
 	float m_fStimulusDelay;
 	std::chrono::high_resolution_clock::time_point m_tStimulusStart;
+	std::chrono::high_resolution_clock::time_point m_tFirstAdjustment;
+	std::chrono::high_resolution_clock::time_point m_tLastAdjustment;
+	unsigned long long m_nStimulusOnsetFrame;
+	unsigned int m_uiStimulusFrames;
+	double m_dFramePeriod;
 
 	float m_fMoveTime;
 	std::chrono::high_resolution_clock::time_point m_tMoveStart;
-	float m_fLastAngle;
 	float m_fTargetAngle;
+	ScreenMotionModel m_MotionModel;
+	std::chrono::high_resolution_clock::time_point m_tPhotonTime;
 
 	std::vector<StudyParam> m_vParams;
 	StudyParam* m_pEditParam;
@@ -143,13 +162,21 @@ private:
 
 	std::string m_strCondition;
 
+	ColumnarLog m_FrameLog;
+	unsigned long long m_nFrameCount;
+
 private:
 	void endTrial();
 	void endStudy();
 	void writeToLog();
+	void openFrameLog();
+	void writeFrameSample();
 	void loadCondition(StudyCondition &c);
 	void resetMeasuringRod();
+	void recordAdjustment(std::chrono::high_resolution_clock::time_point t);
 	float calculateExpectedResponse(StudyCondition &c);
 	bool moveScreen(float viewAngle, bool forceMove = false);
-	void receive(void* data);
+	void onMotorStateChange(MotorControlClient::ConnectionState state);
+	void onMotorPosition(double serverTime, float displayAngle, std::chrono::high_resolution_clock::time_point received);
+	void receive(const InputEvent &ev);
 };
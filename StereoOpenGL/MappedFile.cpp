@@ -0,0 +1,252 @@
+#include "MappedFile.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+#ifdef _WIN32
+	: m_hFile(INVALID_HANDLE_VALUE)
+	, m_hMapping(NULL)
+#else
+	: m_iFD(-1)
+#endif
+	, m_pData(NULL)
+	, m_nSize(0)
+	, m_bWritable(false)
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::create(std::string path, size_t size)
+{
+	close();
+
+	m_bWritable = true;
+	m_nSize = size;
+
+#ifdef _WIN32
+	m_hFile = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (m_hFile == INVALID_HANDLE_VALUE)
+	{
+		std::cerr << "MappedFile: could not create " << path << std::endl;
+		return false;
+	}
+#else
+	m_iFD = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (m_iFD < 0)
+	{
+		std::cerr << "MappedFile: could not create " << path << std::endl;
+		return false;
+	}
+
+	if (ftruncate(m_iFD, static_cast<off_t>(size)) != 0)
+	{
+		std::cerr << "MappedFile: could not size " << path << " to " << size << " bytes" << std::endl;
+		close();
+		return false;
+	}
+#endif
+
+	if (!map())
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+bool MappedFile::openRead(std::string path)
+{
+	close();
+
+	m_bWritable = false;
+
+#ifdef _WIN32
+	m_hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (m_hFile == INVALID_HANDLE_VALUE)
+	{
+		std::cerr << "MappedFile: could not open " << path << std::endl;
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(m_hFile, &fileSize);
+	m_nSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+	m_iFD = ::open(path.c_str(), O_RDONLY);
+	if (m_iFD < 0)
+	{
+		std::cerr << "MappedFile: could not open " << path << std::endl;
+		return false;
+	}
+
+	struct stat st;
+	fstat(m_iFD, &st);
+	m_nSize = static_cast<size_t>(st.st_size);
+#endif
+
+	if (m_nSize == 0u)
+	{
+		std::cerr << "MappedFile: " << path << " is empty" << std::endl;
+		close();
+		return false;
+	}
+
+	if (!map())
+	{
+		close();
+		return false;
+	}
+
+#ifndef _WIN32
+	madvise(m_pData, m_nSize, MADV_SEQUENTIAL);
+#endif
+
+	return true;
+}
+
+bool MappedFile::resize(size_t size)
+{
+	if (!m_bWritable || !isOpen())
+		return false;
+
+	unmap();
+
+	size_t oldSize = m_nSize;
+	m_nSize = size;
+
+	bool grown = true;
+
+#ifndef _WIN32
+	// on Windows the file is extended when the larger mapping is created
+	if (ftruncate(m_iFD, static_cast<off_t>(size)) != 0)
+	{
+		std::cerr << "MappedFile: could not grow file to " << size << " bytes" << std::endl;
+		grown = false;
+	}
+#endif
+
+	if (grown && map())
+		return true;
+
+	// keep the existing contents mapped so the caller can still finish the file
+	m_nSize = oldSize;
+	map();
+
+	return false;
+}
+
+void MappedFile::flush(size_t offset, size_t length)
+{
+	if (!isOpen() || !m_bWritable || offset >= m_nSize)
+		return;
+
+	if (length > m_nSize - offset)
+		length = m_nSize - offset;
+
+#ifdef _WIN32
+	FlushViewOfFile(static_cast<char*>(m_pData) + offset, length);
+#else
+	// msync wants a page-aligned start
+	size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	size_t start = offset - offset % page;
+	msync(static_cast<char*>(m_pData) + start, length + (offset - start), MS_ASYNC);
+#endif
+}
+
+void MappedFile::close(size_t truncateTo)
+{
+	unmap();
+
+#ifdef _WIN32
+	if (m_hFile != INVALID_HANDLE_VALUE)
+	{
+		if (m_bWritable && truncateTo != static_cast<size_t>(-1))
+		{
+			LARGE_INTEGER pos;
+			pos.QuadPart = static_cast<LONGLONG>(truncateTo);
+			SetFilePointerEx(m_hFile, pos, NULL, FILE_BEGIN);
+			SetEndOfFile(m_hFile);
+		}
+
+		CloseHandle(m_hFile);
+		m_hFile = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (m_iFD >= 0)
+	{
+		if (m_bWritable && truncateTo != static_cast<size_t>(-1))
+			ftruncate(m_iFD, static_cast<off_t>(truncateTo));
+
+		::close(m_iFD);
+		m_iFD = -1;
+	}
+#endif
+
+	m_nSize = 0;
+	m_bWritable = false;
+}
+
+bool MappedFile::map()
+{
+#ifdef _WIN32
+	ULARGE_INTEGER size;
+	size.QuadPart = m_nSize;
+
+	m_hMapping = CreateFileMappingA(m_hFile, NULL, m_bWritable ? PAGE_READWRITE : PAGE_READONLY, size.HighPart, size.LowPart, NULL);
+	if (m_hMapping == NULL)
+	{
+		std::cerr << "MappedFile: CreateFileMapping failed (" << GetLastError() << ")" << std::endl;
+		return false;
+	}
+
+	m_pData = MapViewOfFile(m_hMapping, m_bWritable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, m_nSize);
+	if (m_pData == NULL)
+	{
+		std::cerr << "MappedFile: MapViewOfFile failed (" << GetLastError() << ")" << std::endl;
+		CloseHandle(m_hMapping);
+		m_hMapping = NULL;
+		return false;
+	}
+#else
+	void* p = mmap(NULL, m_nSize, m_bWritable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, m_iFD, 0);
+	if (p == MAP_FAILED)
+	{
+		std::cerr << "MappedFile: mmap failed" << std::endl;
+		return false;
+	}
+
+	m_pData = p;
+#endif
+
+	return true;
+}
+
+void MappedFile::unmap()
+{
+	if (m_pData == NULL)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_pData);
+	CloseHandle(m_hMapping);
+	m_hMapping = NULL;
+#else
+	munmap(m_pData, m_nSize);
+#endif
+
+	m_pData = NULL;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+// Thin wrapper around a memory-mapped file (file mapping views on Windows, mmap elsewhere).
+// Files opened with create() are mapped read/write and can be grown with resize();
+// files opened with openRead() are mapped read-only.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool create(std::string path, size_t size);
+	bool openRead(std::string path);
+
+	// write mode only; remaps the file, so any pointers into data() are invalidated. On failure
+	// the file keeps its old size and stays mapped.
+	bool resize(size_t size);
+
+	// asynchronously schedules dirty pages in [offset, offset + length) to be written back;
+	// by default the whole mapping
+	void flush(size_t offset = 0u, size_t length = static_cast<size_t>(-1));
+
+	// truncateTo shrinks the file to that many bytes before closing (write mode only)
+	void close(size_t truncateTo = static_cast<size_t>(-1));
+
+	bool isOpen() const { return m_pData != NULL; }
+	bool isWritable() const { return m_bWritable; }
+
+	unsigned char* data() { return static_cast<unsigned char*>(m_pData); }
+	const unsigned char* data() const { return static_cast<const unsigned char*>(m_pData); }
+	size_t size() const { return m_nSize; }
+
+private:
+	bool map();
+	void unmap();
+
+#ifdef _WIN32
+	void* m_hFile;
+	void* m_hMapping;
+#else
+	int m_iFD;
+#endif
+
+	void* m_pData;
+	size_t m_nSize;
+	bool m_bWritable;
+
+public:
+	MappedFile(MappedFile const&) = delete;
+	void operator=(MappedFile const&) = delete;
+};
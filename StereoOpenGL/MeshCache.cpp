@@ -0,0 +1,148 @@
+#include "MeshCache.h"
+
+#include <cstring>
+#include <iostream>
+#include <experimental/filesystem>
+
+#define MESHCACHE_MAGIC		"SMSH"
+
+MeshCache::MeshCache()
+	: m_strDirectory(MESHCACHE_DEFAULT_DIRECTORY)
+	, m_bEnabled(true)
+	, m_uiLoaded(0u)
+	, m_uiStored(0u)
+	, m_nLoadedBytes(0u)
+{
+}
+
+MeshCache::~MeshCache()
+{
+	close();
+}
+
+bool MeshCache::load(std::string const & key, uint32_t revision, uint32_t vertexSize)
+{
+	close();
+
+	if (!m_bEnabled)
+		return false;
+
+	std::string path = getPath(key);
+
+	// a first run misses on every key, which is not worth MappedFile's error message
+	if (!std::experimental::filesystem::exists(path) || !m_File.openRead(path))
+		return false;
+
+	if (!checkFile(m_File.data(), m_File.size())
+		|| header().revision != revision
+		|| header().vertexSize != vertexSize
+		|| strncmp(header().key, key.c_str(), MESHCACHE_KEY_LENGTH) != 0)
+	{
+		close();
+		return false;
+	}
+
+	m_uiLoaded++;
+	m_nLoadedBytes += m_File.size();
+
+	return true;
+}
+
+void MeshCache::close()
+{
+	m_File.close();
+}
+
+bool MeshCache::store(std::string const & key, uint32_t revision, const void * vertices, uint32_t vertexSize, uint32_t vertexCount, const uint16_t * indices, uint32_t indexCount, glm::vec4 const & boundingSphere, float lodError)
+{
+	if (!m_bEnabled)
+		return false;
+
+	if (key.size() >= MESHCACHE_KEY_LENGTH)
+	{
+		std::cerr << "MeshCache: key \"" << key << "\" is longer than " << MESHCACHE_KEY_LENGTH - 1 << " characters" << std::endl;
+		return false;
+	}
+
+	close();
+
+	std::error_code ec;
+	std::experimental::filesystem::create_directories(m_strDirectory, ec);
+
+	MeshCacheHeader h;
+	memset(&h, 0, sizeof(h));
+	h.revision = revision;
+	strncpy(h.key, key.c_str(), MESHCACHE_KEY_LENGTH - 1);
+	h.topology = MESHCACHE_TRIANGLES;
+	h.vertexSize = vertexSize;
+	h.vertexCount = vertexCount;
+	h.indexSize = sizeof(uint16_t);
+	h.indexCount = indexCount;
+	for (int i = 0; i < 4; ++i)
+		h.boundingSphere[i] = boundingSphere[i];
+	h.lodError = lodError;
+
+	if (!writeFile(getPath(key), h, vertices, indices))
+		return false;
+
+	m_uiStored++;
+
+	return true;
+}
+
+bool MeshCache::writeFile(std::string const & path, MeshCacheHeader header, const void * vertices, const void * indices)
+{
+	size_t vertexBytes = static_cast<size_t>(header.vertexSize) * header.vertexCount;
+	size_t indexBytes = static_cast<size_t>(header.indexSize) * header.indexCount;
+
+	MappedFile file;
+	if (!file.create(path, sizeof(MeshCacheHeader) + vertexBytes + indexBytes))
+		return false;
+
+	memcpy(file.data() + sizeof(MeshCacheHeader), vertices, vertexBytes);
+	if (indexBytes > 0u)
+		memcpy(file.data() + sizeof(MeshCacheHeader) + vertexBytes, indices, indexBytes);
+
+	memcpy(header.magic, MESHCACHE_MAGIC, sizeof(header.magic));
+	header.formatVersion = MESHCACHE_FORMAT_VERSION;
+
+	// the header goes in last: the file is already full size, so a run that dies mid-write
+	// leaves a zero magic behind instead of a valid header over missing data
+	memcpy(file.data(), &header, sizeof(header));
+
+	file.close();
+
+	return true;
+}
+
+bool MeshCache::checkFile(const unsigned char * data, size_t size)
+{
+	if (data == NULL || size < sizeof(MeshCacheHeader))
+		return false;
+
+	const MeshCacheHeader &h = *reinterpret_cast<const MeshCacheHeader*>(data);
+
+	return memcmp(h.magic, MESHCACHE_MAGIC, sizeof(h.magic)) == 0
+		&& h.formatVersion == MESHCACHE_FORMAT_VERSION
+		&& h.topology <= MESHCACHE_POINTS
+		&& (h.indexSize == 0u || h.indexSize == 2u || h.indexSize == 4u)
+		&& (h.indexSize != 0u || h.indexCount == 0u)
+		&& size == sizeof(MeshCacheHeader) + static_cast<size_t>(h.vertexSize) * h.vertexCount + static_cast<size_t>(h.indexSize) * h.indexCount;
+}
+
+std::string MeshCache::getPath(std::string const & key) const
+{
+	std::string name(key);
+	for (auto &c : name)
+		if (!isalnum(static_cast<unsigned char>(c)) && c != '.' && c != '-')
+			c = '_';
+
+	return m_strDirectory + "/" + name + ".mesh";
+}
+
+void MeshCache::resetStats()
+{
+	m_uiLoaded = 0u;
+	m_uiStored = 0u;
+	m_nLoadedBytes = 0u;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <string>
+#include <stdint.h>
+#include <glm.hpp>
+
+#include "MappedFile.h"
+
+#define MESHCACHE_FORMAT_VERSION	2
+#define MESHCACHE_KEY_LENGTH		64		// includes the terminating null
+#define MESHCACHE_DEFAULT_DIRECTORY	"meshcache"
+
+// values of MeshCacheHeader::topology
+#define MESHCACHE_TRIANGLES			0u
+#define MESHCACHE_LINES				1u
+#define MESHCACHE_POINTS			2u
+
+// Start of every mesh file, followed by the vertex blob and then the index blob. The mesh cache
+// writes these, and so can tools converting external data for MeshStreamer. Files are written
+// in native byte order; they are a cache, not an interchange format.
+struct MeshCacheHeader {
+	char magic[4];
+	uint32_t formatVersion;
+	uint32_t revision;					// bumped by the caller whenever its generator output changes
+	char key[MESHCACHE_KEY_LENGTH];		// generator name and parameters, e.g. "torus 32x8"
+	uint32_t topology;
+	uint32_t vertexSize;
+	uint32_t vertexCount;
+	uint32_t indexSize;					// 2 or 4 bytes, or 0 for no index blob (vertices drawn in order)
+	uint32_t indexCount;
+	float boundingSphere[4];			// object space center and radius
+	float lodError;						// caller-defined, stored alongside so loading needs no geometry pass
+};
+
+// On-disk cache of generated meshes, one memory-mapped file per key. A mesh is only loaded
+// back if its header matches the key, revision and vertex size it is requested with, so stale
+// files are regenerated rather than misread.
+class MeshCache
+{
+public:
+	MeshCache();
+	~MeshCache();
+
+	void setDirectory(std::string directory) { m_strDirectory = directory; }
+	std::string getDirectory() const { return m_strDirectory; }
+
+	// while disabled, load() always misses and store() writes nothing
+	void setEnabled(bool enabled) { m_bEnabled = enabled; }
+	bool getEnabled() const { return m_bEnabled; }
+
+	// Maps the file for key; on success header(), vertices() and indices() point into the mapping
+	// until the next load() or close()
+	bool load(std::string const &key, uint32_t revision, uint32_t vertexSize);
+	void close();
+
+	const MeshCacheHeader& header() const { return *reinterpret_cast<const MeshCacheHeader*>(m_File.data()); }
+	const void* vertices() const { return m_File.data() + sizeof(MeshCacheHeader); }
+	const void* indices() const { return m_File.data() + sizeof(MeshCacheHeader) + static_cast<size_t>(header().vertexSize) * header().vertexCount; }
+
+	// writes an indexed triangle list with 16-bit indices under key
+	bool store(std::string const &key, uint32_t revision, const void *vertices, uint32_t vertexSize, uint32_t vertexCount, const uint16_t *indices, uint32_t indexCount, glm::vec4 const &boundingSphere, float lodError);
+
+	// Writes any mesh file; the magic and format version are filled in, the rest of the header is the caller's
+	static bool writeFile(std::string const &path, MeshCacheHeader header, const void *vertices, const void *indices);
+	// true if data holds a complete mesh file of this format version
+	static bool checkFile(const unsigned char *data, size_t size);
+
+	std::string getPath(std::string const &key) const;
+
+	unsigned int getLoadedCount() const { return m_uiLoaded; }
+	unsigned int getStoredCount() const { return m_uiStored; }
+	size_t getLoadedBytes() const { return m_nLoadedBytes; }
+	void resetStats();
+
+private:
+	std::string m_strDirectory;
+	bool m_bEnabled;
+
+	MappedFile m_File;
+
+	unsigned int m_uiLoaded;
+	unsigned int m_uiStored;
+	size_t m_nLoadedBytes;
+
+public:
+	MeshCache(MeshCache const&) = delete;
+	void operator=(MeshCache const&) = delete;
+};
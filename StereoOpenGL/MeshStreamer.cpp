@@ -0,0 +1,218 @@
+#include "MeshStreamer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+MeshStreamer::MeshStreamer()
+	: m_glStagingBuffer(0u)
+	, m_pStaging(NULL)
+	, m_uiSegment(0u)
+{
+	for (auto &fence : m_arrFences)
+		fence = 0;
+}
+
+MeshStreamer::~MeshStreamer()
+{
+}
+
+void MeshStreamer::init()
+{
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glCreateBuffers(1, &m_glStagingBuffer);
+	glNamedBufferStorage(m_glStagingBuffer, MESHSTREAMER_SEGMENT_BYTES * MESHSTREAMER_SEGMENTS, NULL, flags);
+	m_pStaging = static_cast<unsigned char*>(glMapNamedBufferRange(m_glStagingBuffer, 0, MESHSTREAMER_SEGMENT_BYTES * MESHSTREAMER_SEGMENTS, flags));
+}
+
+void MeshStreamer::shutdown()
+{
+	for (auto &fence : m_arrFences)
+	{
+		if (fence)
+			glDeleteSync(fence);
+		fence = 0;
+	}
+
+	if (m_pStaging)
+		glUnmapNamedBuffer(m_glStagingBuffer);
+	m_pStaging = NULL;
+
+	glDeleteBuffers(1, &m_glStagingBuffer);
+	m_glStagingBuffer = 0u;
+
+	for (auto &s : m_vStreams)
+	{
+		glDeleteVertexArrays(1, &s.glVAO);
+		glDeleteBuffers(1, &s.glVBO);
+		glDeleteBuffers(1, &s.glEBO);
+	}
+
+	m_vStreams.clear();
+}
+
+int MeshStreamer::open(std::string const & path, uint32_t vertexSize)
+{
+	Stream s;
+	s.path = path;
+	s.file.reset(new MappedFile());
+
+	if (!s.file->openRead(path))
+		return -1;
+
+	if (!MeshCache::checkFile(s.file->data(), s.file->size()))
+	{
+		printf("Error: \"%s\" is not a mesh file of format version %d\n", path.c_str(), MESHCACHE_FORMAT_VERSION);
+		return -1;
+	}
+
+	memcpy(&s.header, s.file->data(), sizeof(MeshCacheHeader));
+
+	if (s.header.vertexSize != vertexSize || s.header.vertexCount == 0u)
+	{
+		printf("Error: Mesh file \"%s\" has %u vertices of %u bytes, expected %u byte vertices\n", path.c_str(), s.header.vertexCount, s.header.vertexSize, vertexSize);
+		return -1;
+	}
+
+	s.sequentialIndices = s.header.indexSize == 0u;
+	s.indexType = s.header.indexSize == 2u ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	s.vertexBytes = static_cast<size_t>(s.header.vertexSize) * s.header.vertexCount;
+	s.indexBytes = s.sequentialIndices ? s.header.vertexCount * sizeof(GLuint) : static_cast<size_t>(s.header.indexSize) * s.header.indexCount;
+	s.vertexBytesDone = 0u;
+	s.indexBytesDone = 0u;
+	s.readyIndices = 0;
+	s.frames = 0u;
+
+	// filled only by copies from the staging buffer, so no client access flags
+	glCreateBuffers(1, &s.glVBO);
+	glNamedBufferStorage(s.glVBO, s.vertexBytes, NULL, 0);
+	glCreateBuffers(1, &s.glEBO);
+	glNamedBufferStorage(s.glEBO, s.indexBytes, NULL, 0);
+
+	glCreateVertexArrays(1, &s.glVAO);
+	glVertexArrayVertexBuffer(s.glVAO, 0, s.glVBO, 0, s.header.vertexSize);
+	glVertexArrayElementBuffer(s.glVAO, s.glEBO);
+
+	printf("Streaming %s: %.1f MB\n", path.c_str(), (s.vertexBytes + s.indexBytes) / (1024.0 * 1024.0));
+
+	m_vStreams.push_back(std::move(s));
+
+	return static_cast<int>(m_vStreams.size()) - 1;
+}
+
+size_t MeshStreamer::update()
+{
+	if (!m_pStaging || getPendingBytes() == 0u)
+		return 0u;
+
+	// the GPU may still be copying out of this segment from MESHSTREAMER_SEGMENTS updates ago;
+	// rather than wait for it, try again next frame
+	GLsync &fence = m_arrFences[m_uiSegment];
+	if (fence)
+	{
+		GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+			return 0u;
+
+		glDeleteSync(fence);
+		fence = 0;
+	}
+
+	GLintptr segmentOffset = static_cast<GLintptr>(m_uiSegment) * MESHSTREAMER_SEGMENT_BYTES;
+	size_t used = 0u;
+
+	for (auto &s : m_vStreams)
+	{
+		if (!s.file)
+			continue;
+
+		used += uploadStream(s, m_pStaging + segmentOffset + used, segmentOffset + used, MESHSTREAMER_SEGMENT_BYTES - used);
+
+		if (used >= MESHSTREAMER_SEGMENT_BYTES)
+			break;
+	}
+
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_uiSegment = (m_uiSegment + 1u) % MESHSTREAMER_SEGMENTS;
+
+	return used;
+}
+
+size_t MeshStreamer::uploadStream(Stream & s, unsigned char * staging, GLintptr stagingOffset, size_t budget)
+{
+	const unsigned char* src = s.file->data() + sizeof(MeshCacheHeader);
+	size_t used = 0u;
+
+	s.frames++;
+
+	if (s.sequentialIndices)
+	{
+		// whole vertices with their indices, so every uploaded vertex can be drawn
+		size_t vertexSize = s.header.vertexSize;
+		size_t first = s.vertexBytesDone / vertexSize;
+		size_t count = std::min(budget / (vertexSize + sizeof(GLuint)), static_cast<size_t>(s.header.vertexCount) - first);
+
+		if (count == 0u)
+			return 0u;
+
+		memcpy(staging, src + s.vertexBytesDone, count * vertexSize);
+		glCopyNamedBufferSubData(m_glStagingBuffer, s.glVBO, stagingOffset, s.vertexBytesDone, count * vertexSize);
+		used = count * vertexSize;
+
+		GLuint* inds = reinterpret_cast<GLuint*>(staging + used);
+		for (size_t i = 0u; i < count; ++i)
+			inds[i] = static_cast<GLuint>(first + i);
+
+		glCopyNamedBufferSubData(m_glStagingBuffer, s.glEBO, stagingOffset + used, s.indexBytesDone, count * sizeof(GLuint));
+		used += count * sizeof(GLuint);
+
+		s.vertexBytesDone += count * vertexSize;
+		s.indexBytesDone += count * sizeof(GLuint);
+		s.readyIndices = static_cast<GLsizei>(first + count);
+	}
+	else
+	{
+		// every index may point anywhere, so all vertices go up before the first index
+		if (s.vertexBytesDone < s.vertexBytes)
+		{
+			size_t chunk = std::min(budget, s.vertexBytes - s.vertexBytesDone);
+			memcpy(staging, src + s.vertexBytesDone, chunk);
+			glCopyNamedBufferSubData(m_glStagingBuffer, s.glVBO, stagingOffset, s.vertexBytesDone, chunk);
+			s.vertexBytesDone += chunk;
+			used += chunk;
+		}
+
+		if (s.vertexBytesDone == s.vertexBytes && used < budget)
+		{
+			size_t chunk = std::min(budget - used, s.indexBytes - s.indexBytesDone);
+			memcpy(staging + used, src + s.vertexBytes + s.indexBytesDone, chunk);
+			glCopyNamedBufferSubData(m_glStagingBuffer, s.glEBO, stagingOffset + used, s.indexBytesDone, chunk);
+			s.indexBytesDone += chunk;
+			used += chunk;
+
+			size_t primitiveSize = s.header.topology == MESHCACHE_TRIANGLES ? 3u : s.header.topology == MESHCACHE_LINES ? 2u : 1u;
+			size_t indices = s.indexBytesDone / s.header.indexSize;
+			s.readyIndices = static_cast<GLsizei>(indices - indices % primitiveSize);
+		}
+	}
+
+	if (s.vertexBytesDone == s.vertexBytes && s.indexBytesDone == s.indexBytes)
+	{
+		printf("Streamed %s: %.1f MB in %u frames\n", s.path.c_str(), (s.vertexBytes + s.indexBytes) / (1024.0 * 1024.0), s.frames);
+		s.file.reset();
+	}
+
+	return used;
+}
+
+size_t MeshStreamer::getPendingBytes() const
+{
+	size_t pending = 0u;
+
+	for (auto const &s : m_vStreams)
+		if (s.file)
+			pending += s.vertexBytes + s.indexBytes - s.vertexBytesDone - s.indexBytesDone;
+
+	return pending;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "MappedFile.h"
+#include "MeshCache.h"
+
+#define MESHSTREAMER_SEGMENT_BYTES	(4u * 1024u * 1024u)	// most bytes uploaded per update()
+#define MESHSTREAMER_SEGMENTS		3u						// staging segments the GPU may still be copying from
+
+// Uploads large mesh files (the MeshCache file format) to GPU buffers a few megabytes per frame,
+// so loading survey data never stalls a frame. Files are memory-mapped and copied through a
+// persistently mapped staging ring into each mesh's own buffers; a fence per segment keeps the
+// CPU from overwriting data the GPU has not copied yet, and an unsignaled fence defers the
+// upload to the next frame instead of waiting. Meshes without an index blob get sequential
+// 32-bit indices, uploaded alongside their vertices so the loaded prefix is always drawable.
+class MeshStreamer
+{
+public:
+	MeshStreamer();
+	~MeshStreamer();
+
+	void init();
+	void shutdown();
+
+	// Maps path and allocates its buffers and VAO (the caller sets the vertex format); returns the
+	// stream index, or -1 if the file is not a mesh file with vertices of vertexSize bytes
+	int open(std::string const &path, uint32_t vertexSize);
+
+	// copies up to MESHSTREAMER_SEGMENT_BYTES of pending data; returns the bytes uploaded
+	size_t update();
+
+	MeshCacheHeader const& getHeader(int stream) const { return m_vStreams[stream].header; }
+	GLuint getVAO(int stream) const { return m_vStreams[stream].glVAO; }
+	GLenum getIndexType(int stream) const { return m_vStreams[stream].indexType; }
+	// indices that can be drawn now: whole primitives whose indices and vertices are all uploaded
+	GLsizei getIndexCount(int stream) const { return m_vStreams[stream].readyIndices; }
+	bool isComplete(int stream) const { return !m_vStreams[stream].file; }
+
+	size_t getPendingBytes() const;
+
+private:
+	struct Stream {
+		std::string path;
+		std::unique_ptr<MappedFile> file; // released once everything is uploaded
+		MeshCacheHeader header;
+		GLuint glVAO, glVBO, glEBO;
+		GLenum indexType;
+		bool sequentialIndices;
+		size_t vertexBytes, indexBytes;
+		size_t vertexBytesDone, indexBytesDone;
+		GLsizei readyIndices;
+		unsigned int frames;
+	};
+
+	size_t uploadStream(Stream &s, unsigned char* staging, GLintptr stagingOffset, size_t budget);
+
+	std::vector<Stream> m_vStreams;
+
+	GLuint m_glStagingBuffer;
+	unsigned char* m_pStaging;
+	GLsync m_arrFences[MESHSTREAMER_SEGMENTS];
+	unsigned int m_uiSegment;
+
+public:
+	MeshStreamer(MeshStreamer const&) = delete;
+	void operator=(MeshStreamer const&) = delete;
+};
@@ -0,0 +1,347 @@
+#include "MeshUtils.h"
+
+#include <algorithm>
+#include <cmath>
+
+#define MESHUTIL_FORSYTH_DECAY_POWER		1.5f
+#define MESHUTIL_FORSYTH_LAST_TRI_SCORE		0.75f
+#define MESHUTIL_FORSYTH_VALENCE_SCALE		2.f
+#define MESHUTIL_FORSYTH_VALENCE_POWER		0.5f
+#define MESHUTIL_FORSYTH_MAX_VALENCE		32u		// score table size; higher valences share the last entry
+
+namespace meshutil
+{
+	static float forsythVertexScore(int cachePos, unsigned int remainingTris)
+	{
+		if (remainingTris == 0u)
+			return -1.f;
+
+		float score = 0.f;
+
+		if (cachePos >= 0)
+		{
+			// the triangle just emitted gets a flat score, or its own neighbours would win over
+			// triangles sharing an edge with it
+			if (cachePos < 3)
+				score = MESHUTIL_FORSYTH_LAST_TRI_SCORE;
+			else
+				score = powf(1.f - (cachePos - 3) / static_cast<float>(MESHUTIL_FORSYTH_CACHE_SIZE - 3), MESHUTIL_FORSYTH_DECAY_POWER);
+		}
+
+		// finish off vertices with few triangles left instead of stranding them
+		return score + MESHUTIL_FORSYTH_VALENCE_SCALE * powf(static_cast<float>(remainingTris), -MESHUTIL_FORSYTH_VALENCE_POWER);
+	}
+
+	float computeACMR(const std::vector<uint16_t> &indices, size_t vertexCount, unsigned int cacheSize)
+	{
+		size_t triCount = indices.size() / 3u;
+
+		if (triCount == 0u)
+			return 0.f;
+
+		// a vertex is cached if fewer than cacheSize misses happened since its own
+		std::vector<uint32_t> cacheTime(vertexCount, 0u);
+		uint32_t time = cacheSize + 1u;
+		size_t misses = 0u;
+
+		for (auto v : indices)
+		{
+			if (time - cacheTime[v] > cacheSize)
+			{
+				cacheTime[v] = time++;
+				misses++;
+			}
+		}
+
+		return static_cast<float>(misses) / triCount;
+	}
+
+	void optimizeVertexCache(std::vector<uint16_t> &indices, size_t vertexCount)
+	{
+		size_t triCount = indices.size() / 3u;
+
+		if (triCount == 0u)
+			return;
+
+		float scoreTable[MESHUTIL_FORSYTH_CACHE_SIZE + 1][MESHUTIL_FORSYTH_MAX_VALENCE + 1];
+		for (int pos = -1; pos < MESHUTIL_FORSYTH_CACHE_SIZE; ++pos)
+			for (unsigned int val = 0u; val <= MESHUTIL_FORSYTH_MAX_VALENCE; ++val)
+				scoreTable[pos + 1][val] = forsythVertexScore(pos, val);
+
+		// unemitted triangles around each vertex, as ranges of one shared list
+		std::vector<uint32_t> remainingTris(vertexCount, 0u);
+		for (auto v : indices)
+			remainingTris[v]++;
+
+		std::vector<uint32_t> firstTri(vertexCount + 1u, 0u);
+		for (size_t v = 0u; v < vertexCount; ++v)
+			firstTri[v + 1u] = firstTri[v] + remainingTris[v];
+
+		std::vector<uint32_t> vertexTris(indices.size());
+		std::vector<uint32_t> fill(firstTri.begin(), firstTri.end() - 1);
+		for (size_t i = 0u; i < indices.size(); ++i)
+			vertexTris[fill[indices[i]]++] = static_cast<uint32_t>(i / 3u);
+
+		std::vector<int> cachePos(vertexCount, -1);
+		std::vector<float> vertexScore(vertexCount);
+
+		auto scoreVertex = [&](uint32_t v) {
+			vertexScore[v] = scoreTable[cachePos[v] + 1][std::min(remainingTris[v], MESHUTIL_FORSYTH_MAX_VALENCE)];
+		};
+
+		for (uint32_t v = 0u; v < vertexCount; ++v)
+			scoreVertex(v);
+
+		auto scoreTriangle = [&](size_t t) {
+			return vertexScore[indices[t * 3u]] + vertexScore[indices[t * 3u + 1u]] + vertexScore[indices[t * 3u + 2u]];
+		};
+
+		std::vector<bool> emitted(triCount, false);
+		long long bestTri = 0;
+		float bestScore = -1.f;
+
+		for (size_t t = 0u; t < triCount; ++t)
+		{
+			float score = scoreTriangle(t);
+			if (score > bestScore)
+			{
+				bestScore = score;
+				bestTri = static_cast<long long>(t);
+			}
+		}
+
+		std::vector<uint16_t> output;
+		output.reserve(indices.size());
+
+		std::vector<uint32_t> cache, newCache;
+		cache.reserve(MESHUTIL_FORSYTH_CACHE_SIZE + 3);
+		newCache.reserve(MESHUTIL_FORSYTH_CACHE_SIZE + 3);
+
+		size_t scanCursor = 0u;
+
+		for (size_t n = 0u; n < triCount; ++n)
+		{
+			// nothing in the cache has triangles left, so restart at the first unemitted one
+			if (bestTri < 0)
+			{
+				while (emitted[scanCursor])
+					++scanCursor;
+
+				bestTri = static_cast<long long>(scanCursor);
+			}
+
+			size_t t = static_cast<size_t>(bestTri);
+			emitted[t] = true;
+
+			newCache.clear();
+
+			for (size_t k = 0u; k < 3u; ++k)
+			{
+				uint16_t v = indices[t * 3u + k];
+				output.push_back(v);
+				newCache.push_back(v);
+
+				uint32_t* tris = &vertexTris[firstTri[v]];
+				for (uint32_t j = 0u; j < remainingTris[v]; ++j)
+				{
+					if (tris[j] == t)
+					{
+						tris[j] = tris[remainingTris[v] - 1u];
+						break;
+					}
+				}
+
+				remainingTris[v]--;
+			}
+
+			// the emitted triangle moves to the front of the LRU cache
+			for (auto v : cache)
+				if (v != newCache[0] && v != newCache[1] && v != newCache[2])
+					newCache.push_back(v);
+
+			for (size_t i = MESHUTIL_FORSYTH_CACHE_SIZE; i < newCache.size(); ++i)
+			{
+				cachePos[newCache[i]] = -1;
+				scoreVertex(newCache[i]);
+			}
+
+			newCache.resize(std::min<size_t>(newCache.size(), MESHUTIL_FORSYTH_CACHE_SIZE));
+			cache.swap(newCache);
+
+			for (size_t i = 0u; i < cache.size(); ++i)
+			{
+				cachePos[cache[i]] = static_cast<int>(i);
+				scoreVertex(cache[i]);
+			}
+
+			// only triangles touching the cache changed score, so the best one is among them
+			bestTri = -1;
+			bestScore = -1.f;
+
+			for (auto v : cache)
+			{
+				for (uint32_t j = 0u; j < remainingTris[v]; ++j)
+				{
+					uint32_t tri = vertexTris[firstTri[v] + j];
+					float score = scoreTriangle(tri);
+
+					if (score > bestScore)
+					{
+						bestScore = score;
+						bestTri = tri;
+					}
+				}
+			}
+		}
+
+		indices.swap(output);
+	}
+
+	void optimizeOverdraw(std::vector<uint16_t> &indices, const std::vector<glm::vec3> &positions, float threshold)
+	{
+		size_t triCount = indices.size() / 3u;
+
+		if (triCount == 0u)
+			return;
+
+		std::vector<uint32_t> cacheTime(positions.size(), 0u);
+		uint32_t time = MESHUTIL_FIFO_CACHE_SIZE + 1u;
+
+		auto countMisses = [&](size_t t) {
+			unsigned int misses = 0u;
+			for (size_t k = 0u; k < 3u; ++k)
+			{
+				uint16_t v = indices[t * 3u + k];
+				if (time - cacheTime[v] > MESHUTIL_FIFO_CACHE_SIZE)
+				{
+					cacheTime[v] = time++;
+					misses++;
+				}
+			}
+			return misses;
+		};
+
+		auto flushCache = [&]() { time += MESHUTIL_FIFO_CACHE_SIZE + 1u; };
+
+		// hard boundaries: triangles that miss on all three vertices already start on a cold cache
+		std::vector<size_t> hardClusters;
+		for (size_t t = 0u; t < triCount; ++t)
+			if (countMisses(t) == 3u || t == 0u)
+				hardClusters.push_back(t);
+		hardClusters.push_back(triCount);
+
+		// soft boundaries: split again wherever the cluster so far is already as cache friendly as
+		// threshold times the whole cluster, since restarting the cache there costs little
+		std::vector<size_t> clusters;
+		for (size_t c = 0u; c + 1u < hardClusters.size(); ++c)
+		{
+			size_t start = hardClusters[c];
+			size_t end = hardClusters[c + 1u];
+
+			flushCache();
+			unsigned int misses = 0u;
+			for (size_t t = start; t < end; ++t)
+				misses += countMisses(t);
+
+			float clusterACMR = static_cast<float>(misses) / (end - start);
+
+			flushCache();
+			misses = 0u;
+			clusters.push_back(start);
+
+			for (size_t t = start; t < end; ++t)
+			{
+				misses += countMisses(t);
+
+				if (t + 1u < end && static_cast<float>(misses) / (t + 1u - clusters.back()) <= threshold * clusterACMR)
+				{
+					clusters.push_back(t + 1u);
+					flushCache();
+					misses = 0u;
+				}
+			}
+		}
+		clusters.push_back(triCount);
+
+		size_t clusterCount = clusters.size() - 1u;
+
+		// area weighted centroid and normal of each cluster and of the whole mesh
+		std::vector<glm::vec3> clusterCentroid(clusterCount, glm::vec3(0.f));
+		std::vector<glm::vec3> clusterNormal(clusterCount, glm::vec3(0.f));
+		glm::vec3 meshCentroid(0.f);
+		float meshArea = 0.f;
+
+		for (size_t c = 0u; c < clusterCount; ++c)
+		{
+			float clusterArea = 0.f;
+
+			for (size_t t = clusters[c]; t < clusters[c + 1u]; ++t)
+			{
+				const glm::vec3 &p0 = positions[indices[t * 3u]];
+				const glm::vec3 &p1 = positions[indices[t * 3u + 1u]];
+				const glm::vec3 &p2 = positions[indices[t * 3u + 2u]];
+
+				glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+				float area = glm::length(n);
+
+				clusterCentroid[c] += (p0 + p1 + p2) * (area / 3.f);
+				clusterNormal[c] += n;
+				clusterArea += area;
+			}
+
+			meshCentroid += clusterCentroid[c];
+			meshArea += clusterArea;
+
+			if (clusterArea > 0.f)
+				clusterCentroid[c] /= clusterArea;
+		}
+
+		if (meshArea > 0.f)
+			meshCentroid /= meshArea;
+
+		// clusters facing away from the center occlude the most, so they draw first
+		std::vector<float> occlusion(clusterCount, 0.f);
+		for (size_t c = 0u; c < clusterCount; ++c)
+		{
+			float len = glm::length(clusterNormal[c]);
+			if (len > 0.f)
+				occlusion[c] = glm::dot(clusterCentroid[c] - meshCentroid, clusterNormal[c] / len);
+		}
+
+		std::vector<size_t> order(clusterCount);
+		for (size_t c = 0u; c < clusterCount; ++c)
+			order[c] = c;
+
+		std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return occlusion[a] > occlusion[b]; });
+
+		std::vector<uint16_t> output;
+		output.reserve(indices.size());
+
+		for (auto c : order)
+			output.insert(output.end(), indices.begin() + clusters[c] * 3u, indices.begin() + clusters[c + 1u] * 3u);
+
+		indices.swap(output);
+	}
+
+	std::vector<uint16_t> optimizeVertexFetch(std::vector<uint16_t> &indices, size_t vertexCount)
+	{
+		const uint32_t unused = ~0u;
+
+		std::vector<uint32_t> remap(vertexCount, unused);
+		uint32_t next = 0u;
+
+		for (auto &v : indices)
+		{
+			if (remap[v] == unused)
+				remap[v] = next++;
+
+			v = static_cast<uint16_t>(remap[v]);
+		}
+
+		for (auto &r : remap)
+			if (r == unused)
+				r = next++;
+
+		return std::vector<uint16_t>(remap.begin(), remap.end());
+	}
+}
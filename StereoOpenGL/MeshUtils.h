@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include <glm.hpp>
+
+#define MESHUTIL_FIFO_CACHE_SIZE		16		// post-transform cache modeled by computeACMR() and the overdraw clustering
+#define MESHUTIL_FORSYTH_CACHE_SIZE		32		// LRU cache the vertex cache optimizer scores against
+
+// Index buffer reordering for indexed triangle lists, run once on meshes at load time.
+// The usual order is optimizeVertexCache(), then optionally optimizeOverdraw(), then
+// optimizeVertexFetch(), which renumbers the vertices and so must come last.
+namespace meshutil
+{
+	// Average cache miss ratio: vertex shader invocations per triangle with a FIFO cache of
+	// cacheSize entries. About 0.5 is ideal for a large closed mesh; 3 means no reuse at all.
+	float computeACMR(const std::vector<uint16_t> &indices, size_t vertexCount, unsigned int cacheSize = MESHUTIL_FIFO_CACHE_SIZE);
+
+	// Reorders triangles for post-transform cache reuse with Tom Forsyth's linear-speed
+	// vertex cache optimization: the next triangle is the one whose vertices score highest
+	// on recency in a modeled LRU cache plus how few unemitted triangles they have left.
+	void optimizeVertexCache(std::vector<uint16_t> &indices, size_t vertexCount);
+
+	// Splits a cache-optimized triangle order into clusters wherever the FIFO cache restarts,
+	// or where a cluster's ACMR is within threshold times the whole cluster's, then draws the
+	// clusters facing away from the mesh center first so they occlude the rest (Sander et al.,
+	// "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"). threshold >= 1
+	// trades that much ACMR for finer clusters.
+	void optimizeOverdraw(std::vector<uint16_t> &indices, const std::vector<glm::vec3> &positions, float threshold);
+
+	// Renumbers vertices in order of first use so vertex fetch walks memory forward. Returns the
+	// new index of each old vertex; unreferenced vertices are moved after the used ones.
+	std::vector<uint16_t> optimizeVertexFetch(std::vector<uint16_t> &indices, size_t vertexCount);
+}
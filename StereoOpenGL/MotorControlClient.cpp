@@ -0,0 +1,493 @@
+#include "MotorControlClient.h"
+
+#include <deque>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <WinSock2.h>
+#include <ws2tcpip.h>
+
+// Need to link with Ws2_32.lib
+#pragma comment (lib, "Ws2_32.lib")
+
+typedef int socklen_t;
+#define SEND_FLAGS 0
+static int lastSocketError() { return WSAGetLastError(); }
+static bool isWouldBlock(int err) { return err == WSAEWOULDBLOCK || err == WSAEINPROGRESS; }
+static void closeSocket(SOCKET s) { closesocket(s); }
+static void setNonBlocking(SOCKET s) { u_long mode = 1; ioctlsocket(s, FIONBIO, &mode); }
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+typedef int SOCKET;
+#define INVALID_SOCKET	-1
+#define SOCKET_ERROR	-1
+#define SEND_FLAGS		MSG_NOSIGNAL
+static int lastSocketError() { return errno; }
+static bool isWouldBlock(int err) { return err == EWOULDBLOCK || err == EAGAIN || err == EINPROGRESS; }
+static void closeSocket(SOCKET s) { ::close(s); }
+static void setNonBlocking(SOCKET s) { fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK); }
+#endif
+
+typedef std::chrono::high_resolution_clock Clock;
+
+//-----------------------------------------------------------------------------
+// Purpose: Non-blocking connect that gives up after MOTORCLIENT_CONNECT_TIMEOUT_MS
+//			or as soon as the client is told to stop.
+//-----------------------------------------------------------------------------
+static SOCKET openConnection(const std::string &server, int port, std::atomic<bool> &running)
+{
+	struct addrinfo hints, *result = NULL;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+
+	int iResult = getaddrinfo(server.c_str(), std::to_string(port).c_str(), &hints, &result);
+	if (iResult != 0)
+	{
+		printf("MotorControlClient: getaddrinfo failed with error: %d\n", iResult);
+		return INVALID_SOCKET;
+	}
+
+	SOCKET s = INVALID_SOCKET;
+
+	for (struct addrinfo *ptr = result; ptr != NULL && s == INVALID_SOCKET && running; ptr = ptr->ai_next)
+	{
+		s = socket(ptr->ai_family, ptr->ai_socktype, ptr->ai_protocol);
+		if (s == INVALID_SOCKET)
+			continue;
+
+		setNonBlocking(s);
+
+		if (::connect(s, ptr->ai_addr, (int)ptr->ai_addrlen) == 0)
+			break;
+
+		if (!isWouldBlock(lastSocketError()))
+		{
+			closeSocket(s);
+			s = INVALID_SOCKET;
+			continue;
+		}
+
+		// wait for the connect to finish in short slices so a shutdown is not held up
+		bool connected = false;
+		auto deadline = Clock::now() + std::chrono::milliseconds(MOTORCLIENT_CONNECT_TIMEOUT_MS);
+
+		while (running && Clock::now() < deadline)
+		{
+			fd_set wr, ex;
+			FD_ZERO(&wr);
+			FD_ZERO(&ex);
+			FD_SET(s, &wr);
+			FD_SET(s, &ex);
+			timeval tv = { 0, 50000 };
+
+			int n = select((int)(s + 1), NULL, &wr, &ex, &tv);
+			if (n == 0)
+				continue;
+
+			if (n > 0 && FD_ISSET(s, &wr))
+			{
+				int err = 0;
+				socklen_t len = sizeof(err);
+				getsockopt(s, SOL_SOCKET, SO_ERROR, (char*)&err, &len);
+				connected = err == 0;
+			}
+			break;
+		}
+
+		if (!connected)
+		{
+			closeSocket(s);
+			s = INVALID_SOCKET;
+		}
+	}
+
+	freeaddrinfo(result);
+
+	if (s != INVALID_SOCKET)
+	{
+		// commands are tiny and latency-critical
+		int noDelay = 1;
+		setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+	}
+
+	return s;
+}
+
+MotorControlClient::MotorControlClient()
+	: m_iPort(0)
+	, m_bRunning(false)
+	, m_uiFlushTimeoutMS(0u)
+	, m_eState(DISCONNECTED)
+	, m_bPositionPending(false)
+	, m_nPositionsDropped(0u)
+	, m_uiNextMessageID(0u)
+{
+#ifdef _WIN32
+	WSADATA wsaData;
+	int iResult = WSAStartup(MAKEWORD(2, 2), &wsaData);
+	if (iResult != 0)
+		printf("WSAStartup failed with error: %d\n", iResult);
+#endif
+}
+
+MotorControlClient::~MotorControlClient()
+{
+	disconnect();
+
+#ifdef _WIN32
+	WSACleanup();
+#endif
+}
+
+void MotorControlClient::connect(std::string server, int port)
+{
+	disconnect(0u);
+
+	m_strServer = server;
+	m_iPort = port;
+
+	m_bRunning = true;
+	m_NetworkThread = std::thread(&MotorControlClient::networkLoop, this);
+}
+
+void MotorControlClient::disconnect(unsigned int flushTimeoutMS)
+{
+	if (!m_NetworkThread.joinable())
+		return;
+
+	m_uiFlushTimeoutMS = flushTimeoutMS;
+	m_bRunning = false;
+	m_NetworkThread.join();
+}
+
+bool MotorControlClient::send(std::string msg, AckCallback onAck)
+{
+	if (msg.length() >= MOTORCLIENT_MAX_MESSAGE_LENGTH)
+	{
+		printf("MotorControlClient: message too long (%d bytes): %s\n", (int)msg.length(), msg.c_str());
+		return false;
+	}
+
+	OutgoingMessage* slot = m_qOutgoing.claim();
+	if (slot == NULL)
+	{
+		printf("MotorControlClient: send queue full, dropping: %s\n", msg.c_str());
+		return false;
+	}
+
+	memcpy(slot->text, msg.c_str(), msg.length());
+	slot->length = static_cast<unsigned int>(msg.length());
+	slot->id = m_uiNextMessageID++;
+
+	if (onAck)
+		m_mapPendingAcks[slot->id] = onAck;
+
+	m_qOutgoing.commit();
+
+	return true;
+}
+
+void MotorControlClient::pollEvents()
+{
+	IncomingEvent ev;
+
+	while (m_qIncoming.pop(ev))
+	{
+		switch (ev.type)
+		{
+		case EVENT_ACK:
+		case EVENT_NACK:
+		{
+			auto it = m_mapPendingAcks.find(ev.id);
+			if (it != m_mapPendingAcks.end())
+			{
+				AckCallback cb = it->second;
+				m_mapPendingAcks.erase(it);
+				cb(ev.type == EVENT_ACK, std::string(ev.text), ev.roundTripSeconds);
+			}
+			break;
+		}
+		case EVENT_STATE:
+			if (m_fnStateCallback)
+				m_fnStateCallback(ev.state);
+			break;
+		case EVENT_POSITION:
+			if (m_fnPositionCallback)
+				m_fnPositionCallback(ev.serverTime, ev.position, ev.received);
+			break;
+		}
+	}
+}
+
+void MotorControlClient::postEvent(const IncomingEvent &ev)
+{
+	// Never wait on the caller here, or the socket stops being read. While the caller is
+	// behind, only the newest position sample is kept, since it supersedes the older ones;
+	// anything else is held back in order until pollEvents() makes room.
+	flushBacklog();
+
+	if (ev.type == EVENT_POSITION)
+	{
+		if (m_bPositionPending)
+			++m_nPositionsDropped;
+
+		m_LatestPosition = ev;
+		m_bPositionPending = true;
+	}
+	else
+		m_qBacklog.push_back(ev);
+
+	flushBacklog();
+}
+
+void MotorControlClient::flushBacklog()
+{
+	while (!m_qBacklog.empty() && m_qIncoming.push(m_qBacklog.front()))
+		m_qBacklog.pop_front();
+
+	if (m_qBacklog.empty() && m_bPositionPending && m_qIncoming.push(m_LatestPosition))
+		m_bPositionPending = false;
+}
+
+// fails every queued command; network thread only
+void MotorControlClient::rejectQueued()
+{
+	OutgoingMessage* msg;
+	while ((msg = m_qOutgoing.front()) != NULL)
+	{
+		IncomingEvent ev;
+		ev.type = EVENT_NACK;
+		ev.id = msg->id;
+		ev.state = m_eState.load();
+		ev.roundTripSeconds = 0.0;
+		ev.text[0] = '\0';
+		postEvent(ev);
+
+		m_qOutgoing.release();
+	}
+}
+
+void MotorControlClient::postState(ConnectionState state)
+{
+	if (m_eState.exchange(state) == state)
+		return;
+
+	IncomingEvent ev;
+	ev.type = EVENT_STATE;
+	ev.id = 0u;
+	ev.state = state;
+	ev.roundTripSeconds = 0.0;
+	ev.text[0] = '\0';
+	postEvent(ev);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Network thread. Connects (retrying with exponential backoff), then
+//			multiplexes queued commands out and echoed lines in with select().
+//			Echoes arrive in command order, so they are matched first-in
+//			first-out against the commands still in flight.
+//-----------------------------------------------------------------------------
+void MotorControlClient::networkLoop()
+{
+	unsigned int backoffMS = MOTORCLIENT_MIN_BACKOFF_MS;
+
+	struct InFlight {
+		unsigned int id;
+		Clock::time_point sent;
+	};
+
+	while (m_bRunning)
+	{
+		postState(CONNECTING);
+
+		SOCKET s = openConnection(m_strServer, m_iPort, m_bRunning);
+
+		// whatever was queued while connecting was meant for a display state the caller will
+		// have moved on from by the time the CONNECTED event reaches it
+		rejectQueued();
+
+		if (s == INVALID_SOCKET)
+		{
+			postState(DISCONNECTED);
+
+			if (m_bRunning)
+				printf("MotorControlClient: unable to connect to %s port %d; retrying in %u ms\n", m_strServer.c_str(), m_iPort, backoffMS);
+
+			auto retryAt = Clock::now() + std::chrono::milliseconds(backoffMS);
+			while (m_bRunning && Clock::now() < retryAt)
+			{
+				rejectQueued();
+				flushBacklog();
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+
+			backoffMS = backoffMS * 2u > MOTORCLIENT_MAX_BACKOFF_MS ? MOTORCLIENT_MAX_BACKOFF_MS : backoffMS * 2u;
+			continue;
+		}
+
+		printf("MotorControlClient: connected to %s port %d\n", m_strServer.c_str(), m_iPort);
+
+		backoffMS = MOTORCLIENT_MIN_BACKOFF_MS;
+		postState(CONNECTED);
+
+		std::string sendBuffer, recvBuffer;
+		std::deque<InFlight> inFlight;
+		bool stopping = false;
+		Clock::time_point stopDeadline;
+
+		while (true)
+		{
+			Clock::time_point now = Clock::now();
+
+			flushBacklog();
+
+			if (!m_bRunning && !stopping)
+			{
+				stopping = true;
+				stopDeadline = now + std::chrono::milliseconds(m_uiFlushTimeoutMS.load());
+			}
+
+			OutgoingMessage* msg;
+			while ((msg = m_qOutgoing.front()) != NULL)
+			{
+				sendBuffer.append(msg->text, msg->length);
+				sendBuffer += '\n';
+				inFlight.push_back({ msg->id, now });
+				m_qOutgoing.release();
+			}
+
+			if (stopping && (sendBuffer.empty() || now >= stopDeadline))
+				break;
+
+			fd_set rd, wr;
+			FD_ZERO(&rd);
+			FD_ZERO(&wr);
+			FD_SET(s, &rd);
+			if (!sendBuffer.empty())
+				FD_SET(s, &wr);
+
+			// short timeout so newly queued commands go out within a couple of milliseconds
+			timeval tv = { 0, 2000 };
+			int n = select((int)(s + 1), &rd, &wr, NULL, &tv);
+			if (n < 0)
+			{
+				printf("MotorControlClient: select failed with error: %d\n", lastSocketError());
+				break;
+			}
+
+			if (n > 0 && FD_ISSET(s, &wr))
+			{
+				int sent = ::send(s, sendBuffer.data(), (int)sendBuffer.length(), SEND_FLAGS);
+				if (sent > 0)
+					sendBuffer.erase(0, sent);
+				else if (sent == SOCKET_ERROR && !isWouldBlock(lastSocketError()))
+				{
+					printf("MotorControlClient: send failed with error: %d\n", lastSocketError());
+					break;
+				}
+			}
+
+			if (n > 0 && FD_ISSET(s, &rd))
+			{
+				char buf[512];
+				int received = recv(s, buf, sizeof(buf), 0);
+
+				if (received == 0)
+				{
+					printf("MotorControlClient: connection closed by server\n");
+					break;
+				}
+				else if (received == SOCKET_ERROR)
+				{
+					if (isWouldBlock(lastSocketError()))
+						continue;
+
+					printf("MotorControlClient: recv failed with error: %d\n", lastSocketError());
+					break;
+				}
+
+				recvBuffer.append(buf, received);
+
+				size_t eol;
+				while ((eol = recvBuffer.find('\n')) != std::string::npos)
+				{
+					std::string line = recvBuffer.substr(0, eol);
+					recvBuffer.erase(0, eol + 1);
+
+					if (!line.empty() && line.back() == '\r')
+						line.pop_back();
+
+					if (line.compare(0, 4, "pos,") == 0)
+					{
+						IncomingEvent ev;
+						ev.type = EVENT_POSITION;
+						ev.id = 0u;
+						ev.state = CONNECTED;
+						ev.roundTripSeconds = 0.0;
+						ev.received = Clock::now();
+						ev.text[0] = '\0';
+						if (sscanf(line.c_str() + 4, "%lf,%f", &ev.serverTime, &ev.position) == 2)
+							postEvent(ev);
+						continue;
+					}
+
+					if (inFlight.empty())
+					{
+						printf("MotorControlClient: unexpected reply: %s\n", line.c_str());
+						continue;
+					}
+
+					IncomingEvent ev;
+					ev.type = EVENT_ACK;
+					ev.id = inFlight.front().id;
+					ev.state = CONNECTED;
+					ev.roundTripSeconds = std::chrono::duration<double>(Clock::now() - inFlight.front().sent).count();
+					strncpy(ev.text, line.c_str(), MOTORCLIENT_MAX_MESSAGE_LENGTH - 1);
+					ev.text[MOTORCLIENT_MAX_MESSAGE_LENGTH - 1] = '\0';
+					postEvent(ev);
+
+					inFlight.pop_front();
+				}
+			}
+		}
+
+		closeSocket(s);
+
+		if (m_nPositionsDropped > 0u)
+		{
+			printf("MotorControlClient: dropped %llu stale position samples that were not polled in time\n", m_nPositionsDropped);
+			m_nPositionsDropped = 0u;
+		}
+
+		// anything not echoed by now is lost with the connection
+		for (auto const &f : inFlight)
+		{
+			IncomingEvent ev;
+			ev.type = EVENT_NACK;
+			ev.id = f.id;
+			ev.state = DISCONNECTED;
+			ev.roundTripSeconds = 0.0;
+			ev.text[0] = '\0';
+			postEvent(ev);
+		}
+
+		// queued after the connection was lost, or too late to go out before disconnect()
+		rejectQueued();
+
+		postState(DISCONNECTED);
+	}
+
+	m_eState = DISCONNECTED;
+}
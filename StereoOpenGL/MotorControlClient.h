@@ -0,0 +1,124 @@
+#pragma once
+
+#include "SPSCQueue.h"
+
+#include <string>
+#include <map>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <functional>
+
+#define MOTORCLIENT_MAX_MESSAGE_LENGTH	64
+#define MOTORCLIENT_QUEUE_SIZE			256
+#define MOTORCLIENT_MIN_BACKOFF_MS		250
+#define MOTORCLIENT_MAX_BACKOFF_MS		8000
+#define MOTORCLIENT_CONNECT_TIMEOUT_MS	2000
+
+// Asynchronous client for the display motor server (remoteservo.py).
+// Messages are newline-delimited; the server echoes each command line once it has accepted it.
+// The server also streams "pos,<server time>,<angle>" lines with the commanded display angle
+// (the servo's last PWM step; it has no position feedback), which are passed to the position
+// callback and are not treated as acknowledgements. If pollEvents() falls behind, only the
+// newest of these is kept.
+// All socket work happens on a network thread. send() only queues, and acknowledgements and
+// connection changes are handed back to the caller's thread from pollEvents().
+// Commands are only sent over the connection they were queued for: anything still queued when
+// the connection drops, or queued while it is down, fails (ok = false) instead of going out in
+// a burst after the reconnect.
+class MotorControlClient : public CacheAligned
+{
+public:
+	enum ConnectionState {
+		DISCONNECTED,
+		CONNECTING,
+		CONNECTED
+	};
+
+	// ok is false if the connection dropped before the server echoed the command, or was down
+	// when it was queued
+	typedef std::function<void(bool ok, const std::string &reply, double roundTripSeconds)> AckCallback;
+	typedef std::function<void(ConnectionState state)> StateCallback;
+	// serverTime is the server's clock in seconds; angle is the commanded position; received is when the line arrived on this machine
+	typedef std::function<void(double serverTime, float angle, std::chrono::high_resolution_clock::time_point received)> PositionCallback;
+
+	MotorControlClient();
+	~MotorControlClient();
+
+	// returns immediately; the network thread keeps (re)connecting with exponential backoff until disconnect()
+	void connect(std::string server, int port);
+	// sends whatever is still queued (for up to flushTimeoutMS), then closes the connection
+	void disconnect(unsigned int flushTimeoutMS = 500u);
+
+	// queues a command line (without the trailing newline); returns false if the queue is full
+	bool send(std::string msg, AckCallback onAck = AckCallback());
+
+	// delivers pending acknowledgements, position samples and state changes; call once per frame from the thread that calls send()
+	void pollEvents();
+
+	void setStateCallback(StateCallback cb) { m_fnStateCallback = cb; }
+	void setPositionCallback(PositionCallback cb) { m_fnPositionCallback = cb; }
+
+	ConnectionState getState() const { return m_eState.load(); }
+	std::string getServer() const { return m_strServer; }
+	int getPort() const { return m_iPort; }
+
+private:
+	struct OutgoingMessage {
+		char text[MOTORCLIENT_MAX_MESSAGE_LENGTH];
+		unsigned int length;
+		unsigned int id;
+	};
+
+	enum EventType {
+		EVENT_ACK,
+		EVENT_NACK,
+		EVENT_STATE,
+		EVENT_POSITION
+	};
+
+	struct IncomingEvent {
+		EventType type;
+		unsigned int id;
+		ConnectionState state;
+		double roundTripSeconds;
+		double serverTime;
+		float position;
+		std::chrono::high_resolution_clock::time_point received;
+		char text[MOTORCLIENT_MAX_MESSAGE_LENGTH];
+	};
+
+	std::string m_strServer;
+	int m_iPort;
+
+	std::thread m_NetworkThread;
+	std::atomic<bool> m_bRunning;
+	std::atomic<unsigned int> m_uiFlushTimeoutMS;
+	std::atomic<ConnectionState> m_eState;
+
+	SPSCQueue<OutgoingMessage, MOTORCLIENT_QUEUE_SIZE> m_qOutgoing;
+	SPSCQueue<IncomingEvent, MOTORCLIENT_QUEUE_SIZE> m_qIncoming;
+
+	// only touched on the network thread
+	std::deque<IncomingEvent> m_qBacklog;		// acknowledgements and state changes waiting for room in m_qIncoming
+	IncomingEvent m_LatestPosition;				// newest sample waiting for room; replaces any older one
+	bool m_bPositionPending;
+	unsigned long long m_nPositionsDropped;
+
+	// only touched on the caller's thread
+	unsigned int m_uiNextMessageID;
+	std::map<unsigned int, AckCallback> m_mapPendingAcks;
+	StateCallback m_fnStateCallback;
+	PositionCallback m_fnPositionCallback;
+
+	void networkLoop();
+	void postEvent(const IncomingEvent &ev);
+	void flushBacklog();
+	void postState(ConnectionState state);
+	void rejectQueued();
+
+public:
+	MotorControlClient(MotorControlClient const&) = delete;
+	void operator=(MotorControlClient const&) = delete;
+};
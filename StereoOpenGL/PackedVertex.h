@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+
+#include <GL/glew.h>
+
+#include <glm.hpp>
+#include <gtc/packing.hpp>
+
+#include "GLSLpreamble.h"
+
+// Quantized vertex for the built-in meshes: 20 bytes instead of the 48 of float position,
+// normal, color and texture coordinate. Half positions keep about 3 significant digits, which is
+// plenty for unit-sized meshes that are scaled by their model matrix.
+struct PackedVertex {
+	GLhalf p[3];	// position, half float
+	GLhalf pad;		// keeps the normal 4-byte aligned
+	GLuint n;		// normal, snorm GL_INT_2_10_10_10_REV
+	GLuint c;		// color, unorm8 RGBA
+	GLhalf t[2];	// texture coord, half float
+};
+
+inline PackedVertex packVertex(glm::vec3 const &p, glm::vec3 const &n, glm::vec4 const &c, glm::vec2 const &t)
+{
+	PackedVertex pv;
+	pv.p[0] = glm::packHalf1x16(p.x);
+	pv.p[1] = glm::packHalf1x16(p.y);
+	pv.p[2] = glm::packHalf1x16(p.z);
+	pv.pad = 0u;
+	pv.n = glm::packSnorm3x10_1x2(glm::vec4(n, 0.f));
+	pv.c = glm::packUnorm4x8(c);
+	pv.t[0] = glm::packHalf1x16(t.x);
+	pv.t[1] = glm::packHalf1x16(t.y);
+
+	return pv;
+}
+
+// Points the position, normal, color and texture coordinate attributes of a VAO at PackedVertex
+// data in the given vertex buffer binding
+inline void setPackedVertexFormat(GLuint vao, GLuint bindingIndex)
+{
+	glEnableVertexArrayAttrib(vao, POSITION_ATTRIB_LOCATION);
+	glVertexArrayAttribFormat(vao, POSITION_ATTRIB_LOCATION, 3, GL_HALF_FLOAT, GL_FALSE, offsetof(PackedVertex, p));
+	glVertexArrayAttribBinding(vao, POSITION_ATTRIB_LOCATION, bindingIndex);
+	glEnableVertexArrayAttrib(vao, NORMAL_ATTRIB_LOCATION);
+	glVertexArrayAttribFormat(vao, NORMAL_ATTRIB_LOCATION, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offsetof(PackedVertex, n));
+	glVertexArrayAttribBinding(vao, NORMAL_ATTRIB_LOCATION, bindingIndex);
+	glEnableVertexArrayAttrib(vao, COLOR_ATTRIB_LOCATION);
+	glVertexArrayAttribFormat(vao, COLOR_ATTRIB_LOCATION, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(PackedVertex, c));
+	glVertexArrayAttribBinding(vao, COLOR_ATTRIB_LOCATION, bindingIndex);
+	glEnableVertexArrayAttrib(vao, TEXCOORD_ATTRIB_LOCATION);
+	glVertexArrayAttribFormat(vao, TEXCOORD_ATTRIB_LOCATION, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(PackedVertex, t));
+	glVertexArrayAttribBinding(vao, TEXCOORD_ATTRIB_LOCATION, bindingIndex);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+// Shims for the handful of MSVC/Win32-only calls used outside the platform-specific
+// sections of MappedFile, MotorControlClient and shaderset, so the same sources build
+// with the Visual Studio project and with CMake on Linux.
+
+#ifdef _WIN32
+
+#define _WINSOCKAPI_	// keep Windows.h from pulling in winsock 1 ahead of WinSock2.h
+#include <Windows.h>
+
+#else
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdio>
+
+inline void OutputDebugStringA(const char* str) { fputs(str, stderr); }
+
+template <size_t N>
+inline int vsprintf_s(char (&buffer)[N], const char* format, va_list args) { return vsnprintf(buffer, N, format, args); }
+
+#ifndef _countof
+#define _countof(arr)	(sizeof(arr) / sizeof((arr)[0]))
+#endif
+
+#endif
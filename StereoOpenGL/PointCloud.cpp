@@ -0,0 +1,320 @@
+#include "PointCloud.h"
+
+#include "GLSLpreamble.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+
+PointCloud::PointCloud()
+	: m_bLoaderRunning(false)
+	, m_uiPointBudget(POINTCLOUD_POINT_BUDGET)
+	, m_fErrorPixels(POINTCLOUD_ERROR_PIXELS)
+	, m_uiFrame(1u)
+	, m_uiNodesDrawn(0u)
+	, m_nPointsDrawn(0u)
+	, m_nUploadedBytes(0u)
+	, m_glVAO(0u)
+	, m_glPointBuffer(0u)
+	, m_glNodeBuffer(0u)
+{
+}
+
+PointCloud::~PointCloud()
+{
+	close();
+}
+
+bool PointCloud::open(std::string const & path, size_t gpuBudgetBytes)
+{
+	close();
+
+	if (!m_Octree.open(path))
+		return false;
+
+	uint32_t nodes = m_Octree.nodeCount();
+	size_t slotBytes = POINTOCTREE_NODE_POINTS * sizeof(PointOctreePoint);
+	unsigned int slots = static_cast<unsigned int>(std::min(std::max(gpuBudgetBytes / slotBytes, static_cast<size_t>(1u)), static_cast<size_t>(nodes)));
+
+	m_vNodeState.assign(nodes, NODE_ABSENT);
+	m_vNodeSlot.assign(nodes, -1);
+	m_vSlotNode.assign(slots, UINT_MAX);
+	m_vSlotLastDrawn.assign(slots, 0u);
+	m_vFreeSlots.clear();
+	for (unsigned int s = slots; s > 0u; --s)
+		m_vFreeSlots.push_back(static_cast<int>(s - 1u));
+
+	m_vFreeLoads.clear();
+	for (unsigned int i = 0u; i < POINTCLOUD_LOADS_IN_FLIGHT; ++i)
+	{
+		m_arrLoads[i].points.reserve(POINTOCTREE_NODE_POINTS);
+		m_vFreeLoads.push_back(i);
+	}
+
+	glCreateBuffers(1, &m_glPointBuffer);
+	glNamedBufferStorage(m_glPointBuffer, slots * slotBytes, NULL, GL_DYNAMIC_STORAGE_BIT);
+	glCreateBuffers(1, &m_glNodeBuffer);
+	glNamedBufferStorage(m_glNodeBuffer, slots * sizeof(glm::vec4), NULL, GL_DYNAMIC_STORAGE_BIT);
+
+	glCreateVertexArrays(1, &m_glVAO);
+	glVertexArrayVertexBuffer(m_glVAO, 0, m_glPointBuffer, 0, sizeof(PointOctreePoint));
+	glEnableVertexArrayAttrib(m_glVAO, POSITION_ATTRIB_LOCATION);
+	glVertexArrayAttribFormat(m_glVAO, POSITION_ATTRIB_LOCATION, 3, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(PointOctreePoint, x));
+	glVertexArrayAttribBinding(m_glVAO, POSITION_ATTRIB_LOCATION, 0);
+	glEnableVertexArrayAttrib(m_glVAO, COLOR_ATTRIB_LOCATION);
+	glVertexArrayAttribFormat(m_glVAO, COLOR_ATTRIB_LOCATION, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(PointOctreePoint, rgba));
+	glVertexArrayAttribBinding(m_glVAO, COLOR_ATTRIB_LOCATION, 0);
+
+	m_uiFrame = 1u;
+	m_nUploadedBytes = 0u;
+
+	m_bLoaderRunning = true;
+	m_LoaderThread = std::thread(&PointCloud::loaderLoop, this);
+
+	printf("Point cloud %s: %llu points in %u nodes, %u GPU node slots (%.0f MB)\n", path.c_str(), static_cast<unsigned long long>(m_Octree.header().pointCount), nodes, slots, slots * slotBytes / (1024.0 * 1024.0));
+
+	return true;
+}
+
+void PointCloud::close()
+{
+	if (m_LoaderThread.joinable())
+	{
+		m_bLoaderRunning = false;
+		m_LoaderThread.join();
+	}
+
+	// drain anything still queued so a reopened cloud starts empty
+	unsigned int i;
+	while (m_qRequests.pop(i))
+		;
+	while (m_qLoaded.pop(i))
+		;
+
+	if (m_glVAO)
+	{
+		glDeleteVertexArrays(1, &m_glVAO);
+		glDeleteBuffers(1, &m_glPointBuffer);
+		glDeleteBuffers(1, &m_glNodeBuffer);
+		m_glVAO = m_glPointBuffer = m_glNodeBuffer = 0u;
+	}
+
+	m_vNodeState.clear();
+	m_vNodeSlot.clear();
+	m_vSlotNode.clear();
+	m_vSlotLastDrawn.clear();
+	m_vFreeSlots.clear();
+	m_vWanted.clear();
+
+	m_Octree.close();
+}
+
+void PointCloud::update()
+{
+	if (!m_Octree.isOpen())
+		return;
+
+	unsigned int i;
+	for (unsigned int uploads = 0u; uploads < POINTCLOUD_UPLOADS_PER_FRAME && m_qLoaded.pop(i); ++uploads)
+	{
+		uploadNode(m_arrLoads[i]);
+		m_vFreeLoads.push_back(i);
+	}
+
+	// both eyes may want the same node; the state check skips the second request
+	std::sort(m_vWanted.begin(), m_vWanted.end(), [](std::pair<float, uint32_t> const &a, std::pair<float, uint32_t> const &b) { return a.first > b.first; });
+
+	for (auto const &w : m_vWanted)
+	{
+		if (m_vFreeLoads.empty())
+			break;
+
+		if (m_vNodeState[w.second] != NODE_ABSENT)
+			continue;
+
+		unsigned int load = m_vFreeLoads.back();
+		m_vFreeLoads.pop_back();
+
+		m_arrLoads[load].node = w.second;
+		m_vNodeState[w.second] = NODE_REQUESTED;
+		m_qRequests.push(load);
+	}
+
+	m_vWanted.clear();
+	m_uiFrame++;
+}
+
+unsigned long long PointCloud::draw(glm::mat4 const & viewProjection, glm::mat4 const & modelToWorld, float pixelScale)
+{
+	m_uiNodesDrawn = 0u;
+	m_nPointsDrawn = 0u;
+
+	if (!m_Octree.isOpen())
+		return 0u;
+
+	// a node's spacing (cube / grid) projects to the error threshold when its bounding radius
+	// (cube * sqrt(3) / 2) projects to this many pixels
+	const float refinePixels = m_fErrorPixels * POINTOCTREE_GRID * 0.8660254f;
+
+	m_Culler.setView(viewProjection, pixelScale, 0.f);
+	m_vFirsts.clear();
+	m_vCounts.clear();
+	m_vLevel.assign(1, 0u);
+
+	// one level at a time, largest on screen first, so the budget goes to the coarse levels
+	// everywhere before any region gets fine detail
+	while (!m_vLevel.empty())
+	{
+		m_Culler.clear();
+		for (uint32_t n : m_vLevel)
+			m_Culler.add(m_Octree.getNodeBoundingSphere(n), modelToWorld);
+		m_Culler.cull();
+
+		const unsigned char* visible = m_Culler.visibility();
+		m_vVisible.clear();
+		for (size_t k = 0u; k < m_vLevel.size(); ++k)
+			if (visible[k])
+				m_vVisible.push_back(std::make_pair(m_Culler.projectedRadius(m_Octree.getNodeBoundingSphere(m_vLevel[k]), modelToWorld), m_vLevel[k]));
+
+		std::sort(m_vVisible.begin(), m_vVisible.end(), [](std::pair<float, uint32_t> const &a, std::pair<float, uint32_t> const &b) { return a.first > b.first; });
+
+		m_vNextLevel.clear();
+		bool budgetSpent = false;
+
+		for (auto const &v : m_vVisible)
+		{
+			uint32_t n = v.second;
+			const PointOctreeNode &node = m_Octree.node(n);
+
+			if (m_vNodeState[n] != NODE_RESIDENT)
+			{
+				// its subtree waits for it: children only add detail between the parent's points
+				m_vWanted.push_back(v);
+				continue;
+			}
+
+			if (m_nPointsDrawn + node.pointCount > m_uiPointBudget)
+			{
+				budgetSpent = true;
+				break;
+			}
+
+			int slot = m_vNodeSlot[n];
+			m_vFirsts.push_back(slot * POINTOCTREE_NODE_POINTS);
+			m_vCounts.push_back(static_cast<GLsizei>(node.pointCount));
+			m_vSlotLastDrawn[slot] = m_uiFrame;
+			m_nPointsDrawn += node.pointCount;
+
+			if (v.first > refinePixels && node.childMask)
+				for (uint32_t c = 0u, o = 0u; o < 8u; ++o)
+					if ((node.childMask >> o) & 1u)
+						m_vNextLevel.push_back(node.firstChild + c++);
+		}
+
+		if (budgetSpent)
+			break;
+
+		m_vLevel.swap(m_vNextLevel);
+	}
+
+	m_uiNodesDrawn = static_cast<unsigned int>(m_vFirsts.size());
+
+	if (m_vFirsts.empty())
+		return 0u;
+
+	glUniform4f(POINT_SIZE_UNIFORM_LOCATION, pixelScale, POINTCLOUD_POINT_SIZE / POINTOCTREE_GRID, 1.f, POINTCLOUD_MAX_POINT_PIXELS);
+
+	glBindVertexArray(m_glVAO);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, POINT_NODE_STORAGE_BUFFER_BINDING, m_glNodeBuffer);
+	glMultiDrawArrays(GL_POINTS, m_vFirsts.data(), m_vCounts.data(), static_cast<GLsizei>(m_vFirsts.size()));
+	glBindVertexArray(0);
+
+	return m_nPointsDrawn;
+}
+
+PointCloud::Stats PointCloud::getStats() const
+{
+	Stats s;
+	s.nodesDrawn = m_uiNodesDrawn;
+	s.pointsDrawn = m_nPointsDrawn;
+	s.slots = static_cast<unsigned int>(m_vSlotNode.size());
+	s.residentNodes = s.slots - static_cast<unsigned int>(m_vFreeSlots.size());
+	s.loadsPending = POINTCLOUD_LOADS_IN_FLIGHT - static_cast<unsigned int>(m_vFreeLoads.size());
+	s.uploadedBytes = m_nUploadedBytes;
+
+	return s;
+}
+
+void PointCloud::loaderLoop()
+{
+	while (m_bLoaderRunning)
+	{
+		unsigned int i;
+		if (!m_qRequests.pop(i))
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+
+		// the copy is what faults the node's pages in, off the render thread
+		Load &load = m_arrLoads[i];
+		const PointOctreePoint* src = m_Octree.points(load.node);
+		load.points.assign(src, src + m_Octree.node(load.node).pointCount);
+
+		// never full: it has room for every load in flight
+		m_qLoaded.push(i);
+	}
+}
+
+bool PointCloud::uploadNode(Load const & load)
+{
+	int slot = acquireSlot();
+
+	if (slot < 0)
+	{
+		// every slot was drawn last frame; the node is asked for again if it is still wanted
+		m_vNodeState[load.node] = NODE_ABSENT;
+		return false;
+	}
+
+	uint32_t evicted = m_vSlotNode[slot];
+	if (evicted != UINT_MAX)
+	{
+		m_vNodeState[evicted] = NODE_ABSENT;
+		m_vNodeSlot[evicted] = -1;
+	}
+
+	const PointOctreeNode &node = m_Octree.node(load.node);
+	glm::vec4 cube(node.cubeMin[0], node.cubeMin[1], node.cubeMin[2], node.cubeSize);
+
+	size_t bytes = load.points.size() * sizeof(PointOctreePoint);
+	if (bytes > 0u)
+		glNamedBufferSubData(m_glPointBuffer, static_cast<GLintptr>(slot) * POINTOCTREE_NODE_POINTS * sizeof(PointOctreePoint), bytes, load.points.data());
+	glNamedBufferSubData(m_glNodeBuffer, slot * sizeof(glm::vec4), sizeof(glm::vec4), &cube);
+
+	m_vNodeState[load.node] = NODE_RESIDENT;
+	m_vNodeSlot[load.node] = slot;
+	m_vSlotNode[slot] = load.node;
+	m_vSlotLastDrawn[slot] = m_uiFrame; // not evicted before it has had a frame to be drawn
+	m_nUploadedBytes += bytes;
+
+	return true;
+}
+
+// a free slot, else the least recently drawn one that wasn't drawn in the latest frame
+int PointCloud::acquireSlot()
+{
+	if (!m_vFreeSlots.empty())
+	{
+		int slot = m_vFreeSlots.back();
+		m_vFreeSlots.pop_back();
+		return slot;
+	}
+
+	int oldest = -1;
+	for (size_t s = 0u; s < m_vSlotLastDrawn.size(); ++s)
+		if (m_vSlotLastDrawn[s] < m_uiFrame && (oldest < 0 || m_vSlotLastDrawn[s] < m_vSlotLastDrawn[oldest]))
+			oldest = static_cast<int>(s);
+
+	return oldest;
+}
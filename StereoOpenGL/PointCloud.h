@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "FrustumCuller.h"
+#include "PointOctree.h"
+#include "SPSCQueue.h"
+
+#define POINTCLOUD_GPU_BUDGET_MB		512			// default size of the node slot pool
+#define POINTCLOUD_POINT_BUDGET			8000000u	// most points drawn per view
+#define POINTCLOUD_ERROR_PIXELS			1.5f		// nodes are refined while their point spacing projects wider than this
+#define POINTCLOUD_LOADS_IN_FLIGHT		16			// nodes the loader thread may be reading at once
+#define POINTCLOUD_UPLOADS_PER_FRAME	8			// loaded nodes copied to the GPU per update()
+#define POINTCLOUD_POINT_SIZE			1.5f		// point diameter in node spacings (cube size / POINTOCTREE_GRID)
+#define POINTCLOUD_MAX_POINT_PIXELS		16.f
+
+// Out-of-core renderer for a PointOctree file. Each view picks the nodes whose point spacing
+// projects wider than the error threshold, coarse to fine, until the point budget is spent;
+// only nodes already on the GPU are drawn or refined, and the missing ones are queued for a
+// loader thread that copies them out of the mapped file, so a cold page never stalls a frame.
+// Node points live in a pool of POINTOCTREE_NODE_POINTS sized slots bounded by the GPU memory
+// budget, recycled least recently drawn first, and a view's nodes are drawn with one
+// glMultiDrawArrays. The vertex shader finds a point's node (cube for dequantizing, spacing
+// for point size) from its slot, gl_VertexID / POINTOCTREE_NODE_POINTS.
+class PointCloud : public CacheAligned
+{
+public:
+	struct Stats {
+		unsigned int nodesDrawn;		// last view
+		unsigned long long pointsDrawn;	// last view
+		unsigned int residentNodes;
+		unsigned int slots;
+		unsigned int loadsPending;		// requested or loaded but not yet uploaded
+		unsigned long long uploadedBytes;	// since open()
+	};
+
+	PointCloud();
+	~PointCloud();
+
+	bool open(std::string const &path, size_t gpuBudgetBytes);
+	void close();
+
+	PointOctree const& getOctree() const { return m_Octree; }
+	// cloud coordinates
+	glm::vec4 getBoundingSphere() const { return m_Octree.getBoundingSphere(); }
+
+	void setPointBudget(unsigned int points) { m_uiPointBudget = points; }
+	unsigned int getPointBudget() const { return m_uiPointBudget; }
+	void setErrorPixels(float pixels) { m_fErrorPixels = pixels; }
+	float getErrorPixels() const { return m_fErrorPixels; }
+
+	// uploads nodes the loader finished and requests the ones views wanted since the last
+	// update, most visible first; call once per frame outside the views so both eyes agree
+	void update();
+
+	// Picks and draws the nodes for one view with the bound program (see shaders/pointcloud.vert),
+	// setting its point size uniform; the caller sets the model matrix. pixelScale converts radius
+	// over depth to pixels (projection[1][1] * viewport height / 2). Returns the points drawn.
+	unsigned long long draw(glm::mat4 const &viewProjection, glm::mat4 const &modelToWorld, float pixelScale);
+
+	Stats getStats() const;
+
+private:
+	enum NodeState : unsigned char {
+		NODE_ABSENT,
+		NODE_REQUESTED,
+		NODE_RESIDENT
+	};
+
+	struct Load {
+		uint32_t node;
+		std::vector<PointOctreePoint> points;
+	};
+
+	void loaderLoop();
+	bool uploadNode(Load const &load);
+	int acquireSlot();
+
+	PointOctree m_Octree;
+
+	std::vector<NodeState> m_vNodeState;
+	std::vector<int> m_vNodeSlot;
+	std::vector<uint32_t> m_vSlotNode;
+	std::vector<unsigned int> m_vSlotLastDrawn;	// update() count when the slot's node was last drawn
+	std::vector<int> m_vFreeSlots;
+
+	// missing nodes views wanted since the last update(), with their projected radius as priority
+	std::vector<std::pair<float, uint32_t>> m_vWanted;
+
+	Load m_arrLoads[POINTCLOUD_LOADS_IN_FLIGHT];
+	std::vector<unsigned int> m_vFreeLoads;
+	SPSCQueue<unsigned int, 32> m_qRequests;	// render thread to loader
+	SPSCQueue<unsigned int, 32> m_qLoaded;		// loader to render thread
+	std::thread m_LoaderThread;
+	std::atomic<bool> m_bLoaderRunning;
+
+	FrustumCuller m_Culler;
+	std::vector<uint32_t> m_vLevel;
+	std::vector<uint32_t> m_vNextLevel;
+	std::vector<std::pair<float, uint32_t>> m_vVisible;
+	std::vector<GLint> m_vFirsts;
+	std::vector<GLsizei> m_vCounts;
+
+	unsigned int m_uiPointBudget;
+	float m_fErrorPixels;
+	unsigned int m_uiFrame;
+
+	unsigned int m_uiNodesDrawn;
+	unsigned long long m_nPointsDrawn;
+	unsigned long long m_nUploadedBytes;
+
+	GLuint m_glVAO;
+	GLuint m_glPointBuffer;	// the slot pool
+	GLuint m_glNodeBuffer;	// per slot: node cube min and size
+
+public:
+	PointCloud(PointCloud const&) = delete;
+	void operator=(PointCloud const&) = delete;
+};
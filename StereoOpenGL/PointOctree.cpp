@@ -0,0 +1,91 @@
+#include "PointOctree.h"
+
+#include <cstdio>
+#include <cstring>
+
+PointOctree::PointOctree()
+	: m_pNodes(NULL)
+{
+}
+
+PointOctree::~PointOctree()
+{
+	close();
+}
+
+bool PointOctree::open(std::string const & path)
+{
+	close();
+
+	if (!m_File.openRead(path))
+		return false;
+
+	const PointOctreeHeader &h = header();
+	size_t size = m_File.size();
+
+	bool valid = size >= sizeof(PointOctreeHeader)
+		&& memcmp(h.magic, POINTOCTREE_MAGIC, sizeof(h.magic)) == 0
+		&& h.formatVersion == POINTOCTREE_FORMAT_VERSION
+		&& h.grid == POINTOCTREE_GRID
+		&& h.nodeCount > 0u
+		&& h.nodeTableOffset % alignof(PointOctreeNode) == 0u
+		&& h.nodeTableOffset <= size
+		&& (size - h.nodeTableOffset) / sizeof(PointOctreeNode) >= h.nodeCount;
+
+	if (valid)
+	{
+		m_pNodes = reinterpret_cast<const PointOctreeNode*>(m_File.data() + h.nodeTableOffset);
+
+		// the renderer sizes its node slots and trusts child indices, so check every node once here
+		for (uint32_t i = 0u; i < h.nodeCount && valid; ++i)
+		{
+			const PointOctreeNode &n = m_pNodes[i];
+			uint32_t children = 0u;
+			for (int c = 0; c < 8; ++c)
+				children += (n.childMask >> c) & 1u;
+
+			valid = n.pointCount <= POINTOCTREE_NODE_POINTS
+				&& n.pointOffset <= h.nodeTableOffset
+				&& (h.nodeTableOffset - n.pointOffset) / sizeof(PointOctreePoint) >= n.pointCount
+				&& (children == 0u || (n.firstChild > i && n.firstChild + children <= h.nodeCount));
+		}
+	}
+
+	if (!valid)
+	{
+		printf("Error: \"%s\" is not a point octree of format version %d\n", path.c_str(), POINTOCTREE_FORMAT_VERSION);
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void PointOctree::close()
+{
+	m_File.close();
+	m_pNodes = NULL;
+}
+
+glm::vec4 PointOctree::getBoundingSphere() const
+{
+	glm::vec3 bmin(header().boundsMin[0], header().boundsMin[1], header().boundsMin[2]);
+	glm::vec3 bmax(header().boundsMax[0], header().boundsMax[1], header().boundsMax[2]);
+
+	return glm::vec4((bmin + bmax) * 0.5f, glm::length(bmax - bmin) * 0.5f);
+}
+
+glm::vec4 PointOctree::getNodeBoundingSphere(uint32_t i) const
+{
+	const PointOctreeNode &n = m_pNodes[i];
+	float half = n.cubeSize * 0.5f;
+
+	return glm::vec4(n.cubeMin[0] + half, n.cubeMin[1] + half, n.cubeMin[2] + half, half * 1.7320508f);
+}
+
+glm::vec3 PointOctree::decode(uint32_t i, PointOctreePoint const & p) const
+{
+	const PointOctreeNode &n = m_pNodes[i];
+
+	return glm::vec3(n.cubeMin[0], n.cubeMin[1], n.cubeMin[2]) + glm::vec3(p.x, p.y, p.z) * (n.cubeSize / 65535.f);
+}
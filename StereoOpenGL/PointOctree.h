@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string>
+#include <stdint.h>
+#include <glm.hpp>
+
+#include "MappedFile.h"
+
+#define POINTOCTREE_MAGIC			"SOCT"
+#define POINTOCTREE_FORMAT_VERSION	1
+#define POINTOCTREE_GRID			128		// a node keeps at most one point per cell of this grid over its cube
+#define POINTOCTREE_NODE_POINTS		16384	// most points in one node, and so the size of a GPU node slot
+#define POINTOCTREE_MAX_DEPTH		20		// leaves deeper than this would hold coincident points
+
+// A point inside its node: position quantized over the node's cube, 8-bit color
+struct PointOctreePoint {
+	uint16_t x, y, z;
+	uint16_t pad;
+	uint8_t rgba[4];
+};
+
+// Nodes are stored breadth first, so a node's children are contiguous and come after it.
+// Points are additive: drawing a node and all its ancestors shows every point down to its level.
+struct PointOctreeNode {
+	float cubeMin[3];		// cloud coordinates
+	float cubeSize;
+	uint64_t pointOffset;	// byte offset of the node's points in the file
+	uint32_t pointCount;
+	uint32_t firstChild;	// index of the first child, 0 for leaves
+	uint8_t childMask;		// bit (x | y << 1 | z << 2) set for each octant that has a child
+	uint8_t depth;
+	uint16_t pad;
+};
+
+// Start of every octree file. The node table is written after the point blobs; the header is
+// written last, so a build that dies part way leaves a file that fails to open.
+struct PointOctreeHeader {
+	char magic[4];
+	uint32_t formatVersion;
+	double origin[3];		// cloud coordinates are relative to this, e.g. UTM easting, northing and depth
+	float boundsMin[3];		// tight bounds of the points, cloud coordinates
+	float boundsMax[3];
+	uint64_t pointCount;
+	uint32_t nodeCount;
+	uint32_t grid;			// POINTOCTREE_GRID the file was built with
+	uint64_t nodeTableOffset;
+};
+
+// Read-only view of an octree file written by PointOctreeBuilder. The file is memory-mapped,
+// so only the nodes actually read are paged in; points() may be called from any thread.
+class PointOctree
+{
+public:
+	PointOctree();
+	~PointOctree();
+
+	bool open(std::string const &path);
+	void close();
+	bool isOpen() const { return m_File.isOpen(); }
+
+	const PointOctreeHeader& header() const { return *reinterpret_cast<const PointOctreeHeader*>(m_File.data()); }
+	uint32_t nodeCount() const { return header().nodeCount; }
+	const PointOctreeNode& node(uint32_t i) const { return m_pNodes[i]; }
+	const PointOctreePoint* points(uint32_t i) const { return reinterpret_cast<const PointOctreePoint*>(m_File.data() + m_pNodes[i].pointOffset); }
+
+	// cloud coordinates
+	glm::vec4 getBoundingSphere() const;
+	glm::vec4 getNodeBoundingSphere(uint32_t i) const;
+	glm::vec3 decode(uint32_t i, PointOctreePoint const &p) const;
+
+private:
+	MappedFile m_File;
+	const PointOctreeNode* m_pNodes;
+
+public:
+	PointOctree(PointOctree const&) = delete;
+	void operator=(PointOctree const&) = delete;
+};
@@ -0,0 +1,615 @@
+#include "PointOctreeBuilder.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <experimental/filesystem>
+#include <thread>
+
+#define POINTOCTREEBUILDER_GRID_WORDS	(POINTOCTREE_GRID * POINTOCTREE_GRID * POINTOCTREE_GRID / 64)
+#define POINTOCTREEBUILDER_READ_BATCH	65536	// points buffered per write to the temporary file
+
+PointOctreeBuilder::PointOctreeBuilder()
+	: m_uiThreads(0u)
+	, m_bCacheReads(true)
+	, m_Stats()
+	, m_bHaveOrigin(false)
+	, m_vec3Min(0.f)
+	, m_vec3Max(0.f)
+	, m_fCubeSize(1.f)
+	, m_nDropped(0u)
+	, m_pOut(NULL)
+	, m_nWriteOffset(0u)
+	, m_bWriteFailed(false)
+{
+	m_dOrigin[0] = m_dOrigin[1] = m_dOrigin[2] = 0.0;
+}
+
+PointOctreeBuilder::~PointOctreeBuilder()
+{
+}
+
+bool PointOctreeBuilder::build(std::vector<std::string> const & inputs, std::string const & outPath)
+{
+	using clock = std::chrono::high_resolution_clock;
+
+	m_Stats = Stats();
+	m_Stats.threads = m_uiThreads > 0u ? m_uiThreads : std::max(1u, std::thread::hardware_concurrency());
+	m_bHaveOrigin = false;
+	m_vec3Min = glm::vec3(FLT_MAX);
+	m_vec3Max = glm::vec3(-FLT_MAX);
+	m_nDropped = 0u;
+
+	std::string rawPath = outPath + ".raw.tmp";
+	std::string sortedPath = outPath + ".sorted.tmp";
+
+	// 1. parse every input, or map its cache, relative to the first input's origin; a single
+	// input is used straight from its cache, several are concatenated into a temporary file
+	auto t0 = clock::now();
+
+	PointTextParser parser;
+	parser.setThreads(m_Stats.threads);
+	parser.setCacheReads(m_bCacheReads);
+
+	bool concatenate = inputs.size() > 1u;
+	bool readOK = true;
+
+	if (concatenate)
+	{
+		FILE* raw = fopen(rawPath.c_str(), "wb");
+		if (!raw)
+		{
+			printf("Error: Could not open \"%s\" for writing\n", rawPath.c_str());
+			return false;
+		}
+
+		for (auto const &path : inputs)
+			readOK = readOK && readInput(parser, path, raw);
+
+		parser.close();
+		readOK = fclose(raw) == 0 && readOK;
+	}
+	else
+		readOK = readInput(parser, inputs[0], NULL);
+
+	m_Stats.readSeconds = std::chrono::duration<double>(clock::now() - t0).count();
+
+	if (!readOK || m_Stats.points == 0u)
+	{
+		if (readOK)
+			printf("Error: No points read\n");
+		if (concatenate)
+			std::remove(rawPath.c_str());
+		return false;
+	}
+
+	auto t1 = clock::now();
+
+	// the octree is a cube over the bounds, padded so points on the max faces fall inside
+	glm::vec3 extent = m_vec3Max - m_vec3Min;
+	m_fCubeSize = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-3f)) * 1.0001f;
+
+	MappedFile rawFile;
+	if (concatenate && !rawFile.openRead(rawPath))
+	{
+		std::remove(rawPath.c_str());
+		return false;
+	}
+
+	const RawPoint* points = concatenate ? reinterpret_cast<const RawPoint*>(rawFile.data()) : parser.points();
+
+	auto releaseInput = [&]() {
+		parser.close();
+		rawFile.close();
+		if (concatenate)
+			std::remove(rawPath.c_str());
+	};
+	uint64_t count = m_Stats.points;
+
+	// 2. pick the chunk level from a parallel count of the points per cell
+	pickChunkDepth(points, count);
+
+	uint32_t chunkDepth = m_Stats.chunkDepth;
+	uint32_t chunkCount = 1u << (3u * chunkDepth);
+
+	// 3. sample the levels above the chunks in file order, and count what falls through to each chunk
+	std::unique_ptr<Node> root(new Node());
+	root->cubeMin = m_vec3Min;
+	root->cubeSize = m_fCubeSize;
+	root->depth = 0u;
+	root->pointCount = 0u;
+	root->pointOffset = 0u;
+
+	std::vector<uint64_t> chunkPoints(chunkCount, 0u);
+	std::vector<bool> claimed(chunkDepth > 0u ? count : 0u, false);
+	uint64_t unclaimed = count;
+
+	if (chunkDepth > 0u)
+	{
+		root->cells.assign(POINTOCTREEBUILDER_GRID_WORDS, 0u);
+
+		for (uint64_t i = 0u; i < count; ++i)
+		{
+			Node* n = root.get();
+
+			for (uint32_t d = 0u; d < chunkDepth; ++d)
+			{
+				uint32_t c = cell(n, points[i]);
+				uint64_t bit = 1ull << (c & 63u);
+
+				if (n->points.size() < POINTOCTREE_NODE_POINTS && !(n->cells[c >> 6] & bit))
+				{
+					n->cells[c >> 6] |= bit;
+					n->points.push_back(encode(n, points[i]));
+					claimed[i] = true;
+					unclaimed--;
+					break;
+				}
+
+				if (d + 1u == chunkDepth)
+					break;
+
+				int o = octant(n, points[i]);
+				if (!n->children[o])
+				{
+					newChild(n, o);
+					n->children[o]->cells.assign(POINTOCTREEBUILDER_GRID_WORDS, 0u);
+				}
+
+				n = n->children[o].get();
+			}
+
+			if (!claimed[i])
+				chunkPoints[chunkIndex(points[i])]++;
+		}
+	}
+	else
+		chunkPoints[0] = count;
+
+	// 4. counting sort of the remaining points by chunk into a second temporary file
+	std::vector<uint64_t> chunkOffsets(chunkCount + 1u, 0u);
+	for (uint32_t c = 0u; c < chunkCount; ++c)
+		chunkOffsets[c + 1u] = chunkOffsets[c] + chunkPoints[c];
+
+	MappedFile sortedFile;
+	if (unclaimed > 0u)
+	{
+		if (!sortedFile.create(sortedPath, unclaimed * sizeof(RawPoint)))
+		{
+			releaseInput();
+			return false;
+		}
+
+		RawPoint* sorted = reinterpret_cast<RawPoint*>(sortedFile.data());
+		std::vector<uint64_t> cursor(chunkOffsets.begin(), chunkOffsets.end() - 1);
+
+		for (uint64_t i = 0u; i < count; ++i)
+			if (chunkDepth == 0u || !claimed[i])
+				sorted[cursor[chunkIndex(points[i])]++] = points[i];
+	}
+
+	std::vector<bool>().swap(claimed);
+	releaseInput();
+
+	m_pOut = fopen(outPath.c_str(), "wb");
+	if (!m_pOut)
+	{
+		printf("Error: Could not open \"%s\" for writing\n", outPath.c_str());
+		sortedFile.close();
+		std::remove(sortedPath.c_str());
+		return false;
+	}
+
+	// the header is rewritten at the end; until then the magic is zero
+	PointOctreeHeader header;
+	memset(&header, 0, sizeof(header));
+	m_bWriteFailed = fwrite(&header, sizeof(header), 1, m_pOut) != 1;
+	m_nWriteOffset = sizeof(header);
+
+	// 5. build the chunks' subtrees in parallel, largest first so the last one to finish is small
+	std::vector<uint32_t> chunks;
+	for (uint32_t c = 0u; c < chunkCount; ++c)
+		if (chunkPoints[c] > 0u)
+			chunks.push_back(c);
+
+	std::sort(chunks.begin(), chunks.end(), [&chunkPoints](uint32_t a, uint32_t b) { return chunkPoints[a] > chunkPoints[b]; });
+	m_Stats.chunks = static_cast<uint32_t>(chunks.size());
+
+	std::vector<std::unique_ptr<Node>> chunkRoots(chunkCount);
+	std::atomic<size_t> nextChunk(0u);
+	const RawPoint* sorted = unclaimed > 0u ? reinterpret_cast<const RawPoint*>(sortedFile.data()) : NULL;
+
+	auto worker = [&]() {
+		std::vector<uint64_t> cells(POINTOCTREEBUILDER_GRID_WORDS, 0u);
+
+		for (size_t k = nextChunk++; k < chunks.size(); k = nextChunk++)
+		{
+			uint32_t c = chunks[k];
+			uint32_t side = 1u << chunkDepth;
+
+			Node* n = new Node();
+			n->cubeSize = m_fCubeSize / side;
+			n->cubeMin = m_vec3Min + glm::vec3(c % side, (c / side) % side, c / (side * side)) * n->cubeSize;
+			n->depth = chunkDepth;
+			n->pointCount = 0u;
+			n->pointOffset = 0u;
+			chunkRoots[c].reset(n);
+
+			std::vector<RawPoint> chunk(sorted + chunkOffsets[c], sorted + chunkOffsets[c + 1u]);
+			buildChunk(n, chunk, cells);
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (unsigned int t = 1u; t < m_Stats.threads; ++t)
+		workers.push_back(std::thread(worker));
+	worker();
+	for (auto &t : workers)
+		t.join();
+
+	sortedFile.close();
+	std::remove(sortedPath.c_str());
+
+	// 6. hang the chunks under the sampled levels and write those levels' points
+	if (chunkDepth == 0u)
+		root = std::move(chunkRoots[0]);
+	else
+	{
+		uint32_t side = 1u << chunkDepth;
+
+		for (uint32_t c = 0u; c < chunkCount; ++c)
+		{
+			if (!chunkRoots[c])
+				continue;
+
+			glm::uvec3 coord(c % side, (c / side) % side, c / (side * side));
+			Node* n = root.get();
+
+			for (uint32_t d = 1u; d < chunkDepth; ++d)
+			{
+				glm::uvec3 bit = (coord >> (chunkDepth - d)) & 1u;
+				int o = bit.x | (bit.y << 1) | (bit.z << 2);
+				if (!n->children[o])
+					newChild(n, o);
+				n = n->children[o].get();
+			}
+
+			glm::uvec3 bit = coord & 1u;
+			n->children[bit.x | (bit.y << 1) | (bit.z << 2)] = std::move(chunkRoots[c]);
+		}
+
+		std::vector<Node*> upper(1, root.get());
+		for (size_t i = 0u; i < upper.size(); ++i)
+		{
+			Node* n = upper[i];
+			std::vector<uint64_t>().swap(n->cells);
+			writePoints(n, n->points);
+			std::vector<PointOctreePoint>().swap(n->points);
+
+			if (n->depth + 1u < chunkDepth)
+				for (auto &child : n->children)
+					if (child)
+						upper.push_back(child.get());
+		}
+	}
+
+	m_Stats.droppedPoints = m_nDropped;
+
+	uint64_t tableOffset = 0u;
+	bool ok = writeNodeTable(root.get(), tableOffset) && !m_bWriteFailed;
+
+	if (ok)
+	{
+		memcpy(header.magic, POINTOCTREE_MAGIC, sizeof(header.magic));
+		header.formatVersion = POINTOCTREE_FORMAT_VERSION;
+		for (int i = 0; i < 3; ++i)
+		{
+			header.origin[i] = m_dOrigin[i];
+			header.boundsMin[i] = m_vec3Min[i];
+			header.boundsMax[i] = m_vec3Max[i];
+		}
+		header.pointCount = m_Stats.points - m_Stats.droppedPoints;
+		header.nodeCount = m_Stats.nodes;
+		header.grid = POINTOCTREE_GRID;
+		header.nodeTableOffset = tableOffset;
+
+		ok = fseek(m_pOut, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, m_pOut) == 1;
+	}
+
+	ok = fclose(m_pOut) == 0 && ok;
+	m_pOut = NULL;
+
+	if (!ok)
+		printf("Error: Could not write \"%s\"\n", outPath.c_str());
+
+	m_Stats.buildSeconds = std::chrono::duration<double>(clock::now() - t1).count();
+
+	return ok;
+}
+
+bool PointOctreeBuilder::readInput(PointTextParser & parser, std::string const & path, FILE * raw)
+{
+	if (!parser.open(path))
+		return false;
+
+	PointTextParser::Stats const &parse = parser.getStats();
+	PointTextHeader const &head = parser.header();
+
+	m_Stats.inputBytes += parse.textBytes;
+	m_Stats.points += head.pointCount;
+	m_Stats.skippedLines += head.skippedLines;
+	if (parse.fromCache)
+		m_Stats.cachedInputs++;
+
+	if (head.pointCount == 0u)
+		return true;
+
+	if (!m_bHaveOrigin)
+	{
+		for (int i = 0; i < 3; ++i)
+			m_dOrigin[i] = head.origin[i];
+		m_bHaveOrigin = true;
+	}
+
+	// later inputs are moved onto the first one's origin the same way their bounds are, so the bounds stay exact
+	glm::vec3 offset(head.origin[0] - m_dOrigin[0], head.origin[1] - m_dOrigin[1], head.origin[2] - m_dOrigin[2]);
+
+	m_vec3Min = glm::min(m_vec3Min, glm::vec3(head.boundsMin[0], head.boundsMin[1], head.boundsMin[2]) + offset);
+	m_vec3Max = glm::max(m_vec3Max, glm::vec3(head.boundsMax[0], head.boundsMax[1], head.boundsMax[2]) + offset);
+
+	if (!raw)
+		return true;
+
+	std::vector<RawPoint> batch;
+	batch.reserve(POINTOCTREEBUILDER_READ_BATCH);
+
+	const RawPoint* points = parser.points();
+	bool ok = true;
+
+	for (uint64_t i = 0u; ok && i < head.pointCount; i += batch.size())
+	{
+		batch.assign(points + i, points + std::min(head.pointCount, i + POINTOCTREEBUILDER_READ_BATCH));
+
+		for (auto &p : batch)
+		{
+			p.x += offset.x;
+			p.y += offset.y;
+			p.z += offset.z;
+		}
+
+		ok = fwrite(batch.data(), sizeof(RawPoint), batch.size(), raw) == batch.size();
+	}
+
+	if (!ok)
+		printf("Error: Could not write the points of \"%s\"\n", path.c_str());
+
+	return ok;
+}
+
+void PointOctreeBuilder::pickChunkDepth(const RawPoint * points, uint64_t count)
+{
+	const uint32_t side = 1u << POINTOCTREEBUILDER_COUNT_DEPTH;
+	const uint32_t cells = side * side * side;
+
+	std::vector<std::vector<uint32_t>> counts(m_Stats.threads, std::vector<uint32_t>(cells, 0u));
+	std::vector<std::thread> workers;
+
+	for (unsigned int t = 0u; t < m_Stats.threads; ++t)
+	{
+		workers.push_back(std::thread([&, t]() {
+			uint64_t begin = count * t / m_Stats.threads;
+			uint64_t end = count * (t + 1u) / m_Stats.threads;
+			float scale = side / m_fCubeSize;
+
+			for (uint64_t i = begin; i < end; ++i)
+			{
+				glm::uvec3 c = glm::min(glm::uvec3((glm::vec3(points[i].x, points[i].y, points[i].z) - m_vec3Min) * scale), glm::uvec3(side - 1u));
+				counts[t][c.x + side * (c.y + side * c.z)]++;
+			}
+		}));
+	}
+
+	for (auto &w : workers)
+		w.join();
+
+	for (unsigned int t = 1u; t < m_Stats.threads; ++t)
+		for (uint32_t c = 0u; c < cells; ++c)
+			counts[0][c] += counts[t][c];
+
+	// the coarsest level whose fullest cell fits in a chunk
+	for (uint32_t depth = 0u; depth <= POINTOCTREEBUILDER_COUNT_DEPTH; ++depth)
+	{
+		uint32_t shift = POINTOCTREEBUILDER_COUNT_DEPTH - depth;
+		uint32_t levelSide = 1u << depth;
+		std::vector<uint64_t> level(levelSide * levelSide * levelSide, 0u);
+
+		for (uint32_t c = 0u; c < cells; ++c)
+		{
+			uint32_t x = (c % side) >> shift;
+			uint32_t y = ((c / side) % side) >> shift;
+			uint32_t z = (c / (side * side)) >> shift;
+			level[x + levelSide * (y + levelSide * z)] += counts[0][c];
+		}
+
+		m_Stats.chunkDepth = depth;
+
+		if (*std::max_element(level.begin(), level.end()) <= POINTOCTREEBUILDER_CHUNK_POINTS)
+			break;
+	}
+}
+
+void PointOctreeBuilder::buildChunk(Node * node, std::vector<RawPoint>& points, std::vector<uint64_t>& cells)
+{
+	std::vector<PointOctreePoint> kept;
+
+	if (points.size() <= POINTOCTREE_NODE_POINTS || node->depth >= POINTOCTREE_MAX_DEPTH)
+	{
+		// a leaf; past the depth limit the remaining points are all but coincident
+		size_t n = std::min(points.size(), static_cast<size_t>(POINTOCTREE_NODE_POINTS));
+		kept.reserve(n);
+		for (size_t i = 0u; i < n; ++i)
+			kept.push_back(encode(node, points[i]));
+
+		m_nDropped += points.size() - n;
+		writePoints(node, kept);
+		return;
+	}
+
+	std::vector<RawPoint> childPoints[8];
+	std::vector<uint32_t> taken;
+	kept.reserve(POINTOCTREE_NODE_POINTS);
+	taken.reserve(POINTOCTREE_NODE_POINTS);
+
+	for (auto const &p : points)
+	{
+		uint32_t c = cell(node, p);
+		uint64_t bit = 1ull << (c & 63u);
+
+		if (kept.size() < POINTOCTREE_NODE_POINTS && !(cells[c >> 6] & bit))
+		{
+			cells[c >> 6] |= bit;
+			taken.push_back(c);
+			kept.push_back(encode(node, p));
+		}
+		else
+			childPoints[octant(node, p)].push_back(p);
+	}
+
+	// cells is shared by the whole chunk, so clear only the bits this node set
+	for (uint32_t c : taken)
+		cells[c >> 6] = 0u;
+
+	writePoints(node, kept);
+
+	std::vector<RawPoint>().swap(points);
+
+	for (int o = 0; o < 8; ++o)
+		if (!childPoints[o].empty())
+			buildChunk(newChild(node, o), childPoints[o], cells);
+}
+
+bool PointOctreeBuilder::writePoints(Node * node, std::vector<PointOctreePoint> const & points)
+{
+	std::lock_guard<std::mutex> lock(m_WriteMutex);
+
+	node->pointOffset = m_nWriteOffset;
+	node->pointCount = static_cast<uint32_t>(points.size());
+
+	if (!points.empty() && fwrite(points.data(), sizeof(PointOctreePoint), points.size(), m_pOut) != points.size())
+		m_bWriteFailed = true;
+
+	m_nWriteOffset += points.size() * sizeof(PointOctreePoint);
+
+	return !m_bWriteFailed;
+}
+
+bool PointOctreeBuilder::writeNodeTable(Node * root, uint64_t & tableOffset)
+{
+	// breadth first, so each node's children get consecutive indices
+	std::vector<Node*> order(1, root);
+	std::vector<PointOctreeNode> table;
+
+	for (size_t i = 0u; i < order.size(); ++i)
+	{
+		Node* n = order[i];
+
+		PointOctreeNode rec;
+		memset(&rec, 0, sizeof(rec));
+		for (int k = 0; k < 3; ++k)
+			rec.cubeMin[k] = n->cubeMin[k];
+		rec.cubeSize = n->cubeSize;
+		rec.pointOffset = n->pointOffset;
+		rec.pointCount = n->pointCount;
+		rec.depth = static_cast<uint8_t>(n->depth);
+
+		for (int o = 0; o < 8; ++o)
+		{
+			if (!n->children[o])
+				continue;
+
+			if (rec.childMask == 0u)
+				rec.firstChild = static_cast<uint32_t>(order.size());
+			rec.childMask |= 1u << o;
+			order.push_back(n->children[o].get());
+		}
+
+		m_Stats.depth = std::max(m_Stats.depth, n->depth);
+		table.push_back(rec);
+	}
+
+	m_Stats.nodes = static_cast<uint32_t>(table.size());
+
+	// align the table so it can be read in place from the mapping
+	static const char zeros[alignof(PointOctreeNode)] = {};
+	size_t pad = (alignof(PointOctreeNode) - m_nWriteOffset % alignof(PointOctreeNode)) % alignof(PointOctreeNode);
+	tableOffset = m_nWriteOffset + pad;
+
+	return fwrite(zeros, 1, pad, m_pOut) == pad
+		&& fwrite(table.data(), sizeof(PointOctreeNode), table.size(), m_pOut) == table.size();
+}
+
+PointOctreeBuilder::Node * PointOctreeBuilder::newChild(Node * parent, int octant) const
+{
+	Node* child = new Node();
+	child->cubeSize = parent->cubeSize * 0.5f;
+	child->cubeMin = parent->cubeMin + glm::vec3(octant & 1, (octant >> 1) & 1, (octant >> 2) & 1) * child->cubeSize;
+	child->depth = parent->depth + 1u;
+	child->pointCount = 0u;
+	child->pointOffset = 0u;
+
+	parent->children[octant].reset(child);
+
+	return child;
+}
+
+int PointOctreeBuilder::octant(Node const * node, RawPoint const & p) const
+{
+	float half = node->cubeSize * 0.5f;
+
+	return (p.x - node->cubeMin.x >= half ? 1 : 0)
+		| (p.y - node->cubeMin.y >= half ? 2 : 0)
+		| (p.z - node->cubeMin.z >= half ? 4 : 0);
+}
+
+uint32_t PointOctreeBuilder::cell(Node const * node, RawPoint const & p) const
+{
+	glm::vec3 f = (glm::vec3(p.x, p.y, p.z) - node->cubeMin) * (POINTOCTREE_GRID / node->cubeSize);
+	glm::uvec3 c = glm::min(glm::uvec3(glm::max(f, glm::vec3(0.f))), glm::uvec3(POINTOCTREE_GRID - 1));
+
+	return c.x + POINTOCTREE_GRID * (c.y + POINTOCTREE_GRID * c.z);
+}
+
+uint32_t PointOctreeBuilder::chunkIndex(RawPoint const & p) const
+{
+	uint32_t side = 1u << m_Stats.chunkDepth;
+	glm::uvec3 c = glm::min(glm::uvec3((glm::vec3(p.x, p.y, p.z) - m_vec3Min) * (side / m_fCubeSize)), glm::uvec3(side - 1u));
+
+	return c.x + side * (c.y + side * c.z);
+}
+
+PointOctreePoint PointOctreeBuilder::encode(Node const * node, RawPoint const & p) const
+{
+	glm::vec3 q = glm::clamp((glm::vec3(p.x, p.y, p.z) - node->cubeMin) * (65535.f / node->cubeSize) + 0.5f, glm::vec3(0.f), glm::vec3(65535.f));
+
+	PointOctreePoint out;
+	out.x = static_cast<uint16_t>(q.x);
+	out.y = static_cast<uint16_t>(q.y);
+	out.z = static_cast<uint16_t>(q.z);
+	out.pad = 0u;
+
+	if (p.rgba[3] > 0u)
+		memcpy(out.rgba, p.rgba, sizeof(out.rgba));
+	else
+	{
+		// blue through green to red from the lowest to the highest point
+		float t = m_vec3Max.z > m_vec3Min.z ? (p.z - m_vec3Min.z) / (m_vec3Max.z - m_vec3Min.z) : 0.5f;
+		out.rgba[0] = static_cast<uint8_t>(255.f * glm::clamp(2.f * t - 1.f, 0.f, 1.f));
+		out.rgba[1] = static_cast<uint8_t>(255.f * (1.f - std::abs(2.f * t - 1.f)));
+		out.rgba[2] = static_cast<uint8_t>(255.f * glm::clamp(1.f - 2.f * t, 0.f, 1.f));
+		out.rgba[3] = 255u;
+	}
+
+	return out;
+}
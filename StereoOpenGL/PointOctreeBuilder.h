@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "PointOctree.h"
+#include "PointTextParser.h"
+
+#define POINTOCTREEBUILDER_CHUNK_POINTS		(4u * 1024u * 1024u)	// chunks up to this many points are built in memory by one thread
+#define POINTOCTREEBUILDER_COUNT_DEPTH		6						// finest level the chunk level is picked from (8^6 counters)
+
+// Builds a PointOctree file from text point clouds too large to hold in memory, in the manner of
+// Potree's converter. The text is read through PointTextParser and its binary cache; the octree is then
+// split at a chunk level picked so no chunk exceeds POINTOCTREEBUILDER_CHUNK_POINTS. The levels
+// above it are sampled in one pass over the points, and each chunk's subtree is built in
+// memory on its own worker thread, writing finished nodes straight to the output file.
+// Each node keeps the first point that lands in each cell of a POINTOCTREE_GRID grid over its
+// cube and passes the rest to its children, so coarse nodes are an even subsample.
+class PointOctreeBuilder
+{
+public:
+	struct Stats {
+		uint64_t inputBytes;
+		uint32_t cachedInputs;		// served from PointTextParser's cache instead of parsed
+		uint64_t points;
+		uint64_t skippedLines;		// fewer than three numbers, e.g. headers
+		uint64_t droppedPoints;		// past POINTOCTREE_NODE_POINTS in a leaf at POINTOCTREE_MAX_DEPTH
+		uint32_t nodes;
+		uint32_t depth;				// deepest node
+		uint32_t chunkDepth;
+		uint32_t chunks;
+		unsigned int threads;
+		double readSeconds;
+		double buildSeconds;
+	};
+
+	PointOctreeBuilder();
+	~PointOctreeBuilder();
+
+	// 0 uses one thread per hardware thread
+	void setThreads(unsigned int threads) { m_uiThreads = threads; }
+	// while disabled, every input is parsed again even if its cache is current
+	void setCacheReads(bool enabled) { m_bCacheReads = enabled; }
+
+	// Reads whitespace- or comma-separated lines of x y z, optionally followed by r g b (0-255),
+	// from every input (see PointTextParser, which leaves a cache beside each). Points without
+	// color are colored by height. The temporary files are written next to outPath and removed
+	// afterwards.
+	bool build(std::vector<std::string> const &inputs, std::string const &outPath);
+
+	Stats const& getStats() const { return m_Stats; }
+
+private:
+	// relative to the first input's origin; alpha 0 means the input had no color
+	typedef PointTextPoint RawPoint;
+
+	struct Node {
+		glm::vec3 cubeMin;
+		float cubeSize;
+		uint32_t depth;
+		uint32_t pointCount;
+		uint64_t pointOffset;
+		std::vector<PointOctreePoint> points;	// upper-level nodes only, held until the end
+		std::vector<uint64_t> cells;			// upper-level nodes only, one bit per grid cell taken
+		std::unique_ptr<Node> children[8];
+	};
+
+	// appends the input's points to raw, if given, rebased onto the first input's origin
+	bool readInput(PointTextParser &parser, std::string const &path, FILE* raw);
+	void pickChunkDepth(const RawPoint* points, uint64_t count);
+	void buildChunk(Node* node, std::vector<RawPoint> &points, std::vector<uint64_t> &cells);
+	bool writePoints(Node* node, std::vector<PointOctreePoint> const &points);
+	bool writeNodeTable(Node* root, uint64_t &tableOffset);
+
+	Node* newChild(Node* parent, int octant) const;
+	int octant(Node const* node, RawPoint const &p) const;
+	uint32_t cell(Node const* node, RawPoint const &p) const;
+	uint32_t chunkIndex(RawPoint const &p) const;
+	PointOctreePoint encode(Node const* node, RawPoint const &p) const;
+
+	unsigned int m_uiThreads;
+	bool m_bCacheReads;
+	Stats m_Stats;
+
+	bool m_bHaveOrigin;
+	double m_dOrigin[3];
+	glm::vec3 m_vec3Min;
+	glm::vec3 m_vec3Max;
+	float m_fCubeSize;
+
+	std::atomic<uint64_t> m_nDropped;
+
+	FILE* m_pOut;
+	uint64_t m_nWriteOffset;
+	bool m_bWriteFailed;
+	std::mutex m_WriteMutex;
+
+public:
+	PointOctreeBuilder(PointOctreeBuilder const&) = delete;
+	void operator=(PointOctreeBuilder const&) = delete;
+};
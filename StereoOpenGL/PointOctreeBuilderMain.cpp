@@ -0,0 +1,62 @@
+#include "PointOctreeBuilder.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Converts text point clouds (e.g. the Reson sonar exports, one "x y z" line per point) into
+// one PointOctree file for the renderer to stream from. Each input's parsed points are cached
+// beside it (input.txt.ptcache), or in the temp directory when that isn't writable, and reused
+// until the text changes; --reparse ignores the caches.
+//
+// usage: PointOctreeBuilder [-j threads] [--reparse] <output.octree> <input.txt>...
+
+//-----------------------------------------------------------------------------
+// Purpose:
+//-----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+	unsigned int threads = 0u;
+	bool cacheReads = true;
+	std::vector<std::string> paths;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg(argv[i]);
+
+		if (arg == "-j" && i + 1 < argc)
+			threads = atoi(argv[++i]);
+		else if (arg == "--reparse")
+			cacheReads = false;
+		else
+			paths.push_back(arg);
+	}
+
+	if (paths.size() < 2u)
+	{
+		printf("usage: %s [-j threads] [--reparse] <output.octree> <input.txt>...\n", argv[0]);
+		return 1;
+	}
+
+	std::string outPath = paths[0];
+	std::vector<std::string> inputs(paths.begin() + 1, paths.end());
+
+	PointOctreeBuilder builder;
+	builder.setThreads(threads);
+	builder.setCacheReads(cacheReads);
+
+	if (!builder.build(inputs, outPath))
+		return 1;
+
+	PointOctreeBuilder::Stats const &stats = builder.getStats();
+
+	printf("Read %llu points from %u files (%.1f MB, %u cached) in %.2f s (%.1f MB/s), %llu lines skipped\n", static_cast<unsigned long long>(stats.points), static_cast<unsigned int>(inputs.size()), stats.inputBytes / (1024.0 * 1024.0), stats.cachedInputs, stats.readSeconds, stats.inputBytes / (1024.0 * 1024.0) / std::max(stats.readSeconds, 1e-6), static_cast<unsigned long long>(stats.skippedLines));
+	printf("Built %u nodes, depth %u, %u chunks at level %u on %u threads in %.2f s (%.1f M points/s)\n", stats.nodes, stats.depth, stats.chunks, stats.chunkDepth, stats.threads, stats.buildSeconds, stats.points / std::max(stats.buildSeconds, 1e-6) / 1e6);
+	if (stats.droppedPoints > 0u)
+		printf("Dropped %llu coincident points past depth %d\n", static_cast<unsigned long long>(stats.droppedPoints), POINTOCTREE_MAX_DEPTH);
+	printf("Wrote %s\n", outPath.c_str());
+
+	return 0;
+}
@@ -0,0 +1,498 @@
+#include "PointTextParser.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <experimental/filesystem>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#ifdef POINTTEXTPARSER_SSE
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define POINTTEXTPARSER_MAX_VALUES	6	// x y z r g b
+#define POINTTEXTPARSER_MAX_DIGITS	19	// significant digits that always fit a 64-bit mantissa
+
+namespace
+{
+	// powers of ten exactly representable as doubles; a mantissa below 2^53 multiplied or
+	// divided by one of them is correctly rounded
+	const double s_arrPow10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	struct ChunkResult {
+		uint64_t points;
+		uint64_t skippedLines;
+		float boundsMin[3];
+		float boundsMax[3];
+	};
+
+	inline bool isDigit(char c)
+	{
+		return static_cast<unsigned char>(c - '0') < 10u;
+	}
+
+	inline unsigned int countTrailingZeros(unsigned int v)
+	{
+#ifdef _MSC_VER
+		unsigned long i;
+		_BitScanForward(&i, v);
+		return static_cast<unsigned int>(i);
+#else
+		return static_cast<unsigned int>(__builtin_ctz(v));
+#endif
+	}
+
+	// length of the run of decimal digits at p, sixteen bytes at a time where the data allows
+	inline size_t digitRun(const char* p, const char* end)
+	{
+		const char* start = p;
+
+#ifdef POINTTEXTPARSER_SSE
+		const __m128i below = _mm_set1_epi8('0' - 1);
+		const __m128i above = _mm_set1_epi8('9' + 1);
+
+		while (end - p >= 16)
+		{
+			__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			unsigned int digits = static_cast<unsigned int>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpgt_epi8(c, below), _mm_cmplt_epi8(c, above))));
+
+			if (digits != 0xFFFFu)
+				return static_cast<size_t>(p - start) + countTrailingZeros(~digits);
+
+			p += 16;
+		}
+#endif
+
+		while (p < end && isDigit(*p))
+			++p;
+
+		return static_cast<size_t>(p - start);
+	}
+
+	// value of eight ASCII digits, combined pairwise within one 64-bit word (little-endian)
+	inline uint32_t parseEightDigits(const char* p)
+	{
+		uint64_t v;
+		memcpy(&v, p, sizeof(v));
+		v -= 0x3030303030303030ull;
+		v = v * 10u + (v >> 8);
+		v = (((v & 0x000000FF000000FFull) * 0x000F424000000064ull) + (((v >> 16) & 0x000000FF000000FFull) * 0x0000271000000001ull)) >> 32;
+
+		return static_cast<uint32_t>(v);
+	}
+
+	inline uint64_t accumulateDigits(uint64_t m, const char* p, size_t count)
+	{
+		for (; count >= 8u; count -= 8u, p += 8)
+			m = m * 100000000u + parseEightDigits(p);
+
+		for (; count > 0u; --count, ++p)
+			m = m * 10u + static_cast<unsigned int>(*p - '0');
+
+		return m;
+	}
+
+	// Parses a decimal number at p; returns the character after it, or NULL if p does not start one
+	const char* parseNumber(const char* p, const char* end, double &value)
+	{
+		const char* start = p;
+
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+			negative = *p++ == '-';
+
+		const char* intDigits = p;
+		size_t intCount = digitRun(p, end);
+		p += intCount;
+
+		const char* fracDigits = p;
+		size_t fracCount = 0u;
+		if (p < end && *p == '.')
+		{
+			fracDigits = ++p;
+			fracCount = digitRun(p, end);
+			p += fracCount;
+		}
+
+		if (intCount + fracCount == 0u)
+			return NULL;
+
+		int exponent = 0;
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			const char* e = p + 1;
+
+			bool negativeExponent = false;
+			if (e < end && (*e == '-' || *e == '+'))
+				negativeExponent = *e++ == '-';
+
+			size_t expCount = digitRun(e, end);
+			if (expCount > 0u)
+			{
+				exponent = expCount > 4u ? 100000 : static_cast<int>(accumulateDigits(0u, e, expCount));
+				if (negativeExponent)
+					exponent = -exponent;
+				p = e + expCount;
+			}
+		}
+
+		int scale = exponent - static_cast<int>(fracCount);
+
+		// leading zeros add no precision
+		while (intCount > 0u && *intDigits == '0')
+		{
+			++intDigits;
+			--intCount;
+		}
+		if (intCount == 0u)
+		{
+			while (fracCount > 0u && *fracDigits == '0')
+			{
+				++fracDigits;
+				--fracCount;
+			}
+		}
+
+		if (intCount + fracCount <= POINTTEXTPARSER_MAX_DIGITS && scale >= -22 && scale <= 22)
+		{
+			uint64_t m = accumulateDigits(accumulateDigits(0u, intDigits, intCount), fracDigits, fracCount);
+
+			if (m < (1ull << 53))
+			{
+				double d = static_cast<double>(m);
+				d = scale < 0 ? d / s_arrPow10[-scale] : d * s_arrPow10[scale];
+				value = negative ? -d : d;
+				return p;
+			}
+		}
+
+		// too many digits or too large an exponent to round exactly here; the mapping is not
+		// null-terminated, so strtod gets a copy
+		char buffer[128];
+		size_t length = std::min(static_cast<size_t>(p - start), sizeof(buffer) - 1u);
+		memcpy(buffer, start, length);
+		buffer[length] = '\0';
+		value = strtod(buffer, NULL);
+
+		return p;
+	}
+
+	// Reads the numbers of the line at p, up to the first thing that is not one, and moves p to
+	// the start of the next line. Lookahead may run to fileEnd, past the end of the chunk.
+	int parseLine(const char* &p, const char* end, const char* fileEnd, double (&v)[POINTTEXTPARSER_MAX_VALUES])
+	{
+		int n = 0;
+
+		while (n < POINTTEXTPARSER_MAX_VALUES)
+		{
+			while (p < end && (*p == ' ' || *p == '\t' || *p == ',' || *p == '\r'))
+				++p;
+
+			if (p >= end || *p == '\n')
+				break;
+
+			const char* next = parseNumber(p, fileEnd, v[n]);
+			if (!next)
+				break;
+
+			p = next;
+			n++;
+		}
+
+		const char* eol = p < end ? static_cast<const char*>(memchr(p, '\n', end - p)) : NULL;
+		p = eol ? eol + 1 : end;
+
+		return n;
+	}
+
+	void parseChunk(const char* p, const char* end, const char* fileEnd, double const (&origin)[3], PointTextPoint* out, ChunkResult &result)
+	{
+		result.points = 0u;
+		result.skippedLines = 0u;
+		for (int i = 0; i < 3; ++i)
+		{
+			result.boundsMin[i] = FLT_MAX;
+			result.boundsMax[i] = -FLT_MAX;
+		}
+
+		while (p < end)
+		{
+			double v[POINTTEXTPARSER_MAX_VALUES];
+			int n = parseLine(p, end, fileEnd, v);
+
+			if (n < 3)
+			{
+				result.skippedLines++;
+				continue;
+			}
+
+			PointTextPoint &pt = out[result.points++];
+			pt.x = static_cast<float>(v[0] - origin[0]);
+			pt.y = static_cast<float>(v[1] - origin[1]);
+			pt.z = static_cast<float>(v[2] - origin[2]);
+
+			if (n >= 6)
+			{
+				for (int i = 0; i < 3; ++i)
+					pt.rgba[i] = static_cast<uint8_t>(std::min(std::max(v[3 + i], 0.0), 255.0));
+				pt.rgba[3] = 255u;
+			}
+			else
+				pt.rgba[0] = pt.rgba[1] = pt.rgba[2] = pt.rgba[3] = 0u;
+
+			float xyz[3] = { pt.x, pt.y, pt.z };
+			for (int i = 0; i < 3; ++i)
+			{
+				result.boundsMin[i] = std::min(result.boundsMin[i], xyz[i]);
+				result.boundsMax[i] = std::max(result.boundsMax[i], xyz[i]);
+			}
+		}
+	}
+
+	// runs task(0) .. task(count - 1) on up to threads threads
+	void runParallel(unsigned int threads, size_t count, std::function<void(size_t)> const &task)
+	{
+		std::atomic<size_t> next(0u);
+		auto worker = [&]() {
+			for (size_t i = next++; i < count; i = next++)
+				task(i);
+		};
+
+		std::vector<std::thread> pool;
+		for (unsigned int t = 1u; t < std::min(static_cast<size_t>(threads), count); ++t)
+			pool.push_back(std::thread(worker));
+
+		worker();
+
+		for (auto &t : pool)
+			t.join();
+	}
+}
+
+PointTextParser::PointTextParser()
+	: m_uiThreads(0u)
+	, m_bCacheReads(true)
+	, m_Stats()
+{
+}
+
+PointTextParser::~PointTextParser()
+{
+	close();
+}
+
+bool PointTextParser::open(std::string const & path)
+{
+	using clock = std::chrono::high_resolution_clock;
+	auto t0 = clock::now();
+
+	close();
+	m_Stats = Stats();
+
+	std::error_code ec;
+	uint64_t sourceSize = std::experimental::filesystem::file_size(path, ec);
+	if (ec)
+	{
+		printf("Error: Could not open \"%s\"\n", path.c_str());
+		return false;
+	}
+
+	int64_t sourceTime = static_cast<int64_t>(std::experimental::filesystem::last_write_time(path, ec).time_since_epoch().count());
+
+	m_Stats.textBytes = sourceSize;
+	m_Stats.fromCache = m_bCacheReads && (loadCache(cachePath(path), sourceSize, sourceTime) || loadCache(fallbackCachePath(path), sourceSize, sourceTime));
+
+	bool ok = m_Stats.fromCache || parse(path, sourceSize, sourceTime);
+
+	m_Stats.seconds = std::chrono::duration<double>(clock::now() - t0).count();
+
+	return ok;
+}
+
+void PointTextParser::close()
+{
+	m_File.close();
+	m_vMemory.clear();
+	m_vMemory.shrink_to_fit();
+}
+
+std::string PointTextParser::fallbackCachePath(std::string const & path)
+{
+	namespace fs = std::experimental::filesystem;
+
+	std::error_code ec;
+	fs::path source = fs::absolute(path);
+	fs::path temp = fs::temp_directory_path(ec);
+	if (ec)
+		return std::string();
+
+	char hash[17];
+	snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(std::hash<std::string>()(source.string())));
+
+	return (temp / (source.filename().string() + "." + hash + POINTTEXTPARSER_CACHE_EXTENSION)).string();
+}
+
+double PointTextParser::getMBPerSecond() const
+{
+	return m_Stats.textBytes / (1024.0 * 1024.0) / std::max(m_Stats.seconds, 1e-6);
+}
+
+bool PointTextParser::loadCache(std::string const & cache, uint64_t sourceSize, int64_t sourceTime)
+{
+	std::error_code ec;
+	if (cache.empty() || !std::experimental::filesystem::exists(cache, ec) || !m_File.openRead(cache))
+		return false;
+
+	bool valid = m_File.size() >= sizeof(PointTextHeader)
+		&& memcmp(header().magic, POINTTEXTPARSER_MAGIC, sizeof(header().magic)) == 0
+		&& header().formatVersion == POINTTEXTPARSER_FORMAT_VERSION
+		&& header().sourceSize == sourceSize
+		&& header().sourceTime == sourceTime
+		&& m_File.size() == sizeof(PointTextHeader) + header().pointCount * sizeof(PointTextPoint);
+
+	if (!valid)
+		m_File.close();
+
+	return valid;
+}
+
+bool PointTextParser::parse(std::string const & path, uint64_t sourceSize, int64_t sourceTime)
+{
+	m_Stats.threads = m_uiThreads > 0u ? m_uiThreads : std::max(1u, std::thread::hardware_concurrency());
+
+	MappedFile text;
+	if (sourceSize > 0u && !text.openRead(path))
+	{
+		printf("Error: Could not open \"%s\"\n", path.c_str());
+		return false;
+	}
+
+	const char* begin = reinterpret_cast<const char*>(text.data());
+	const char* fileEnd = begin + (sourceSize > 0u ? text.size() : 0u);
+
+	// chunks end just past a line break, so no line straddles two of them
+	std::vector<const char*> bounds(1, begin);
+	while (bounds.back() < fileEnd)
+	{
+		const char* p = bounds.back() + std::min(static_cast<size_t>(fileEnd - bounds.back()), static_cast<size_t>(POINTTEXTPARSER_CHUNK_BYTES));
+		const char* eol = p < fileEnd ? static_cast<const char*>(memchr(p, '\n', fileEnd - p)) : NULL;
+		bounds.push_back(eol ? eol + 1 : fileEnd);
+	}
+
+	size_t chunkCount = bounds.size() - 1u;
+	m_Stats.chunks = chunkCount;
+
+	// a chunk holds at most one point per line, which places every chunk's output before parsing
+	std::vector<uint64_t> lines(chunkCount);
+	runParallel(m_Stats.threads, chunkCount, [&](size_t c) {
+		uint64_t n = static_cast<uint64_t>(std::count(bounds[c], bounds[c + 1u], '\n'));
+		lines[c] = n + (bounds[c + 1u][-1] != '\n' ? 1u : 0u);
+	});
+
+	std::vector<uint64_t> offsets(chunkCount + 1u, 0u);
+	for (size_t c = 0u; c < chunkCount; ++c)
+		offsets[c + 1u] = offsets[c] + lines[c];
+
+	// positions are stored relative to the first point so UTM-sized coordinates keep their precision as floats
+	PointTextHeader head;
+	memset(&head, 0, sizeof(head));
+
+	for (const char* p = begin; p < fileEnd;)
+	{
+		double v[POINTTEXTPARSER_MAX_VALUES];
+		if (parseLine(p, fileEnd, fileEnd, v) >= 3)
+		{
+			for (int i = 0; i < 3; ++i)
+				head.origin[i] = v[i];
+			break;
+		}
+	}
+
+	size_t outBytes = sizeof(PointTextHeader) + offsets.back() * sizeof(PointTextPoint);
+
+	// a read-only source directory moves the cache to the temp directory; failing that the points
+	// are parsed into memory and the next open() parses again
+	MappedFile out;
+	std::string cache = cachePath(path);
+	if (!out.create(cache, outBytes))
+	{
+		cache = fallbackCachePath(path);
+		if (cache.empty() || !out.create(cache, outBytes))
+		{
+			printf("Point cache skipped for \"%s\": no writable cache location; keeping the points in memory\n", path.c_str());
+			cache.clear();
+			m_Stats.cacheSkipped = true;
+			m_vMemory.resize(outBytes);
+		}
+		else
+			printf("Caching \"%s\" points in \"%s\"\n", path.c_str(), cache.c_str());
+	}
+
+	unsigned char* outData = m_Stats.cacheSkipped ? m_vMemory.data() : out.data();
+	PointTextPoint* points = reinterpret_cast<PointTextPoint*>(outData + sizeof(PointTextHeader));
+	std::vector<ChunkResult> results(chunkCount);
+
+	runParallel(m_Stats.threads, chunkCount, [&](size_t c) {
+		parseChunk(bounds[c], bounds[c + 1u], fileEnd, head.origin, points + offsets[c], results[c]);
+	});
+
+	text.close();
+
+	// close the gaps the skipped lines left
+	for (int i = 0; i < 3; ++i)
+	{
+		head.boundsMin[i] = FLT_MAX;
+		head.boundsMax[i] = -FLT_MAX;
+	}
+
+	for (size_t c = 0u; c < chunkCount; ++c)
+	{
+		if (head.pointCount != offsets[c] && results[c].points > 0u)
+			memmove(points + head.pointCount, points + offsets[c], results[c].points * sizeof(PointTextPoint));
+
+		head.pointCount += results[c].points;
+		head.skippedLines += results[c].skippedLines;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			head.boundsMin[i] = std::min(head.boundsMin[i], results[c].boundsMin[i]);
+			head.boundsMax[i] = std::max(head.boundsMax[i], results[c].boundsMax[i]);
+		}
+	}
+
+	// the header goes in last, so an interrupted parse leaves a cache that never validates
+	memcpy(head.magic, POINTTEXTPARSER_MAGIC, sizeof(head.magic));
+	head.formatVersion = POINTTEXTPARSER_FORMAT_VERSION;
+	head.sourceSize = sourceSize;
+	head.sourceTime = sourceTime;
+	memcpy(outData, &head, sizeof(head));
+
+	if (m_Stats.cacheSkipped)
+	{
+		m_vMemory.resize(sizeof(PointTextHeader) + head.pointCount * sizeof(PointTextPoint));
+		return true;
+	}
+
+	out.close(sizeof(PointTextHeader) + head.pointCount * sizeof(PointTextPoint));
+
+	if (!m_File.openRead(cache))
+	{
+		printf("Error: Could not read back the point cache \"%s\"\n", cache.c_str());
+		return false;
+	}
+
+	return true;
+}
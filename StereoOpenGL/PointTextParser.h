@@ -0,0 +1,102 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "MappedFile.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define POINTTEXTPARSER_SSE
+#endif
+
+#define POINTTEXTPARSER_MAGIC			"SPTC"
+#define POINTTEXTPARSER_FORMAT_VERSION	1
+#define POINTTEXTPARSER_CACHE_EXTENSION	".ptcache"			// appended to the text file's name
+#define POINTTEXTPARSER_CHUNK_BYTES		(8u * 1024u * 1024u)	// text handed to a parse thread at a time
+
+// a parsed point, relative to PointTextHeader::origin; alpha 0 means the line had no color
+struct PointTextPoint {
+	float x, y, z;
+	uint8_t rgba[4];
+};
+
+// Start of a cache file, followed by pointCount PointTextPoints. The cache is only used while
+// the source's size and modification time match the ones recorded here.
+struct PointTextHeader {
+	char magic[4];
+	uint32_t formatVersion;
+	uint64_t sourceSize;
+	int64_t sourceTime;		// filesystem clock ticks
+	uint64_t pointCount;
+	uint64_t skippedLines;	// fewer than three numbers, e.g. headers
+	double origin[3];		// first point of the file
+	float boundsMin[3];
+	float boundsMax[3];
+};
+
+// Reads whitespace- or comma-separated text point clouds (x y z, optionally followed by r g b
+// in 0-255, one point per line) such as the Reson sonar exports. The text is memory-mapped and
+// cut at line breaks into POINTTEXTPARSER_CHUNK_BYTES pieces that worker threads parse straight
+// into a binary cache file beside the source; numbers take a fast path that scans digit runs
+// with SSE2 and converts eight digits at a time, falling back to strtod for the rare ones it
+// cannot round exactly. Later opens of an unchanged file only map the cache. Sources in
+// directories that can't be written to are cached in the temp directory instead, and if that
+// fails too the points are kept in memory for this open() only.
+class PointTextParser
+{
+public:
+	struct Stats {
+		uint64_t textBytes;
+		uint64_t chunks;
+		unsigned int threads;
+		bool fromCache;
+		bool cacheSkipped;	// no cache could be written; the points are held in memory
+		double seconds;		// open(), including writing the cache
+	};
+
+	PointTextParser();
+	~PointTextParser();
+
+	// 0 uses one thread per hardware thread
+	void setThreads(unsigned int threads) { m_uiThreads = threads; }
+	// while disabled, open() always parses and the cache is written but never read
+	void setCacheReads(bool enabled) { m_bCacheReads = enabled; }
+
+	// On success header() and points() point into the mapped cache (or the in-memory copy) until
+	// the next open() or close()
+	bool open(std::string const &path);
+	void close();
+
+	bool isOpen() const { return m_File.isOpen() || !m_vMemory.empty(); }
+
+	const PointTextHeader& header() const { return *reinterpret_cast<const PointTextHeader*>(data()); }
+	const PointTextPoint* points() const { return reinterpret_cast<const PointTextPoint*>(data() + sizeof(PointTextHeader)); }
+	uint64_t pointCount() const { return header().pointCount; }
+
+	Stats const& getStats() const { return m_Stats; }
+	// text throughput of the last open(), whether parsed or served from the cache
+	double getMBPerSecond() const;
+
+	static std::string cachePath(std::string const &path) { return path + POINTTEXTPARSER_CACHE_EXTENSION; }
+	// where the cache goes when the source's directory is read-only; named after a hash of the
+	// absolute path so same-named sources don't share one
+	static std::string fallbackCachePath(std::string const &path);
+
+private:
+	bool loadCache(std::string const &cache, uint64_t sourceSize, int64_t sourceTime);
+	bool parse(std::string const &path, uint64_t sourceSize, int64_t sourceTime);
+
+	const unsigned char* data() const { return m_File.isOpen() ? m_File.data() : m_vMemory.data(); }
+
+	unsigned int m_uiThreads;
+	bool m_bCacheReads;
+	Stats m_Stats;
+
+	MappedFile m_File;
+	std::vector<unsigned char> m_vMemory;	// header and points when no cache could be written
+
+public:
+	PointTextParser(PointTextParser const&) = delete;
+	void operator=(PointTextParser const&) = delete;
+};
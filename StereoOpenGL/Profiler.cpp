@@ -0,0 +1,351 @@
+#include "Profiler.h"
+#include "FrameTiming.h"
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <sstream>
+
+Profiler::Profiler()
+	: m_bInitialized(false)
+	, m_uiGPUFrame(0u)
+	, m_bGPUFrameActive(false)
+	, m_uiTraceFramesLeft(0u)
+{
+	for (auto &f : m_arrGPUFrames)
+	{
+		f.queryCount = 0u;
+		f.pending = false;
+		f.traced = false;
+	}
+}
+
+Profiler::~Profiler()
+{
+}
+
+bool Profiler::init()
+{
+	if (m_bInitialized)
+		return true;
+
+	for (unsigned int i = 0u; i < PROFILER_QUERY_FRAMES; ++i)
+		glGenQueries(PROFILER_MAX_GPU_ZONES * 2, m_arrQueries[i]);
+
+	m_vCPUZones.reserve(64);
+	m_vTrace.reserve(PROFILER_TRACE_FRAMES * 32);
+
+	m_bInitialized = true;
+
+	return true;
+}
+
+void Profiler::shutdown()
+{
+	if (!m_bInitialized)
+		return;
+
+	for (unsigned int i = 0u; i < PROFILER_QUERY_FRAMES; ++i)
+		glDeleteQueries(PROFILER_MAX_GPU_ZONES * 2, m_arrQueries[i]);
+
+	m_bInitialized = false;
+}
+
+void Profiler::beginFrame()
+{
+	m_vCPUZones.clear();
+	m_vCPUStack.clear();
+	m_vGPUStack.clear();
+	m_strGPUPath.clear();
+
+	if (!m_bInitialized)
+		return;
+
+	m_uiGPUFrame = (m_uiGPUFrame + 1u) % PROFILER_QUERY_FRAMES;
+	GPUFrame &frame = m_arrGPUFrames[m_uiGPUFrame];
+
+	if (frame.pending)
+		readGPUFrame(frame, m_uiGPUFrame);
+
+	// if the GPU is still PROFILER_QUERY_FRAMES frames behind, skip GPU timing this frame rather than wait
+	m_bGPUFrameActive = !frame.pending;
+
+	if (m_bGPUFrameActive)
+	{
+		frame.zones.clear();
+		frame.queryCount = 0u;
+		frame.traced = isCapturing() && m_uiTraceFramesLeft > 0u;
+	}
+}
+
+void Profiler::endFrame()
+{
+	for (auto const &z : m_vCPUZones)
+	{
+		addSample(z.path, z.name, z.depth, false, std::chrono::duration<double, std::milli>(z.end - z.start).count());
+
+		if (isCapturing() && m_uiTraceFramesLeft > 0u)
+			m_vTrace.push_back({ z.name, false, z.start, z.end });
+	}
+
+	commitFrameStats(false);
+
+	if (m_bInitialized)
+	{
+		if (m_bGPUFrameActive)
+			m_arrGPUFrames[m_uiGPUFrame].pending = m_arrGPUFrames[m_uiGPUFrame].queryCount > 0u;
+
+		// pick up any older frames that have finished, oldest first
+		for (unsigned int i = 1u; i < PROFILER_QUERY_FRAMES; ++i)
+		{
+			unsigned int slot = (m_uiGPUFrame + i) % PROFILER_QUERY_FRAMES;
+			if (m_arrGPUFrames[slot].pending)
+				readGPUFrame(m_arrGPUFrames[slot], slot);
+		}
+	}
+
+	if (isCapturing())
+	{
+		// keep going for a few frames after the capture so its GPU results come back
+		if (m_uiTraceFramesLeft > 0u)
+			m_uiTraceFramesLeft--;
+		else if (std::none_of(m_arrGPUFrames, m_arrGPUFrames + PROFILER_QUERY_FRAMES, [](GPUFrame const &f) { return f.pending && f.traced; }))
+			writeTrace();
+	}
+}
+
+std::string Profiler::currentPath(const char* name) const
+{
+	if (m_vCPUStack.empty())
+		return std::string(name);
+
+	return m_vCPUZones[m_vCPUStack.back()].path + "/" + name;
+}
+
+void Profiler::beginZone(const char* name)
+{
+	CPUZone z;
+	z.path = currentPath(name);
+	z.name = name;
+	z.depth = static_cast<unsigned int>(m_vCPUStack.size());
+
+	m_vCPUStack.push_back(static_cast<unsigned int>(m_vCPUZones.size()));
+	m_vCPUZones.push_back(z);
+
+	m_vCPUZones.back().start = Clock::now();
+}
+
+void Profiler::endZone()
+{
+	Clock::time_point now = Clock::now();
+
+	if (m_vCPUStack.empty())
+		return;
+
+	m_vCPUZones[m_vCPUStack.back()].end = now;
+	m_vCPUStack.pop_back();
+}
+
+void Profiler::beginGPUZone(const char* name)
+{
+	GPUFrame &frame = m_arrGPUFrames[m_uiGPUFrame];
+
+	if (!m_bInitialized || !m_bGPUFrameActive || frame.queryCount + 2u > PROFILER_MAX_GPU_ZONES * 2)
+	{
+		m_vGPUStack.push_back(UINT_MAX);
+		return;
+	}
+
+	GPUZone z;
+	z.name = name;
+	z.depth = 0u;
+	for (unsigned int idx : m_vGPUStack)
+		if (idx != UINT_MAX)
+			z.depth++;
+	z.path = (m_strGPUPath.empty() ? std::string("gpu") : m_strGPUPath) + "/" + name;
+	z.query = frame.queryCount;
+
+	frame.queryCount += 2u;
+
+	glQueryCounter(m_arrQueries[m_uiGPUFrame][z.query], GL_TIMESTAMP);
+
+	m_strGPUPath = z.path;
+	m_vGPUStack.push_back(static_cast<unsigned int>(frame.zones.size()));
+	frame.zones.push_back(z);
+}
+
+void Profiler::endGPUZone()
+{
+	if (m_vGPUStack.empty())
+		return;
+
+	unsigned int idx = m_vGPUStack.back();
+	m_vGPUStack.pop_back();
+
+	if (idx == UINT_MAX)
+		return;
+
+	GPUFrame &frame = m_arrGPUFrames[m_uiGPUFrame];
+	glQueryCounter(m_arrQueries[m_uiGPUFrame][frame.zones[idx].query + 1u], GL_TIMESTAMP);
+
+	size_t slash = m_strGPUPath.find_last_of('/');
+	m_strGPUPath = m_strGPUPath.substr(0, slash);
+	if (m_strGPUPath == "gpu")
+		m_strGPUPath.clear();
+}
+
+void Profiler::readGPUFrame(GPUFrame & frame, unsigned int slot)
+{
+	if (frame.queryCount == 0u)
+	{
+		frame.pending = false;
+		return;
+	}
+
+	// queries complete in order, so the last one being ready means they all are
+	GLuint available = 0;
+	glGetQueryObjectuiv(m_arrQueries[slot][frame.queryCount - 1u], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+		return;
+
+	for (auto const &z : frame.zones)
+	{
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(m_arrQueries[slot][z.query], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(m_arrQueries[slot][z.query + 1u], GL_QUERY_RESULT, &end);
+
+		addSample(z.path, z.name, z.depth, true, (end - begin) / 1000000.0);
+
+		if (frame.traced && isCapturing())
+			m_vTrace.push_back({ z.name, true, FrameTiming::getInstance().fromGPUTime(begin), FrameTiming::getInstance().fromGPUTime(end) });
+	}
+
+	commitFrameStats(true);
+
+	frame.pending = false;
+}
+
+void Profiler::addSample(const std::string & path, const char* name, unsigned int depth, bool gpu, double ms)
+{
+	auto it = m_mapStats.find(path);
+
+	if (it == m_mapStats.end())
+	{
+		Stats s;
+		s.name = name;
+		s.depth = depth;
+		s.gpu = gpu;
+		s.next = 0u;
+		s.count = 0u;
+		s.frameTotal = 0.0;
+		s.touched = false;
+
+		it = m_mapStats.insert(std::make_pair(path, s)).first;
+		m_vStatsOrder.push_back(path);
+	}
+
+	it->second.frameTotal += ms;
+	it->second.touched = true;
+}
+
+void Profiler::commitFrameStats(bool gpu)
+{
+	for (auto &entry : m_mapStats)
+	{
+		Stats &s = entry.second;
+
+		if (s.gpu != gpu || !s.touched)
+			continue;
+
+		s.samples[s.next] = s.frameTotal;
+		s.next = (s.next + 1u) % PROFILER_HISTORY;
+		s.count = std::min(s.count + 1u, static_cast<unsigned int>(PROFILER_HISTORY));
+		s.frameTotal = 0.0;
+		s.touched = false;
+	}
+}
+
+std::string Profiler::statsString() const
+{
+	std::stringstream ss;
+	ss.precision(2);
+	ss << std::fixed;
+
+	ss << "Zone (ms)                     min    avg    p99" << std::endl;
+
+	double sorted[PROFILER_HISTORY];
+
+	for (auto const &path : m_vStatsOrder)
+	{
+		Stats const &s = m_mapStats.at(path);
+
+		if (s.count == 0u)
+			continue;
+
+		std::copy(s.samples, s.samples + s.count, sorted);
+		std::sort(sorted, sorted + s.count);
+
+		double sum = 0.0;
+		for (unsigned int i = 0u; i < s.count; ++i)
+			sum += sorted[i];
+
+		unsigned int p99 = std::min(s.count - 1u, static_cast<unsigned int>(s.count * 0.99));
+
+		std::string label = std::string(s.depth * 2u, ' ') + s.name + (s.gpu ? " [gpu]" : "");
+		label.resize(std::max(label.size(), static_cast<size_t>(26)), ' ');
+
+		char line[128];
+		snprintf(line, sizeof(line), "%s %6.2f %6.2f %6.2f", label.c_str(), sorted[0], sum / s.count, sorted[p99]);
+		ss << line << std::endl;
+	}
+
+	return ss.str();
+}
+
+void Profiler::captureTrace(std::string path)
+{
+	if (isCapturing())
+		return;
+
+	m_strTracePath = path;
+	m_uiTraceFramesLeft = PROFILER_TRACE_FRAMES;
+	m_vTrace.clear();
+}
+
+void Profiler::writeTrace()
+{
+	FILE* out = fopen(m_strTracePath.c_str(), "w");
+
+	if (!out)
+		printf("Profiler: could not open %s for writing\n", m_strTracePath.c_str());
+	else
+	{
+		Clock::time_point origin = m_vTrace.empty() ? Clock::now() : m_vTrace.front().start;
+		for (auto const &ev : m_vTrace)
+			origin = std::min(origin, ev.start);
+
+		fprintf(out, "{\"traceEvents\":[\n");
+		fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n");
+		fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}");
+
+		for (auto const &ev : m_vTrace)
+		{
+			fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+				ev.name,
+				ev.gpu ? "gpu" : "cpu",
+				std::chrono::duration<double, std::micro>(ev.start - origin).count(),
+				std::chrono::duration<double, std::micro>(ev.end - ev.start).count(),
+				ev.gpu ? 2 : 1);
+		}
+
+		fprintf(out, "\n]}\n");
+		fclose(out);
+
+		printf("Profiler: wrote %u events to %s\n", static_cast<unsigned int>(m_vTrace.size()), m_strTracePath.c_str());
+	}
+
+	m_strTracePath.clear();
+	m_vTrace.clear();
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#define PROFILER_HISTORY			240		// frames of samples kept per zone for min/avg/p99
+#define PROFILER_QUERY_FRAMES		3		// frames of GPU queries in flight before results are read back
+#define PROFILER_MAX_GPU_ZONES		64		// per frame
+#define PROFILER_TRACE_FRAMES		120		// frames written by a trace capture
+
+// Hierarchical frame profiler. CPU zones are timed with the high resolution clock and GPU zones
+// with a pair of GL_TIMESTAMP queries, which (unlike GL_TIME_ELAPSED) can nest. GPU results are
+// read back PROFILER_QUERY_FRAMES frames later, and only once they are available, so profiling
+// never stalls the pipeline. Zones are identified by their path ("render/left eye/opaque") and
+// must be opened and closed on the main thread; GPU zones live under "gpu/".
+class Profiler
+{
+public:
+	typedef std::chrono::high_resolution_clock Clock;
+
+	static Profiler& getInstance()
+	{
+		static Profiler s_instance;
+		return s_instance;
+	}
+
+	// needs a current GL context
+	bool init();
+	void shutdown();
+
+	void beginFrame();
+	void endFrame();
+
+	void beginZone(const char* name);
+	void endZone();
+
+	void beginGPUZone(const char* name);
+	void endGPUZone();
+
+	// rolling min/avg/p99 for every zone, indented by depth, for the diagnostics overlay
+	std::string statsString() const;
+
+	// records the next PROFILER_TRACE_FRAMES frames and writes them as Chrome trace JSON (chrome://tracing)
+	void captureTrace(std::string path);
+	bool isCapturing() const { return !m_strTracePath.empty(); }
+
+private:
+	Profiler();
+	~Profiler();
+
+	struct CPUZone {
+		std::string path;
+		const char* name;
+		unsigned int depth;
+		Clock::time_point start;
+		Clock::time_point end;
+	};
+
+	struct GPUZone {
+		std::string path;
+		const char* name;
+		unsigned int depth;
+		unsigned int query;	// begin timestamp; the end timestamp is the next query
+	};
+
+	struct GPUFrame {
+		std::vector<GPUZone> zones;
+		unsigned int queryCount;
+		bool pending;
+		bool traced;	// recorded while a trace capture was running
+	};
+
+	struct Stats {
+		std::string name;
+		unsigned int depth;
+		bool gpu;
+		double samples[PROFILER_HISTORY];	// ms per frame
+		unsigned int next;
+		unsigned int count;
+		double frameTotal;					// zones with the same path are summed within a frame
+		bool touched;
+	};
+
+	struct TraceEvent {
+		const char* name;
+		bool gpu;
+		Clock::time_point start;
+		Clock::time_point end;
+	};
+
+	bool m_bInitialized;
+
+	std::vector<CPUZone> m_vCPUZones;
+	std::vector<unsigned int> m_vCPUStack;
+
+	unsigned int m_arrQueries[PROFILER_QUERY_FRAMES][PROFILER_MAX_GPU_ZONES * 2];
+	GPUFrame m_arrGPUFrames[PROFILER_QUERY_FRAMES];
+	unsigned int m_uiGPUFrame;
+	bool m_bGPUFrameActive;
+	std::vector<unsigned int> m_vGPUStack;
+	std::string m_strGPUPath;
+
+	std::map<std::string, Stats> m_mapStats;
+	std::vector<std::string> m_vStatsOrder;
+
+	std::string m_strTracePath;
+	unsigned int m_uiTraceFramesLeft;
+	std::vector<TraceEvent> m_vTrace;
+
+	std::string currentPath(const char* name) const;
+	void addSample(const std::string &path, const char* name, unsigned int depth, bool gpu, double ms);
+	void commitFrameStats(bool gpu);
+	void readGPUFrame(GPUFrame &frame, unsigned int slot);
+	void writeTrace();
+
+public:
+	// DELETE THE FOLLOWING FUNCTIONS TO AVOID NON-SINGLETON USE
+	Profiler(Profiler const&) = delete;
+	void operator=(Profiler const&) = delete;
+};
+
+class ProfileScope
+{
+public:
+	ProfileScope(const char* name) { Profiler::getInstance().beginZone(name); }
+	~ProfileScope() { Profiler::getInstance().endZone(); }
+};
+
+class GPUProfileScope
+{
+public:
+	GPUProfileScope(const char* name) { Profiler::getInstance().beginGPUZone(name); }
+	~GPUProfileScope() { Profiler::getInstance().endGPUZone(); }
+};
+
+#define PROFILE_CONCAT_INNER(a, b)	a##b
+#define PROFILE_CONCAT(a, b)		PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name)			ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name)		GPUProfileScope PROFILE_CONCAT(gpuProfileScope_, __LINE__)(name)
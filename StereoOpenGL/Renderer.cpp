@@ -1,4 +1,5 @@
 #include "Renderer.h"
+#include "Platform.h"
 
 #include <vector>
 #include <numeric>
@@ -14,14 +15,37 @@
 
 #include "DebugDrawer.h"
 #include "Icosphere.h"
+#include "MeshUtils.h"
+#include "PackedVertex.h"
 #include "GLSLpreamble.h"
+#include "Profiler.h"
 
 Renderer::Renderer()
-	: m_pLighting(NULL)
+	: m_uiFontPointSize(144u)
+	, m_pLighting(NULL)
+	, m_bShowWireframe(false)
+	, m_RenderStats()
+	, m_bCulling(true)
+	, m_eTransparencyMode(TRANSPARENCY_AUTO)
+	, m_bOITPass(false)
+	, m_bMultiDrawIndirect(true)
+	, m_bMultiDrawIndirectSupported(false)
+	, m_bBindlessTextures(false)
+	, m_bPackedVertices(true)
+	, m_nPrimitiveArenaBytes(0u)
+	, m_glDrawDataSSBO(0)
+	, m_glDrawCommandBuffer(0)
+	, m_bPrimitiveBatchOpen(false)
+	, m_nPrimitiveBatchStart(0u)
+	, m_fPrimitiveSetupMS(0.f)
+	, m_uiGeneratedPrimitives(0u)
+	, m_bLevelOfDetail(true)
+	, m_glPrimitiveVAO(0)
+	, m_glPrimitiveVBO(0)
+	, m_glPrimitiveEBO(0)
+	, m_glBoundVAO(0)
 	, m_glFrameUBO(0)
 	, m_glFullscreenTextureVAO(0)
-	, m_bShowWireframe(false)
-	, m_uiFontPointSize(144u)
 {
 }
 
@@ -31,6 +55,16 @@ Renderer::~Renderer()
 
 void Renderer::shutdown()
 {
+	m_MeshStreamer.shutdown();
+	for (auto &pc : m_mapPointClouds)
+		delete pc.second;
+	m_mapPointClouds.clear();
+	m_vPointCloudQueue.clear();
+	glDeleteVertexArrays(1, &m_glPrimitiveVAO);
+	glDeleteBuffers(1, &m_glPrimitiveVBO);
+	glDeleteBuffers(1, &m_glPrimitiveEBO);
+	glDeleteBuffers(1, &m_glDrawDataSSBO);
+	glDeleteBuffers(1, &m_glDrawCommandBuffer);
 	glDeleteBuffers(1, &m_glFullscreenTextureVBO);
 	glDeleteBuffers(1, &m_glFullscreenTextureEBO);
 }
@@ -47,12 +81,24 @@ bool Renderer::init()
 	glNamedBufferData(m_glFrameUBO, sizeof(FrameUniforms), NULL, GL_STATIC_DRAW); // allocate memory
 	glBindBufferRange(GL_UNIFORM_BUFFER, SCENE_UNIFORM_BUFFER_LOCATION, m_glFrameUBO, 0, sizeof(FrameUniforms));
 
+	// gl_DrawIDARB is how multi-draw shaders find their draw data
+	m_bMultiDrawIndirectSupported = GLEW_ARB_shader_draw_parameters == GL_TRUE;
+
+	// GLTexture makes a handle resident for every texture when this is available
+	m_bBindlessTextures = m_bMultiDrawIndirectSupported && GLEW_ARB_bindless_texture == GL_TRUE;
+
+	// both are refilled (and orphaned) by every multi-draw queue pass
+	glCreateBuffers(1, &m_glDrawDataSSBO);
+	glCreateBuffers(1, &m_glDrawCommandBuffer);
+
 	setupShaders();
 
 	setupTextures();
 
 	setupPrimitives();
 
+	m_MeshStreamer.init();
+
 	setupFullscreenQuad();
 
 	setupText();
@@ -80,7 +126,6 @@ void Renderer::addToStaticRenderQueue(RendererSubmission &rs)
 	if (rs.hasTransparency || diff->hasTransparency() || spec->hasTransparency() || rs.diffuseColor.a < 1.f || rs.specularColor.a < 1.f)
 	{
 		m_vStaticRenderQueue_Transparency.push_back(rs);
-		m_vTransparentRenderQueue.push_back(rs);
 	}
 	else
 		m_vStaticRenderQueue_Opaque.push_back(rs);
@@ -106,7 +151,6 @@ void Renderer::addToDynamicRenderQueue(RendererSubmission &rs)
 	if (rs.hasTransparency || diff->hasTransparency() || spec->hasTransparency() || rs.diffuseColor.a < 1.f)
 	{
 		m_vDynamicRenderQueue_Transparency.push_back(rs);
-		m_vTransparentRenderQueue.push_back(rs);
 	}
 	else
 		m_vDynamicRenderQueue_Opaque.push_back(rs);
@@ -116,8 +160,7 @@ void Renderer::clearDynamicRenderQueue()
 {
 	m_vDynamicRenderQueue_Opaque.clear();
 	m_vDynamicRenderQueue_Transparency.clear();
-	m_vTransparentRenderQueue.clear();
-	m_vTransparentRenderQueue = m_vStaticRenderQueue_Transparency;
+	m_vPointCloudQueue.clear();
 }
 
 void Renderer::addToUIRenderQueue(RendererSubmission & rs)
@@ -137,18 +180,12 @@ void Renderer::showMessage(std::string message, float duration)
 
 bool Renderer::drawPrimitive(std::string primName, glm::mat4 modelTransform, std::string diffuseTextureName, std::string specularTextureName, float specularExponent)
 {
-	GLuint vao = getPrimitiveVAO(primName);
-	if (vao == 0u)
+	RendererSubmission rs;
+	if (!setSubmissionPrimitive(rs, primName))
 		return false;
 
-
-	RendererSubmission rs;
-	rs.glPrimitiveType = GL_TRIANGLES;
 	rs.shaderName = "lighting";
 	rs.modelToWorldTransform = modelTransform;
-	rs.VAO = vao;
-	rs.vertCount = getPrimitiveIndexCount(primName);
-	rs.indexType = GL_UNSIGNED_SHORT;
 	rs.diffuseTexName = diffuseTextureName;
 	rs.specularTexName = specularTextureName;
 	rs.specularExponent = specularExponent;
@@ -164,18 +201,12 @@ bool Renderer::drawPrimitive(std::string primName, glm::mat4 modelTransform, std
 
 bool Renderer::drawPrimitive(std::string primName, glm::mat4 modelTransform, glm::vec4 diffuseColor, glm::vec4 specularColor, float specularExponent)
 {
-	GLuint vao = getPrimitiveVAO(primName);
-	if (vao == 0u)
+	RendererSubmission rs;
+	if (!setSubmissionPrimitive(rs, primName))
 		return false;
 
-
-	RendererSubmission rs;
-	rs.glPrimitiveType = primName.find("_line") != std::string::npos ? GL_LINES : GL_TRIANGLES;
 	rs.shaderName = "lighting";
 	rs.modelToWorldTransform = modelTransform;
-	rs.VAO = vao;
-	rs.vertCount = getPrimitiveIndexCount(primName);
-	rs.indexType = GL_UNSIGNED_SHORT;
 	rs.diffuseColor = diffuseColor;
 	rs.specularColor = specularColor;
 	rs.specularExponent = specularExponent;
@@ -191,18 +222,12 @@ bool Renderer::drawPrimitive(std::string primName, glm::mat4 modelTransform, glm
 
 bool Renderer::drawFlatPrimitive(std::string primName, glm::mat4 modelTransform, glm::vec4 color)
 {
-	GLuint vao = getPrimitiveVAO(primName);
-	if (vao == 0u)
+	RendererSubmission rs;
+	if (!setSubmissionPrimitive(rs, primName))
 		return false;
 
-
-	RendererSubmission rs;
-	rs.glPrimitiveType = primName.find("_line") != std::string::npos ? GL_LINES : GL_TRIANGLES;
 	rs.shaderName = "flat";
 	rs.modelToWorldTransform = modelTransform;
-	rs.VAO = vao;
-	rs.vertCount = getPrimitiveIndexCount(primName);
-	rs.indexType = GL_UNSIGNED_SHORT;
 	rs.diffuseColor = color;
 	rs.hasTransparency = color.a != 1.f;
 
@@ -216,18 +241,12 @@ bool Renderer::drawFlatPrimitive(std::string primName, glm::mat4 modelTransform,
 
 bool Renderer::drawPrimitiveCustom(std::string primName, glm::mat4 modelTransform, std::string shaderName, std::string diffuseTexName, glm::vec4 diffuseColor)
 {
-	GLuint vao = getPrimitiveVAO(primName);
-	if (vao == 0u)
+	RendererSubmission rs;
+	if (!setSubmissionPrimitive(rs, primName))
 		return false;
 
-
-	RendererSubmission rs;
-	rs.glPrimitiveType = primName.find("_line") != std::string::npos ? GL_LINES : GL_TRIANGLES;
 	rs.shaderName = shaderName;
 	rs.modelToWorldTransform = modelTransform;
-	rs.VAO = vao;
-	rs.vertCount = getPrimitiveIndexCount(primName);
-	rs.indexType = GL_UNSIGNED_SHORT;
 	rs.diffuseTexName = diffuseTexName;
 	rs.diffuseColor = diffuseColor;
 	rs.specularTexName = "white";
@@ -288,9 +307,20 @@ bool Renderer::addTexture(GLTexture * tex)
 
 void Renderer::sortTransparentObjects(glm::vec3 HMDPos)
 {
-	std::sort(m_vStaticRenderQueue_Transparency.begin(), m_vStaticRenderQueue_Transparency.end(), ObjectSorter(HMDPos));
-	std::sort(m_vDynamicRenderQueue_Transparency.begin(), m_vDynamicRenderQueue_Transparency.end(), ObjectSorter(HMDPos));
-	std::sort(m_vTransparentRenderQueue.begin(), m_vTransparentRenderQueue.end(), ObjectSorter(HMDPos));
+	// the queues themselves stay in submission order; only the sorter's index list is reordered
+	m_TransparencySorter.clear();
+
+	// weighted-blended OIT doesn't depend on draw order
+	if (usingOIT())
+		return;
+
+	for (auto const &rs : m_vStaticRenderQueue_Transparency)
+		m_TransparencySorter.add(getTransparencySortPosition(rs));
+
+	for (auto const &rs : m_vDynamicRenderQueue_Transparency)
+		m_TransparencySorter.add(getTransparencySortPosition(rs));
+
+	m_TransparencySorter.sort(HMDPos);
 }
 
 
@@ -316,12 +346,61 @@ void Renderer::setupShaders()
 	m_mapShaders["solid"] = m_Shaders.AddProgramFromExts({ "shaders/solid.vert", "shaders/flat.frag" });
 	m_mapShaders["text"] = m_Shaders.AddProgramFromExts({ "shaders/text.vert", "shaders/text.frag" });
 	m_mapShaders["shadow"] = m_Shaders.AddProgramFromExts({ "shaders/shadow.vert", "shaders/shadow.frag" });
+	m_mapShaders["oitcomposite"] = m_Shaders.AddProgramFromExts({ "shaders/desktopwindow.vert", "shaders/oitcomposite.frag" });
+	m_mapShaders["pointcloud"] = m_Shaders.AddProgramFromExts({ "shaders/pointcloud.vert", "shaders/pointcloud.frag" }, "#define POINT_CLOUD_NODE_POINTS " + std::to_string(POINTOCTREE_NODE_POINTS) + "\n");
+
+	// variants of the programs that can draw transparent submissions, for the weighted-blended OIT pass
+	m_mapOITShaders["lighting"] = m_Shaders.AddProgramFromExts({ "shaders/lighting.vert", "shaders/lighting.frag" }, RENDERER_OIT_SHADER_DEFINES);
+	m_mapOITShaders["lightingWireframe"] = m_Shaders.AddProgramFromExts({ "shaders/lighting.vert", "shaders/lightingWF.geom", "shaders/lightingWF.frag" }, RENDERER_OIT_SHADER_DEFINES);
+	m_mapOITShaders["flat"] = m_Shaders.AddProgramFromExts({ "shaders/flat.vert", "shaders/flat.frag" }, RENDERER_OIT_SHADER_DEFINES);
+	m_mapOITShaders["grid"] = m_Shaders.AddProgramFromExts({ "shaders/lighting.vert", "shaders/gridlighting.frag" }, RENDERER_OIT_SHADER_DEFINES);
+	m_mapOITShaders["gridflat"] = m_Shaders.AddProgramFromExts({ "shaders/lighting.vert", "shaders/gridflat.frag" }, RENDERER_OIT_SHADER_DEFINES);
+	m_mapOITShaders["rings"] = m_Shaders.AddProgramFromExts({ "shaders/lighting.vert", "shaders/ringslighting.frag" }, RENDERER_OIT_SHADER_DEFINES);
+	m_mapOITShaders["ringsflat"] = m_Shaders.AddProgramFromExts({ "shaders/lighting.vert", "shaders/ringsflat.frag" }, RENDERER_OIT_SHADER_DEFINES);
+	m_mapOITShaders["text"] = m_Shaders.AddProgramFromExts({ "shaders/text.vert", "shaders/text.frag" }, RENDERER_OIT_SHADER_DEFINES);
+	m_mapOITShaders["shadow"] = m_Shaders.AddProgramFromExts({ "shaders/shadow.vert", "shaders/shadow.frag" }, RENDERER_OIT_SHADER_DEFINES);
+
+	// variants that read their per-draw inputs from the draw data buffer, for multi-draw indirect
+	// (the wireframe geometry shader doesn't forward the draw index, so it's always drawn singly)
+	if (m_bMultiDrawIndirectSupported)
+	{
+		std::string mdiDefines = std::string(RENDERER_MDI_SHADER_DEFINES) + (m_bBindlessTextures ? RENDERER_BINDLESS_SHADER_DEFINES : "");
+
+		m_mapMDIShaders["lighting"] = m_Shaders.AddProgramFromExts({ "shaders/lighting.vert", "shaders/lighting.frag" }, mdiDefines);
+		m_mapMDIShaders["flat"] = m_Shaders.AddProgramFromExts({ "shaders/flat.vert", "shaders/flat.frag" }, mdiDefines);
+		m_mapMDIShaders["debug"] = m_Shaders.AddProgramFromExts({ "shaders/flat.vert", "shaders/flat.frag" }, mdiDefines);
+		m_mapMDIShaders["grid"] = m_Shaders.AddProgramFromExts({ "shaders/lighting.vert", "shaders/gridlighting.frag" }, mdiDefines);
+		m_mapMDIShaders["gridflat"] = m_Shaders.AddProgramFromExts({ "shaders/lighting.vert", "shaders/gridflat.frag" }, mdiDefines);
+		m_mapMDIShaders["rings"] = m_Shaders.AddProgramFromExts({ "shaders/lighting.vert", "shaders/ringslighting.frag" }, mdiDefines);
+		m_mapMDIShaders["ringsflat"] = m_Shaders.AddProgramFromExts({ "shaders/lighting.vert", "shaders/ringsflat.frag" }, mdiDefines);
+		m_mapMDIShaders["text"] = m_Shaders.AddProgramFromExts({ "shaders/text.vert", "shaders/text.frag" }, mdiDefines);
+		m_mapMDIShaders["shadow"] = m_Shaders.AddProgramFromExts({ "shaders/shadow.vert", "shaders/shadow.frag" }, mdiDefines);
+
+		m_mapMDIOITShaders["lighting"] = m_Shaders.AddProgramFromExts({ "shaders/lighting.vert", "shaders/lighting.frag" }, RENDERER_OIT_SHADER_DEFINES + mdiDefines);
+		m_mapMDIOITShaders["flat"] = m_Shaders.AddProgramFromExts({ "shaders/flat.vert", "shaders/flat.frag" }, RENDERER_OIT_SHADER_DEFINES + mdiDefines);
+		m_mapMDIOITShaders["grid"] = m_Shaders.AddProgramFromExts({ "shaders/lighting.vert", "shaders/gridlighting.frag" }, RENDERER_OIT_SHADER_DEFINES + mdiDefines);
+		m_mapMDIOITShaders["gridflat"] = m_Shaders.AddProgramFromExts({ "shaders/lighting.vert", "shaders/gridflat.frag" }, RENDERER_OIT_SHADER_DEFINES + mdiDefines);
+		m_mapMDIOITShaders["rings"] = m_Shaders.AddProgramFromExts({ "shaders/lighting.vert", "shaders/ringslighting.frag" }, RENDERER_OIT_SHADER_DEFINES + mdiDefines);
+		m_mapMDIOITShaders["ringsflat"] = m_Shaders.AddProgramFromExts({ "shaders/lighting.vert", "shaders/ringsflat.frag" }, RENDERER_OIT_SHADER_DEFINES + mdiDefines);
+		m_mapMDIOITShaders["text"] = m_Shaders.AddProgramFromExts({ "shaders/text.vert", "shaders/text.frag" }, RENDERER_OIT_SHADER_DEFINES + mdiDefines);
+		m_mapMDIOITShaders["shadow"] = m_Shaders.AddProgramFromExts({ "shaders/shadow.vert", "shaders/shadow.frag" }, RENDERER_OIT_SHADER_DEFINES + mdiDefines);
+	}
 
 	m_pLighting->addShaderToUpdate(m_mapShaders["lighting"]);
 	m_pLighting->addShaderToUpdate(m_mapShaders["lightingWireframe"]);
 	m_pLighting->addShaderToUpdate(m_mapShaders["grid"]);
 	m_pLighting->addShaderToUpdate(m_mapShaders["rings"]);
 	m_pLighting->addShaderToUpdate(m_mapShaders["shadow"]);
+	m_pLighting->addShaderToUpdate(m_mapOITShaders["lighting"]);
+	m_pLighting->addShaderToUpdate(m_mapOITShaders["lightingWireframe"]);
+	m_pLighting->addShaderToUpdate(m_mapOITShaders["grid"]);
+	m_pLighting->addShaderToUpdate(m_mapOITShaders["rings"]);
+	m_pLighting->addShaderToUpdate(m_mapOITShaders["shadow"]);
+
+	for (auto const &variants : { &m_mapMDIShaders, &m_mapMDIOITShaders })
+		for (auto const &name : { "lighting", "grid", "rings", "shadow" })
+			if (variants->count(name))
+				m_pLighting->addShaderToUpdate(variants->at(name));
 }
 
 void Renderer::setupTextures()
@@ -365,6 +444,9 @@ bool Renderer::CreateFrameBuffer(int nWidth, int nHeight, FramebufferDesc &frame
 	glTextureParameteri(framebufferDesc.m_nResolveTextureId, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTextureParameteri(framebufferDesc.m_nResolveTextureId, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 
+	framebufferDesc.m_nWidth = nWidth;
+	framebufferDesc.m_nHeight = nHeight;
+
 	// check FBO statuses
 	GLenum renderStatus = glCheckNamedFramebufferStatus(framebufferDesc.m_nRenderFramebufferId, GL_FRAMEBUFFER);
 	GLenum resolveStatus = glCheckNamedFramebufferStatus(framebufferDesc.m_nResolveFramebufferId, GL_FRAMEBUFFER);
@@ -374,6 +456,39 @@ bool Renderer::CreateFrameBuffer(int nWidth, int nHeight, FramebufferDesc &frame
 	return true;
 }
 
+//-----------------------------------------------------------------------------
+// Purpose: Allocates the weighted-blended OIT targets the first time a
+//          framebuffer needs them; 16x RGBA16F + R16F is too much to carry
+//          for scenes that never leave sorted transparency
+//-----------------------------------------------------------------------------
+bool Renderer::createOITTargets(FramebufferDesc &framebufferDesc)
+{
+	if (framebufferDesc.m_bOITAllocated)
+		return framebufferDesc.m_bOITComplete;
+
+	int nWidth = framebufferDesc.m_nWidth;
+	int nHeight = framebufferDesc.m_nHeight;
+
+	// Weighted-blended OIT targets share the render framebuffer's sample count and depth buffer
+	glTextureStorage2DMultisample(framebufferDesc.m_nOITAccumTextureId, 16, GL_RGBA16F, nWidth, nHeight, true);
+	glTextureStorage2DMultisample(framebufferDesc.m_nOITRevealageTextureId, 16, GL_R16F, nWidth, nHeight, true);
+
+	glNamedFramebufferRenderbuffer(framebufferDesc.m_nOITFramebufferId, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, framebufferDesc.m_nDepthBufferId);
+	glNamedFramebufferTexture(framebufferDesc.m_nOITFramebufferId, GL_COLOR_ATTACHMENT0 + COLOR_OUTPUT_LOCATION, framebufferDesc.m_nOITAccumTextureId, 0);
+	glNamedFramebufferTexture(framebufferDesc.m_nOITFramebufferId, GL_COLOR_ATTACHMENT0 + OIT_REVEALAGE_OUTPUT_LOCATION, framebufferDesc.m_nOITRevealageTextureId, 0);
+
+	GLenum oitDrawBuffers[] = { GL_COLOR_ATTACHMENT0 + COLOR_OUTPUT_LOCATION, GL_COLOR_ATTACHMENT0 + OIT_REVEALAGE_OUTPUT_LOCATION };
+	glNamedFramebufferDrawBuffers(framebufferDesc.m_nOITFramebufferId, _countof(oitDrawBuffers), oitDrawBuffers);
+
+	framebufferDesc.m_bOITAllocated = true;
+	framebufferDesc.m_bOITComplete = glCheckNamedFramebufferStatus(framebufferDesc.m_nOITFramebufferId, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+	if (!framebufferDesc.m_bOITComplete)
+		printf("Error: could not create the OIT framebuffer; transparency stays sorted\n");
+
+	return framebufferDesc.m_bOITComplete;
+}
+
 bool Renderer::snapshotFrameBufferToTGA(GLuint framebufferID, glm::ivec4 rect, std::string filename, bool append_timestamp, bool silent)
 {
 	glBindFramebuffer(GL_FRAMEBUFFER, framebufferID);
@@ -456,8 +571,8 @@ bool Renderer::snapshotFrameBufferToTGA(GLuint framebufferID, glm::ivec4 rect, s
 
 	unsigned char TGAheader[12] = { 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 	unsigned char header[6] = { 
-		rect[2] % 256, rect[2] / 256,
-		rect[3] % 256, rect[3] / 256,
+		static_cast<unsigned char>(rect[2] % 256), static_cast<unsigned char>(rect[2] / 256),
+		static_cast<unsigned char>(rect[3] % 256), static_cast<unsigned char>(rect[3] / 256),
 		24, 0 
 	};
 
@@ -508,19 +623,42 @@ void Renderer::RenderFrame(SceneViewInfo *sceneView3DInfo, SceneViewInfo *sceneV
 
 		m_pLighting->update(sceneView3DInfo->view);
 
+		m_Culler.setView(sceneView3DInfo->projection * sceneView3DInfo->view, sceneView3DInfo->projection[1][1] * sceneView3DInfo->m_nRenderHeight * 0.5f, RENDERER_CULL_MIN_PIXELS);
+
 		// Opaque objects first while depth buffer writing enabled
-		processRenderQueue(m_vStaticRenderQueue_Opaque);
-		processRenderQueue(m_vDynamicRenderQueue_Opaque);
+		{
+			PROFILE_GPU_SCOPE("opaque");
+			processRenderQueue(m_vStaticRenderQueue_Opaque, true);
+			processRenderQueue(m_vDynamicRenderQueue_Opaque, true);
+		}
+
+		if (!m_vPointCloudQueue.empty())
+		{
+			PROFILE_GPU_SCOPE("points");
+			renderPointClouds(sceneView3DInfo);
+		}
 
-		if (m_vTransparentRenderQueue.size() > 0 || sceneViewUIInfo)
+		if (m_vStaticRenderQueue_Transparency.size() + m_vDynamicRenderQueue_Transparency.size() > 0 || sceneViewUIInfo)
 		{
 			glEnable(GL_BLEND);
+			{
+				PROFILE_GPU_SCOPE("transparent");
+				if (usingOIT() && createOITTargets(*frameBuffer))
+					renderTransparencyOIT(frameBuffer);
+				else
+				{
+					glDisable(GL_DEPTH_TEST);
+					processTransparentRenderQueue();
+				}
+			}
 			glDisable(GL_DEPTH_TEST);
-			processRenderQueue(m_vTransparentRenderQueue);
 
 			// UI ELEMENTS
 			if (sceneViewUIInfo)
+			{
+				PROFILE_GPU_SCOPE("ui");
 				RenderUI(sceneViewUIInfo, frameBuffer);
+			}
 			
 			glEnable(GL_DEPTH_TEST);
 			glDisable(GL_BLEND);
@@ -532,6 +670,7 @@ void Renderer::RenderFrame(SceneViewInfo *sceneView3DInfo, SceneViewInfo *sceneV
 	glDisable(GL_MULTISAMPLE);
 
 	// Blit Framebuffer to resolve framebuffer
+	PROFILE_GPU_SCOPE("resolve");
 	glBlitNamedFramebuffer(
 		frameBuffer->m_nRenderFramebufferId,
 		frameBuffer->m_nResolveFramebufferId,
@@ -665,377 +804,1156 @@ void Renderer::RenderUI(SceneViewInfo * sceneViewInfo, FramebufferDesc * frameBu
 	processRenderQueue(m_vUIRenderQueue);
 }
 
-void Renderer::processRenderQueue(std::vector<RendererSubmission> &renderQueue)
+void Renderer::processRenderQueue(std::vector<RendererSubmission> &renderQueue, bool cull)
 {
-	for (auto i : renderQueue)
+	const unsigned char* visible = NULL;
+
+	// the culler's view is set per eye in RenderFrame
+	if (cull && m_bCulling && !renderQueue.empty())
 	{
-		if (m_mapShaders[i.shaderName] && *m_mapShaders[i.shaderName])
-		{
-			glUseProgram(*m_mapShaders[i.shaderName]);
-			glUniformMatrix4fv(MODEL_MAT_UNIFORM_LOCATION, 1, GL_FALSE, glm::value_ptr(i.modelToWorldTransform));
+		m_Culler.clear();
+		for (auto const &rs : renderQueue)
+			m_Culler.add(rs.boundingSphere, rs.modelToWorldTransform);
 
-			// handle diffuse solid color
-			glUniform4fv(DIFFUSE_COLOR_UNIFORM_LOCATION, 1, glm::value_ptr(i.diffuseColor));
+		m_Culler.cull();
+		visible = m_Culler.visibility();
 
-			// handle specular solid color
-			glUniform4fv(SPECULAR_COLOR_UNIFORM_LOCATION, 1, glm::value_ptr(i.specularColor));
-	
-			// Handle diffuse texture, if any
-			glActiveTexture(GL_TEXTURE0 + DIFFUSE_TEXTURE_BINDING);
-			glBindTextureUnit(DIFFUSE_TEXTURE_BINDING, m_mapTextures[i.diffuseTexName]->getTexture());
-			
-			// Handle specular texture, if any
-			glActiveTexture(GL_TEXTURE0 + SPECULAR_TEXTURE_BINDING);
-			glBindTextureUnit(SPECULAR_TEXTURE_BINDING, m_mapTextures[i.specularTexName]->getTexture());
+		m_RenderStats.culledOutside += m_Culler.culledOutside();
+		m_RenderStats.culledTooSmall += m_Culler.culledTooSmall();
+	}
 
-			if (i.specularExponent > 0.f)
-				glUniform1f(MATERIAL_SHININESS_UNIFORM_LOCATION, i.specularExponent);
+	m_vDrawList.clear();
 
-			glFrontFace(i.vertWindingOrder);
+	for (size_t n = 0u; n < renderQueue.size(); ++n)
+	{
+		if (visible && !visible[n])
+			continue;
 
-			glBindVertexArray(i.VAO);
-			glDrawElements(i.glPrimitiveType, i.vertCount, i.indexType, 0);
-			glBindVertexArray(0);
+		if (renderQueue[n].lodChain >= 0)
+			selectLevelOfDetail(renderQueue[n]);
+
+		// streamed meshes draw whatever has been uploaded so far
+		if (renderQueue[n].stream >= 0)
+		{
+			renderQueue[n].vertCount = m_MeshStreamer.getIndexCount(renderQueue[n].stream);
+			if (renderQueue[n].vertCount == 0)
+				continue;
 		}
+
+		m_vDrawList.push_back(&renderQueue[n]);
 	}
+
+	processDrawList();
 }
 
-bool Renderer::sortByViewDistance(RendererSubmission const & rsLHS, RendererSubmission const & rsRHS, glm::vec3 const & HMDPos)
+void Renderer::processTransparentRenderQueue()
 {
-	glm::vec3 lhsPos = rsLHS.transparencySortPosition.w == -1.f ? glm::vec3(rsLHS.modelToWorldTransform[3]) : glm::vec3(rsLHS.transparencySortPosition);
-	glm::vec3 rhsPos = rsRHS.transparencySortPosition.w == -1.f ? glm::vec3(rsRHS.modelToWorldTransform[3]) : glm::vec3(rsRHS.transparencySortPosition);
+	size_t count = m_vStaticRenderQueue_Transparency.size() + m_vDynamicRenderQueue_Transparency.size();
 
-	return glm::length2(lhsPos - HMDPos) > glm::length2(rhsPos - HMDPos);
-}
+	if (count == 0u)
+		return;
 
+	// anything queued after sortTransparentObjects() invalidates the order, so draw in submission order
+	const uint32_t* order = m_TransparencySorter.size() == count ? m_TransparencySorter.order() : NULL;
 
-void Renderer::setupPrimitives()
-{
-	generateIcosphere(4);
-	generateCylinder(32);
-	generateTorus(1.f, 0.05f, 32, 8);
-	generatePlane();
-	generateCube();
-	generateBBox();
-}
+	const unsigned char* visible = NULL;
 
+	if (m_bCulling)
+	{
+		m_Culler.clear();
+		for (size_t n = 0u; n < count; ++n)
+		{
+			RendererSubmission &rs = getTransparentSubmission(order ? order[n] : static_cast<uint32_t>(n));
+			m_Culler.add(rs.boundingSphere, rs.modelToWorldTransform);
+		}
 
-//-----------------------------------------------------------------------------
-// Purpose:
-//-----------------------------------------------------------------------------
-void Renderer::setupFullscreenQuad()
-{
-	glm::vec2 vVerts[4];
+		m_Culler.cull();
+		visible = m_Culler.visibility();
 
-	// left eye verts	
-	vVerts[0] = glm::vec2(-1, -1);
-	vVerts[1] = glm::vec2(1, -1);
-	vVerts[2] = glm::vec2(-1, 1);
-	vVerts[3] = glm::vec2(1, 1);
+		m_RenderStats.culledOutside += m_Culler.culledOutside();
+		m_RenderStats.culledTooSmall += m_Culler.culledTooSmall();
+	}
 
-	// right eye verts
-	//vVerts.push_back(VertexDataWindow(glm::vec2(0, -1), glm::vec2(0, 0)));
-	//vVerts.push_back(VertexDataWindow(glm::vec2(1, -1), glm::vec2(1, 0)));
-	//vVerts.push_back(VertexDataWindow(glm::vec2(0, 1), glm::vec2(0, 1)));
-	//vVerts.push_back(VertexDataWindow(glm::vec2(1, 1), glm::vec2(1, 1)));
+	m_vDrawList.clear();
 
-	GLushort vIndices[] = { 0, 1, 3,   0, 3, 2 };//,   4, 5, 7,   4, 7, 6 };
-	m_uiCompanionWindowVertCount = _countof(vIndices);
+	for (size_t n = 0u; n < count; ++n)
+	{
+		if (visible && !visible[n])
+			continue;
 
-	// Generate/allocate and fill vertex buffer object
-	glCreateBuffers(1, &m_glFullscreenTextureVBO);
-	glNamedBufferStorage(m_glFullscreenTextureVBO, sizeof(vVerts) * sizeof(glm::vec2), &vVerts[0], GL_NONE);
+		RendererSubmission &rs = getTransparentSubmission(order ? order[n] : static_cast<uint32_t>(n));
 
-	// Generate/allocate and fill index buffer object
-	glCreateBuffers(1, &m_glFullscreenTextureEBO);
-	glNamedBufferStorage(m_glFullscreenTextureEBO, m_uiCompanionWindowVertCount * sizeof(GLushort), &vIndices[0], GL_NONE);
+		if (rs.lodChain >= 0)
+			selectLevelOfDetail(rs);
 
-	// Define our Vertex Attribute Object
-	glGenVertexArrays(1, &m_glFullscreenTextureVAO);
-	glBindVertexArray(m_glFullscreenTextureVAO);
+		if (rs.stream >= 0)
+		{
+			rs.vertCount = m_MeshStreamer.getIndexCount(rs.stream);
+			if (rs.vertCount == 0)
+				continue;
+		}
 
-		glBindBuffer(GL_ARRAY_BUFFER, m_glFullscreenTextureVBO);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_glFullscreenTextureEBO);
+		m_vDrawList.push_back(&rs);
+	}
 
-		glEnableVertexAttribArray(POSITION_ATTRIB_LOCATION);
-		glVertexAttribPointer(POSITION_ATTRIB_LOCATION, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void *)0);
+	processDrawList();
+}
 
-	glBindVertexArray(0);
+// Moves a primitive submission along its level of detail chain for the current view. The level
+// only changes once the projected tessellation error is RENDERER_LOD_HYSTERESIS past the
+// budget, so the two eyes, whose projected sizes differ slightly, draw the same level.
+void Renderer::selectLevelOfDetail(RendererSubmission & rs)
+{
+	std::vector<PrimitiveMesh> const &lods = m_vPrimitiveLODs[rs.lodChain];
+	int last = static_cast<int>(lods.size()) - 1;
+	int level = 0;
 
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-}
+	if (m_bLevelOfDetail)
+	{
+		float radiusPixels = m_Culler.projectedRadius(rs.boundingSphere, rs.modelToWorldTransform);
 
+		if (rs.lodLevel < 0)
+		{
+			while (level < last && lods[level + 1].lodError * radiusPixels <= RENDERER_LOD_ERROR_PIXELS)
+				++level;
+		}
+		else
+		{
+			level = std::min(rs.lodLevel, last);
 
-void Renderer::generateIcosphere(int recursionLevel)
-{
-	Icosphere ico(recursionLevel);
+			while (level > 0 && lods[level].lodError * radiusPixels > RENDERER_LOD_ERROR_PIXELS * (1.f + RENDERER_LOD_HYSTERESIS))
+				--level;
+			while (level < last && lods[level + 1].lodError * radiusPixels < RENDERER_LOD_ERROR_PIXELS * (1.f - RENDERER_LOD_HYSTERESIS))
+				++level;
+		}
+	}
 
-	m_glIcosphereVAO = ico.getVAO();
+	if (level > 0)
+		m_RenderStats.coarserLODs++;
 
-	m_mapPrimitives["icosphere"] = m_mapPrimitives["inverse_icosphere"] = std::make_pair(m_glIcosphereVAO, ico.getIndices().size());
+	if (level == rs.lodLevel)
+		return;
+
+	rs.lodLevel = level;
+	rs.vertCount = lods[level].indexCount;
+	rs.firstIndex = lods[level].firstIndex;
+	rs.baseVertex = lods[level].baseVertex;
 }
 
+void Renderer::processDrawList()
+{
+	for (auto rs : m_vDrawList)
+		if (rs->VAO == m_glPrimitiveVAO)
+			m_RenderStats.primitiveVertexBytes += rs->vertCount * getPrimitiveVertexSize();
+
+	if (getMultiDrawIndirect())
+		processMultiDrawIndirect();
+	else
+		for (auto rs : m_vDrawList)
+			processRenderSubmission(*rs);
+
+	unbindRenderQueueVAO();
+}
 
-void Renderer::generateTorus(float coreRadius, float meridianRadius, int numCoreSegments, int numMeridianSegments)
+void Renderer::processMultiDrawIndirect()
 {
-	int nVerts = numCoreSegments * numMeridianSegments;
+	if (m_vDrawList.empty())
+		return;
 
-	std::vector<PrimVert> verts;
-	std::vector<GLushort> inds;
+	m_vDrawData.clear();
+	m_vDrawCommands.clear();
 
-	for (int i = 0; i < numCoreSegments; i++)
-		for (int j = 0; j < numMeridianSegments; j++)
+	bool bindless = getBindlessTextures();
+
+	// one command and one draw data entry per submission, at the same index
+	for (auto rs : m_vDrawList)
+	{
+		DrawData dd = DrawData();
+		dd.m4Model = rs->modelToWorldTransform;
+		dd.v4DiffuseColor = rs->diffuseColor;
+		dd.v4SpecularColor = rs->specularColor;
+		dd.v4TexCoordTransform = rs->texCoordTransform;
+		dd.fShininess = rs->specularExponent;
+
+		if (bindless)
 		{
-			float u = i / (numCoreSegments - 1.f);
-			float v = j / (numMeridianSegments - 1.f);
-			float theta = u * 2.f * glm::pi<float>();
-			float rho = v * 2.f * glm::pi<float>();
-			float x = cos(theta) * (coreRadius + meridianRadius*cos(rho));
-			float y = sin(theta) * (coreRadius + meridianRadius*cos(rho));
-			float z = meridianRadius*sin(rho);
-			float nx = cos(theta)*cos(rho);
-			float ny = sin(theta)*cos(rho);
-			float nz = sin(rho);
-			float s = u;
-			float t = v;
-
-			PrimVert currentVert = { glm::vec3(x, y, z), glm::vec3(nx, ny, nz), glm::vec4(1.f), glm::vec2(s, t) };
-			verts.push_back(currentVert);
-
-			GLushort uvInd = i * numMeridianSegments + j;
-			GLushort uvpInd = i * numMeridianSegments + (j + 1) % numMeridianSegments;
-			GLushort umvInd = (((i - 1) % numCoreSegments + numCoreSegments) % numCoreSegments) * numMeridianSegments + j; // true modulo (not C++ remainder operand %) for negative wraparound
-			GLushort umvpInd = (((i - 1) % numCoreSegments + numCoreSegments) % numCoreSegments) * numMeridianSegments + (j + 1) % numMeridianSegments;
-
-			inds.push_back(uvInd);   // (u    , v)
-			inds.push_back(uvpInd);  // (u    , v + 1)
-			inds.push_back(umvInd);  // (u - 1, v)
-
-			inds.push_back(umvInd);  // (u - 1, v)
-			inds.push_back(uvpInd);  // (u    , v + 1)
-			inds.push_back(umvpInd); // (u - 1, v + 1)
+			dd.diffuseTexHandle = m_mapTextures[rs->diffuseTexName]->getHandle();
+			dd.specularTexHandle = m_mapTextures[rs->specularTexName]->getHandle();
 		}
 
-	glGenVertexArrays(1, &m_glTorusVAO);
-	glGenBuffers(1, &m_glTorusVBO);
-	glGenBuffers(1, &m_glTorusEBO);
+		m_vDrawData.push_back(dd);
 
-	glBindVertexArray(this->m_glTorusVAO);
-		// Load data into vertex buffers
-		glBindBuffer(GL_ARRAY_BUFFER, this->m_glTorusVBO);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->m_glTorusEBO);
+		DrawElementsIndirectCommand cmd;
+		cmd.count = rs->vertCount;
+		cmd.instanceCount = 1u;
+		cmd.firstIndex = rs->firstIndex;
+		cmd.baseVertex = rs->baseVertex;
+		cmd.baseInstance = 0u;
+		m_vDrawCommands.push_back(cmd);
+	}
 
-		// Set the vertex attribute pointers
-		glEnableVertexAttribArray(POSITION_ATTRIB_LOCATION);
-		glVertexAttribPointer(POSITION_ATTRIB_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(PrimVert), (GLvoid*) offsetof(PrimVert, p));
-		glEnableVertexAttribArray(NORMAL_ATTRIB_LOCATION);
-		glVertexAttribPointer(NORMAL_ATTRIB_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(PrimVert), (GLvoid*) offsetof(PrimVert, n));
-		glEnableVertexAttribArray(COLOR_ATTRIB_LOCATION);
-		glVertexAttribPointer(COLOR_ATTRIB_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(PrimVert), (GLvoid*)offsetof(PrimVert, c));
-		glEnableVertexAttribArray(TEXCOORD_ATTRIB_LOCATION);
-		glVertexAttribPointer(TEXCOORD_ATTRIB_LOCATION, 2, GL_FLOAT, GL_FALSE, sizeof(PrimVert), (GLvoid*)offsetof(PrimVert, t));
-	glBindVertexArray(0);
+	glNamedBufferData(m_glDrawDataSSBO, m_vDrawData.size() * sizeof(DrawData), m_vDrawData.data(), GL_STREAM_DRAW);
+	glNamedBufferData(m_glDrawCommandBuffer, m_vDrawCommands.size() * sizeof(DrawElementsIndirectCommand), m_vDrawCommands.data(), GL_STREAM_DRAW);
 
-	// Allocate and store buffer data and indices
-	glNamedBufferStorage(m_glTorusVBO, verts.size() * sizeof(PrimVert), &verts[0], GL_NONE);
-	glNamedBufferStorage(m_glTorusEBO, inds.size() * sizeof(GLushort), &inds[0], GL_NONE);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_STORAGE_BUFFER_BINDING, m_glDrawDataSSBO);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_glDrawCommandBuffer);
 
-	m_mapPrimitives["torus"] = std::make_pair(m_glTorusVAO, inds.size());
-}
+	// runs of consecutive submissions sharing program, textures (unless bindless), winding and
+	// VAO become one draw, so order (and back-to-front sorting) is preserved
+	for (size_t first = 0u; first < m_vDrawList.size();)
+	{
+		RendererSubmission &rs = *m_vDrawList[first];
+		GLuint* program = getSubmissionProgram(rs, true);
 
-void Renderer::generateCylinder(int numSegments)
-{
-	std::vector<PrimVert> verts;
-	std::vector<GLushort> inds;
+		if (!program || !*program)
+		{
+			processRenderSubmission(rs);
+			++first;
+			continue;
+		}
 
-	// Front endcap
-	verts.push_back(PrimVert({ glm::vec3(0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec4(1.f), glm::vec2(0.5f, 0.5f) }));
-	for (float i = 0; i < numSegments; ++i)
-	{
-		float angle = ((float)i / (float)(numSegments - 1)) * glm::two_pi<float>();
-		verts.push_back(PrimVert({ glm::vec3(sin(angle), cos(angle), 0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec4(1.f), (glm::vec2(sin(angle), cos(angle)) + 1.f) / 2.f }));
+		size_t last = first + 1u;
+		while (last < m_vDrawList.size() && canShareMultiDraw(rs, *m_vDrawList[last]))
+			++last;
 
-		if (i > 0)
+		m_RenderStats.submissions += static_cast<unsigned int>(last - first);
+		m_RenderStats.programBinds++;
+		m_RenderStats.uniformUpdates++;
+		m_RenderStats.drawCalls++;
+
+		glUseProgram(*program);
+		glUniform1i(DRAW_OFFSET_UNIFORM_LOCATION, static_cast<GLint>(first));
+
+		if (!bindless)
 		{
-			inds.push_back(0);
-			inds.push_back(verts.size() - 2);
-			inds.push_back(verts.size() - 1);
+			m_RenderStats.textureBinds += 2u;
+			glBindTextureUnit(DIFFUSE_TEXTURE_BINDING, m_mapTextures[rs.diffuseTexName]->getTexture());
+			glBindTextureUnit(SPECULAR_TEXTURE_BINDING, m_mapTextures[rs.specularTexName]->getTexture());
 		}
-	}
-	inds.push_back(0);
-	inds.push_back(verts.size() - 1);
-	inds.push_back(1);
 
-	// Back endcap
-	verts.push_back(PrimVert({ glm::vec3(0.f, 0.f, 1.f), glm::vec3(0.f, 0.f, 1.f), glm::vec4(1.f), glm::vec2(0.5f, 0.5f) }));
-	for (float i = 0; i < numSegments; ++i)
-	{
-		float angle = ((float)i / (float)(numSegments - 1)) * glm::two_pi<float>();
-		verts.push_back(PrimVert({ glm::vec3(sin(angle), cos(angle), 1.f), glm::vec3(0.f, 0.f, 1.f), glm::vec4(1.f), (glm::vec2(sin(angle), cos(angle)) + 1.f) / 2.f }));
+		glFrontFace(rs.vertWindingOrder);
 
-		if (i > 0)
+		if (rs.VAO != m_glBoundVAO)
 		{
-			inds.push_back(verts.size() - (i + 2)); // ctr pt of endcap
-			inds.push_back(verts.size() - 1);
-			inds.push_back(verts.size() - 2);
+			m_RenderStats.vertexArrayBinds++;
+			glBindVertexArray(rs.VAO);
+			m_glBoundVAO = rs.VAO;
 		}
+
+		glMultiDrawElementsIndirect(rs.glPrimitiveType, rs.indexType, (GLvoid*)(first * sizeof(DrawElementsIndirectCommand)), static_cast<GLsizei>(last - first), 0);
+
+		first = last;
 	}
-	inds.push_back(verts.size() - (numSegments + 1));
-	inds.push_back(verts.size() - (numSegments));
-	inds.push_back(verts.size() - 1);
 
-	// Shaft
-	for (float i = 0; i < numSegments; ++i)
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void Renderer::unbindRenderQueueVAO()
+{
+	if (m_glBoundVAO != 0u)
 	{
-		float angle = ((float)i / (float)(numSegments - 1)) * glm::two_pi<float>();
-		verts.push_back(PrimVert({ glm::vec3(sin(angle), cos(angle), 0.f), glm::vec3(sin(angle), cos(angle), 0.f), glm::vec4(1.f), glm::vec2((float)i / (float)(numSegments - 1), 0.f) }));
+		glBindVertexArray(0);
+		m_glBoundVAO = 0u;
+	}
+}
 
-		verts.push_back(PrimVert({ glm::vec3(sin(angle), cos(angle), 1.f), glm::vec3(sin(angle), cos(angle), 0.f), glm::vec4(1.f), glm::vec2((float)i / (float)(numSegments - 1), 1.f) }));
+void Renderer::renderTransparencyOIT(FramebufferDesc * frameBuffer)
+{
+	GLuint* composite = m_mapShaders["oitcomposite"];
 
-		if (i > 0)
-		{
-			inds.push_back(verts.size() - 4);
-			inds.push_back(verts.size() - 3);
-			inds.push_back(verts.size() - 2);
+	if (composite == NULL || *composite == 0 || m_vStaticRenderQueue_Transparency.size() + m_vDynamicRenderQueue_Transparency.size() == 0u)
+		return;
 
-			inds.push_back(verts.size() - 2);
-			inds.push_back(verts.size() - 3);
-			inds.push_back(verts.size() - 1);
-		}
-	}
-	inds.push_back(verts.size() - 2);
-	inds.push_back(verts.size() - numSegments * 2);
-	inds.push_back(verts.size() - 1);
+	const GLfloat clearAccum[4] = { 0.f, 0.f, 0.f, 0.f };
+	const GLfloat clearRevealage[4] = { 1.f, 0.f, 0.f, 0.f };
 
-	inds.push_back(verts.size() - numSegments * 2);
-	inds.push_back(verts.size() - numSegments * 2 + 1);
-	inds.push_back(verts.size() - 1);
+	glClearNamedFramebufferfv(frameBuffer->m_nOITFramebufferId, GL_COLOR, COLOR_OUTPUT_LOCATION, clearAccum);
+	glClearNamedFramebufferfv(frameBuffer->m_nOITFramebufferId, GL_COLOR, OIT_REVEALAGE_OUTPUT_LOCATION, clearRevealage);
 
-	glGenVertexArrays(1, &m_glCylinderVAO);
-	glGenBuffers(1, &m_glCylinderVBO);
-	glGenBuffers(1, &m_glCylinderEBO);
+	// accumulate against the opaque depth without writing it
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer->m_nOITFramebufferId);
+	glEnable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+	glBlendFunci(COLOR_OUTPUT_LOCATION, GL_ONE, GL_ONE);
+	glBlendFunci(OIT_REVEALAGE_OUTPUT_LOCATION, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
 
-	// Setup VAO
-	glBindVertexArray(this->m_glCylinderVAO);
-		// Load data into vertex buffers
-		glBindBuffer(GL_ARRAY_BUFFER, this->m_glCylinderVBO);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->m_glCylinderEBO);
+	m_bOITPass = true;
+	processTransparentRenderQueue();
+	m_bOITPass = false;
 
-		// Set the vertex attribute pointers
-		glEnableVertexAttribArray(POSITION_ATTRIB_LOCATION);
-		glVertexAttribPointer(POSITION_ATTRIB_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(PrimVert), (GLvoid*) offsetof(PrimVert, p));
-		glEnableVertexAttribArray(NORMAL_ATTRIB_LOCATION);
-		glVertexAttribPointer(NORMAL_ATTRIB_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(PrimVert), (GLvoid*) offsetof(PrimVert, n));
-		glEnableVertexAttribArray(COLOR_ATTRIB_LOCATION);
-		glVertexAttribPointer(COLOR_ATTRIB_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(PrimVert), (GLvoid*) offsetof(PrimVert, c));
-		glEnableVertexAttribArray(TEXCOORD_ATTRIB_LOCATION);
-		glVertexAttribPointer(TEXCOORD_ATTRIB_LOCATION, 2, GL_FLOAT, GL_FALSE, sizeof(PrimVert), (GLvoid*) offsetof(PrimVert, t));
+	glDepthMask(GL_TRUE);
+
+	// composite over the opaque image
+	glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer->m_nRenderFramebufferId);
+	glDisable(GL_DEPTH_TEST);
+	glBlendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA);
+
+	glUseProgram(*composite);
+	glBindTextureUnit(DIFFUSE_TEXTURE_BINDING, frameBuffer->m_nOITAccumTextureId);
+	glBindTextureUnit(SPECULAR_TEXTURE_BINDING, frameBuffer->m_nOITRevealageTextureId);
+	glFrontFace(GL_CCW);
+	glBindVertexArray(m_glFullscreenTextureVAO);
+	glDrawElements(GL_TRIANGLES, m_uiCompanionWindowVertCount, GL_UNSIGNED_SHORT, 0);
 	glBindVertexArray(0);
 
-	// Allocate buffer data
-	glNamedBufferStorage(m_glCylinderVBO, verts.size() * sizeof(PrimVert), &verts[0], GL_NONE);
-	// Element array buffer
-	glNamedBufferStorage(m_glCylinderEBO, inds.size() * sizeof(GLushort), &inds[0], GL_NONE);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
 
-	m_mapPrimitives["cylinder"] = std::make_pair(m_glCylinderVAO, inds.size());
+bool Renderer::usingOIT() const
+{
+	switch (m_eTransparencyMode)
+	{
+	case TRANSPARENCY_WEIGHTED_BLENDED:
+		return true;
+	case TRANSPARENCY_AUTO:
+		return m_vStaticRenderQueue_Transparency.size() + m_vDynamicRenderQueue_Transparency.size() >= RENDERER_OIT_AUTO_THRESHOLD;
+	default:
+		return false;
+	}
 }
 
-void Renderer::generatePlane()
+const char * Renderer::transparencyModeName(TransparencyMode mode)
 {
-	std::vector<PrimVert> verts;
-	std::vector<GLushort> inds;
+	switch (mode)
+	{
+	case TRANSPARENCY_SORTED:
+		return "sorted";
+	case TRANSPARENCY_WEIGHTED_BLENDED:
+		return "weighted-blended OIT";
+	case TRANSPARENCY_AUTO:
+		return "auto";
+	default:
+		return "unknown";
+	}
+}
 
-	// Front face
-	verts.push_back(PrimVert({ glm::vec3(-0.5f, -0.5f, 0.f), glm::vec3(0.f, 0.f, 1.f), glm::vec4(1.f), glm::vec2(0.f, 1.f) }));
-	verts.push_back(PrimVert({ glm::vec3(0.5f, -0.5f, 0.f), glm::vec3(0.f, 0.f, 1.f), glm::vec4(1.f), glm::vec2(1.f, 1.f) }));
-	verts.push_back(PrimVert({ glm::vec3(0.5f, 0.5f, 0.f), glm::vec3(0.f, 0.f, 1.f), glm::vec4(1.f), glm::vec2(1.f, 0.f) }));
-	verts.push_back(PrimVert({ glm::vec3(-0.5f, 0.5f, 0.f), glm::vec3(0.f, 0.f, 1.f),	glm::vec4(1.f), glm::vec2(0.f, 0.f) }));
+void Renderer::processRenderSubmission(RendererSubmission &i)
+{
+	m_RenderStats.submissions++;
 
-	inds.push_back(0);
-	inds.push_back(1);
-	inds.push_back(2);
+	GLuint* program = getSubmissionProgram(i, false);
 
-	inds.push_back(2);
-	inds.push_back(3);
-	inds.push_back(0);
+	if (program && *program)
+	{
+		m_RenderStats.programBinds++;
+		m_RenderStats.uniformUpdates += i.specularExponent > 0.f ? 5u : 4u;
+		m_RenderStats.textureBinds += 2u;
+		m_RenderStats.drawCalls++;
 
-	// Back face
-	verts.push_back(PrimVert({ glm::vec3(0.5f, -0.5f, 0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec4(1.f), glm::vec2(1.f, 1.f) }));
-	verts.push_back(PrimVert({ glm::vec3(-0.5f, -0.5f, 0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec4(1.f), glm::vec2(0.f, 1.f) }));
-	verts.push_back(PrimVert({ glm::vec3(-0.5f, 0.5f, 0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec4(1.f), glm::vec2(0.f, 0.f) }));
-	verts.push_back(PrimVert({ glm::vec3(0.5f, 0.5f, 0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec4(1.f), glm::vec2(1.f, 0.f) }));
+		glUseProgram(*program);
+		glUniformMatrix4fv(MODEL_MAT_UNIFORM_LOCATION, 1, GL_FALSE, glm::value_ptr(i.modelToWorldTransform));
 
-	inds.push_back(4);
-	inds.push_back(5);
-	inds.push_back(6);
+		// handle diffuse solid color
+		glUniform4fv(DIFFUSE_COLOR_UNIFORM_LOCATION, 1, glm::value_ptr(i.diffuseColor));
 
-	inds.push_back(6);
-	inds.push_back(7);
-	inds.push_back(4);
+		// handle specular solid color
+		glUniform4fv(SPECULAR_COLOR_UNIFORM_LOCATION, 1, glm::value_ptr(i.specularColor));
 
-	glGenVertexArrays(1, &m_glPlaneVAO);
-	glGenBuffers(1, &m_glPlaneVBO);
-	glGenBuffers(1, &m_glPlaneEBO);
+		glUniform4fv(TEXCOORD_TRANSFORM_UNIFORM_LOCATION, 1, glm::value_ptr(i.texCoordTransform));
 
-	// Setup VAO
-	glBindVertexArray(this->m_glPlaneVAO);
-		// Load data into vertex buffers
-		glBindBuffer(GL_ARRAY_BUFFER, this->m_glPlaneVBO);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->m_glPlaneEBO);
+		// Handle diffuse texture, if any
+		glActiveTexture(GL_TEXTURE0 + DIFFUSE_TEXTURE_BINDING);
+		glBindTextureUnit(DIFFUSE_TEXTURE_BINDING, m_mapTextures[i.diffuseTexName]->getTexture());
+		
+		// Handle specular texture, if any
+		glActiveTexture(GL_TEXTURE0 + SPECULAR_TEXTURE_BINDING);
+		glBindTextureUnit(SPECULAR_TEXTURE_BINDING, m_mapTextures[i.specularTexName]->getTexture());
 
-		// Set the vertex attribute pointers
-		glEnableVertexAttribArray(POSITION_ATTRIB_LOCATION);
-		glVertexAttribPointer(POSITION_ATTRIB_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(PrimVert), (GLvoid*) offsetof(PrimVert, p));
-		glEnableVertexAttribArray(NORMAL_ATTRIB_LOCATION);
-		glVertexAttribPointer(NORMAL_ATTRIB_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(PrimVert), (GLvoid*) offsetof(PrimVert, n));
-		glEnableVertexAttribArray(COLOR_ATTRIB_LOCATION);
-		glVertexAttribPointer(COLOR_ATTRIB_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(PrimVert), (GLvoid*) offsetof(PrimVert, c));
-		glEnableVertexAttribArray(TEXCOORD_ATTRIB_LOCATION);
-		glVertexAttribPointer(TEXCOORD_ATTRIB_LOCATION, 2, GL_FLOAT, GL_FALSE, sizeof(PrimVert), (GLvoid*) offsetof(PrimVert, t));
-	glBindVertexArray(0);
+		if (i.specularExponent > 0.f)
+			glUniform1f(MATERIAL_SHININESS_UNIFORM_LOCATION, i.specularExponent);
 
-	// Alloc buffer and store data
-	glNamedBufferStorage(m_glPlaneVBO, verts.size() * sizeof(PrimVert), &verts[0], GL_NONE);
-	// Element array buffer
-	glNamedBufferStorage(m_glPlaneEBO, inds.size() * sizeof(GLushort), &inds[0], GL_NONE);
+		glFrontFace(i.vertWindingOrder);
 
-	m_mapPrimitives["plane"] = m_mapPrimitives["quad"] = std::make_pair(m_glPlaneVAO, 6); // one sided
-	m_mapPrimitives["planedouble"] = m_mapPrimitives["quaddouble"] = std::make_pair(m_glPlaneVAO, 12); // two sided
+		// built-in primitives all share one VAO, so consecutive submissions rarely rebind
+		if (i.VAO != m_glBoundVAO)
+		{
+			m_RenderStats.vertexArrayBinds++;
+			glBindVertexArray(i.VAO);
+			m_glBoundVAO = i.VAO;
+		}
+
+		glDrawElementsBaseVertex(i.glPrimitiveType, i.vertCount, i.indexType, (GLvoid*)(i.firstIndex * indexTypeSize(i.indexType)), i.baseVertex);
+	}
 }
 
-void Renderer::generateCube()
+GLuint * Renderer::getSubmissionProgram(RendererSubmission const & rs, bool multiDraw)
 {
-	std::vector<PrimVert> verts;
+	std::map<std::string, GLuint*> &variants = multiDraw ? (m_bOITPass ? m_mapMDIOITShaders : m_mapMDIShaders) : m_mapOITShaders;
 
-	glm::vec3 bboxMin(-0.5f);
-	glm::vec3 bboxMax(0.5f);
+	auto it = variants.find(rs.shaderName);
 
-	std::vector<GLushort> inds;
+	if (multiDraw)
+		return it != variants.end() ? it->second : NULL;
 
-	// Bottom
-	verts.push_back(PrimVert({ glm::vec3(bboxMin[0], bboxMin[1], bboxMin[2]), glm::vec3(0.f, -1.f, 0.f), glm::vec4(1.f), glm::vec2(0.f) }));
-	verts.push_back(PrimVert({ glm::vec3(bboxMax[0], bboxMin[1], bboxMin[2]), glm::vec3(0.f, -1.f, 0.f), glm::vec4(1.f), glm::vec2(1.f, 0.f) }));
-	verts.push_back(PrimVert({ glm::vec3(bboxMax[0], bboxMin[1], bboxMax[2]), glm::vec3(0.f, -1.f, 0.f), glm::vec4(1.f), glm::vec2(1.f) }));
-	verts.push_back(PrimVert({ glm::vec3(bboxMin[0], bboxMin[1], bboxMax[2]), glm::vec3(0.f, -1.f, 0.f), glm::vec4(1.f), glm::vec2(0.f, 1.f) }));
-	inds.push_back(verts.size() - 4);
-	inds.push_back(verts.size() - 3);
-	inds.push_back(verts.size() - 1);
-	inds.push_back(verts.size() - 3);
-	inds.push_back(verts.size() - 2);
-	inds.push_back(verts.size() - 1);
+	// programs without an OIT variant write unweighted color and no revealage, which the
+	// composite can't resolve, so the OIT pass skips their submissions
+	if (m_bOITPass)
+		return it != variants.end() ? it->second : NULL;
 
-	// Top
-	verts.push_back(PrimVert({ glm::vec3(bboxMax[0], bboxMax[1], bboxMax[2]), glm::vec3(0.f, 1.f, 0.f), glm::vec4(1.f), glm::vec2(1.f, 0.f) }));
-	verts.push_back(PrimVert({ glm::vec3(bboxMax[0], bboxMax[1], bboxMin[2]), glm::vec3(0.f, 1.f, 0.f), glm::vec4(1.f), glm::vec2(1.f) }));
-	verts.push_back(PrimVert({ glm::vec3(bboxMin[0], bboxMax[1], bboxMin[2]), glm::vec3(0.f, 1.f, 0.f), glm::vec4(1.f), glm::vec2(0.f, 1.f) }));
-	verts.push_back(PrimVert({ glm::vec3(bboxMin[0], bboxMax[1], bboxMax[2]), glm::vec3(0.f, 1.f, 0.f), glm::vec4(1.f), glm::vec2(0.f) }));
-	inds.push_back(verts.size() - 4);
-	inds.push_back(verts.size() - 3);
-	inds.push_back(verts.size() - 1);
-	inds.push_back(verts.size() - 3);
-	inds.push_back(verts.size() - 2);
-	inds.push_back(verts.size() - 1);
+	it = m_mapShaders.find(rs.shaderName);
+
+	return it != m_mapShaders.end() ? it->second : NULL;
+}
+
+bool Renderer::canShareMultiDraw(RendererSubmission const & a, RendererSubmission const & b) const
+{
+	return a.shaderName == b.shaderName
+		&& a.VAO == b.VAO
+		&& a.glPrimitiveType == b.glPrimitiveType
+		&& a.indexType == b.indexType
+		&& a.vertWindingOrder == b.vertWindingOrder
+		&& (getBindlessTextures() || (a.diffuseTexName == b.diffuseTexName && a.specularTexName == b.specularTexName));
+}
+
+void Renderer::resetRenderStats()
+{
+	m_RenderStats = RenderStats();
+}
+
+size_t Renderer::indexTypeSize(GLenum indexType)
+{
+	switch (indexType)
+	{
+	case GL_UNSIGNED_BYTE:
+		return sizeof(GLubyte);
+	case GL_UNSIGNED_SHORT:
+		return sizeof(GLushort);
+	default:
+		return sizeof(GLuint);
+	}
+}
+
+Renderer::RendererSubmission & Renderer::getTransparentSubmission(uint32_t index)
+{
+	if (index < m_vStaticRenderQueue_Transparency.size())
+		return m_vStaticRenderQueue_Transparency[index];
+
+	return m_vDynamicRenderQueue_Transparency[index - m_vStaticRenderQueue_Transparency.size()];
+}
+
+glm::vec3 Renderer::getTransparencySortPosition(RendererSubmission const & rs)
+{
+	return rs.transparencySortPosition.w == -1.f ? glm::vec3(rs.modelToWorldTransform[3]) : glm::vec3(rs.transparencySortPosition);
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose: Builds every built-in mesh into one shared vertex/index arena,
+//          so all primitives draw from a single VAO
+//-----------------------------------------------------------------------------
+void Renderer::setupPrimitives()
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	m_vPrimitiveLODs.clear();
+	m_MeshCache.resetStats();
+	m_uiGeneratedPrimitives = 0u;
+
+	// each level halves the tessellation; the coarsest still reads as the right shape
+	std::vector<PrimitiveMesh> lods;
+	for (int recursion = 4; recursion >= 1; --recursion)
+		lods.push_back(generateIcosphere(recursion));
+	addPrimitiveLODs({ "icosphere", "inverse_icosphere" }, lods);
+
+	lods.clear();
+	for (int segments = 32; segments >= 8; segments /= 2)
+		lods.push_back(generateCylinder(segments));
+	addPrimitiveLODs({ "cylinder" }, lods);
+
+	lods.clear();
+	lods.push_back(generateTorus(1.f, 0.05f, 32, 8));
+	lods.push_back(generateTorus(1.f, 0.05f, 16, 6));
+	lods.push_back(generateTorus(1.f, 0.05f, 8, 4));
+	addPrimitiveLODs({ "torus" }, lods);
+
+	generatePlane();
+	generateCube();
+	generateBBox();
+
+	for (auto const &custom : m_vCustomPrimitives)
+	{
+		PrimitiveMesh mesh;
+		if (addCachedPrimitiveMesh(custom.cacheKey, custom.generator, mesh))
+			m_mapPrimitives[custom.name] = mesh;
+	}
+
+	uploadPrimitiveArena();
+
+	m_fPrimitiveSetupMS = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	printf("Primitive meshes: %u from %s/ (%.1f KB), %u generated, %.1f ms\n", m_MeshCache.getLoadedCount(), m_MeshCache.getDirectory().c_str(), m_MeshCache.getLoadedBytes() / 1024.f, m_uiGeneratedPrimitives, m_fPrimitiveSetupMS);
+}
+
+bool Renderer::addPrimitive(std::string primName, std::string cacheKey, PrimitiveGenerator generator)
+{
+	bool pending = false;
+	for (auto const &custom : m_vCustomPrimitives)
+		pending |= custom.name == primName;
+
+	if (pending || m_mapPrimitives.find(primName) != m_mapPrimitives.end())
+	{
+		printf("Error: Adding primitive \"%s\" which already exists\n", primName.c_str());
+		return false;
+	}
+
+	m_vCustomPrimitives.push_back(CustomPrimitive({ primName, cacheKey, generator }));
+
+	if (m_bPrimitiveBatchOpen)
+		return true;
+
+	// rebuilding is cheap once everything else comes from the cache, and keeps the arena in one buffer
+	return buildCustomPrimitives(m_vCustomPrimitives.size() - 1u);
+}
+
+void Renderer::beginPrimitiveRegistration()
+{
+	if (m_bPrimitiveBatchOpen)
+		return;
+
+	m_bPrimitiveBatchOpen = true;
+	m_nPrimitiveBatchStart = m_vCustomPrimitives.size();
+}
+
+bool Renderer::endPrimitiveRegistration()
+{
+	if (!m_bPrimitiveBatchOpen)
+		return true;
+
+	m_bPrimitiveBatchOpen = false;
+
+	if (m_nPrimitiveBatchStart == m_vCustomPrimitives.size())
+		return true;
+
+	return buildCustomPrimitives(m_nPrimitiveBatchStart);
+}
+
+bool Renderer::buildCustomPrimitives(size_t firstNew)
+{
+	setupPrimitives();
+
+	size_t kept = firstNew;
+	for (size_t i = firstNew; i < m_vCustomPrimitives.size(); ++i)
+		if (m_mapPrimitives.find(m_vCustomPrimitives[i].name) != m_mapPrimitives.end())
+			m_vCustomPrimitives[kept++] = m_vCustomPrimitives[i];
+
+	bool allBuilt = kept == m_vCustomPrimitives.size();
+	m_vCustomPrimitives.resize(kept);
+
+	return allBuilt;
+}
+
+bool Renderer::streamPrimitive(std::string primName, std::string path)
+{
+	if (m_mapPrimitives.find(primName) != m_mapPrimitives.end())
+	{
+		printf("Error: Adding primitive \"%s\" which already exists\n", primName.c_str());
+		return false;
+	}
+
+	int stream = m_MeshStreamer.open(path, sizeof(PrimVert));
+	if (stream < 0)
+		return false;
+
+	setPrimVertFormat(m_MeshStreamer.getVAO(stream), 0);
+
+	MeshCacheHeader const &header = m_MeshStreamer.getHeader(stream);
+
+	PrimitiveMesh mesh;
+	mesh.baseVertex = 0;
+	mesh.firstIndex = 0u;
+	mesh.indexCount = 0;
+	mesh.boundingSphere = glm::vec4(header.boundingSphere[0], header.boundingSphere[1], header.boundingSphere[2], header.boundingSphere[3]);
+	mesh.lodError = 0.f;
+	mesh.lodChain = -1;
+	mesh.primitiveType = header.topology == MESHCACHE_POINTS ? GL_POINTS : header.topology == MESHCACHE_LINES ? GL_LINES : GL_TRIANGLES;
+	mesh.stream = stream;
+
+	m_mapPrimitives[primName] = mesh;
+
+	return true;
+}
+
+void Renderer::updateStreaming()
+{
+	m_RenderStats.streamedBytes += m_MeshStreamer.update();
+
+	for (auto &pc : m_mapPointClouds)
+		pc.second->update();
+}
+
+bool Renderer::addPointCloud(std::string name, std::string path, size_t gpuBudgetMB)
+{
+	if (m_mapPointClouds.find(name) != m_mapPointClouds.end())
+	{
+		printf("Error: Adding point cloud \"%s\" which already exists\n", name.c_str());
+		return false;
+	}
+
+	PointCloud* pc = new PointCloud();
+	if (!pc->open(path, gpuBudgetMB * 1024u * 1024u))
+	{
+		delete pc;
+		return false;
+	}
+
+	m_mapPointClouds[name] = pc;
+
+	return true;
+}
+
+bool Renderer::drawPointCloud(std::string name, glm::mat4 modelTransform)
+{
+	PointCloud* pc = getPointCloud(name);
+	if (!pc)
+	{
+		printf("Error: Point cloud \"%s\" not found\n", name.c_str());
+		return false;
+	}
+
+	m_vPointCloudQueue.push_back(std::make_pair(pc, modelTransform));
+
+	return true;
+}
+
+PointCloud* Renderer::getPointCloud(std::string name)
+{
+	auto pc = m_mapPointClouds.find(name);
+
+	return pc == m_mapPointClouds.end() ? NULL : pc->second;
+}
+
+void Renderer::renderPointClouds(SceneViewInfo * sceneViewInfo)
+{
+	GLuint* program = m_mapShaders["pointcloud"];
+	if (!program || !*program)
+		return;
+
+	unbindRenderQueueVAO();
+
+	glm::mat4 viewProjection = sceneViewInfo->projection * sceneViewInfo->view;
+	float pixelScale = sceneViewInfo->projection[1][1] * sceneViewInfo->m_nRenderHeight * 0.5f;
+
+	m_RenderStats.programBinds++;
+	glUseProgram(*program);
+	glEnable(GL_PROGRAM_POINT_SIZE);
+
+	for (auto const &pc : m_vPointCloudQueue)
+	{
+		m_RenderStats.uniformUpdates += 2u;
+		glUniformMatrix4fv(MODEL_MAT_UNIFORM_LOCATION, 1, GL_FALSE, glm::value_ptr(pc.second));
+
+		unsigned long long points = pc.first->draw(viewProjection, pc.second, pixelScale);
+
+		if (points > 0u)
+		{
+			m_RenderStats.drawCalls++;
+			m_RenderStats.vertexArrayBinds++;
+			m_RenderStats.pointCloudNodes += pc.first->getStats().nodesDrawn;
+			m_RenderStats.pointCloudPoints += points;
+		}
+	}
+
+	glDisable(GL_PROGRAM_POINT_SIZE);
+}
+
+// Maps the mesh for cacheKey from the mesh cache into the arena, or generates, optimizes and
+// caches it. The mesh's lodError comes back relative to its bounding radius.
+bool Renderer::addCachedPrimitiveMesh(std::string const & cacheKey, PrimitiveGenerator const & generator, PrimitiveMesh & mesh)
+{
+	bool cached = m_MeshCache.load(cacheKey, RENDERER_MESH_CACHE_REVISION, sizeof(PrimVert)) && m_MeshCache.header().topology == MESHCACHE_TRIANGLES && m_MeshCache.header().indexSize == sizeof(GLushort);
+
+	// a damaged or foreign cache entry is regenerated rather than drawn out of bounds
+	if (cached && !checkPrimitiveMesh(cacheKey, static_cast<const GLushort*>(m_MeshCache.indices()), m_MeshCache.header().indexCount, m_MeshCache.header().vertexCount))
+	{
+		printf("Regenerating primitive mesh \"%s\"\n", cacheKey.c_str());
+		m_MeshCache.close();
+		cached = false;
+	}
+
+	if (cached)
+	{
+		MeshCacheHeader const &header = m_MeshCache.header();
+		const PrimVert* verts = static_cast<const PrimVert*>(m_MeshCache.vertices());
+		const GLushort* inds = static_cast<const GLushort*>(m_MeshCache.indices());
+
+		mesh.baseVertex = static_cast<GLint>(m_vPrimitiveArenaVerts.size());
+		mesh.firstIndex = static_cast<GLuint>(m_vPrimitiveArenaIndices.size());
+		mesh.indexCount = static_cast<GLsizei>(header.indexCount);
+		mesh.boundingSphere = glm::vec4(header.boundingSphere[0], header.boundingSphere[1], header.boundingSphere[2], header.boundingSphere[3]);
+		mesh.lodError = header.lodError;
+		mesh.lodChain = -1;
+		mesh.primitiveType = GL_TRIANGLES;
+		mesh.stream = -1;
+
+		m_vPrimitiveArenaVerts.insert(m_vPrimitiveArenaVerts.end(), verts, verts + header.vertexCount);
+		m_vPrimitiveArenaIndices.insert(m_vPrimitiveArenaIndices.end(), inds, inds + header.indexCount);
+
+		m_MeshCache.close();
+
+		return true;
+	}
+
+	std::vector<PrimVert> verts;
+	std::vector<GLushort> inds;
+	float error = generator(verts, inds);
+
+	if (!checkPrimitiveMesh(cacheKey, inds.data(), inds.size(), verts.size()))
+		return false;
+
+	optimizePrimitiveMesh(cacheKey, verts, inds);
+
+	mesh = addPrimitiveMesh(verts, inds);
+	if (mesh.boundingSphere.w > 0.f)
+		mesh.lodError = error / mesh.boundingSphere.w;
+
+	m_uiGeneratedPrimitives++;
+
+	m_MeshCache.store(cacheKey, RENDERER_MESH_CACHE_REVISION, &verts[0], sizeof(PrimVert), static_cast<uint32_t>(verts.size()), &inds[0], static_cast<uint32_t>(inds.size()), mesh.boundingSphere, mesh.lodError);
+
+	return true;
+}
+
+// Arena indices are 16-bit and mesh-local, so a mesh must be a triangle list of 1 to 65536
+// vertices that never indexes past its own vertices
+bool Renderer::checkPrimitiveMesh(std::string const & name, const GLushort * inds, size_t indexCount, size_t vertexCount)
+{
+	if (vertexCount == 0u || indexCount == 0u || indexCount % 3u != 0u || vertexCount > 65536u)
+	{
+		printf("Error: Primitive mesh \"%s\" is not a triangle list of 1 to 65536 vertices\n", name.c_str());
+		return false;
+	}
+
+	for (size_t i = 0u; i < indexCount; ++i)
+	{
+		if (inds[i] >= vertexCount)
+		{
+			printf("Error: Primitive mesh \"%s\" indexes past its %u vertices\n", name.c_str(), static_cast<unsigned int>(vertexCount));
+			return false;
+		}
+	}
+
+	return true;
+}
+
+Renderer::PrimitiveMesh Renderer::addPrimitiveMesh(std::vector<PrimVert> const & verts, std::vector<GLushort> const & inds)
+{
+	// indices stay mesh-local (16-bit); baseVertex offsets them into the arena at draw time
+	PrimitiveMesh mesh;
+	mesh.baseVertex = static_cast<GLint>(m_vPrimitiveArenaVerts.size());
+	mesh.firstIndex = static_cast<GLuint>(m_vPrimitiveArenaIndices.size());
+	mesh.indexCount = static_cast<GLsizei>(inds.size());
+	mesh.boundingSphere = computeBoundingSphere(verts);
+	mesh.lodError = 0.f;
+	mesh.lodChain = -1;
+	mesh.primitiveType = GL_TRIANGLES;
+	mesh.stream = -1;
+
+	m_vPrimitiveArenaVerts.insert(m_vPrimitiveArenaVerts.end(), verts.begin(), verts.end());
+	m_vPrimitiveArenaIndices.insert(m_vPrimitiveArenaIndices.end(), inds.begin(), inds.end());
+
+	return mesh;
+}
+
+void Renderer::addPrimitiveLODs(std::vector<std::string> const & names, std::vector<PrimitiveMesh> const & lods)
+{
+	int chain = static_cast<int>(m_vPrimitiveLODs.size());
+	m_vPrimitiveLODs.push_back(lods);
+
+	// coarser levels are inscribed in the finest, so its bounds cover every level
+	for (auto &lod : m_vPrimitiveLODs.back())
+	{
+		lod.boundingSphere = lods.front().boundingSphere;
+		lod.lodChain = chain;
+	}
+
+	for (auto const &name : names)
+		m_mapPrimitives[name] = m_vPrimitiveLODs.back().front();
+}
+
+// Reorders a generated triangle mesh for the post-transform cache, optionally for overdraw,
+// then renumbers its vertices in order of use; generation order is usually poor for both.
+void Renderer::optimizePrimitiveMesh(std::string const & name, std::vector<PrimVert>& verts, std::vector<GLushort>& inds)
+{
+	float acmrBefore = meshutil::computeACMR(inds, verts.size());
+
+	meshutil::optimizeVertexCache(inds, verts.size());
+
+	if (RENDERER_MESH_OVERDRAW_THRESHOLD > 0.f)
+	{
+		std::vector<glm::vec3> positions;
+		positions.reserve(verts.size());
+		for (auto const &v : verts)
+			positions.push_back(v.p);
+
+		meshutil::optimizeOverdraw(inds, positions, RENDERER_MESH_OVERDRAW_THRESHOLD);
+	}
+
+	std::vector<GLushort> remap = meshutil::optimizeVertexFetch(inds, verts.size());
+
+	std::vector<PrimVert> reordered(verts.size());
+	for (size_t i = 0u; i < verts.size(); ++i)
+		reordered[remap[i]] = verts[i];
+	verts.swap(reordered);
+
+	printf("Optimized %s: %u vertices, %u triangles, ACMR %.3f -> %.3f\n", name.c_str(), static_cast<unsigned int>(verts.size()), static_cast<unsigned int>(inds.size() / 3u), acmrBefore, meshutil::computeACMR(inds, verts.size()));
+}
+
+void Renderer::uploadPrimitiveArena()
+{
+	// a rebuild keeps the VAO name, which submissions already hold
+	glDeleteBuffers(1, &m_glPrimitiveVBO);
+	glDeleteBuffers(1, &m_glPrimitiveEBO);
+
+	if (m_glPrimitiveVAO == 0u)
+		glCreateVertexArrays(1, &m_glPrimitiveVAO);
+
+	glCreateBuffers(1, &m_glPrimitiveVBO);
+
+	if (m_bPackedVertices)
+	{
+		std::vector<PackedVertex> packed;
+		packed.reserve(m_vPrimitiveArenaVerts.size());
+		for (auto const &v : m_vPrimitiveArenaVerts)
+			packed.push_back(packVertex(v.p, v.n, v.c, v.t));
+
+		m_nPrimitiveArenaBytes = packed.size() * sizeof(PackedVertex);
+		glNamedBufferStorage(m_glPrimitiveVBO, m_nPrimitiveArenaBytes, &packed[0], GL_NONE);
+	}
+	else
+	{
+		m_nPrimitiveArenaBytes = m_vPrimitiveArenaVerts.size() * sizeof(PrimVert);
+		glNamedBufferStorage(m_glPrimitiveVBO, m_nPrimitiveArenaBytes, &m_vPrimitiveArenaVerts[0], GL_NONE);
+	}
+
+	glCreateBuffers(1, &m_glPrimitiveEBO);
+	glNamedBufferStorage(m_glPrimitiveEBO, m_vPrimitiveArenaIndices.size() * sizeof(GLushort), &m_vPrimitiveArenaIndices[0], GL_NONE);
+
+	m_nPrimitiveArenaBytes += m_vPrimitiveArenaIndices.size() * sizeof(GLushort);
+
+	glVertexArrayVertexBuffer(m_glPrimitiveVAO, 0, m_glPrimitiveVBO, 0, getPrimitiveVertexSize());
+	glVertexArrayElementBuffer(m_glPrimitiveVAO, m_glPrimitiveEBO);
+
+	m_vPrimitiveArenaVerts.clear();
+	m_vPrimitiveArenaVerts.shrink_to_fit();
+	m_vPrimitiveArenaIndices.clear();
+	m_vPrimitiveArenaIndices.shrink_to_fit();
+
+	if (m_bPackedVertices)
+	{
+		setPackedVertexFormat(m_glPrimitiveVAO, 0);
+		return;
+	}
+
+	setPrimVertFormat(m_glPrimitiveVAO, 0);
+}
+
+// Points the position, normal, color and texture coordinate attributes of a VAO at PrimVert
+// data in the given vertex buffer binding
+void Renderer::setPrimVertFormat(GLuint vao, GLuint bindingIndex)
+{
+	glEnableVertexArrayAttrib(vao, POSITION_ATTRIB_LOCATION);
+	glVertexArrayAttribFormat(vao, POSITION_ATTRIB_LOCATION, 3, GL_FLOAT, GL_FALSE, offsetof(PrimVert, p));
+	glVertexArrayAttribBinding(vao, POSITION_ATTRIB_LOCATION, bindingIndex);
+	glEnableVertexArrayAttrib(vao, NORMAL_ATTRIB_LOCATION);
+	glVertexArrayAttribFormat(vao, NORMAL_ATTRIB_LOCATION, 3, GL_FLOAT, GL_FALSE, offsetof(PrimVert, n));
+	glVertexArrayAttribBinding(vao, NORMAL_ATTRIB_LOCATION, bindingIndex);
+	glEnableVertexArrayAttrib(vao, COLOR_ATTRIB_LOCATION);
+	glVertexArrayAttribFormat(vao, COLOR_ATTRIB_LOCATION, 4, GL_FLOAT, GL_FALSE, offsetof(PrimVert, c));
+	glVertexArrayAttribBinding(vao, COLOR_ATTRIB_LOCATION, bindingIndex);
+	glEnableVertexArrayAttrib(vao, TEXCOORD_ATTRIB_LOCATION);
+	glVertexArrayAttribFormat(vao, TEXCOORD_ATTRIB_LOCATION, 2, GL_FLOAT, GL_FALSE, offsetof(PrimVert, t));
+	glVertexArrayAttribBinding(vao, TEXCOORD_ATTRIB_LOCATION, bindingIndex);
+}
+
+void Renderer::setPackedVertices(bool enabled)
+{
+	if (enabled == m_bPackedVertices)
+		return;
+
+	m_bPackedVertices = enabled;
+
+	// only rebuild once init() has built the arena; meshes regenerate in the same order, so
+	// every submission's base vertex and first index still match
+	if (m_glPrimitiveVAO != 0u)
+		setupPrimitives();
+}
+
+size_t Renderer::getPrimitiveVertexSize() const
+{
+	return m_bPackedVertices ? sizeof(PackedVertex) : sizeof(PrimVert);
+}
+
+
+//-----------------------------------------------------------------------------
+// Purpose:
+//-----------------------------------------------------------------------------
+void Renderer::setupFullscreenQuad()
+{
+	glm::vec2 vVerts[4];
+
+	// left eye verts	
+	vVerts[0] = glm::vec2(-1, -1);
+	vVerts[1] = glm::vec2(1, -1);
+	vVerts[2] = glm::vec2(-1, 1);
+	vVerts[3] = glm::vec2(1, 1);
+
+	// right eye verts
+	//vVerts.push_back(VertexDataWindow(glm::vec2(0, -1), glm::vec2(0, 0)));
+	//vVerts.push_back(VertexDataWindow(glm::vec2(1, -1), glm::vec2(1, 0)));
+	//vVerts.push_back(VertexDataWindow(glm::vec2(0, 1), glm::vec2(0, 1)));
+	//vVerts.push_back(VertexDataWindow(glm::vec2(1, 1), glm::vec2(1, 1)));
+
+	GLushort vIndices[] = { 0, 1, 3,   0, 3, 2 };//,   4, 5, 7,   4, 7, 6 };
+	m_uiCompanionWindowVertCount = _countof(vIndices);
+
+	// Generate/allocate and fill vertex buffer object
+	glCreateBuffers(1, &m_glFullscreenTextureVBO);
+	glNamedBufferStorage(m_glFullscreenTextureVBO, sizeof(vVerts) * sizeof(glm::vec2), &vVerts[0], GL_NONE);
+
+	// Generate/allocate and fill index buffer object
+	glCreateBuffers(1, &m_glFullscreenTextureEBO);
+	glNamedBufferStorage(m_glFullscreenTextureEBO, m_uiCompanionWindowVertCount * sizeof(GLushort), &vIndices[0], GL_NONE);
+
+	// Define our Vertex Attribute Object
+	glGenVertexArrays(1, &m_glFullscreenTextureVAO);
+	glBindVertexArray(m_glFullscreenTextureVAO);
+
+		glBindBuffer(GL_ARRAY_BUFFER, m_glFullscreenTextureVBO);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_glFullscreenTextureEBO);
+
+		glEnableVertexAttribArray(POSITION_ATTRIB_LOCATION);
+		glVertexAttribPointer(POSITION_ATTRIB_LOCATION, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void *)0);
+
+	glBindVertexArray(0);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+
+Renderer::PrimitiveMesh Renderer::generateIcosphere(int recursionLevel)
+{
+	PrimitiveMesh mesh;
+	addCachedPrimitiveMesh("icosphere " + std::to_string(recursionLevel), [recursionLevel](std::vector<PrimVert> &verts, std::vector<GLushort> &inds) {
+		Icosphere ico(recursionLevel);
+
+		for (auto const &v : ico.getVertices())
+			verts.push_back(PrimVert({ v, v, glm::vec4(1.f), glm::vec2(0.5f) }));
+
+		inds = ico.getIndices();
+
+		// the unit sphere is farthest from a face where the face's plane comes closest to the center
+		float error = 0.f;
+		for (size_t i = 0u; i < inds.size(); i += 3u)
+		{
+			glm::vec3 const &a = verts[inds[i]].p;
+			glm::vec3 n = glm::normalize(glm::cross(verts[inds[i + 1]].p - a, verts[inds[i + 2]].p - a));
+			error = std::max(error, 1.f - std::abs(glm::dot(n, a)));
+		}
+
+		return error;
+	}, mesh);
+
+	return mesh;
+}
+
+
+Renderer::PrimitiveMesh Renderer::generateTorus(float coreRadius, float meridianRadius, int numCoreSegments, int numMeridianSegments)
+{
+	char key[MESHCACHE_KEY_LENGTH];
+	snprintf(key, sizeof(key), "torus %gx%g %dx%d", coreRadius, meridianRadius, numCoreSegments, numMeridianSegments);
+
+	PrimitiveMesh mesh;
+	addCachedPrimitiveMesh(key, [=](std::vector<PrimVert> &verts, std::vector<GLushort> &inds) {
+		for (int i = 0; i < numCoreSegments; i++)
+			for (int j = 0; j < numMeridianSegments; j++)
+			{
+				float u = i / (numCoreSegments - 1.f);
+				float v = j / (numMeridianSegments - 1.f);
+				float theta = u * 2.f * glm::pi<float>();
+				float rho = v * 2.f * glm::pi<float>();
+				float x = cos(theta) * (coreRadius + meridianRadius*cos(rho));
+				float y = sin(theta) * (coreRadius + meridianRadius*cos(rho));
+				float z = meridianRadius*sin(rho);
+				float nx = cos(theta)*cos(rho);
+				float ny = sin(theta)*cos(rho);
+				float nz = sin(rho);
+				float s = u;
+				float t = v;
+
+				PrimVert currentVert = { glm::vec3(x, y, z), glm::vec3(nx, ny, nz), glm::vec4(1.f), glm::vec2(s, t) };
+				verts.push_back(currentVert);
+
+				GLushort uvInd = i * numMeridianSegments + j;
+				GLushort uvpInd = i * numMeridianSegments + (j + 1) % numMeridianSegments;
+				GLushort umvInd = (((i - 1) % numCoreSegments + numCoreSegments) % numCoreSegments) * numMeridianSegments + j; // true modulo (not C++ remainder operand %) for negative wraparound
+				GLushort umvpInd = (((i - 1) % numCoreSegments + numCoreSegments) % numCoreSegments) * numMeridianSegments + (j + 1) % numMeridianSegments;
+
+				inds.push_back(uvInd);   // (u    , v)
+				inds.push_back(uvpInd);  // (u    , v + 1)
+				inds.push_back(umvInd);  // (u - 1, v)
+
+				inds.push_back(umvInd);  // (u - 1, v)
+				inds.push_back(uvpInd);  // (u    , v + 1)
+				inds.push_back(umvpInd); // (u - 1, v + 1)
+			}
+
+		// chord sag of the outer rim and of the tube cross section; the first and last ring coincide
+		float coreError = (coreRadius + meridianRadius) * (1.f - cos(glm::pi<float>() / (numCoreSegments - 1)));
+		float meridianError = meridianRadius * (1.f - cos(glm::pi<float>() / (numMeridianSegments - 1)));
+
+		return std::max(coreError, meridianError);
+	}, mesh);
+
+	return mesh;
+}
+
+Renderer::PrimitiveMesh Renderer::generateCylinder(int numSegments)
+{
+	PrimitiveMesh mesh;
+	addCachedPrimitiveMesh("cylinder " + std::to_string(numSegments), [numSegments](std::vector<PrimVert> &verts, std::vector<GLushort> &inds) {
+		// Front endcap
+		verts.push_back(PrimVert({ glm::vec3(0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec4(1.f), glm::vec2(0.5f, 0.5f) }));
+		for (float i = 0; i < numSegments; ++i)
+		{
+			float angle = ((float)i / (float)(numSegments - 1)) * glm::two_pi<float>();
+			verts.push_back(PrimVert({ glm::vec3(sin(angle), cos(angle), 0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec4(1.f), (glm::vec2(sin(angle), cos(angle)) + 1.f) / 2.f }));
+
+			if (i > 0)
+			{
+				inds.push_back(0);
+				inds.push_back(verts.size() - 2);
+				inds.push_back(verts.size() - 1);
+			}
+		}
+		inds.push_back(0);
+		inds.push_back(verts.size() - 1);
+		inds.push_back(1);
+
+		// Back endcap
+		verts.push_back(PrimVert({ glm::vec3(0.f, 0.f, 1.f), glm::vec3(0.f, 0.f, 1.f), glm::vec4(1.f), glm::vec2(0.5f, 0.5f) }));
+		for (float i = 0; i < numSegments; ++i)
+		{
+			float angle = ((float)i / (float)(numSegments - 1)) * glm::two_pi<float>();
+			verts.push_back(PrimVert({ glm::vec3(sin(angle), cos(angle), 1.f), glm::vec3(0.f, 0.f, 1.f), glm::vec4(1.f), (glm::vec2(sin(angle), cos(angle)) + 1.f) / 2.f }));
+
+			if (i > 0)
+			{
+				inds.push_back(verts.size() - (i + 2)); // ctr pt of endcap
+				inds.push_back(verts.size() - 1);
+				inds.push_back(verts.size() - 2);
+			}
+		}
+		inds.push_back(verts.size() - (numSegments + 1));
+		inds.push_back(verts.size() - (numSegments));
+		inds.push_back(verts.size() - 1);
+
+		// Shaft
+		for (float i = 0; i < numSegments; ++i)
+		{
+			float angle = ((float)i / (float)(numSegments - 1)) * glm::two_pi<float>();
+			verts.push_back(PrimVert({ glm::vec3(sin(angle), cos(angle), 0.f), glm::vec3(sin(angle), cos(angle), 0.f), glm::vec4(1.f), glm::vec2((float)i / (float)(numSegments - 1), 0.f) }));
+
+			verts.push_back(PrimVert({ glm::vec3(sin(angle), cos(angle), 1.f), glm::vec3(sin(angle), cos(angle), 0.f), glm::vec4(1.f), glm::vec2((float)i / (float)(numSegments - 1), 1.f) }));
+
+			if (i > 0)
+			{
+				inds.push_back(verts.size() - 4);
+				inds.push_back(verts.size() - 3);
+				inds.push_back(verts.size() - 2);
+
+				inds.push_back(verts.size() - 2);
+				inds.push_back(verts.size() - 3);
+				inds.push_back(verts.size() - 1);
+			}
+		}
+		inds.push_back(verts.size() - 2);
+		inds.push_back(verts.size() - numSegments * 2);
+		inds.push_back(verts.size() - 1);
+
+		inds.push_back(verts.size() - numSegments * 2);
+		inds.push_back(verts.size() - numSegments * 2 + 1);
+		inds.push_back(verts.size() - 1);
+
+		// chord sag of the unit circle; the first and last segment vertex coincide
+		return 1.f - cos(glm::pi<float>() / (numSegments - 1));
+	}, mesh);
+
+	return mesh;
+}
+
+void Renderer::generatePlane()
+{
+	std::vector<PrimVert> verts;
+	std::vector<GLushort> inds;
+
+	// Front face
+	verts.push_back(PrimVert({ glm::vec3(-0.5f, -0.5f, 0.f), glm::vec3(0.f, 0.f, 1.f), glm::vec4(1.f), glm::vec2(0.f, 1.f) }));
+	verts.push_back(PrimVert({ glm::vec3(0.5f, -0.5f, 0.f), glm::vec3(0.f, 0.f, 1.f), glm::vec4(1.f), glm::vec2(1.f, 1.f) }));
+	verts.push_back(PrimVert({ glm::vec3(0.5f, 0.5f, 0.f), glm::vec3(0.f, 0.f, 1.f), glm::vec4(1.f), glm::vec2(1.f, 0.f) }));
+	verts.push_back(PrimVert({ glm::vec3(-0.5f, 0.5f, 0.f), glm::vec3(0.f, 0.f, 1.f),	glm::vec4(1.f), glm::vec2(0.f, 0.f) }));
+
+	inds.push_back(0);
+	inds.push_back(1);
+	inds.push_back(2);
+
+	inds.push_back(2);
+	inds.push_back(3);
+	inds.push_back(0);
+
+	// Back face
+	verts.push_back(PrimVert({ glm::vec3(0.5f, -0.5f, 0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec4(1.f), glm::vec2(1.f, 1.f) }));
+	verts.push_back(PrimVert({ glm::vec3(-0.5f, -0.5f, 0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec4(1.f), glm::vec2(0.f, 1.f) }));
+	verts.push_back(PrimVert({ glm::vec3(-0.5f, 0.5f, 0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec4(1.f), glm::vec2(0.f, 0.f) }));
+	verts.push_back(PrimVert({ glm::vec3(0.5f, 0.5f, 0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec4(1.f), glm::vec2(1.f, 0.f) }));
+
+	inds.push_back(4);
+	inds.push_back(5);
+	inds.push_back(6);
+
+	inds.push_back(6);
+	inds.push_back(7);
+	inds.push_back(4);
+
+	PrimitiveMesh plane = addPrimitiveMesh(verts, inds);
+	m_mapPrimitives["planedouble"] = m_mapPrimitives["quaddouble"] = plane; // two sided
+
+	plane.indexCount = 6;
+	m_mapPrimitives["plane"] = m_mapPrimitives["quad"] = plane; // one sided
+}
+
+void Renderer::generateCube()
+{
+	std::vector<PrimVert> verts;
+
+	glm::vec3 bboxMin(-0.5f);
+	glm::vec3 bboxMax(0.5f);
+
+	std::vector<GLushort> inds;
+
+	// Bottom
+	verts.push_back(PrimVert({ glm::vec3(bboxMin[0], bboxMin[1], bboxMin[2]), glm::vec3(0.f, -1.f, 0.f), glm::vec4(1.f), glm::vec2(0.f) }));
+	verts.push_back(PrimVert({ glm::vec3(bboxMax[0], bboxMin[1], bboxMin[2]), glm::vec3(0.f, -1.f, 0.f), glm::vec4(1.f), glm::vec2(1.f, 0.f) }));
+	verts.push_back(PrimVert({ glm::vec3(bboxMax[0], bboxMin[1], bboxMax[2]), glm::vec3(0.f, -1.f, 0.f), glm::vec4(1.f), glm::vec2(1.f) }));
+	verts.push_back(PrimVert({ glm::vec3(bboxMin[0], bboxMin[1], bboxMax[2]), glm::vec3(0.f, -1.f, 0.f), glm::vec4(1.f), glm::vec2(0.f, 1.f) }));
+	inds.push_back(verts.size() - 4);
+	inds.push_back(verts.size() - 3);
+	inds.push_back(verts.size() - 1);
+	inds.push_back(verts.size() - 3);
+	inds.push_back(verts.size() - 2);
+	inds.push_back(verts.size() - 1);
+
+	// Top
+	verts.push_back(PrimVert({ glm::vec3(bboxMax[0], bboxMax[1], bboxMax[2]), glm::vec3(0.f, 1.f, 0.f), glm::vec4(1.f), glm::vec2(1.f, 0.f) }));
+	verts.push_back(PrimVert({ glm::vec3(bboxMax[0], bboxMax[1], bboxMin[2]), glm::vec3(0.f, 1.f, 0.f), glm::vec4(1.f), glm::vec2(1.f) }));
+	verts.push_back(PrimVert({ glm::vec3(bboxMin[0], bboxMax[1], bboxMin[2]), glm::vec3(0.f, 1.f, 0.f), glm::vec4(1.f), glm::vec2(0.f, 1.f) }));
+	verts.push_back(PrimVert({ glm::vec3(bboxMin[0], bboxMax[1], bboxMax[2]), glm::vec3(0.f, 1.f, 0.f), glm::vec4(1.f), glm::vec2(0.f) }));
+	inds.push_back(verts.size() - 4);
+	inds.push_back(verts.size() - 3);
+	inds.push_back(verts.size() - 1);
+	inds.push_back(verts.size() - 3);
+	inds.push_back(verts.size() - 2);
+	inds.push_back(verts.size() - 1);
 
 	// Left
 	verts.push_back(PrimVert({ glm::vec3(bboxMin[0], bboxMin[1], bboxMin[2]), glm::vec3(-1.f, 0.f, 0.f), glm::vec4(1.f), glm::vec2(0.f) }));
@@ -1085,33 +2003,7 @@ void Renderer::generateCube()
 	inds.push_back(verts.size() - 2);
 	inds.push_back(verts.size() - 1);
 
-	glGenVertexArrays(1, &m_glCubeVAO);
-	glGenBuffers(1, &m_glCubeVBO);
-	glGenBuffers(1, &m_glCubeEBO);
-
-	// Setup VAO
-	glBindVertexArray(m_glCubeVAO);
-	// Load data into vertex buffers
-	glBindBuffer(GL_ARRAY_BUFFER, m_glCubeVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_glCubeEBO);
-
-	// Set the vertex attribute pointers
-	glEnableVertexAttribArray(POSITION_ATTRIB_LOCATION);
-	glVertexAttribPointer(POSITION_ATTRIB_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(PrimVert), (GLvoid*)offsetof(PrimVert, p));
-	glEnableVertexAttribArray(NORMAL_ATTRIB_LOCATION);
-	glVertexAttribPointer(NORMAL_ATTRIB_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(PrimVert), (GLvoid*)offsetof(PrimVert, n));
-	glEnableVertexAttribArray(COLOR_ATTRIB_LOCATION);
-	glVertexAttribPointer(COLOR_ATTRIB_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(PrimVert), (GLvoid*)offsetof(PrimVert, c));
-	glEnableVertexAttribArray(TEXCOORD_ATTRIB_LOCATION);
-	glVertexAttribPointer(TEXCOORD_ATTRIB_LOCATION, 2, GL_FLOAT, GL_FALSE, sizeof(PrimVert), (GLvoid*)offsetof(PrimVert, t));
-	glBindVertexArray(0);
-
-	// Alloc buffer and store data
-	glNamedBufferStorage(m_glCubeVBO, verts.size() * sizeof(PrimVert), &verts[0], GL_NONE);
-	// Element array buffer
-	glNamedBufferStorage(m_glCubeEBO, inds.size() * sizeof(GLushort), &inds[0], GL_NONE);
-
-	m_mapPrimitives["cube"] = m_mapPrimitives["box"] = std::make_pair(m_glCubeVAO, inds.size());
+	m_mapPrimitives["cube"] = m_mapPrimitives["box"] = addPrimitiveMesh(verts, inds);
 }
 
 // Essentially a unit cube wireframe
@@ -1150,33 +2042,9 @@ void Renderer::generateBBox()
 	std::vector<GLushort> inds(12 * 2);
 	std::iota(inds.begin(), inds.end(), 0u);
 
-	glGenVertexArrays(1, &m_glBBoxVAO);
-	glGenBuffers(1, &m_glBBoxVBO);
-	glGenBuffers(1, &m_glBBoxEBO);
-
-	// Setup VAO
-	glBindVertexArray(m_glBBoxVAO);
-	// Load data into vertex buffers
-	glBindBuffer(GL_ARRAY_BUFFER, m_glBBoxVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_glBBoxEBO);
-
-	// Set the vertex attribute pointers
-	glEnableVertexAttribArray(POSITION_ATTRIB_LOCATION);
-	glVertexAttribPointer(POSITION_ATTRIB_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(PrimVert), (GLvoid*)offsetof(PrimVert, p));
-	glEnableVertexAttribArray(NORMAL_ATTRIB_LOCATION);
-	glVertexAttribPointer(NORMAL_ATTRIB_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(PrimVert), (GLvoid*)offsetof(PrimVert, n));
-	glEnableVertexAttribArray(COLOR_ATTRIB_LOCATION);
-	glVertexAttribPointer(COLOR_ATTRIB_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(PrimVert), (GLvoid*)offsetof(PrimVert, c));
-	glEnableVertexAttribArray(TEXCOORD_ATTRIB_LOCATION);
-	glVertexAttribPointer(TEXCOORD_ATTRIB_LOCATION, 2, GL_FLOAT, GL_FALSE, sizeof(PrimVert), (GLvoid*)offsetof(PrimVert, t));
-	glBindVertexArray(0);
-
-	// Alloc buffer and store data
-	glNamedBufferStorage(m_glBBoxVBO, verts.size() * sizeof(PrimVert), &verts[0], GL_NONE);
-	// Element array buffer
-	glNamedBufferStorage(m_glBBoxEBO, inds.size() * sizeof(GLushort), &inds[0], GL_NONE);
-
-	m_mapPrimitives["bbox_lines"] = std::make_pair(m_glBBoxVAO, inds.size()); 
+	PrimitiveMesh bbox = addPrimitiveMesh(verts, inds);
+	bbox.primitiveType = GL_LINES;
+	m_mapPrimitives["bbox_lines"] = bbox;
 }
 
 void Renderer::setupText()
@@ -1195,8 +2063,10 @@ void Renderer::setupText()
 	// Set size to load glyphs as
 	FT_Set_Pixel_Sizes(face, 0, m_uiFontPointSize);
 
-	// Disable byte-alignment restriction
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	// Glyph bitmaps are held until both fonts are loaded, then packed one per layer into an array
+	// texture sized to the largest glyph, so every text draw uses the same texture
+	std::vector<std::vector<GLubyte>> vGlyphBitmaps;
+	glm::ivec2 layerSize(1, 1);
 
 	// Load first 128 characters of ASCII set
 	for (GLubyte c = 0; c < 128; c++)
@@ -1207,41 +2077,18 @@ void Renderer::setupText()
 			std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
 			continue;
 		}
-		// Generate texture
-		GLuint texture;
-		glGenTextures(1, &texture);
-		glBindTexture(GL_TEXTURE_2D, texture);
-		glTexImage2D(
-			GL_TEXTURE_2D,
-			0,
-			GL_RED,
-			face->glyph->bitmap.width,
-			face->glyph->bitmap.rows,
-			0,
-			GL_RED,
-			GL_UNSIGNED_BYTE,
-			face->glyph->bitmap.buffer
-		);
-		// Set texture options
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 		// Now store character for later use
 		Character character = {
-			texture,
+			static_cast<GLuint>(vGlyphBitmaps.size()),
+			glm::vec2(1.f),
 			glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
 			glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
 			glm::ivec2(face->glyph->advance.x, face->glyph->advance.y)
 		};
 		m_arrCharacters[c] = character;
-		char tmp[2];
-		tmp[0] = c;
-		tmp[1] = '\0';
-		//std::cout << "Adding character \'" << std::string((const char*)&c) << "\' to text renderer..." << std::endl;
-		addTexture(new GLTexture(std::string(tmp), face->glyph->bitmap.width, face->glyph->bitmap.rows, texture, true));
+		vGlyphBitmaps.push_back(std::vector<GLubyte>(face->glyph->bitmap.buffer, face->glyph->bitmap.buffer + character.Size.x * character.Size.y));
+		layerSize = glm::max(layerSize, character.Size);
 	}
-	glBindTexture(GL_TEXTURE_2D, 0);
 	// Destroy FreeType once we're finished
 	FT_Done_Face(face);
 
@@ -1266,46 +2113,56 @@ void Renderer::setupText()
 				std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
 				continue;
 			}
-			// Generate texture
-			GLuint texture;
-			glGenTextures(1, &texture);
-			glBindTexture(GL_TEXTURE_2D, texture);
-			glTexImage2D(
-				GL_TEXTURE_2D,
-				0,
-				GL_RED,
-				face->glyph->bitmap.width,
-				face->glyph->bitmap.rows,
-				0,
-				GL_RED,
-				GL_UNSIGNED_BYTE,
-				face->glyph->bitmap.buffer
-			);
-			// Set texture options
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 			// Now store character for later use
 			Character character = {
-				texture,
+				static_cast<GLuint>(vGlyphBitmaps.size()),
+				glm::vec2(1.f),
 				glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
 				glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
 				glm::ivec2(face->glyph->advance.x, face->glyph->advance.y)
 			};
 			m_mapSloanCharacters[c] = character;
-			char tmp[2];
-			tmp[0] = c;
-			tmp[1] = '\0';
-			//std::cout << "Adding character \'" << std::string(tmp) + "_sloan" << "\' to text renderer..." << std::endl;
-			addTexture(new GLTexture(std::string(tmp) + "_sloan", face->glyph->bitmap.width, face->glyph->bitmap.rows, texture, true));
+			vGlyphBitmaps.push_back(std::vector<GLubyte>(face->glyph->bitmap.buffer, face->glyph->bitmap.buffer + character.Size.x * character.Size.y));
+			layerSize = glm::max(layerSize, character.Size);
 		}
-		glBindTexture(GL_TEXTURE_2D, 0);
 		// Destroy FreeType once we're finished
 		FT_Done_Face(face);
 	}
 
 	FT_Done_FreeType(ft);
+
+	// Generate texture
+	GLuint glyphArray;
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &glyphArray);
+	glTextureStorage3D(glyphArray, 1, GL_R8, layerSize.x, layerSize.y, static_cast<GLsizei>(vGlyphBitmaps.size()));
+
+	// texels outside a glyph read as zero, like the border of a texture that fits it exactly
+	GLubyte zero = 0u;
+	glClearTexImage(glyphArray, 0, GL_RED, GL_UNSIGNED_BYTE, &zero);
+
+	// Disable byte-alignment restriction
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	auto uploadGlyph = [&](Character &ch) {
+		ch.TexCoordScale = glm::vec2(ch.Size) / glm::vec2(layerSize);
+		if (ch.Size.x > 0 && ch.Size.y > 0)
+			glTextureSubImage3D(glyphArray, 0, 0, 0, ch.Layer, ch.Size.x, ch.Size.y, 1, GL_RED, GL_UNSIGNED_BYTE, vGlyphBitmaps[ch.Layer].data());
+	};
+
+	for (auto &ch : m_arrCharacters)
+		if (ch.Layer < vGlyphBitmaps.size())
+			uploadGlyph(ch);
+
+	for (auto &ch : m_mapSloanCharacters)
+		uploadGlyph(ch.second);
+
+	// Set texture options
+	glTextureParameteri(glyphArray, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTextureParameteri(glyphArray, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	glTextureParameteri(glyphArray, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(glyphArray, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	addTexture(new GLTexture(RENDERER_GLYPH_TEXTURE_NAME, layerSize.x, layerSize.y, glyphArray, true));
 }
 
 void Renderer::drawText(std::string text, glm::vec4 color, glm::vec3 pos, glm::quat rot, GLfloat size, TextSizeDim sizeDim, TextAlignment alignment, TextAnchor anchor, bool snellenFont)
@@ -1336,7 +2193,7 @@ void Renderer::drawText(std::string text, glm::vec4 color, glm::vec3 pos, glm::q
 			continue;
 		}
 
-		Character* charDesc = snellenFont ? &m_mapSloanCharacters[charCurrent] : &m_arrCharacters[charCurrent];
+		Character* charDesc = snellenFont ? &m_mapSloanCharacters[charCurrent] : &getCharacter(charCurrent);
 
 		if (numLines == 1 && charDesc->Bearing.y > firstLineMaxHeight)
 			firstLineMaxHeight = charDesc->Bearing.y;
@@ -1414,7 +2271,7 @@ void Renderer::drawText(std::string text, glm::vec4 color, glm::vec3 pos, glm::q
 			continue;
 		}
 
-		Character *ch = snellenFont ? &m_mapSloanCharacters[*c] : &m_arrCharacters[*c];
+		Character *ch = snellenFont ? &m_mapSloanCharacters[*c] : &getCharacter(*c);
 
 		GLfloat xpos = cursor.x + (ch->Bearing.x + 0.5f * ch->Size.x);
 		GLfloat ypos = cursor.y + (ch->Bearing.y - 0.5f * ch->Size.y);
@@ -1430,18 +2287,13 @@ void Renderer::drawText(std::string text, glm::vec4 color, glm::vec3 pos, glm::q
 		if (*c == ' ')
 			continue;
 
-		std::stringstream diffTexName;
-		diffTexName << *c;
-		if (snellenFont) diffTexName << "_sloan";
-
 		RendererSubmission rs;
 		rs.glPrimitiveType = GL_TRIANGLES;
 		rs.shaderName = "text";
 		rs.modelToWorldTransform = glm::translate(glm::mat4(), pos) * glm::mat4(rot) * glm::scale(glm::mat4(), glm::vec3(scale, scale, 1.f)) * trans;
-		rs.VAO = m_mapPrimitives["quaddouble"].first;
-		rs.vertCount = m_mapPrimitives["quaddouble"].second;
-		rs.indexType = GL_UNSIGNED_SHORT;
-		rs.diffuseTexName = diffTexName.str();
+		setSubmissionPrimitive(rs, "quaddouble");
+		rs.diffuseTexName = RENDERER_GLYPH_TEXTURE_NAME;
+		rs.texCoordTransform = glm::vec4(ch->TexCoordScale, ch->Layer, 0.f);
 		rs.diffuseColor = color;
 
 		addToDynamicRenderQueue(rs);
@@ -1474,14 +2326,14 @@ void Renderer::drawUIText(std::string text, glm::vec4 color, glm::vec3 pos, glm:
 			continue;
 		}
 
-		if (numLines == 1 && m_arrCharacters[*c].Bearing.y > firstLineMaxHeight)
-			firstLineMaxHeight = m_arrCharacters[*c].Bearing.y;
+		if (numLines == 1 && getCharacter(*c).Bearing.y > firstLineMaxHeight)
+			firstLineMaxHeight = getCharacter(*c).Bearing.y;
 
-		int padding = m_arrCharacters[*c].Size.y - m_arrCharacters[*c].Bearing.y;
+		int padding = getCharacter(*c).Size.y - getCharacter(*c).Bearing.y;
 		if (padding > lastLinePadding)
 			lastLinePadding = padding;
 
-		cursorDistOnBaseline += (m_arrCharacters[*c].Advance.x >> 6);
+		cursorDistOnBaseline += (getCharacter(*c).Advance.x >> 6);
 		if (cursorDistOnBaseline > maxCursorDist)
 			maxCursorDist = cursorDistOnBaseline;
 	}
@@ -1550,7 +2402,7 @@ void Renderer::drawUIText(std::string text, glm::vec4 color, glm::vec3 pos, glm:
 			continue;
 		}
 
-		Character ch = m_arrCharacters[*c];
+		Character ch = getCharacter(*c);
 
 		GLfloat xpos = cursor.x + (ch.Bearing.x + 0.5f * ch.Size.x);
 		GLfloat ypos = cursor.y + (ch.Bearing.y - 0.5f * ch.Size.y);
@@ -1564,10 +2416,9 @@ void Renderer::drawUIText(std::string text, glm::vec4 color, glm::vec3 pos, glm:
 		rs.glPrimitiveType = GL_TRIANGLES;
 		rs.shaderName = "text";
 		rs.modelToWorldTransform = glm::translate(glm::mat4(), pos) * glm::mat4(rot) * glm::scale(glm::mat4(), glm::vec3(scale, scale, 1.f)) * trans;
-		rs.VAO = m_mapPrimitives["quaddouble"].first;
-		rs.vertCount = m_mapPrimitives["quaddouble"].second;
-		rs.indexType = GL_UNSIGNED_SHORT;
-		rs.diffuseTexName = *c;
+		setSubmissionPrimitive(rs, "quaddouble");
+		rs.diffuseTexName = RENDERER_GLYPH_TEXTURE_NAME;
+		rs.texCoordTransform = glm::vec4(ch.TexCoordScale, ch.Layer, 0.f);
 		rs.diffuseColor = color;
 
 		addToUIRenderQueue(rs);
@@ -1600,14 +2451,14 @@ glm::vec2 Renderer::getTextDimensions(std::string text, float size, TextSizeDim
 			continue;
 		}
 
-		if (numLines == 1 && m_arrCharacters[*c].Bearing.y > firstLineMaxHeight)
-			firstLineMaxHeight = m_arrCharacters[*c].Bearing.y;
+		if (numLines == 1 && getCharacter(*c).Bearing.y > firstLineMaxHeight)
+			firstLineMaxHeight = getCharacter(*c).Bearing.y;
 
-		int padding = m_arrCharacters[*c].Size.y - m_arrCharacters[*c].Bearing.y;
+		int padding = getCharacter(*c).Size.y - getCharacter(*c).Bearing.y;
 		if (padding > lastLinePadding)
 			lastLinePadding = padding;
 
-		cursorDistOnBaseline += (m_arrCharacters[*c].Advance.x >> 6);
+		cursorDistOnBaseline += (getCharacter(*c).Advance.x >> 6);
 		if (cursorDistOnBaseline > maxCursorDist)
 			maxCursorDist = cursorDistOnBaseline;
 	}
@@ -1628,7 +2479,10 @@ GLuint Renderer::getPrimitiveVAO(std::string primName)
 		return 0;
 	}
 
-	return prim->second.first;
+	if (prim->second.stream >= 0)
+		return m_MeshStreamer.getVAO(prim->second.stream);
+
+	return m_glPrimitiveVAO;
 }
 
 GLsizei Renderer::getPrimitiveIndexCount(std::string primName)
@@ -1641,7 +2495,83 @@ GLsizei Renderer::getPrimitiveIndexCount(std::string primName)
 		return 0;
 	}
 
-	return prim->second.second;
+	if (prim->second.stream >= 0)
+		return m_MeshStreamer.getIndexCount(prim->second.stream);
+
+	return prim->second.indexCount;
+}
+
+bool Renderer::setSubmissionPrimitive(RendererSubmission & rs, std::string primName)
+{
+	auto prim = m_mapPrimitives.find(primName);
+
+	if (prim == m_mapPrimitives.end())
+	{
+		std::cerr << "Primitive \"" << primName << "\" not found!" << std::endl;
+		return false;
+	}
+
+	rs.glPrimitiveType = prim->second.primitiveType;
+	rs.VAO = m_glPrimitiveVAO;
+	rs.vertCount = prim->second.indexCount;
+	rs.indexType = GL_UNSIGNED_SHORT;
+	rs.firstIndex = prim->second.firstIndex;
+	rs.baseVertex = prim->second.baseVertex;
+	rs.boundingSphere = prim->second.boundingSphere;
+	rs.lodChain = prim->second.lodChain;
+	rs.lodLevel = -1;
+	rs.stream = prim->second.stream;
+
+	if (rs.stream >= 0)
+	{
+		rs.VAO = m_MeshStreamer.getVAO(rs.stream);
+		rs.vertCount = m_MeshStreamer.getIndexCount(rs.stream);
+		rs.indexType = m_MeshStreamer.getIndexType(rs.stream);
+	}
+
+	return true;
+}
+
+glm::vec4 Renderer::getPrimitiveBoundingSphere(std::string primName)
+{
+	auto prim = m_mapPrimitives.find(primName);
+
+	if (prim == m_mapPrimitives.end())
+		return glm::vec4(0.f, 0.f, 0.f, -1.f);
+
+	return prim->second.boundingSphere;
+}
+
+// center of the bounding box and the farthest point from it; loose, but cheap and stable
+glm::vec4 Renderer::computeBoundingSphere(std::vector<glm::vec3> const &points)
+{
+	if (points.empty())
+		return glm::vec4(0.f, 0.f, 0.f, -1.f);
+
+	glm::vec3 bbMin(points[0]), bbMax(points[0]);
+	for (auto const &p : points)
+	{
+		bbMin = glm::min(bbMin, p);
+		bbMax = glm::max(bbMax, p);
+	}
+
+	glm::vec3 center = (bbMin + bbMax) * 0.5f;
+
+	float radius2 = 0.f;
+	for (auto const &p : points)
+		radius2 = std::max(radius2, glm::length2(p - center));
+
+	return glm::vec4(center, sqrt(radius2));
+}
+
+glm::vec4 Renderer::computeBoundingSphere(std::vector<PrimVert> const &verts)
+{
+	std::vector<glm::vec3> points;
+	points.reserve(verts.size());
+	for (auto const &v : verts)
+		points.push_back(v.p);
+
+	return computeBoundingSphere(points);
 }
 
 glm::mat4 Renderer::getBillBoardTransform(const glm::vec3 & pos, const glm::vec3 & at, const glm::vec3 &up, bool lockToUpVector)
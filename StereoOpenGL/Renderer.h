@@ -4,8 +4,25 @@
 #include <GLTexture.h>
 #include <gtc/quaternion.hpp>
 #include <chrono>
+#include <functional>
 #include "LightingSystem.h"
 #include "shaderset.h"
+#include "FrustumCuller.h"
+#include "TransparencySorter.h"
+#include "MeshCache.h"
+#include "MeshStreamer.h"
+#include "PointCloud.h"
+
+#define RENDERER_CULL_MIN_PIXELS	0.25f	// submissions whose bounds project smaller than this radius are skipped
+#define RENDERER_OIT_AUTO_THRESHOLD	64		// TRANSPARENCY_AUTO switches to weighted-blended OIT at this many transparent submissions
+#define RENDERER_OIT_SHADER_DEFINES	"#define WEIGHTED_BLENDED_OIT\n"
+#define RENDERER_MDI_SHADER_DEFINES	"#define MULTI_DRAW_INDIRECT\n"
+#define RENDERER_BINDLESS_SHADER_DEFINES	"#define BINDLESS_TEXTURES\n"
+#define RENDERER_GLYPH_TEXTURE_NAME	"glyphs"	// array texture holding every font glyph, one per layer
+#define RENDERER_MESH_OVERDRAW_THRESHOLD	1.05f	// ACMR the overdraw ordering of generated meshes may give up (<= 0 skips it)
+#define RENDERER_LOD_ERROR_PIXELS	0.5f	// primitives draw the coarsest level whose tessellation error projects under this
+#define RENDERER_MESH_CACHE_REVISION	1		// bump when a primitive generator or the mesh optimizer changes its output
+#define RENDERER_LOD_HYSTERESIS		0.2f	// fraction past RENDERER_LOD_ERROR_PIXELS before a level changes, so eyes and frames agree
 
 struct FrameUniforms {
 	glm::vec4 v4Viewport;
@@ -14,6 +31,18 @@ struct FrameUniforms {
 	glm::mat4 m4ViewProjection;
 };
 
+// one entry of the draw data storage buffer (std430), see PER-DRAW INPUTS in GLSLpreamble.h
+struct DrawData {
+	glm::mat4 m4Model;
+	glm::vec4 v4DiffuseColor;
+	glm::vec4 v4SpecularColor;
+	glm::vec4 v4TexCoordTransform;
+	GLuint64 diffuseTexHandle;	// bindless handles, 0 without ARB_bindless_texture
+	GLuint64 specularTexHandle;
+	float fShininess;
+	float pad[3];
+};
+
 class Renderer
 {
 public:
@@ -24,18 +53,35 @@ public:
 		GLuint m_nRenderFramebufferId;
 		GLuint m_nResolveTextureId;
 		GLuint m_nResolveFramebufferId;
+		GLuint m_nOITAccumTextureId;		// weighted premultiplied color sum
+		GLuint m_nOITRevealageTextureId;	// product of (1 - alpha)
+		GLuint m_nOITFramebufferId;			// both of the above plus the render depth buffer
+		int m_nWidth;
+		int m_nHeight;
+		bool m_bOITAllocated;				// OIT storage is only allocated the first time the OIT pass runs
+		bool m_bOITComplete;
 
 		FramebufferDesc()
+			: m_nWidth(0)
+			, m_nHeight(0)
+			, m_bOITAllocated(false)
+			, m_bOITComplete(false)
 		{
 			glCreateRenderbuffers(1, &m_nDepthBufferId);
 			glCreateTextures(GL_TEXTURE_2D_MULTISAMPLE, 1, &m_nRenderTextureId);
 			glCreateFramebuffers(1, &m_nRenderFramebufferId);
 			glCreateTextures(GL_TEXTURE_2D, 1, &m_nResolveTextureId);
 			glCreateFramebuffers(1, &m_nResolveFramebufferId);
+			glCreateTextures(GL_TEXTURE_2D_MULTISAMPLE, 1, &m_nOITAccumTextureId);
+			glCreateTextures(GL_TEXTURE_2D_MULTISAMPLE, 1, &m_nOITRevealageTextureId);
+			glCreateFramebuffers(1, &m_nOITFramebufferId);
 		}
 
 		~FramebufferDesc()
 		{
+			glDeleteFramebuffers(1, &m_nOITFramebufferId);
+			glDeleteTextures(1, &m_nOITRevealageTextureId);
+			glDeleteTextures(1, &m_nOITAccumTextureId);
 			glDeleteFramebuffers(1, &m_nResolveFramebufferId);
 			glDeleteTextures(1, &m_nResolveTextureId);
 			glDeleteFramebuffers(1, &m_nRenderFramebufferId);
@@ -50,6 +96,8 @@ public:
 		GLuint			VAO;
 		int				vertCount;
 		GLenum			indexType;
+		GLuint			firstIndex;		// into the VAO's element buffer
+		GLint			baseVertex;		// added to every index
 		std::string		shaderName;
 		GLenum			vertWindingOrder;
 		glm::vec4		diffuseColor;
@@ -57,15 +105,22 @@ public:
 		std::string		diffuseTexName;
 		std::string		specularTexName;
 		float			specularExponent;
+		glm::vec4		texCoordTransform; // xy scale texture coordinates, z is the layer of an array texture
 		bool			hasTransparency;
 		glm::vec4		transparencySortPosition;
 		glm::mat4		modelToWorldTransform;
+		glm::vec4		boundingSphere; // object space center and radius; negative radius is never culled
+		int				lodChain;		// primitive level of detail chain, -1 if the geometry has a single level
+		int				lodLevel;		// level drawn for the last view, -1 until the first
+		int				stream;			// streamed mesh whose uploaded part is drawn, -1 for other geometry
 
 		RendererSubmission()
 			: glPrimitiveType(GL_NONE)
 			, VAO(0)
 			, vertCount(0)
 			, indexType(GL_UNSIGNED_SHORT)
+			, firstIndex(0u)
+			, baseVertex(0)
 			, shaderName("")
 			, vertWindingOrder(GL_CCW)
 			, diffuseColor(glm::vec4(1.f))
@@ -73,21 +128,17 @@ public:
 			, diffuseTexName("white")
 			, specularTexName("white")
 			, specularExponent(0.f)
+			, texCoordTransform(glm::vec4(1.f, 1.f, 0.f, 0.f))
 			, hasTransparency(false)
 			, transparencySortPosition(glm::vec4(0.f, 0.f, 0.f, -1.f))
 			, modelToWorldTransform(glm::mat4())
+			, boundingSphere(glm::vec4(0.f, 0.f, 0.f, -1.f))
+			, lodChain(-1)
+			, lodLevel(-1)
+			, stream(-1)
 		{}
 	};
 
-	class ObjectSorter {
-		glm::vec3 _HMDPos;
-	public:
-		ObjectSorter(glm::vec3 HMDPos) : _HMDPos(HMDPos) {}
-		bool operator()(RendererSubmission lhs, RendererSubmission rhs) const {
-			return sortByViewDistance(lhs, rhs, _HMDPos);
-		}
-	};
-
 	struct SceneViewInfo {
 		glm::mat4 view;
 		glm::mat4 projection;
@@ -102,6 +153,36 @@ public:
 		glm::vec3 up;
 	};
 
+	// GL calls issued by the render queues since the last resetRenderStats()
+	struct RenderStats {
+		unsigned int submissions;
+		unsigned int drawCalls;
+		unsigned int programBinds;
+		unsigned int vertexArrayBinds;
+		unsigned int textureBinds;
+		unsigned int uniformUpdates;
+		unsigned int culledOutside;		// outside the view frustum
+		unsigned int culledTooSmall;	// under RENDERER_CULL_MIN_PIXELS on screen
+		unsigned long long primitiveVertexBytes;	// indices drawn from the primitive arena times its vertex size (no post-transform cache)
+		unsigned int coarserLODs;		// primitive submissions drawn below their finest level of detail
+		unsigned long long streamedBytes;	// mesh data uploaded by updateStreaming()
+		unsigned int pointCloudNodes;	// octree nodes drawn, summed over views
+		unsigned long long pointCloudPoints;
+
+		unsigned int stateChanges() const { return programBinds + vertexArrayBinds + textureBinds; }
+	};
+
+	// vertex of the primitive meshes, and of the mesh cache files they are stored in
+	struct PrimVert {
+		glm::vec3 p; // point
+		glm::vec3 n; // normal
+		glm::vec4 c; // color
+		glm::vec2 t; // texture coord
+	};
+
+	// fills an indexed triangle list and returns its tessellation error in object units (0 for exact meshes)
+	typedef std::function<float(std::vector<PrimVert> &verts, std::vector<GLushort> &inds)> PrimitiveGenerator;
+
 public:	
 	// Singleton instance access
 	static Renderer& getInstance()
@@ -142,6 +223,13 @@ public:
 		WIDTH,
 		HEIGHT
 	};
+
+	// how the transparent queues are composited
+	enum TransparencyMode {
+		TRANSPARENCY_SORTED,			// back-to-front sort, blended in order with depth test off
+		TRANSPARENCY_WEIGHTED_BLENDED,	// weighted-blended OIT, no sort, depth tested against opaque geometry
+		TRANSPARENCY_AUTO				// sorted below RENDERER_OIT_AUTO_THRESHOLD submissions, OIT above
+	};
 	
 	bool init();
 
@@ -168,6 +256,32 @@ public:
 
 	GLuint getPrimitiveVAO(std::string primName);
 	GLsizei getPrimitiveIndexCount(std::string primName);
+	glm::vec4 getPrimitiveBoundingSphere(std::string primName);
+	// fills in the VAO, index range and bounds of a built-in primitive
+	bool setSubmissionPrimitive(RendererSubmission &rs, std::string primName);
+	// Adds a mesh to the primitive arena after init(). The generator only runs when the mesh cache
+	// has nothing for cacheKey, so it should name everything the mesh depends on. Meshes are
+	// limited to 65536 vertices since the arena indices are 16-bit.
+	bool addPrimitive(std::string primName, std::string cacheKey, PrimitiveGenerator generator);
+	// Each addPrimitive() call rebuilds the whole arena. Between these two calls, addPrimitive()
+	// only checks the name, and the arena is rebuilt once at the end. endPrimitiveRegistration()
+	// returns false if any mesh in the batch could not be built; those meshes are left out.
+	void beginPrimitiveRegistration();
+	bool endPrimitiveRegistration();
+	// Maps a mesh file (MeshCache format with PrimVert vertices, e.g. a converted survey) and adds
+	// it as primName right away; updateStreaming() uploads it over the following frames, and until
+	// then draws show the part loaded so far
+	bool streamPrimitive(std::string primName, std::string path);
+	// uploads up to MESHSTREAMER_SEGMENT_BYTES of streamed meshes and the point cloud nodes loaded
+	// since the last call; call once per frame outside RenderFrame() so both eyes draw the same data
+	void updateStreaming();
+	size_t getStreamingBytesPending() const { return m_MeshStreamer.getPendingBytes(); }
+
+	// Opens a point octree (see PointOctreeBuilder) as name, with gpuBudgetMB of node storage
+	bool addPointCloud(std::string name, std::string path, size_t gpuBudgetMB = POINTCLOUD_GPU_BUDGET_MB);
+	// draws the cloud this frame; every view picks its own nodes from the octree
+	bool drawPointCloud(std::string name, glm::mat4 modelTransform);
+	PointCloud* getPointCloud(std::string name);
 
 	static glm::mat4 getBillBoardTransform(const glm::vec3 &pos, const glm::vec3 &viewPos, const glm::vec3 &up, bool lockToUpVector);
 
@@ -180,6 +294,43 @@ public:
 
 	void sortTransparentObjects(glm::vec3 HMDPos);
 
+	void setTransparencyMode(TransparencyMode mode) { m_eTransparencyMode = mode; }
+	TransparencyMode getTransparencyMode() const { return m_eTransparencyMode; }
+	bool usingOIT() const;
+	static const char* transparencyModeName(TransparencyMode mode);
+
+	RenderStats getRenderStats() const { return m_RenderStats; }
+	void resetRenderStats();
+
+	void setCulling(bool enabled) { m_bCulling = enabled; }
+	bool getCulling() const { return m_bCulling; }
+
+	// merges runs of submissions that share state into one glMultiDrawElementsIndirect call;
+	// needs ARB_shader_draw_parameters, otherwise every submission is drawn on its own
+	void setMultiDrawIndirect(bool enabled) { m_bMultiDrawIndirect = enabled; }
+	bool getMultiDrawIndirect() const { return m_bMultiDrawIndirect && m_bMultiDrawIndirectSupported; }
+	// multi-draws sample textures through resident handles, so texture changes don't split them
+	bool getBindlessTextures() const { return getMultiDrawIndirect() && m_bBindlessTextures; }
+
+	// built-in primitives store half positions and texture coords, 10-bit normals and 8-bit colors;
+	// changing it rebuilds the primitive arena in place, so queued submissions stay valid
+	void setPackedVertices(bool enabled);
+	bool getPackedVertices() const { return m_bPackedVertices; }
+	size_t getPrimitiveVertexSize() const;
+	size_t getPrimitiveArenaBytes() const { return m_nPrimitiveArenaBytes; }
+
+	// icospheres, cylinders and tori pick a tessellation per view from their projected size
+	void setLevelOfDetail(bool enabled) { m_bLevelOfDetail = enabled; }
+	bool getLevelOfDetail() const { return m_bLevelOfDetail; }
+
+	// generated primitives are written to the mesh cache on first run and mapped from it afterwards;
+	// disable it before init() to regenerate everything
+	void setMeshCache(bool enabled) { m_MeshCache.setEnabled(enabled); }
+	bool getMeshCache() const { return m_MeshCache.getEnabled(); }
+	float getPrimitiveSetupMS() const { return m_fPrimitiveSetupMS; }
+	unsigned int getCachedPrimitiveCount() const { return m_MeshCache.getLoadedCount(); }
+	unsigned int getGeneratedPrimitiveCount() const { return m_uiGeneratedPrimitives; }
+
 	void RenderFrame(SceneViewInfo *sceneViewInfo, SceneViewInfo *sceneViewUIInfo, FramebufferDesc *frameBuffer);
 	void RenderUI(SceneViewInfo *sceneViewInfo, FramebufferDesc *frameBuffer);
 	void RenderFullscreenTexture(int width, int height, GLuint textureID, bool textureAspectPortrait = false);
@@ -199,29 +350,71 @@ private:
 	void setupFullscreenQuad();
 
 	void setupPrimitives();
-	void generateIcosphere(int recursionLevel);
-	void generateTorus(float coreRadius, float meridianRadius, int numCoreSegments, int numMeridianSegments);
-	void generateCylinder(int numSegments);
 	void generatePlane();
 	void generateCube();
 	void generateBBox();
 
 	void setupText();
 
-	void processRenderQueue(std::vector<RendererSubmission> &renderQueue);
-
-	static bool sortByViewDistance(RendererSubmission const &rsLHS, RendererSubmission const &rsRHS, glm::vec3 const &HMDPos);
+	void processRenderQueue(std::vector<RendererSubmission> &renderQueue, bool cull = false);
+	void processTransparentRenderQueue();
+	bool createOITTargets(FramebufferDesc &framebufferDesc);
+	void renderTransparencyOIT(FramebufferDesc *frameBuffer);
+	void renderPointClouds(SceneViewInfo *sceneViewInfo);
+	void processDrawList();
+	void processMultiDrawIndirect();
+	void processRenderSubmission(RendererSubmission &rs);
+	void selectLevelOfDetail(RendererSubmission &rs);
+	GLuint* getSubmissionProgram(RendererSubmission const &rs, bool multiDraw);
+	bool canShareMultiDraw(RendererSubmission const &a, RendererSubmission const &b) const;
+	void unbindRenderQueueVAO();
+	static size_t indexTypeSize(GLenum indexType);
+
+	RendererSubmission& getTransparentSubmission(uint32_t index);
+	static glm::vec3 getTransparencySortPosition(RendererSubmission const &rs);
 
 private:
-	struct PrimVert {
-		glm::vec3 p; // point
-		glm::vec3 n; // normal
-		glm::vec4 c; // color
-		glm::vec2 t; // texture coord
+	// layout glMultiDrawElementsIndirect reads from the draw indirect buffer
+	struct DrawElementsIndirectCommand {
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// a range of the shared primitive arena
+	struct PrimitiveMesh {
+		GLint baseVertex;
+		GLuint firstIndex;
+		GLsizei indexCount;
+		glm::vec4 boundingSphere; // object space center and radius
+		float lodError; // tessellation error as a fraction of the bounding radius
+		int lodChain; // index into m_vPrimitiveLODs, -1 for a single level
+		GLenum primitiveType;
+		int stream; // MeshStreamer stream holding the mesh instead of the arena, -1 for arena meshes
 	};
 
+	PrimitiveMesh generateIcosphere(int recursionLevel);
+	PrimitiveMesh generateTorus(float coreRadius, float meridianRadius, int numCoreSegments, int numMeridianSegments);
+	PrimitiveMesh generateCylinder(int numSegments);
+
+	PrimitiveMesh addPrimitiveMesh(std::vector<PrimVert> const &verts, std::vector<GLushort> const &inds);
+	bool addCachedPrimitiveMesh(std::string const &cacheKey, PrimitiveGenerator const &generator, PrimitiveMesh &mesh);
+	void optimizePrimitiveMesh(std::string const &name, std::vector<PrimVert> &verts, std::vector<GLushort> &inds);
+	void addPrimitiveLODs(std::vector<std::string> const &names, std::vector<PrimitiveMesh> const &lods);
+	void uploadPrimitiveArena();
+	// rebuilds the arena and drops custom primitives from firstNew on that failed to build
+	bool buildCustomPrimitives(size_t firstNew);
+	static bool checkPrimitiveMesh(std::string const &name, const GLushort* inds, size_t indexCount, size_t vertexCount);
+
+	static glm::vec4 computeBoundingSphere(std::vector<glm::vec3> const &points);
+	static glm::vec4 computeBoundingSphere(std::vector<PrimVert> const &verts);
+	static void setPrimVertFormat(GLuint vao, GLuint bindingIndex);
+
 	struct Character {
-		GLuint TextureID;   // ID handle of the glyph texture
+		GLuint Layer;       // Layer of the glyph texture array
+		glm::vec2 TexCoordScale; // Share of the layer the glyph covers
 		glm::ivec2 Size;    // Size of glyph
 		glm::ivec2 Bearing;  // Offset from baseline to left/top of glyph
 		glm::ivec2 Advance;    // Horizontal offset to advance to next glyph
@@ -229,6 +422,8 @@ private:
 
 	Character m_arrCharacters[128];
 	std::map<char, Character> m_mapSloanCharacters;
+	// the font only has ASCII glyphs; plain char may be signed, so never index with it directly
+	Character& getCharacter(char c) { return m_arrCharacters[static_cast<unsigned char>(c) & 0x7Fu]; }
 	unsigned int m_uiFontPointSize;
 
 	LightingSystem* m_pLighting;
@@ -239,25 +434,74 @@ private:
 	std::vector<RendererSubmission> m_vStaticRenderQueue_Transparency;
 	std::vector<RendererSubmission> m_vDynamicRenderQueue_Opaque;
 	std::vector<RendererSubmission> m_vDynamicRenderQueue_Transparency;
-	std::vector<RendererSubmission> m_vTransparentRenderQueue;
 	std::vector<RendererSubmission> m_vUIRenderQueue;
 
 	bool m_bShowWireframe;
 
+	RenderStats m_RenderStats;
+
+	bool m_bCulling;
+	FrustumCuller m_Culler;
+
+	// back-to-front order over the static then dynamic transparency queues
+	TransparencySorter m_TransparencySorter;
+
+	TransparencyMode m_eTransparencyMode;
+	bool m_bOITPass;
+
+	std::map<std::string, GLuint*> m_mapOITShaders; // WEIGHTED_BLENDED_OIT variants of m_mapShaders entries
+	std::map<std::string, GLuint*> m_mapMDIShaders; // MULTI_DRAW_INDIRECT variants
+	std::map<std::string, GLuint*> m_mapMDIOITShaders; // MULTI_DRAW_INDIRECT variants of m_mapOITShaders entries
+
+	bool m_bMultiDrawIndirect;
+	bool m_bMultiDrawIndirectSupported;
+	bool m_bBindlessTextures;
+
+	bool m_bPackedVertices;
+	size_t m_nPrimitiveArenaBytes;
+
+	// visible submissions of the queue being processed, in draw order
+	std::vector<RendererSubmission*> m_vDrawList;
+	std::vector<DrawData> m_vDrawData;
+	std::vector<DrawElementsIndirectCommand> m_vDrawCommands;
+	GLuint m_glDrawDataSSBO;
+	GLuint m_glDrawCommandBuffer;
+
 	std::map<std::string, GLuint*> m_mapShaders;
 
-	std::map<std::string, std::pair<GLuint, GLsizei>> m_mapPrimitives;
+	std::map<std::string, PrimitiveMesh> m_mapPrimitives;
+	std::vector<std::vector<PrimitiveMesh>> m_vPrimitiveLODs; // finest level first
+
+	// meshes added through addPrimitive(), re-added after the built-ins whenever the arena is rebuilt
+	struct CustomPrimitive {
+		std::string name;
+		std::string cacheKey;
+		PrimitiveGenerator generator;
+	};
+	std::vector<CustomPrimitive> m_vCustomPrimitives;
+	bool m_bPrimitiveBatchOpen;
+	size_t m_nPrimitiveBatchStart; // first m_vCustomPrimitives entry of the open batch
+
+	MeshCache m_MeshCache;
+	MeshStreamer m_MeshStreamer;
+
+	std::map<std::string, PointCloud*> m_mapPointClouds;
+	std::vector<std::pair<PointCloud*, glm::mat4>> m_vPointCloudQueue; // cleared with the dynamic queue
+	float m_fPrimitiveSetupMS;
+	unsigned int m_uiGeneratedPrimitives;
+
+	bool m_bLevelOfDetail;
 
 	std::map<std::string, GLTexture*> m_mapTextures; // holds a flag for texture with transparency
 
 	std::vector<std::tuple<std::string, float, std::chrono::high_resolution_clock::time_point>> m_vMessages;
 
-	GLuint m_glIcosphereVAO, m_glIcosphereVBO, m_glIcosphereEBO;
-	GLuint m_glTorusVAO, m_glTorusVBO, m_glTorusEBO;
-	GLuint m_glCylinderVAO, m_glCylinderVBO, m_glCylinderEBO;
-	GLuint m_glPlaneVAO, m_glPlaneVBO, m_glPlaneEBO;
-	GLuint m_glCubeVAO, m_glCubeVBO, m_glCubeEBO;
-	GLuint m_glBBoxVAO, m_glBBoxVBO, m_glBBoxEBO;
+	// every built-in primitive lives in these buffers; the vectors only hold data until upload
+	std::vector<PrimVert> m_vPrimitiveArenaVerts;
+	std::vector<GLushort> m_vPrimitiveArenaIndices;
+	GLuint m_glPrimitiveVAO, m_glPrimitiveVBO, m_glPrimitiveEBO;
+
+	GLuint m_glBoundVAO; // last VAO bound while processing a render queue
 
 	GLuint m_glFrameUBO;
 	
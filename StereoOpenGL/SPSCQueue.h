@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#include "CacheAligned.h"
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread.
+// Capacity must be a power of two; one slot is never used so that full and empty can be told apart.
+template <typename T, size_t Capacity>
+class SPSCQueue
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SPSCQueue capacity must be a power of two");
+
+public:
+	SPSCQueue()
+		: m_nHead(0)
+		, m_nTail(0)
+	{}
+
+	// Producer only. Returns false without blocking if the queue is full.
+	bool push(const T &item)
+	{
+		size_t tail = m_nTail.load(std::memory_order_relaxed);
+		size_t next = (tail + 1) & (Capacity - 1);
+
+		if (next == m_nHead.load(std::memory_order_acquire))
+			return false;
+
+		m_arrSlots[tail] = item;
+		m_nTail.store(next, std::memory_order_release);
+
+		return true;
+	}
+
+	// Producer only. Returns a slot to fill in place, or NULL if the queue is full.
+	// The slot is handed to the consumer by the following call to commit().
+	T* claim()
+	{
+		size_t tail = m_nTail.load(std::memory_order_relaxed);
+
+		if (((tail + 1) & (Capacity - 1)) == m_nHead.load(std::memory_order_acquire))
+			return NULL;
+
+		return &m_arrSlots[tail];
+	}
+
+	void commit()
+	{
+		m_nTail.store((m_nTail.load(std::memory_order_relaxed) + 1) & (Capacity - 1), std::memory_order_release);
+	}
+
+	// Consumer only. Returns false if the queue is empty.
+	bool pop(T &item)
+	{
+		size_t head = m_nHead.load(std::memory_order_relaxed);
+
+		if (head == m_nTail.load(std::memory_order_acquire))
+			return false;
+
+		item = m_arrSlots[head];
+		m_nHead.store((head + 1) & (Capacity - 1), std::memory_order_release);
+
+		return true;
+	}
+
+	// Consumer only. Returns the oldest item without removing it, or NULL if the queue is empty.
+	T* front()
+	{
+		size_t head = m_nHead.load(std::memory_order_relaxed);
+
+		if (head == m_nTail.load(std::memory_order_acquire))
+			return NULL;
+
+		return &m_arrSlots[head];
+	}
+
+	void release()
+	{
+		m_nHead.store((m_nHead.load(std::memory_order_relaxed) + 1) & (Capacity - 1), std::memory_order_release);
+	}
+
+	bool empty() const
+	{
+		return m_nHead.load(std::memory_order_acquire) == m_nTail.load(std::memory_order_acquire);
+	}
+
+private:
+	// keep the indices on separate cache lines so producer and consumer do not false-share
+	alignas(CACHEALIGNED_BYTES) std::atomic<size_t> m_nHead;
+	alignas(CACHEALIGNED_BYTES) std::atomic<size_t> m_nTail;
+	alignas(CACHEALIGNED_BYTES) T m_arrSlots[Capacity];
+
+public:
+	SPSCQueue(SPSCQueue const&) = delete;
+	void operator=(SPSCQueue const&) = delete;
+};
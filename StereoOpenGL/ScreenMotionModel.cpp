@@ -0,0 +1,118 @@
+#include "ScreenMotionModel.h"
+
+#include <cmath>
+#include <algorithm>
+
+static double toSeconds(ScreenMotionModel::Clock::time_point t)
+{
+	return std::chrono::duration<double>(t.time_since_epoch()).count();
+}
+
+ScreenMotionModel::ScreenMotionModel()
+{
+	reset(0.f);
+}
+
+void ScreenMotionModel::reset(float angle)
+{
+	m_fFrom = m_fTo = angle;
+	m_dStart = 0.0;
+	m_dDuration = 0.0;
+
+	m_dLag = 0.0;
+	m_fBias = 0.f;
+
+	m_bHaveSample = false;
+	m_dClockOffset = 0.0;
+	m_dSampleTime = 0.0;
+	m_fSampleAngle = angle;
+	m_fSampleResidual = 0.f;
+}
+
+void ScreenMotionModel::commandMove(float targetAngle, float durationSeconds, Clock::time_point expectedStart)
+{
+	// the server clamps to its mechanical range
+	targetAngle = std::max(-90.f, std::min(90.f, targetAngle));
+
+	m_fFrom = predict(expectedStart) - m_fBias;
+	m_fTo = targetAngle;
+	m_dStart = toSeconds(expectedStart);
+	m_dDuration = std::max(0.0, static_cast<double>(durationSeconds));
+	m_fSampleResidual = 0.f;
+}
+
+void ScreenMotionModel::confirmStart(Clock::time_point start)
+{
+	m_dStart = toSeconds(start);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Samples taken part way through a ramp give the lag directly: invert
+//			the ramp to find when the plan reached the measured angle. Samples
+//			taken once the display has settled give the static offset.
+//-----------------------------------------------------------------------------
+void ScreenMotionModel::addSample(double serverTime, float angle, Clock::time_point received)
+{
+	double recv = toSeconds(received);
+
+	// network delay only ever adds, so the smallest difference is the closest to the true clock offset
+	double offset = recv - serverTime;
+	if (!m_bHaveSample || offset < m_dClockOffset)
+		m_dClockOffset = offset;
+	else
+		m_dClockOffset += (offset - m_dClockOffset) * SCREENMOTION_OFFSET_RELAX;
+
+	double t = serverTime + m_dClockOffset;
+
+	float span = m_fTo - m_fFrom;
+	float progress = span != 0.f ? (angle - m_fBias - m_fFrom) / span : -1.f;
+
+	if (m_dDuration > 0.0 && progress > 0.1f && progress < 0.9f)
+	{
+		double lag = t - (m_dStart + progress * m_dDuration);
+		lag = std::max(0.0, std::min(SCREENMOTION_MAX_LAG, lag));
+		m_dLag += (lag - m_dLag) * SCREENMOTION_LAG_GAIN;
+	}
+	else if (t > m_dStart + m_dLag + m_dDuration + SCREENMOTION_SETTLE_TIME)
+	{
+		m_fBias += ((angle - m_fTo) - m_fBias) * static_cast<float>(SCREENMOTION_BIAS_GAIN);
+	}
+
+	m_bHaveSample = true;
+	m_dSampleTime = t;
+	m_fSampleAngle = angle;
+	m_fSampleResidual = angle - model(t);
+}
+
+float ScreenMotionModel::predict(Clock::time_point t) const
+{
+	double s = toSeconds(t);
+	float angle = model(s);
+
+	if (m_bHaveSample && s > m_dSampleTime)
+		angle += m_fSampleResidual * static_cast<float>(std::exp(-(s - m_dSampleTime) / SCREENMOTION_CORRECTION_TIME));
+
+	return angle;
+}
+
+bool ScreenMotionModel::isMoving(Clock::time_point t) const
+{
+	double s = toSeconds(t) - m_dLag;
+	return m_fFrom != m_fTo && s >= m_dStart && s < m_dStart + m_dDuration;
+}
+
+float ScreenMotionModel::planned(double t) const
+{
+	if (t <= m_dStart)
+		return m_fFrom;
+
+	if (m_dDuration <= 0.0 || t >= m_dStart + m_dDuration)
+		return m_fTo;
+
+	return m_fFrom + (m_fTo - m_fFrom) * static_cast<float>((t - m_dStart) / m_dDuration);
+}
+
+float ScreenMotionModel::model(double t) const
+{
+	return planned(t - m_dLag) + m_fBias;
+}
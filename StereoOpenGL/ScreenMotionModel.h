@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+
+#define SCREENMOTION_LAG_GAIN			0.2		// weight of each new lag estimate
+#define SCREENMOTION_BIAS_GAIN			0.1		// weight of each new at-rest offset
+#define SCREENMOTION_MAX_LAG			0.5		// seconds
+#define SCREENMOTION_SETTLE_TIME		0.25	// seconds after a move ends before samples count as at rest
+#define SCREENMOTION_CORRECTION_TIME	0.1		// seconds for a sample's residual to fade from the prediction
+#define SCREENMOTION_OFFSET_RELAX		0.01	// how quickly the clock offset follows slower arrivals (drift)
+
+// Predicts the display angle at a given time (normally the time the next frame reaches the screen).
+// Each move is planned as the linear ramp the motor server runs. The commanded positions streamed
+// back by the server (the last PWM step it wrote; the servo reports no measured angle) are mapped
+// onto the local clock and used to learn how far the server's stepping lags the plan and how far
+// it settles from the target, and the latest sample's residual is blended in so an unexpected
+// stall is followed rather than rendered through.
+class ScreenMotionModel
+{
+public:
+	typedef std::chrono::high_resolution_clock Clock;
+
+	ScreenMotionModel();
+
+	// forgets learned lag, offset and samples, and holds at angle
+	void reset(float angle);
+
+	// a move from wherever the display is predicted to be at expectedStart
+	void commandMove(float targetAngle, float durationSeconds, Clock::time_point expectedStart);
+	// a better estimate of when the current move began (e.g. from the command acknowledgement)
+	void confirmStart(Clock::time_point start);
+
+	void addSample(double serverTime, float angle, Clock::time_point received);
+
+	float predict(Clock::time_point t) const;
+	bool isMoving(Clock::time_point t) const;
+
+	bool hasSamples() const { return m_bHaveSample; }
+	float getLastSample() const { return m_fSampleAngle; }
+	double getLagSeconds() const { return m_dLag; }
+	float getBias() const { return m_fBias; }
+
+private:
+	float m_fFrom;
+	float m_fTo;
+	double m_dStart;		// local seconds
+	double m_dDuration;
+
+	double m_dLag;
+	float m_fBias;
+
+	bool m_bHaveSample;
+	double m_dClockOffset;	// local seconds minus server seconds, at the fastest observed delivery
+	double m_dSampleTime;	// local seconds
+	float m_fSampleAngle;
+	float m_fSampleResidual;
+
+	float planned(double t) const;
+	float model(double t) const;
+};
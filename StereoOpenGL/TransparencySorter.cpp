@@ -0,0 +1,144 @@
+#include "TransparencySorter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <gtx/norm.hpp>
+
+TransparencySorter::TransparencySorter()
+	: m_vec3LastViewPos(0.f)
+	, m_nLastCount(0u)
+	, m_bIncremental(false)
+{
+}
+
+void TransparencySorter::clear()
+{
+	m_vPositions.clear();
+	m_vKeys.clear();
+}
+
+void TransparencySorter::reserve(size_t count)
+{
+	m_vPositions.reserve(count);
+	m_vKeys.reserve(count);
+	m_vOrder.reserve(count);
+	m_vScratch.reserve(count);
+}
+
+void TransparencySorter::add(const glm::vec3 & position)
+{
+	m_vPositions.push_back(position);
+	m_vKeys.push_back(0u);
+}
+
+void TransparencySorter::sort(const glm::vec3 & viewPos)
+{
+	size_t n = m_vKeys.size();
+
+	for (size_t i = 0u; i < n; ++i)
+	{
+		// squared distances are non-negative, so their bit patterns order like unsigned ints
+		float distSq = glm::length2(m_vPositions[i] - viewPos);
+		uint32_t bits;
+		memcpy(&bits, &distSq, sizeof(bits));
+		m_vKeys[i] = ~bits;
+	}
+
+	m_bIncremental = n == m_nLastCount && n == m_vOrder.size() && glm::length2(viewPos - m_vec3LastViewPos) < TRANSPARENCYSORTER_COHERENCE_DIST * TRANSPARENCYSORTER_COHERENCE_DIST;
+
+	if (!m_bIncremental || !insertionSort())
+	{
+		m_bIncremental = false;
+		radixSort();
+	}
+
+	m_vec3LastViewPos = viewPos;
+	m_nLastCount = n;
+}
+
+bool TransparencySorter::insertionSort()
+{
+	size_t n = m_vOrder.size();
+	size_t budget = n * TRANSPARENCYSORTER_MAX_SHIFTS;
+
+	for (size_t i = 1u; i < n; ++i)
+	{
+		uint32_t idx = m_vOrder[i];
+		uint32_t key = m_vKeys[idx];
+		size_t j = i;
+
+		// ties fall back to submission index so both paths produce the same order
+		while (j > 0u && (m_vKeys[m_vOrder[j - 1u]] > key || (m_vKeys[m_vOrder[j - 1u]] == key && m_vOrder[j - 1u] > idx)))
+		{
+			m_vOrder[j] = m_vOrder[j - 1u];
+			--j;
+
+			if (--budget == 0u)
+			{
+				m_vOrder[j] = idx;
+				return false;
+			}
+		}
+
+		m_vOrder[j] = idx;
+	}
+
+	return true;
+}
+
+void TransparencySorter::radixSort()
+{
+	size_t n = m_vKeys.size();
+
+	m_vOrder.resize(n);
+	m_vScratch.resize(n);
+
+	if (n == 0u)
+		return;
+
+	uint32_t counts[4][256];
+	memset(counts, 0, sizeof(counts));
+
+	for (size_t i = 0u; i < n; ++i)
+	{
+		uint32_t k = m_vKeys[i];
+		counts[0][k & 0xFF]++;
+		counts[1][(k >> 8) & 0xFF]++;
+		counts[2][(k >> 16) & 0xFF]++;
+		counts[3][k >> 24]++;
+	}
+
+	for (uint32_t i = 0u; i < n; ++i)
+		m_vOrder[i] = i;
+
+	uint32_t* src = &m_vOrder[0];
+	uint32_t* dst = &m_vScratch[0];
+
+	for (int pass = 0; pass < 4; ++pass)
+	{
+		int shift = pass * 8;
+
+		// every key shares this digit, so the pass would not reorder anything
+		if (counts[pass][(m_vKeys[0] >> shift) & 0xFF] == n)
+			continue;
+
+		uint32_t offsets[256];
+		uint32_t sum = 0u;
+		for (int b = 0; b < 256; ++b)
+		{
+			offsets[b] = sum;
+			sum += counts[pass][b];
+		}
+
+		for (size_t i = 0u; i < n; ++i)
+		{
+			uint32_t idx = src[i];
+			dst[offsets[(m_vKeys[idx] >> shift) & 0xFF]++] = idx;
+		}
+
+		std::swap(src, dst);
+	}
+
+	if (src != &m_vOrder[0])
+		m_vOrder.swap(m_vScratch);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include <glm.hpp>
+
+#define TRANSPARENCYSORTER_COHERENCE_DIST	1.f	// view moves under this reuse last frame's order (scene units, cm)
+#define TRANSPARENCYSORTER_MAX_SHIFTS		4u	// insertion sort gives up after this many element shifts per item
+
+// Orders transparent submissions back to front by distance to the view position. Only a
+// compact (key, index) pair per item is sorted, never the submissions themselves: keys are
+// the squared distance's float bits inverted so an ascending unsigned sort yields far-to-near,
+// and equal distances keep submission order. A full sort is a 4-pass LSD radix sort; when
+// the item count is unchanged and the view barely moved, last frame's order is insertion
+// sorted instead, which is linear for nearly-sorted input. Buffers are reused across frames.
+class TransparencySorter
+{
+public:
+	TransparencySorter();
+
+	void clear();
+	void reserve(size_t count);
+
+	void add(const glm::vec3 &position);
+
+	size_t size() const { return m_vKeys.size(); }
+
+	// sorts everything added since clear() back to front as seen from viewPos
+	void sort(const glm::vec3 &viewPos);
+
+	// submission indices, farthest first; valid after sort()
+	const uint32_t* order() const { return m_vOrder.empty() ? NULL : &m_vOrder[0]; }
+
+	// true if the last sort() reused the previous frame's order
+	bool wasIncremental() const { return m_bIncremental; }
+
+private:
+	std::vector<glm::vec3> m_vPositions;
+	std::vector<uint32_t> m_vKeys;
+	std::vector<uint32_t> m_vOrder;
+	std::vector<uint32_t> m_vScratch;
+
+	glm::vec3 m_vec3LastViewPos;
+	size_t m_nLastCount;
+	bool m_bIncremental;
+
+	bool insertionSort();
+	void radixSort();
+};
@@ -10,8 +10,8 @@ ViewingConditionsDiagram::ViewingConditionsDiagram(glm::mat4 screenBasis, glm::i
 	: m_mat4ScreenBasis(screenBasis)
 	, m_ivec2ScreenRes(screenResolution)
 	, m_fOriginScreenDist(5.f)
-	, m_fHingeAngle(90.f)
 	, m_fHingeLength(2.5f)
+	, m_fHingeAngle(90.f)
 	, m_fProjectionAngle(0.f)
 	, m_fProjectionDistance(glm::length(screenBasis[1]) * (2.f / 3.f))
 	, m_fViewingAngle(0.f)
@@ -35,8 +35,6 @@ ViewingConditionsDiagram::~ViewingConditionsDiagram()
 
 void ViewingConditionsDiagram::draw()
 {
-	glm::vec3 screenOrigin = glm::vec3(m_mat4ScreenBasis[3]);
-
 	DebugDrawer::getInstance().setTransform(m_mat4ScreenBasisOrtho);
 	
 	// Screen
@@ -56,8 +54,6 @@ void ViewingConditionsDiagram::draw()
 	glm::mat4 viewBasis = glm::rotate(glm::mat4(), glm::radians(m_fViewingAngle), glm::vec3(m_mat4ScreenBasisOrtho[2])) * glm::translate(m_mat4ScreenBasisOrtho, glm::vec3(0.f, -m_fViewingDistance, 0.f));
 	glm::vec3 viewPos(viewBasis[3]);
 
-	glm::vec3 screenViewVec = screenOrigin - viewPos;
-
 	float viewAngleOffset = glm::degrees(glm::asin(m_fEyeSeparation / (2.f * m_fViewingDistance)));
 
 	glm::vec3 leftEyePos = (glm::rotate(glm::mat4(), glm::radians(m_fViewingAngle - viewAngleOffset), glm::vec3(m_mat4ScreenBasisOrtho[2])) * glm::translate(m_mat4ScreenBasisOrtho, glm::vec3(0.f, -m_fViewingDistance, 0.f)))[3];
@@ -104,7 +100,7 @@ void ViewingConditionsDiagram::draw()
 		auto iR = distutil::getScreenIntersections(copRight, glm::vec3(m_mat4ScreenBasisOrtho[3]), -glm::vec3(m_mat4ScreenBasisOrtho[1]), hingePts);
 
 		// Calc intersection points
-		for (int i = 0; i < hingePts.size(); ++i)
+		for (size_t i = 0; i < hingePts.size(); ++i)
 		{
 			DebugDrawer::getInstance().setTransform(glm::translate(glm::mat4(), iL[i]));
 			DebugDrawer::getInstance().drawArc(0.1f, 0.1f, 0.f, 360.f, glm::vec4(1.f, 0.f, 1.f, 1.f), false);
@@ -0,0 +1,118 @@
+# Stand-in for remoteservo.py that runs on the local machine without servo hardware.
+# Speaks the same newline-delimited protocol: every "angle[,time]" command is echoed back
+# once it is accepted, and the simulated display sweeps to the new angle over <time> seconds.
+# The simulated commanded angle is streamed back as "pos,<server time>,<angle>" lines like the real server does.
+import sys
+import socket
+import time
+import threading
+
+if len(sys.argv) > 1 and sys.argv[1] in ("-h", "--help"):
+    print("Usage:", sys.argv[0], "[port] [reply-delay-ms] [drop-after-n-commands]")
+    sys.exit()
+
+TCP_PORT = int(sys.argv[1]) if len(sys.argv) > 1 else 5005
+REPLY_DELAY = float(sys.argv[2]) / 1000.0 if len(sys.argv) > 2 else 0.0
+DROP_AFTER = int(sys.argv[3]) if len(sys.argv) > 3 else 0
+POSITION_INTERVAL = 0.02
+
+class simservo:
+    def __init__(self):
+        self.angle = 0.0
+        self.start = 0.0
+        self.target = 0.0
+        self.startTime = time.time()
+        self.duration = 0.0
+
+    def current(self):
+        if self.duration <= 0.0:
+            return self.target
+        ratio = min(1.0, (time.time() - self.startTime) / self.duration)
+        return self.start + (self.target - self.start) * ratio
+
+    def set(self, angle, duration = 2.5):
+        self.start = self.current()
+        self.target = max(-90.0, min(90.0, angle))
+        self.startTime = time.time()
+        self.duration = duration
+
+serv = simservo()
+
+def stream_positions(conn, lock, connected):
+    while connected.is_set():
+        try:
+            with lock:
+                conn.sendall(("pos,%.4f,%.3f\n" % (time.time(), serv.current())).encode())
+        except OSError:
+            break
+        time.sleep(POSITION_INTERVAL)
+
+sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+sock.bind(("127.0.0.1", TCP_PORT))
+sock.listen(1)
+
+print("Loopback servo listening on 127.0.0.1 port", TCP_PORT)
+
+try:
+    while True:
+        (clientsocket, address) = sock.accept()
+        clientsocket.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        print("Connection from", address[0], "port", address[1])
+
+        buf = b""
+        commands = 0
+
+        sendlock = threading.Lock()
+        connected = threading.Event()
+        connected.set()
+        streamer = threading.Thread(target=stream_positions, args=(clientsocket, sendlock, connected), daemon=True)
+        streamer.start()
+
+        while True:
+            try:
+                data = clientsocket.recv(512)
+            except ConnectionResetError:
+                data = None
+
+            if not data:
+                print("Connection lost from", address[0], "port", address[1])
+                break
+
+            buf += data
+
+            while b"\n" in buf:
+                line, buf = buf.split(b"\n", 1)
+                msg = line.decode().strip()
+                if not msg:
+                    continue
+
+                if REPLY_DELAY > 0.0:
+                    time.sleep(REPLY_DELAY)
+
+                with sendlock:
+                    clientsocket.sendall((msg + "\n").encode())
+
+                angletime = msg.split(",")
+                if len(angletime) == 2:
+                    serv.set(float(angletime[0]), float(angletime[1]))
+                else:
+                    serv.set(float(angletime[0]))
+
+                print("Command:", msg, "-> moving from %.2f to %.2f over %.2f s" % (serv.start, serv.target, serv.duration))
+
+                commands += 1
+                if DROP_AFTER > 0 and commands >= DROP_AFTER:
+                    print("Dropping connection to exercise client reconnect")
+                    break
+
+            if DROP_AFTER > 0 and commands >= DROP_AFTER:
+                break
+
+        connected.clear()
+        streamer.join()
+        clientsocket.close()
+except KeyboardInterrupt:
+    print("\nShutting down...")
+finally:
+    sock.close()
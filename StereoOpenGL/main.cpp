@@ -1,5 +1,4 @@
 #include "Engine.h"
-#include <conio.h>
 #include <cstdio> // fclose
 #include <string>
 
@@ -2,6 +2,7 @@
 import sys
 import socket
 import time
+import threading
 import servo
 import lcddriver
 
@@ -11,6 +12,9 @@ if len(sys.argv) < 2:
 
 TCP_PORT = int(sys.argv[1])
 
+# while a client is connected the commanded arm angle (servo.position()) is streamed back as "pos,<server time>,<angle>" lines
+POSITION_INTERVAL = 0.02
+
 def get_ip_address():
     s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
     s.connect(("8.8.8.8", 80))
@@ -46,6 +50,15 @@ if lcd:
 
 clientsocket = None
 
+def stream_positions(conn, lock, connected):
+    while connected.is_set():
+        try:
+            with lock:
+                conn.sendall(("pos,%.4f,%.3f\n" % (time.time(), serv.position())).encode())
+        except OSError:
+            break
+        time.sleep(POSITION_INTERVAL)
+
 try:
     sock.listen(1)
     
@@ -61,6 +74,16 @@ try:
                 lcd.lcd_display_string(time.strftime("%m/%d/%Y %H:%M:%S"), 2)
                 lcd.lcd_display_string("<Connected>", 3)
 
+            # commands are newline-delimited; each one is echoed back as its acknowledgement
+            buf = b""
+
+            # moves run on their own thread so the socket keeps being read and positions keep streaming
+            sendlock = threading.Lock()
+            connected = threading.Event()
+            connected.set()
+            streamer = threading.Thread(target=stream_positions, args=(clientsocket, sendlock, connected), daemon=True)
+            streamer.start()
+
             while True:
                 try:
                     data = clientsocket.recv(512)
@@ -69,19 +92,24 @@ try:
                     break
                 
                 if data:
-                    ts = time.localtime(time.time())
-                    print("Received data:", data.decode())
-                    if lcd:
-                        lcd.lcd_display_string(time.strftime("%m/%d/%Y %H:%M:%S"), 2)
-                        lcd.lcd_display_string("Angle: " + str(data.decode()), 4)
+                    buf += data
+
+                    while b"\n" in buf:
+                        line, buf = buf.split(b"\n", 1)
+                        msg = line.decode().strip()
+                        if not msg:
+                            continue
+
+                        print("Received data:", msg)
+                        if lcd:
+                            lcd.lcd_display_string(time.strftime("%m/%d/%Y %H:%M:%S"), 2)
+                            lcd.lcd_display_string("Angle: " + msg, 4)
                 
-                    clientsocket.sendall(data)
+                        with sendlock:
+                            clientsocket.sendall((msg + "\n").encode())
                 
-                    angletime = data.decode().split(",")
-                    if len(angletime) == 2:
-                        serv.set(float(angletime[0]), float(angletime[1]))    
-                    else:
-                        serv.set(float(angletime[0]))
+                        angletime = [float(v) for v in msg.split(",")]
+                        threading.Thread(target=serv.set, args=angletime[:2], daemon=True).start()
                 
                 else:
                     print("Connection lost from", address[0], "port", address[1])
@@ -89,6 +117,9 @@ try:
                         lcd.lcd_display_string(time.strftime("%m/%d/%Y %H:%M:%S"), 2)
                         lcd.lcd_display_string("<Connection lost>", 3)
                     break
+
+            connected.clear()
+            streamer.join()
         except KeyboardInterrupt:
             print("\nShutting down...")
             break
@@ -16,7 +16,7 @@ sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
 sock.connect((TCP_IP, TCP_PORT))
 
 if len(sys.argv) == 4:
-    sock.send(sys.argv[3].encode())
+    sock.send((sys.argv[3] + "\n").encode())
     print("Message:", sys.argv[3])
 
     data = sock.recv(BUF_SIZE)
@@ -24,7 +24,7 @@ if len(sys.argv) == 4:
 else:
     angle = input("Angle(, Time): ")
     while float(angle.split(',')[0]) >= -90:
-        sock.send(angle.encode())
+        sock.send((angle + "\n").encode())
         data = sock.recv(BUF_SIZE)
         print("Response:", data.decode())
         angle = input("Angle(, Time): ")
@@ -13,6 +13,8 @@ class servo:
         self.stepSize = float(self.maxStop - self.minStop) / self.servoAngularRange
     
         self.angle = 0
+        self.current = 0.0 # angle of the last PWM step written, updated while moving
+        self.moveID = 0
     
         self.setupGPIO()
     
@@ -32,34 +34,46 @@ class servo:
         wiringpi.pwmSetClock(192)
         wiringpi.pwmSetRange(2000)
         
+    # commanded position: the angle of the last PWM step, in the same sign convention as set().
+    # The servo has no position feedback, so this is where the arm was told to be, not a measurement.
+    def position(self):
+        return -self.current
+        
+    # blocks for the duration of the move; a newer set() call (e.g. from another thread) cuts it short
     def set(self, angle, time = 2.5):
         #servo turns clockwise, so change sign of angle
         angle = -angle;
-        if self.angle == angle:
-            return
         if angle < -90:
             angle = -90
         if angle > 90:
             angle = 90
-            
-        delta = angle - self.angle
-        nsteps = delta * self.stepSize
-        sleeptime = abs(time / nsteps)
         
-        start = int(self.origin + self.angle * self.stepSize)
+        self.moveID += 1
+        moveID = self.moveID
+        
+        start = int(round(self.origin + self.current * self.stepSize))
         stop = int(self.origin + angle * self.stepSize)
         
+        if start == stop:
+            self.angle = angle
+            return
+        
         if start - stop > 0:
             movement = range(start, stop - 1, -1)
         else:
-            if start - stop < 0:
-                movement = range(start, stop + 1, 1)
+            movement = range(start, stop + 1, 1)
+        
+        sleeptime = abs(time / len(movement))
         
-        if sleeptime == 0 & len(movement) > 0:
+        if sleeptime == 0:
             wiringpi.pwmWrite(18, movement[-1])
+            self.current = float(movement[-1] - self.origin) / self.stepSize
         else:
             for step in movement:
+                if self.moveID != moveID:
+                    return
                 wiringpi.pwmWrite(18, step)
+                self.current = float(step - self.origin) / self.stepSize
                 sleep(sleeptime)
                 
-        self.angle = angle
\ No newline at end of file
+        self.angle = angle
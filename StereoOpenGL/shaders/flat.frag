@@ -1,18 +1,14 @@
 layout(binding = DIFFUSE_TEXTURE_BINDING)
 	uniform sampler2D diffuseTex;
-layout(location = DIFFUSE_COLOR_UNIFORM_LOCATION)
-	uniform vec4 diffColor;
-layout(location = SPECULAR_COLOR_UNIFORM_LOCATION)
-	uniform vec4 specColor;
 
 in vec4 v4Color;
 in vec2 v2TexCoords;
-out vec4 outputColor;
+layout(location = COLOR_OUTPUT_LOCATION) out vec4 outputColor;
 
 void main()
 {
-   if (v4Color.a * diffColor.a == 0.f)
+   if (v4Color.a * DRAW_DIFFUSE_COLOR.a == 0.f)
       discard;
 	  
-   outputColor = texture(diffuseTex, v2TexCoords) * v4Color * diffColor;
+   outputColor = shadeOutput(texture(DRAW_DIFFUSE_SAMPLER(sampler2D), v2TexCoords) * v4Color * DRAW_DIFFUSE_COLOR);
 }
\ No newline at end of file
@@ -5,9 +5,6 @@ layout(location = COLOR_ATTRIB_LOCATION)
 layout(location = TEXCOORD_ATTRIB_LOCATION)
 	in vec2 v2TexCoordsIn;
 	
-layout(location = MODEL_MAT_UNIFORM_LOCATION)
-	uniform mat4 m4Model;
-	
 layout(std140, binding = SCENE_UNIFORM_BUFFER_LOCATION) 
 	uniform FrameUniforms
 	{
@@ -22,7 +19,8 @@ out vec2 v2TexCoords;
 
 void main()
 {
+	forwardDrawID();
 	v4Color = v4ColorIn;
 	v2TexCoords = v2TexCoordsIn;
-	gl_Position = m4ViewProjection * m4Model * vec4(v3Position, 1.0);
+	gl_Position = m4ViewProjection * DRAW_MODEL * vec4(v3Position, 1.0);
 }
\ No newline at end of file
@@ -1,15 +1,11 @@
 layout(binding = DIFFUSE_TEXTURE_BINDING)
 	uniform sampler2D diffuseTex;
-layout(location = DIFFUSE_COLOR_UNIFORM_LOCATION)
-	uniform vec4 diffColor;
-layout(location = SPECULAR_COLOR_UNIFORM_LOCATION)
-	uniform vec4 gridColor;
 
 in vec3 v3Normal;
 in vec3 v3FragPos;
 in vec2 v2TexCoords;
 
-out vec4 color;
+layout(location = COLOR_OUTPUT_LOCATION) out vec4 color;
 
 void main()
 {
@@ -24,11 +20,12 @@ void main()
 	float blend = smoothstep(gridLineWidth, gridLineWidth + falloff, remainderX) * (1.f - smoothstep(1.f - gridLineWidth - falloff, 1.f - gridLineWidth, remainderX)) *
         smoothstep(gridLineWidth, gridLineWidth + falloff, remainderY) * (1.f - smoothstep(1.f - gridLineWidth - falloff, 1.f - gridLineWidth, remainderY));
 
-	vec4 surfaceDiffColor = texture(diffuseTex, v2TexCoords) * diffColor;
-	surfaceDiffColor = mix(gridColor, surfaceDiffColor, blend);
+	vec4 surfaceDiffColor = texture(DRAW_DIFFUSE_SAMPLER(sampler2D), v2TexCoords) * DRAW_DIFFUSE_COLOR;
+	// the grid line color travels in the specular color
+	surfaceDiffColor = mix(DRAW_SPECULAR_COLOR, surfaceDiffColor, blend);
 
 	if (surfaceDiffColor.a == 0.f)
 	    discard;
 
-    color = surfaceDiffColor;
+    color = shadeOutput(surfaceDiffColor);
 }
\ No newline at end of file
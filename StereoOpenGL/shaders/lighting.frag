@@ -4,20 +4,14 @@ layout(binding = SPECULAR_TEXTURE_BINDING)
 	uniform sampler2D specularTex;
 layout(binding = EMISSIVE_TEXTURE_BINDING)
 	uniform sampler2D emissiveTex;
-layout(location = MATERIAL_SHININESS_UNIFORM_LOCATION)
-	uniform float shininess;
 layout(location = LIGHT_COUNT_UNIFORM_LOCATION)
 	uniform int numLights;
-layout(location = DIFFUSE_COLOR_UNIFORM_LOCATION)
-	uniform vec4 diffColor;
-layout(location = SPECULAR_COLOR_UNIFORM_LOCATION)
-	uniform vec4 specColor;
 
 in vec3 v3Normal;
 in vec3 v3FragPos;
 in vec2 v2TexCoords;
 
-out vec4 color;
+layout(location = COLOR_OUTPUT_LOCATION) out vec4 color;
 
 struct Light {
     vec4 position;
@@ -56,12 +50,12 @@ void main()
 {
     vec3 norm = normalize(v3Normal);
     vec3 fragToViewDir = normalize(-v3FragPos);
-	vec4 surfaceDiffColor = texture(diffuseTex, v2TexCoords) * diffColor;
+	vec4 surfaceDiffColor = texture(DRAW_DIFFUSE_SAMPLER(sampler2D), v2TexCoords) * DRAW_DIFFUSE_COLOR;
 
 	if (surfaceDiffColor.a == 0.f)
 	    discard;
 
-	vec4 surfaceSpecColor = texture(specularTex, v2TexCoords) * specColor;
+	vec4 surfaceSpecColor = texture(DRAW_SPECULAR_SAMPLER(sampler2D), v2TexCoords) * DRAW_SPECULAR_COLOR;
 	vec4 surfaceEmisColor = texture(emissiveTex, v2TexCoords);
 	
     vec3 result = vec3(0.f);
@@ -72,7 +66,7 @@ void main()
 	result += surfaceEmisColor.rgb;
 	//vec3 gammaCorrection = vec3(1.f/2.2f);
 	//color = vec4(pow(result, gammaCorrection), 1.0);
-    color = vec4(result, surfaceDiffColor.a);
+    color = shadeOutput(vec4(result, surfaceDiffColor.a));
 }
 
 
@@ -97,7 +91,7 @@ vec3 phong(Light light, vec3 surfDiffCol, vec3 surfSpecCol, vec3 normal, vec3 fr
     float diffCoeff = max(dot(normal, fragToLightDir), 0.0);
     vec3 diffuse = light.color.rgb * diffCoeff * surfDiffCol;
 	
-    float specCoeff = pow(max(dot(surfToViewDir, reflect(-fragToLightDir, normal)), 0.0), shininess);
+    float specCoeff = pow(max(dot(surfToViewDir, reflect(-fragToLightDir, normal)), 0.0), DRAW_SHININESS);
     vec3 specular = light.color.rgb * specCoeff * surfSpecCol;
 	
     ambient *= attenuation * intensity;
@@ -5,9 +5,6 @@ layout(location = NORMAL_ATTRIB_LOCATION)
 layout(location = TEXCOORD_ATTRIB_LOCATION)
 	in vec2 v2TexCoordsIn;
 	
-layout(location = MODEL_MAT_UNIFORM_LOCATION)
-	uniform mat4 m4Model;
-	
 layout(std140, binding = SCENE_UNIFORM_BUFFER_LOCATION) 
 	uniform FrameUniforms
 	{
@@ -23,8 +20,9 @@ out vec2 v2TexCoords;
 
 void main()
 {
-	gl_Position = m4ViewProjection * m4Model * vec4(v3Position, 1.f);
-	v3FragPos = vec3(m4View * m4Model * vec4(v3Position, 1.f));
-	v3Normal =  mat3(transpose(inverse(m4View * m4Model))) * v3NormalIn;
+	forwardDrawID();
+	gl_Position = m4ViewProjection * DRAW_MODEL * vec4(v3Position, 1.f);
+	v3FragPos = vec3(m4View * DRAW_MODEL * vec4(v3Position, 1.f));
+	v3Normal =  mat3(transpose(inverse(m4View * DRAW_MODEL))) * v3NormalIn;
 	v2TexCoords = v2TexCoordsIn;
 }
\ No newline at end of file
@@ -4,14 +4,8 @@ layout(binding = SPECULAR_TEXTURE_BINDING)
 	uniform sampler2D specularTex;
 layout(binding = EMISSIVE_TEXTURE_BINDING)
 	uniform sampler2D emissiveTex;
-layout(location = MATERIAL_SHININESS_UNIFORM_LOCATION)
-	uniform float shininess;
 layout(location = LIGHT_COUNT_UNIFORM_LOCATION)
 	uniform int numLights;
-layout(location = DIFFUSE_COLOR_UNIFORM_LOCATION)
-	uniform vec4 diffColor;
-layout(location = SPECULAR_COLOR_UNIFORM_LOCATION)
-	uniform vec4 specColor;
 
 float lineWidth = 1.f;
 vec4 lineColor = vec4(0.f, 0.f, 0.f, 1.f);
@@ -22,7 +16,7 @@ in vec3 GPos;
 in vec2 GTex;
 noperspective in vec3 GEdgeDist;
 
-out vec4 color;
+layout(location = COLOR_OUTPUT_LOCATION) out vec4 color;
 
 struct Light {
     vec4 position;
@@ -62,12 +56,12 @@ void main()
     vec3 norm = normalize(GNorm);
 	norm = float(gl_FrontFacing) * norm + (1.f - float(gl_FrontFacing)) * -norm;
     vec3 fragToViewDir = normalize(-GPos);
-	vec4 surfaceDiffColor = texture(diffuseTex, GTex) * diffColor;
+	vec4 surfaceDiffColor = texture(DRAW_DIFFUSE_SAMPLER(sampler2D), GTex) * DRAW_DIFFUSE_COLOR;
 
 	if (surfaceDiffColor.a == 0.f)
 	    discard;
 
-	vec4 surfaceSpecColor = texture(specularTex, GTex) * specColor;
+	vec4 surfaceSpecColor = texture(DRAW_SPECULAR_SAMPLER(sampler2D), GTex) * DRAW_SPECULAR_COLOR;
 	vec4 surfaceEmisColor = texture(emissiveTex, GTex);
 	
     vec3 result = vec3(0.f);
@@ -89,7 +83,7 @@ void main()
 	// Set wireframe line and transparent fill
 	lineColor = color;
 	fillColor = vec4(lineColor.rbg, 0.f);
-	color = mix(lineColor, fillColor, mixVal);
+	color = shadeOutput(mix(lineColor, fillColor, mixVal));
 	
 	// Discard transparent fragments so they don't write to depth buffer
 	if (color.a <= 0.f)
@@ -118,7 +112,7 @@ vec3 phong(Light light, vec3 surfDiffCol, vec3 surfSpecCol, vec3 normal, vec3 fr
     float diffCoeff = max(dot(normal, fragToLightDir), 0.0);
     vec3 diffuse = light.color.rgb * diffCoeff * surfDiffCol;
 	
-    float specCoeff = pow(max(dot(surfToViewDir, reflect(-fragToLightDir, normal)), 0.0), shininess);
+    float specCoeff = pow(max(dot(surfToViewDir, reflect(-fragToLightDir, normal)), 0.0), DRAW_SHININESS);
     vec3 specular = light.color.rgb * specCoeff * surfSpecCol;
 	
     ambient *= attenuation * intensity;
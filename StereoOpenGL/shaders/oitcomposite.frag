@@ -0,0 +1,22 @@
+layout(binding = DIFFUSE_TEXTURE_BINDING)
+	uniform sampler2DMS accumTex;
+layout(binding = SPECULAR_TEXTURE_BINDING)
+	uniform sampler2DMS revealageTex;
+
+layout(location = COLOR_OUTPUT_LOCATION) out vec4 outputColor;
+
+// Resolves the weighted-blended transparency targets over the opaque image, one sample at a time.
+// Blended with (ONE_MINUS_SRC_ALPHA, SRC_ALPHA), so alpha carries the revealage.
+void main()
+{
+	ivec2 texel = ivec2(gl_FragCoord.xy);
+
+	float revealage = texelFetch(revealageTex, texel, gl_SampleID).r;
+
+	if (revealage == 1.f)
+		discard;
+
+	vec4 accum = texelFetch(accumTex, texel, gl_SampleID);
+
+	outputColor = vec4(accum.rgb / clamp(accum.a, 1e-4f, 5e4f), revealage);
+}
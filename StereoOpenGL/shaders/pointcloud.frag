@@ -0,0 +1,12 @@
+in vec4 v4Color;
+layout(location = COLOR_OUTPUT_LOCATION) out vec4 outputColor;
+
+void main()
+{
+	// round points
+	vec2 d = gl_PointCoord * 2.0 - 1.0;
+	if (dot(d, d) > 1.0)
+		discard;
+
+	outputColor = v4Color;
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+layout(location = POSITION_ATTRIB_LOCATION)
+	in vec3 v3Position; // 0 to 1 over the node's cube
+layout(location = COLOR_ATTRIB_LOCATION)
+	in vec4 v4ColorIn;
+
+layout(std140, binding = SCENE_UNIFORM_BUFFER_LOCATION) 
+	uniform FrameUniforms
+	{
+		vec4 v4Viewport;
+		mat4 m4View;
+		mat4 m4Projection;
+		mat4 m4ViewProjection;
+	};
+
+// cube min and size of the node in each slot of the point pool
+layout(std430, binding = POINT_NODE_STORAGE_BUFFER_BINDING) readonly buffer PointNodeBuffer
+{
+	vec4 v4NodeCube[];
+};
+
+// x: pixels per unit at unit depth, y: point diameter as a fraction of the node's cube size, z/w: min/max diameter in pixels
+layout(location = POINT_SIZE_UNIFORM_LOCATION)
+	uniform vec4 v4PointSize;
+
+out vec4 v4Color;
+
+void main()
+{
+	vec4 cube = v4NodeCube[gl_VertexID / POINT_CLOUD_NODE_POINTS];
+
+	v4Color = v4ColorIn;
+	gl_Position = m4ViewProjection * DRAW_MODEL * vec4(cube.xyz + v3Position * cube.w, 1.0);
+	gl_PointSize = clamp(v4PointSize.x * v4PointSize.y * cube.w * length(DRAW_MODEL[0].xyz) / gl_Position.w, v4PointSize.z, v4PointSize.w);
+}
\ No newline at end of file
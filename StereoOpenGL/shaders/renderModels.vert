@@ -5,9 +5,6 @@ layout(location = NORMAL_ATTRIB_LOCATION)
 layout(location = TEXCOORD_ATTRIB_LOCATION)
 	in vec2 v2TexCoordsIn;
 	
-layout(location = MODEL_MAT_UNIFORM_LOCATION)
-	uniform mat4 m4Model;
-	
 layout(std140, binding = SCENE_UNIFORM_BUFFER_LOCATION) 
 	uniform FrameUniforms
 	{
@@ -22,7 +19,8 @@ out vec2 v2TexCoord;
 
 void main()
 {
-	gl_Position = m4ViewProjection * m4Model * vec4(position.xyz, 1);
-	v3Normal = normalize(mat3(transpose(inverse(m4View * m4Model))) * v3NormalIn);
+	forwardDrawID();
+	gl_Position = m4ViewProjection * DRAW_MODEL * vec4(position.xyz, 1);
+	v3Normal = normalize(mat3(transpose(inverse(m4View * DRAW_MODEL))) * v3NormalIn);
 	v2TexCoord = v2TexCoordsIn;
 }
\ No newline at end of file
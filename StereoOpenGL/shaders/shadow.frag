@@ -1,9 +1,6 @@
-layout(location = DIFFUSE_COLOR_UNIFORM_LOCATION)
-	uniform vec4 diffColor;
-
-out vec4 color;
+layout(location = COLOR_OUTPUT_LOCATION) out vec4 color;
 
 void main()
 {
-	color = diffColor;
+	color = shadeOutput(DRAW_DIFFUSE_COLOR);
 }
\ No newline at end of file
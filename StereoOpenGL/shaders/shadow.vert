@@ -20,9 +20,6 @@ struct Light {
 
 uniform Light lights[MAX_LIGHTS];
 
-layout(location = MODEL_MAT_UNIFORM_LOCATION)
-	uniform mat4 m4Model;
-	
 layout(std140, binding = SCENE_UNIFORM_BUFFER_LOCATION) 
 	uniform FrameUniforms
 	{
@@ -83,9 +80,10 @@ mat4 makeShadowMatrix(vec4 plane, vec4 L)
 
 void main()
 {
+	forwardDrawID();
 	vec4 plane;
 	plane.xyz = normalize(vec3(0.f, 1.f, 0.f));
-	plane.w = ((length(m4Model[0]) / 2.f) - m4Model[3].y) * 0.999f;
+	plane.w = ((length(DRAW_MODEL[0]) / 2.f) - DRAW_MODEL[3].y) * 0.999f;
 	mat4 shadowMat = makeShadowMatrix(plane, normalize(-lights[0].direction));
-	gl_Position = m4ViewProjection * shadowMat * m4Model * vec4(v3Position, 1.0);
+	gl_Position = m4ViewProjection * shadowMat * DRAW_MODEL * vec4(v3Position, 1.0);
 }
\ No newline at end of file
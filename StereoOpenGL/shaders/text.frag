@@ -1,19 +1,15 @@
 layout(binding = DIFFUSE_TEXTURE_BINDING)
-	uniform sampler2D diffuseTex;
-layout(location = DIFFUSE_COLOR_UNIFORM_LOCATION)
-	uniform vec4 diffColor;
-layout(location = SPECULAR_COLOR_UNIFORM_LOCATION)
-	uniform vec4 specColor;
+	uniform sampler2DArray diffuseTex;
 
 in vec2 v2TexCoords;
-out vec4 outputColor;
+layout(location = COLOR_OUTPUT_LOCATION) out vec4 outputColor;
 
 void main()
 {
-	vec4 sampled = vec4(1.f, 1.f, 1.f, texture(diffuseTex, v2TexCoords).r);
+	vec4 sampled = vec4(1.f, 1.f, 1.f, texture(DRAW_DIFFUSE_SAMPLER(sampler2DArray), vec3(v2TexCoords, DRAW_TEXCOORD_TRANSFORM.z)).r);
 	
 	if (sampled.a == 0.f)
 		discard;
 
-	outputColor = sampled * diffColor;
+	outputColor = shadeOutput(sampled * DRAW_DIFFUSE_COLOR);
 }
\ No newline at end of file
@@ -3,9 +3,6 @@ layout(location = POSITION_ATTRIB_LOCATION)
 layout(location = TEXCOORD_ATTRIB_LOCATION)
 	in vec2 v2TexCoordsIn;
 	
-layout(location = MODEL_MAT_UNIFORM_LOCATION)
-	uniform mat4 m4Model;
-	
 layout(std140, binding = SCENE_UNIFORM_BUFFER_LOCATION) 
 	uniform FrameUniforms
 	{
@@ -19,6 +16,7 @@ out vec2 v2TexCoords;
 
 void main()
 {
-	gl_Position = m4ViewProjection * m4Model * vec4(v3Position, 1.0);
-	v2TexCoords = v2TexCoordsIn;
+	forwardDrawID();
+	gl_Position = m4ViewProjection * DRAW_MODEL * vec4(v3Position, 1.0);
+	v2TexCoords = v2TexCoordsIn * DRAW_TEXCOORD_TRANSFORM.xy;
 }
\ No newline at end of file
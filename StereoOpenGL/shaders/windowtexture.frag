@@ -1,4 +1,4 @@
-layout(location = DIFFUSE_TEXTURE_BINDING)
+layout(binding = DIFFUSE_TEXTURE_BINDING)
 	uniform sampler2D mytexture;
 
 noperspective in vec2 v2UV;
@@ -101,7 +101,7 @@ void ShaderSet::SetPreamble(const std::string& preamble)
     mPreamble = preamble;
 }
 
-GLuint* ShaderSet::AddProgram(const std::vector<std::pair<std::string, GLenum>>& typedShaders)
+GLuint* ShaderSet::AddProgram(const std::vector<std::pair<std::string, GLenum>>& typedShaders, const std::string& defines)
 {
     std::vector<const ShaderNameTypePair*> shaderNameTypes;
         
@@ -110,6 +110,7 @@ GLuint* ShaderSet::AddProgram(const std::vector<std::pair<std::string, GLenum>>&
     {
         ShaderNameTypePair tmpShaderNameType;
         std::tie(tmpShaderNameType.Name, tmpShaderNameType.Type) = shaderNameType;
+        tmpShaderNameType.Defines = defines;
 
         auto foundShader = mShaders.emplace(std::move(tmpShaderNameType), Shader{}).first;
         if (!foundShader->second.Handle)
@@ -172,6 +173,7 @@ void ShaderSet::UpdatePrograms()
         case GL_TESS_EVALUATION_SHADER: defines += "#define TESS_EVALUATION_SHADER\n";    break;
         case GL_COMPUTE_SHADER:         defines += "#define COMPUTE_SHADER\n";            break;
         }
+        defines += shader->first.Defines;
 
         std::string preamble_hash = std::to_string((int32_t)std::hash<std::string>()("preamble") & 0x7FFFFFFF);
         std::string preamble = "#line 1 " + preamble_hash + "\n" + 
@@ -328,7 +330,7 @@ void ShaderSet::SetPreambleFile(const std::string& preambleFilename)
     SetPreamble(ShaderStringFromFile(preambleFilename.c_str()));
 }
 
-GLuint* ShaderSet::AddProgramFromExts(const std::vector<std::string>& shaders)
+GLuint* ShaderSet::AddProgramFromExts(const std::vector<std::string>& shaders, const std::string& defines)
 {
     std::vector<std::pair<std::string, GLenum>> typedShaders;
     for (const std::string& shader : shaders)
@@ -360,7 +362,7 @@ GLuint* ShaderSet::AddProgramFromExts(const std::vector<std::string>& shaders)
         typedShaders.emplace_back(shader, shaderType);
     }
 
-    return AddProgram(typedShaders);
+    return AddProgram(typedShaders, defines);
 }
 
 GLuint* ShaderSet::AddProgramFromCombinedFile(const std::string &filename, const std::vector<GLenum> &shaderTypes)
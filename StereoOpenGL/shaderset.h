@@ -1,9 +1,10 @@
 #pragma once
 
 // Replace with your own GL header include
-#include <GL\glew.h>
+#include <GL/glew.h>
 
 #include <vector>
+#include <string>
 #include <utility>
 #include <map>
 #include <set>
@@ -14,12 +15,13 @@ class ShaderSet
     using ShaderHandle = GLuint;
     using ProgramHandle = GLuint;
 
-    // filename and shader type
+    // filename, shader type and extra #defines (the same file compiled with different defines is a separate shader)
     struct ShaderNameTypePair
     {
         std::string Name;
         GLenum Type;
-        bool operator<(const ShaderNameTypePair& rhs) const { return std::tie(Name, Type) < std::tie(rhs.Name, rhs.Type); }
+        std::string Defines;
+        bool operator<(const ShaderNameTypePair& rhs) const { return std::tie(Name, Type, Defines) < std::tie(rhs.Name, rhs.Type, rhs.Defines); }
     };
 
     // Shader in the ShaderSet system
@@ -71,8 +73,10 @@ public:
 
     // list of (file name, shader type) pairs
     // eg: AddProgram({ {"foo.vert", GL_VERTEX_SHADER}, {"bar.frag", GL_FRAGMENT_SHADER} });
+    // defines are inserted ahead of the preamble in every shader of the program, for building variants of the same files
+    // eg: AddProgram({ {"foo.vert", GL_VERTEX_SHADER}, {"bar.frag", GL_FRAGMENT_SHADER} }, "#define FOO\n");
     // To be const-correct, this should maybe return "const GLuint*". I'm trusting you not to write to that pointer.
-    GLuint* AddProgram(const std::vector<std::pair<std::string, GLenum>>& typedShaders);
+    GLuint* AddProgram(const std::vector<std::pair<std::string, GLenum>>& typedShaders, const std::string& defines = "");
 
     // Polls the timestamps of all the shaders and recompiles/relinks them if they changed
     void UpdatePrograms();
@@ -86,7 +90,7 @@ public:
     // compute shader: .comp
     // eg: AddProgramFromExts({"foo.vert", "bar.frag"});
     // To be const-correct, this should maybe return "const GLuint*". I'm trusting you not to write to that pointer.
-    GLuint* AddProgramFromExts(const std::vector<std::string>& shaders);
+    GLuint* AddProgramFromExts(const std::vector<std::string>& shaders, const std::string& defines = "");
 
     // Convenience to add a single file that contains many shader stages.
     // Similar to what is explained here: https://software.intel.com/en-us/blogs/2012/03/26/using-ifdef-in-opengl-es-20-shaders
@@ -1,9 +1,10 @@
 #pragma once
 
-#include <GL\glew.h>
+#include <GL/glew.h>
 #include <iostream>
 #include <string>
 #include <algorithm>
+#include <cmath>
 #include <lodepng.h>
 
 class GLTexture
@@ -11,6 +12,7 @@ class GLTexture
 public:
 	GLTexture(std::string name, GLubyte color[4])
 		: m_uiID(0)
+		, m_glHandle(0u)
 		, m_strName(name)
 		, m_uiWidth(1u)
 		, m_uiHeight(1u)
@@ -25,6 +27,7 @@ public:
 
 	GLTexture(std::string name, unsigned short width, unsigned short height, unsigned char const * data, bool hasTransparency)
 		: m_uiID(0)
+		, m_glHandle(0u)
 		, m_strName(name)
 		, m_uiWidth(width)
 		, m_uiHeight(height)
@@ -35,15 +38,18 @@ public:
 
 	GLTexture(std::string name, unsigned short width, unsigned short height, GLuint texID, bool hasTransparency)
 		: m_uiID(texID)
+		, m_glHandle(0u)
 		, m_strName(name)
 		, m_uiWidth(width)
 		, m_uiHeight(height)
 		, m_bTransparency(hasTransparency)
 	{
+		makeResident();
 	}
 
 	GLTexture(std::string png_filename, bool hasTransparency)
 		: m_uiID(0)
+		, m_glHandle(0u)
 		, m_uiWidth(0)
 		, m_uiHeight(0)
 		, m_bTransparency(hasTransparency)
@@ -63,6 +69,9 @@ public:
 
 	~GLTexture()
 	{
+		if (m_glHandle)
+			glMakeTextureHandleNonResidentARB(m_glHandle);
+
 		glDeleteTextures(1, &m_uiID);
 	}
 
@@ -73,8 +82,12 @@ public:
 
 	GLuint getTexture() { return m_uiID; }
 
+	// resident bindless handle, or 0 without ARB_bindless_texture
+	GLuint64 getHandle() { return m_glHandle; }
+
 private:
 	GLuint m_uiID;
+	GLuint64 m_glHandle;
 	std::string m_strName;
 	unsigned m_uiWidth, m_uiHeight;
 	bool m_bTransparency;
@@ -100,5 +113,17 @@ private:
 		GLfloat fLargest;
 		glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &fLargest);
 		glTextureParameterf(m_uiID, GL_TEXTURE_MAX_ANISOTROPY_EXT, fLargest);
+
+		makeResident();
+	}
+
+	// a handle freezes the texture's sampling state, so this comes after all parameters are set
+	void makeResident()
+	{
+		if (!GLEW_ARB_bindless_texture || m_uiID == 0)
+			return;
+
+		m_glHandle = glGetTextureHandleARB(m_uiID);
+		glMakeTextureHandleResidentARB(m_glHandle);
 	}
 };
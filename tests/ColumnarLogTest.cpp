@@ -0,0 +1,226 @@
+#include "ColumnarLogReader.h"
+#include "TestCheck.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/resource.h>
+#endif
+
+// Round trip through ColumnarLog and ColumnarLogReader: every column type, several blocks with a
+// partial last one, category labels, a log that runs out of room, and rejection of damaged files.
+
+#define COLUMNARLOGTEST_PATH		"ColumnarLogTest.col"
+#define COLUMNARLOGTEST_BLOCK_ROWS	16u
+#define COLUMNARLOGTEST_ROWS		100u
+#define COLUMNARLOGTEST_GROW_BLOCK_ROWS	4096u
+
+static const char* s_Labels[] = { "left", "right", "a label long enough to need more than one word" };
+
+static bool writeLog()
+{
+	ColumnarLog log;
+	log.addColumn("i32", ColumnarLog::INT32);
+	log.addColumn("u32", ColumnarLog::UINT32);
+	log.addColumn("i64", ColumnarLog::INT64);
+	log.addColumn("u64", ColumnarLog::UINT64);
+	log.addColumn("f32", ColumnarLog::FLOAT32);
+	log.addColumn("f64", ColumnarLog::FLOAT64);
+	log.addColumn("b8", ColumnarLog::BOOL8);
+	log.addColumn("cat", ColumnarLog::CATEGORY);
+
+	if (!log.open(COLUMNARLOGTEST_PATH, COLUMNARLOGTEST_BLOCK_ROWS))
+		return false;
+
+	for (unsigned int r = 0u; r < COLUMNARLOGTEST_ROWS; ++r)
+	{
+		log.set(0u, -static_cast<int>(r));
+		log.set(1u, r * 3u);
+		log.set(2u, -static_cast<long long>(r) * 10000000000ll);
+		log.set(3u, static_cast<unsigned long long>(r) << 40);
+		log.set(4u, r * 0.5f);
+		log.set(5u, r / 3.0);
+		log.set(6u, r % 2u == 0u);
+
+		// exercise both the null-terminated and the counted text overloads
+		const char* label = s_Labels[r % 3u];
+		if (r % 2u)
+			log.set(7u, label);
+		else
+			log.set(7u, label, strlen(label));
+
+		log.commitRow();
+	}
+
+	CHECK(log.rowCount() == COLUMNARLOGTEST_ROWS);
+
+	log.close();
+
+	return true;
+}
+
+static void checkLog()
+{
+	ColumnarLogReader reader;
+	CHECK(reader.open(COLUMNARLOGTEST_PATH));
+	if (!reader.isOpen())
+		return;
+
+	CHECK(reader.columnCount() == 8u);
+	CHECK(reader.findColumn("f64") == 5);
+	CHECK(reader.findColumn("missing") == -1);
+	CHECK(reader.column(7u).type == ColumnarLog::CATEGORY);
+	CHECK(reader.rowCount() == COLUMNARLOGTEST_ROWS);
+	CHECK(reader.blockCount() == (COLUMNARLOGTEST_ROWS + COLUMNARLOGTEST_BLOCK_ROWS - 1u) / COLUMNARLOGTEST_BLOCK_ROWS);
+	CHECK(reader.corruptBlockCount() == 0u);
+
+	// a span of the wrong type is empty rather than reinterpreted
+	CHECK(reader.span<double>(0u, 0u).empty());
+
+	unsigned int r = 0u;
+	for (size_t b = 0u; b < reader.blockCount(); ++b)
+	{
+		ColumnSpan<int32_t> i32 = reader.span<int32_t>(b, 0u);
+		ColumnSpan<uint32_t> u32 = reader.span<uint32_t>(b, 1u);
+		ColumnSpan<int64_t> i64 = reader.span<int64_t>(b, 2u);
+		ColumnSpan<uint64_t> u64 = reader.span<uint64_t>(b, 3u);
+		ColumnSpan<float> f32 = reader.span<float>(b, 4u);
+		ColumnSpan<double> f64 = reader.span<double>(b, 5u);
+		ColumnSpan<uint8_t> b8 = reader.span<uint8_t>(b, 6u);
+		ColumnSpan<uint32_t> cat = reader.span<uint32_t>(b, 7u);
+
+		CHECK(i32.size == reader.blockRowCount(b) && cat.size == reader.blockRowCount(b));
+
+		for (size_t i = 0u; i < i32.size; ++i, ++r)
+		{
+			CHECK(i32[i] == -static_cast<int32_t>(r));
+			CHECK(u32[i] == r * 3u);
+			CHECK(i64[i] == -static_cast<int64_t>(r) * 10000000000ll);
+			CHECK(u64[i] == static_cast<uint64_t>(r) << 40);
+			CHECK(f32[i] == r * 0.5f);
+			CHECK(f64[i] == r / 3.0);
+			CHECK(b8[i] == (r % 2u == 0u ? 1u : 0u));
+			CHECK(reader.categoryLabel(7u, cat[i]) == s_Labels[r % 3u]);
+		}
+	}
+
+	CHECK(r == COLUMNARLOGTEST_ROWS);
+}
+
+#ifndef _WIN32
+// With the file size capped below the first growth step, the log closes itself when it can't
+// add a block. Everything sealed up to then must still be readable, category labels included.
+static void testGrowFailure()
+{
+	struct rlimit original;
+	if (getrlimit(RLIMIT_FSIZE, &original) != 0)
+		return;
+
+	struct rlimit capped = original;
+	capped.rlim_cur = COLUMNARLOG_GROW_BYTES + COLUMNARLOG_GROW_BYTES / 2u;
+	if (original.rlim_cur != RLIM_INFINITY && original.rlim_cur < capped.rlim_cur)
+		return;
+
+	// growing past the cap raises SIGXFSZ instead of just failing
+	signal(SIGXFSZ, SIG_IGN);
+	CHECK(setrlimit(RLIMIT_FSIZE, &capped) == 0);
+
+	ColumnarLog log;
+	log.addColumn("f64", ColumnarLog::FLOAT64);
+	log.addColumn("cat", ColumnarLog::CATEGORY);
+	CHECK(log.open(COLUMNARLOGTEST_PATH, COLUMNARLOGTEST_GROW_BLOCK_ROWS));
+
+	for (unsigned int r = 0u; log.isOpen() && r < 4u * COLUMNARLOG_GROW_BYTES / 12u; ++r)
+	{
+		log.set(0u, static_cast<double>(r));
+		log.set(1u, s_Labels[r % 3u]);
+		log.commitRow();
+	}
+
+	CHECK(!log.isOpen());
+	setrlimit(RLIMIT_FSIZE, &original);
+
+	ColumnarLogReader reader;
+	CHECK(reader.open(COLUMNARLOGTEST_PATH));
+	if (!reader.isOpen())
+		return;
+
+	CHECK(reader.blockCount() > 0u);
+	CHECK(reader.corruptBlockCount() == 0u);
+	CHECK(reader.rowCount() == log.rowCount());
+
+	unsigned int r = 0u;
+	for (size_t b = 0u; b < reader.blockCount(); ++b)
+	{
+		ColumnSpan<double> f64 = reader.span<double>(b, 0u);
+		ColumnSpan<uint32_t> cat = reader.span<uint32_t>(b, 1u);
+
+		for (size_t i = 0u; i < f64.size; ++i, ++r)
+		{
+			if (f64[i] != static_cast<double>(r) || reader.categoryLabel(1u, cat[i]) != s_Labels[r % 3u])
+			{
+				printf("row %u: %g \"%s\"\n", r, f64[i], reader.categoryLabel(1u, cat[i]).c_str());
+				CHECK(false);
+				return;
+			}
+		}
+	}
+}
+#endif
+
+// overwrites length bytes at offset, returning false if the file could not be patched
+static bool patchFile(long offset, const void* bytes, size_t length)
+{
+	FILE* f = fopen(COLUMNARLOGTEST_PATH, "r+b");
+	if (!f)
+		return false;
+
+	bool ok = fseek(f, offset, SEEK_SET) == 0 && fwrite(bytes, 1u, length, f) == length;
+	fclose(f);
+
+	return ok;
+}
+
+int main()
+{
+	CHECK(writeLog());
+	checkLog();
+
+	// flip a value in the first block: its checksum no longer matches, so it is skipped
+	{
+		ColumnarFileHeader header;
+		FILE* f = fopen(COLUMNARLOGTEST_PATH, "rb");
+		CHECK(f && fread(&header, sizeof(header), 1u, f) == 1u);
+		if (f)
+			fclose(f);
+
+		const unsigned char garbage = 0xA5;
+		CHECK(patchFile(static_cast<long>(header.headerBytes + sizeof(ColumnarBlockHeader)), &garbage, 1u));
+
+		ColumnarLogReader reader;
+		CHECK(reader.open(COLUMNARLOGTEST_PATH));
+		CHECK(reader.corruptBlockCount() == 1u);
+		CHECK(reader.rowCount() == COLUMNARLOGTEST_ROWS - COLUMNARLOGTEST_BLOCK_ROWS);
+	}
+
+	// a column name that runs past the column table must be rejected, not read out of bounds
+	{
+		CHECK(writeLog());
+
+		const uint16_t nameLength = 0xFFFFu;
+		CHECK(patchFile(static_cast<long>(sizeof(ColumnarFileHeader) + 2u), &nameLength, sizeof(nameLength)));
+
+		ColumnarLogReader reader;
+		CHECK(!reader.open(COLUMNARLOGTEST_PATH));
+	}
+
+#ifndef _WIN32
+	testGrowFailure();
+#endif
+
+	remove(COLUMNARLOGTEST_PATH);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,55 @@
+#include "DataLogger.h"
+#include "TestCheck.h"
+
+#include <fstream>
+#include <string>
+
+// Logs well past the queue capacity while the writer is parked between its drain and its
+// overflow pickup, then checks that every line reaches the file once and in logged order.
+
+#define DATALOGGERTEST_LOGNAME	"DataLoggerTest"
+#define DATALOGGERTEST_LINES	(3u * DATALOGGER_QUEUE_SIZE)
+
+static void testOverflowKeepsOrder()
+{
+	DataLogger &logger = DataLogger::getInstance();
+
+	logger.setLogDirectory(".");
+	logger.setID("t");
+	CHECK(logger.openLog(DATALOGGERTEST_LOGNAME, false));
+	logger.start();
+
+	logger.pauseWriter(true);
+	for (unsigned int i = 0u; i < DATALOGGERTEST_LINES; ++i)
+		logger.logMessage(std::to_string(i));
+	logger.pauseWriter(false);
+
+	logger.closeLog();
+
+	std::ifstream in(DATALOGGERTEST_LOGNAME ".csv");
+	CHECK(in.good());
+
+	std::string text;
+	unsigned int expected = 0u;
+	bool inOrder = true;
+	while (std::getline(in, text))
+	{
+		if (text != "t," + std::to_string(expected))
+		{
+			if (inOrder)
+				printf("line %u is \"%s\"\n", expected, text.c_str());
+			inOrder = false;
+		}
+		++expected;
+	}
+
+	CHECK(inOrder);
+	CHECK(expected == DATALOGGERTEST_LINES);
+}
+
+int main()
+{
+	testOverflowKeepsOrder();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,130 @@
+#include "DistortionUtils.h"
+#include "TestCheck.h"
+
+#include <cstdlib>
+
+// LineLineIntersect and IntersectRaysFromTwoOrigins against known closest points and degenerate
+// input, and transformStereoscopicPoints reproducing points seen from their own projection.
+
+template <typename T>
+static glm::tvec3<T, glm::highp> randomPoint()
+{
+	return glm::tvec3<T, glm::highp>(rand() % 2001 - 1000, rand() % 2001 - 1000, rand() % 2001 - 1000) / T(100);
+}
+
+template <typename T>
+static void testBatch(double tolerance)
+{
+	typedef glm::tvec3<T, glm::highp> vec;
+
+	const size_t n = 1000u;
+	std::vector<vec> p2(n), p4(n), pa(n), pb(n);
+	std::vector<T> mua(n), mub(n);
+	std::vector<uint8_t> valid(n);
+
+	vec p1(T(-3), T(0), T(10)), p3(T(3), T(0), T(10));
+
+	for (size_t i = 0u; i < n; ++i)
+	{
+		p2[i] = randomPoint<T>();
+		p4[i] = randomPoint<T>();
+	}
+
+	// degenerate pairs: a zero-length line, then parallel lines
+	p2[0] = p1;
+	p2[1] = p1 + vec(T(1), T(2), T(3));
+	p4[1] = p3 + vec(T(2), T(4), T(6));
+
+	size_t nValid = distutil::IntersectRaysFromTwoOrigins<T>(p1, p2.data(), p3, p4.data(), n, pa.data(), pb.data(), mua.data(), mub.data(), valid.data());
+
+	CHECK(valid[0] == 0u && valid[1] == 0u);
+	CHECK(mua[0] == T(1) && mub[0] == T(1));
+	CHECK(pa[1] == p2[1] && pb[1] == p4[1]);
+
+	size_t counted = 0u;
+	for (size_t i = 0u; i < n; ++i)
+	{
+		counted += valid[i];
+		if (!valid[i])
+			continue;
+
+		// the shortest segment between the lines is perpendicular to both
+		vec seg = pb[i] - pa[i];
+		CHECK_NEAR(glm::dot(seg, glm::normalize(p2[i] - p1)), 0.0, tolerance);
+		CHECK_NEAR(glm::dot(seg, glm::normalize(p4[i] - p3)), 0.0, tolerance);
+		CHECK_NEAR(glm::length(pa[i] - (p1 + mua[i] * (p2[i] - p1))), 0.0, tolerance);
+		CHECK_NEAR(glm::length(pb[i] - (p3 + mub[i] * (p4[i] - p3))), 0.0, tolerance);
+	}
+
+	CHECK(counted == nValid);
+	CHECK(nValid >= n - 2u);
+}
+
+static void testSingle()
+{
+	glm::vec3 pa, pb;
+	double mua, mub;
+
+	// the x axis and a line parallel to z through (0, 1, 0) are closest at the origin and (0, 1, 0)
+	CHECK(distutil::LineLineIntersect(glm::vec3(0.f), glm::vec3(1.f, 0.f, 0.f), glm::vec3(0.f, 1.f, 1.f), glm::vec3(0.f, 1.f, 0.f), &pa, &pb, &mua, &mub));
+	CHECK_NEAR(glm::length(pa), 0.0, 1e-6);
+	CHECK_NEAR(glm::length(pb - glm::vec3(0.f, 1.f, 0.f)), 0.0, 1e-6);
+	CHECK_NEAR(mua, 0.0, 1e-9);
+	CHECK_NEAR(mub, 1.0, 1e-9);
+
+	CHECK(!distutil::LineLineIntersect(glm::vec3(0.f), glm::vec3(1.f, 0.f, 0.f), glm::vec3(0.f, 1.f, 0.f), glm::vec3(2.f, 1.f, 0.f), &pa, &pb, &mua, &mub));
+	CHECK(!distutil::LineLineIntersect(glm::vec3(0.f), glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f), glm::vec3(2.f, 1.f, 0.f), &pa, &pb, NULL, NULL));
+}
+
+static void testStereoscopicIdentity()
+{
+	// viewed from the centers of projection themselves, every point in front of the eyes stays put
+	glm::vec3 eyeL(-3.f, 0.f, 60.f), eyeR(3.f, 0.f, 60.f);
+	glm::vec3 screenCtr(0.f), screenNorm(0.f, 0.f, 1.f);
+
+	std::vector<glm::vec3> pts;
+	for (int i = 0; i < 200; ++i)
+		pts.push_back(glm::vec3(rand() % 41 - 20, rand() % 41 - 20, rand() % 81 - 40));
+
+	// reuses the scratch buffers of the first call
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		std::vector<uint8_t> valid;
+		std::vector<glm::vec3> out = distutil::transformStereoscopicPoints(eyeL, eyeR, eyeL, eyeR, screenCtr, screenNorm, pts, &valid);
+
+		CHECK(out.size() == pts.size() && valid.size() == pts.size());
+		if (out.size() != pts.size() || valid.size() != pts.size())
+			return;
+
+		for (size_t i = 0u; i < pts.size(); ++i)
+		{
+			CHECK(valid[i] == 1u);
+			CHECK_NEAR(glm::length(out[i] - pts[i]), 0.0, 1e-3);
+		}
+
+		pts.resize(pts.size() / 2u);
+	}
+
+	// the span overload writes into the caller's buffer and matches the vector overload
+	std::vector<glm::vec3> expected = distutil::transformStereoscopicPoints(eyeL, eyeR, eyeL + glm::vec3(5.f, 0.f, 0.f), eyeR + glm::vec3(5.f, 0.f, 0.f), screenCtr, screenNorm, pts);
+	std::vector<glm::vec3> out(pts.size());
+	std::vector<uint8_t> valid(pts.size());
+
+	size_t nValid = distutil::transformStereoscopicPoints(eyeL, eyeR, eyeL + glm::vec3(5.f, 0.f, 0.f), eyeR + glm::vec3(5.f, 0.f, 0.f), screenCtr, screenNorm, pts.data(), pts.size(), out.data(), valid.data());
+
+	CHECK(nValid == pts.size());
+	for (size_t i = 0u; i < pts.size(); ++i)
+		CHECK(out[i] == expected[i] && valid[i] == 1u);
+}
+
+int main()
+{
+	srand(1u);
+
+	testSingle();
+	testBatch<float>(1e-2);
+	testBatch<double>(1e-9);
+	testStereoscopicIdentity();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,87 @@
+# Starts loopbackservo.py on a free local port, checks its protocol over a plain socket, then
+# runs the MotorControlClientTest executable against it.
+#
+# usage: LoopbackServoTest.py <loopbackservo.py> <MotorControlClientTest>
+import sys
+import socket
+import subprocess
+import time
+
+TIMEOUT = 5.0
+
+def free_port():
+    s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    s.bind(("127.0.0.1", 0))
+    port = s.getsockname()[1]
+    s.close()
+    return port
+
+failures = []
+
+def check(cond, what):
+    if not cond:
+        print("FAILED:", what)
+        failures.append(what)
+
+# reads lines until one satisfies pred or the timeout passes; returns the position angles seen and the match
+def read_until(conn, buf, pred):
+    angles = []
+    deadline = time.time() + TIMEOUT
+    while time.time() < deadline:
+        while b"\n" in buf[0]:
+            line, buf[0] = buf[0].split(b"\n", 1)
+            msg = line.decode().strip()
+            if msg.startswith("pos,"):
+                angles.append(float(msg.split(",")[2]))
+            if pred(msg, angles):
+                return angles, msg
+        conn.settimeout(max(0.01, deadline - time.time()))
+        try:
+            data = conn.recv(512)
+        except socket.timeout:
+            break
+        if not data:
+            break
+        buf[0] += data
+    return angles, None
+
+def check_protocol(port):
+    conn = socket.create_connection(("127.0.0.1", port), timeout=TIMEOUT)
+    buf = [b""]
+
+    # commands are echoed once accepted, between the streamed positions
+    conn.sendall(b"45,0.2\n")
+    _, echo = read_until(conn, buf, lambda msg, angles: msg == "45,0.2")
+    check(echo == "45,0.2", "command echoed")
+
+    angles, _ = read_until(conn, buf, lambda msg, angles: len(angles) > 0 and angles[-1] == 45.0)
+    check(len(angles) > 0 and angles[-1] == 45.0, "commanded position sweeps to 45")
+    check(all(abs(b - 45.0) <= abs(a - 45.0) for a, b in zip(angles, angles[1:])), "sweep approaches 45")
+
+    # targets are clamped to the servo's range, and a command without a time still moves
+    conn.sendall(b"120\n")
+    angles, _ = read_until(conn, buf, lambda msg, angles: len(angles) > 0 and angles[-1] == 90.0)
+    check(len(angles) > 0 and angles[-1] == 90.0, "target clamped to 90")
+
+    conn.close()
+
+if len(sys.argv) < 3:
+    print("usage:", sys.argv[0], "<loopbackservo.py> <MotorControlClientTest>")
+    sys.exit(1)
+
+port = free_port()
+server = subprocess.Popen([sys.executable, "-u", sys.argv[1], str(port)], stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+
+try:
+    ready = server.stdout.readline().decode()
+    check("listening" in ready, "server started")
+
+    if not failures:
+        check_protocol(port)
+        client = subprocess.run([sys.argv[2], str(port), str(free_port())], timeout=4 * TIMEOUT)
+        check(client.returncode == 0, "MotorControlClientTest passed")
+finally:
+    server.kill()
+    server.wait()
+
+sys.exit(1 if failures else 0)
@@ -0,0 +1,83 @@
+#include "MPMCQueue.h"
+#include "TestCheck.h"
+
+#include <thread>
+#include <vector>
+
+// Single-threaded semantics of MPMCQueue, then several producer and consumer threads checking
+// that every item arrives exactly once.
+
+#define MPMCQUEUETEST_ITEMS		200000u
+#define MPMCQUEUETEST_THREADS	4u
+
+static void testMPMCBasics()
+{
+	MPMCQueue<int, 4> q;
+	int v = 0;
+
+	CHECK(!q.pop(v));
+
+	for (int i = 0; i < 4; ++i)
+		CHECK(q.push(i));
+	CHECK(!q.push(4));
+
+	for (int i = 0; i < 4; ++i)
+	{
+		CHECK(q.pop(v));
+		CHECK(v == i);
+	}
+
+	CHECK(!q.pop(v));
+}
+
+static void testMPMCThreads()
+{
+	MPMCQueue<unsigned int, 256> q;
+	const unsigned int perProducer = MPMCQUEUETEST_ITEMS / MPMCQUEUETEST_THREADS;
+	const unsigned int total = perProducer * MPMCQUEUETEST_THREADS;
+
+	std::vector<unsigned char> seen(total, 0u);
+	std::vector<std::thread> threads;
+	std::atomic<unsigned int> popped(0u);
+
+	for (unsigned int p = 0u; p < MPMCQUEUETEST_THREADS; ++p)
+		threads.push_back(std::thread([&q, p, perProducer]() {
+			for (unsigned int i = 0u; i < perProducer; ++i)
+				while (!q.push(p * perProducer + i))
+					std::this_thread::yield();
+		}));
+
+	// consumers mark what they receive; every item goes to exactly one of them
+	for (unsigned int c = 0u; c < MPMCQUEUETEST_THREADS; ++c)
+		threads.push_back(std::thread([&]() {
+			unsigned int v;
+			while (popped.load() < total)
+			{
+				if (q.pop(v))
+				{
+					++seen[v];
+					++popped;
+				}
+				else
+					std::this_thread::yield();
+			}
+		}));
+
+	for (auto &t : threads)
+		t.join();
+
+	unsigned int once = 0u;
+	for (unsigned char s : seen)
+		once += s == 1u;
+
+	CHECK(popped.load() == total);
+	CHECK(once == total);
+}
+
+int main()
+{
+	testMPMCBasics();
+	testMPMCThreads();
+
+	return TEST_RESULT();
+}
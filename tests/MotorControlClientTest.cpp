@@ -0,0 +1,90 @@
+#include "MotorControlClient.h"
+#include "TestCheck.h"
+
+#include <cstdlib>
+#include <vector>
+
+// Runs MotorControlClient against a motor server on localhost (LoopbackServoTest.py starts
+// loopbackservo.py for it): connects, checks a command is acknowledged with its echo, that the
+// streamed commanded positions sweep to the target, and that disconnect() reports the change.
+// Then points a client at a port nothing listens on and checks that a command queued while it
+// can't connect fails instead of waiting for a connection.
+//
+// usage: MotorControlClientTest <port> <unused port>
+
+#define MOTORCLIENTTEST_TIMEOUT_MS	5000
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// polls the client until done() or the timeout; returns done()
+template <typename F>
+static bool pollUntil(MotorControlClient &client, F done)
+{
+	auto deadline = Clock::now() + std::chrono::milliseconds(MOTORCLIENTTEST_TIMEOUT_MS);
+
+	while (!done() && Clock::now() < deadline)
+	{
+		client.pollEvents();
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+
+	return done();
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		printf("usage: %s <port> <unused port>\n", argv[0]);
+		return 1;
+	}
+
+	MotorControlClient client;
+
+	std::vector<MotorControlClient::ConnectionState> states;
+	std::vector<float> angles;
+	bool acked = false, ackOK = false;
+	std::string reply;
+
+	client.setStateCallback([&](MotorControlClient::ConnectionState s) { states.push_back(s); });
+	client.setPositionCallback([&](double, float angle, Clock::time_point) { angles.push_back(angle); });
+
+	client.connect("127.0.0.1", atoi(argv[1]));
+
+	CHECK(pollUntil(client, [&]() { return client.getState() == MotorControlClient::CONNECTED; }));
+
+	CHECK(client.send("20,0.3", [&](bool ok, const std::string &r, double) { acked = true; ackOK = ok; reply = r; }));
+	CHECK(pollUntil(client, [&]() { return acked; }));
+	CHECK(ackOK);
+	CHECK(reply == "20,0.3");
+
+	// the sweep takes 0.3 s; wait until the stream has settled on the target
+	angles.clear();
+	CHECK(pollUntil(client, [&]() { return !angles.empty() && angles.back() == 20.f; }));
+
+	// the server keeps its angle between connections, so the sweep may run either way
+	bool approaching = true;
+	for (size_t i = 1u; i < angles.size(); ++i)
+		approaching &= std::fabs(angles[i] - 20.f) <= std::fabs(angles[i - 1u] - 20.f);
+	CHECK(approaching);
+
+	client.disconnect();
+	client.pollEvents();
+
+	CHECK(client.getState() == MotorControlClient::DISCONNECTED);
+	CHECK(!states.empty() && states.back() == MotorControlClient::DISCONNECTED);
+
+	// nothing to connect to: the command is failed, not held for a later connection
+	MotorControlClient unreachable;
+	bool nacked = false;
+
+	unreachable.connect("127.0.0.1", atoi(argv[2]));
+	CHECK(unreachable.send("10,0.1", [&](bool ok, const std::string &, double) { acked = true; nacked = !ok; }));
+
+	acked = false;
+	CHECK(pollUntil(unreachable, [&]() { return acked; }));
+	CHECK(nacked);
+	CHECK(unreachable.getState() != MotorControlClient::CONNECTED);
+
+	return TEST_RESULT();
+}
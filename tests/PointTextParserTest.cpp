@@ -0,0 +1,102 @@
+#include "PointTextParser.h"
+#include "TestCheck.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <experimental/filesystem>
+
+// Parses a small text cloud with the cache beside it, then with that spot blocked (a directory
+// squats on the cache name) so the cache moves to the temp directory, then with no usable temp
+// directory either so the points are only kept in memory.
+
+#define POINTTEXTPARSERTEST_PATH	"PointTextParserTest.txt"
+#define POINTTEXTPARSERTEST_TEMP	"PointTextParserTestTemp"
+
+namespace fs = std::experimental::filesystem;
+
+static void checkPoints(PointTextParser const &parser)
+{
+	CHECK(parser.isOpen());
+	if (!parser.isOpen())
+		return;
+
+	CHECK(parser.pointCount() == 3u);
+	CHECK(parser.header().skippedLines == 1u);
+	CHECK(parser.header().origin[0] == 10.0);
+
+	const PointTextPoint* p = parser.points();
+	CHECK(p[1].x == 1.f && p[1].y == 2.f && p[1].z == 3.f);
+	CHECK(p[2].rgba[0] == 255u && p[2].rgba[3] == 255u);
+}
+
+static void setTempDirectory(const char* dir)
+{
+#ifdef _WIN32
+	_putenv_s("TMP", dir);
+	_putenv_s("TEMP", dir);
+#else
+	setenv("TMPDIR", dir, 1);
+#endif
+}
+
+int main()
+{
+	FILE* f = fopen(POINTTEXTPARSERTEST_PATH, "w");
+	CHECK(f != NULL);
+	if (!f)
+		return TEST_RESULT();
+	fputs("x y z\n10 20 30\n11 22 33\n12,21,30,255,0,0\n", f);
+	fclose(f);
+
+	std::error_code ec;
+	fs::remove(PointTextParser::cachePath(POINTTEXTPARSERTEST_PATH), ec);
+	fs::create_directory(POINTTEXTPARSERTEST_TEMP, ec);
+	setTempDirectory(fs::absolute(POINTTEXTPARSERTEST_TEMP).string().c_str());
+
+	PointTextParser parser;
+	parser.setThreads(2u);
+
+	// beside the source, then read back from there
+	CHECK(parser.open(POINTTEXTPARSERTEST_PATH));
+	CHECK(!parser.getStats().fromCache && !parser.getStats().cacheSkipped);
+	checkPoints(parser);
+	CHECK(fs::exists(PointTextParser::cachePath(POINTTEXTPARSERTEST_PATH)));
+
+	CHECK(parser.open(POINTTEXTPARSERTEST_PATH));
+	CHECK(parser.getStats().fromCache);
+	checkPoints(parser);
+	parser.close();
+
+	// blocked beside the source: cached in the temp directory and found there next time
+	fs::remove(PointTextParser::cachePath(POINTTEXTPARSERTEST_PATH), ec);
+	fs::create_directory(PointTextParser::cachePath(POINTTEXTPARSERTEST_PATH), ec);
+
+	std::string fallback = PointTextParser::fallbackCachePath(POINTTEXTPARSERTEST_PATH);
+	CHECK(fs::path(fallback).parent_path() == fs::absolute(POINTTEXTPARSERTEST_TEMP));
+
+	CHECK(parser.open(POINTTEXTPARSERTEST_PATH));
+	CHECK(!parser.getStats().fromCache && !parser.getStats().cacheSkipped);
+	checkPoints(parser);
+	CHECK(fs::exists(fallback));
+
+	CHECK(parser.open(POINTTEXTPARSERTEST_PATH));
+	CHECK(parser.getStats().fromCache);
+	checkPoints(parser);
+	parser.close();
+
+	// no temp directory either: parsed into memory
+	fs::remove(fallback, ec);
+	setTempDirectory(fs::absolute(POINTTEXTPARSERTEST_TEMP "/missing").string().c_str());
+
+	CHECK(parser.open(POINTTEXTPARSERTEST_PATH));
+	CHECK(!parser.getStats().fromCache && parser.getStats().cacheSkipped);
+	checkPoints(parser);
+	parser.close();
+	CHECK(!parser.isOpen());
+
+	fs::remove(PointTextParser::cachePath(POINTTEXTPARSERTEST_PATH), ec);
+	fs::remove_all(POINTTEXTPARSERTEST_TEMP, ec);
+	remove(POINTTEXTPARSERTEST_PATH);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,83 @@
+#include "SPSCQueue.h"
+#include "TestCheck.h"
+
+#include <thread>
+
+// Single-threaded semantics of SPSCQueue, then a producer and a consumer thread checking that
+// every item arrives exactly once and in order.
+
+#define SPSCQUEUETEST_ITEMS		200000u
+
+static void testSPSCBasics()
+{
+	SPSCQueue<int, 8> q;
+	int v = 0;
+
+	CHECK(q.empty());
+	CHECK(!q.pop(v));
+	CHECK(q.front() == NULL);
+
+	// one slot is never used, so a capacity of 8 holds 7
+	for (int i = 0; i < 7; ++i)
+		CHECK(q.push(i));
+	CHECK(!q.push(7));
+	CHECK(q.claim() == NULL);
+
+	CHECK(q.front() != NULL && *q.front() == 0);
+	q.release();
+
+	int* slot = q.claim();
+	CHECK(slot != NULL);
+	if (slot)
+	{
+		*slot = 7;
+		q.commit();
+	}
+
+	for (int i = 1; i <= 7; ++i)
+	{
+		CHECK(q.pop(v));
+		CHECK(v == i);
+	}
+
+	CHECK(q.empty());
+}
+
+static void testSPSCThreads()
+{
+	// a small queue so the producer keeps finding it full
+	SPSCQueue<unsigned int, 64> q;
+
+	std::thread producer([&q]() {
+		for (unsigned int i = 0u; i < SPSCQUEUETEST_ITEMS; ++i)
+			while (!q.push(i))
+				std::this_thread::yield();
+	});
+
+	unsigned int expected = 0u, v;
+	bool inOrder = true;
+	while (expected < SPSCQUEUETEST_ITEMS)
+	{
+		if (!q.pop(v))
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		inOrder &= v == expected;
+		++expected;
+	}
+
+	producer.join();
+
+	CHECK(inOrder);
+	CHECK(q.empty());
+}
+
+int main()
+{
+	testSPSCBasics();
+	testSPSCThreads();
+
+	return TEST_RESULT();
+}
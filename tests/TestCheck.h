@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+
+// Minimal checks for the ctest executables: a failed CHECK prints where and what failed and
+// the run carries on, so one ctest run reports every broken case. main() returns TEST_RESULT().
+
+static int g_nTestFailures = 0;
+
+#define CHECK(cond) \
+	do { if (!(cond)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); ++g_nTestFailures; } } while (0)
+
+#define CHECK_NEAR(a, b, tolerance) \
+	do { double a_ = (a), b_ = (b); if (!(std::fabs(a_ - b_) <= (tolerance))) { printf("%s:%d: CHECK_NEAR(%s, %s) failed: %g vs %g\n", __FILE__, __LINE__, #a, #b, a_, b_); ++g_nTestFailures; } } while (0)
+
+#define TEST_RESULT() (g_nTestFailures == 0 ? 0 : 1)
@@ -0,0 +1,83 @@
+#include "TransparencySorter.h"
+#include "TestCheck.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <gtx/norm.hpp>
+
+// TransparencySorter's radix and incremental paths against std::stable_sort by descending
+// squared distance, including ties, which must keep submission order.
+
+static std::vector<uint32_t> referenceOrder(const std::vector<glm::vec3> &positions, const glm::vec3 &viewPos)
+{
+	std::vector<float> distSq(positions.size());
+	for (size_t i = 0u; i < positions.size(); ++i)
+		distSq[i] = glm::length2(positions[i] - viewPos);
+
+	std::vector<uint32_t> order(positions.size());
+	for (uint32_t i = 0u; i < order.size(); ++i)
+		order[i] = i;
+
+	std::stable_sort(order.begin(), order.end(), [&distSq](uint32_t a, uint32_t b) { return distSq[a] > distSq[b]; });
+
+	return order;
+}
+
+static bool matchesReference(const TransparencySorter &sorter, const std::vector<glm::vec3> &positions, const glm::vec3 &viewPos)
+{
+	std::vector<uint32_t> expected = referenceOrder(positions, viewPos);
+
+	return sorter.size() == expected.size() && (expected.empty() || std::equal(expected.begin(), expected.end(), sorter.order()));
+}
+
+int main()
+{
+	srand(1u);
+
+	std::vector<glm::vec3> positions;
+	for (int i = 0; i < 5000; ++i)
+		positions.push_back(glm::vec3(rand() % 2001 - 1000, rand() % 2001 - 1000, rand() % 2001 - 1000) * 0.1f);
+
+	// exact ties
+	for (int i = 0; i < 50; ++i)
+		positions.push_back(positions[i]);
+
+	TransparencySorter sorter;
+	sorter.reserve(positions.size());
+
+	glm::vec3 viewPos(10.f, 20.f, 30.f);
+
+	for (auto const &p : positions)
+		sorter.add(p);
+
+	sorter.sort(viewPos);
+	CHECK(!sorter.wasIncremental());
+	CHECK(matchesReference(sorter, positions, viewPos));
+
+	// a small step reuses last frame's order
+	viewPos += glm::vec3(0.1f, 0.f, 0.f);
+	sorter.sort(viewPos);
+	CHECK(sorter.wasIncremental());
+	CHECK(matchesReference(sorter, positions, viewPos));
+
+	// a jump past the coherence distance sorts from scratch
+	viewPos += glm::vec3(TRANSPARENCYSORTER_COHERENCE_DIST * 50.f, 0.f, 0.f);
+	sorter.sort(viewPos);
+	CHECK(!sorter.wasIncremental());
+	CHECK(matchesReference(sorter, positions, viewPos));
+
+	// a different count cannot reuse the order either
+	sorter.clear();
+	positions.resize(100u);
+	for (auto const &p : positions)
+		sorter.add(p);
+	sorter.sort(viewPos);
+	CHECK(!sorter.wasIncremental());
+	CHECK(matchesReference(sorter, positions, viewPos));
+
+	sorter.clear();
+	sorter.sort(viewPos);
+	CHECK(sorter.size() == 0u && sorter.order() == NULL);
+
+	return TEST_RESULT();
+}